@@ -69,6 +69,11 @@ typedef enum
 	OAES_RET_MEM,
 	OAES_RET_BUF,
 	OAES_RET_HEADER,
+	OAES_RET_ARG8,
+	OAES_RET_ARG9,
+	OAES_RET_ARG10,
+	// the authentication tag does not match
+	OAES_RET_AUTH,
 	OAES_RET_COUNT
 } OAES_RET;
 
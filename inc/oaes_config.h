@@ -43,6 +43,60 @@ extern "C" {
 #define OAES_DEBUG 0
 #endif // OAES_DEBUG
 
+// step tracing through OAES_OPTION_STEP_ON, it runs on kernels of its own
+// so the engines are untouched by it, build with OAES_STEP_TRACE=0 to drop it
+#ifndef OAES_STEP_TRACE
+#define OAES_STEP_TRACE 1
+#endif // OAES_STEP_TRACE
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define OAES_ARCH_X86 1
+#endif
+
+// AES-NI engine, picked at run time when the cpu supports it
+#ifndef OAES_HAVE_AESNI
+#ifdef OAES_ARCH_X86
+#define OAES_HAVE_AESNI 1
+#else
+#define OAES_HAVE_AESNI 0
+#endif
+#endif // OAES_HAVE_AESNI
+
+// constant time bitsliced engine, used in place of the tables when there
+// is no AES-NI
+#ifndef OAES_HAVE_BITSLICE
+#ifdef OAES_ARCH_X86
+#define OAES_HAVE_BITSLICE 1
+#else
+#define OAES_HAVE_BITSLICE 0
+#endif
+#endif // OAES_HAVE_BITSLICE
+
+// constant time SSSE3 engine for single blocks, used when there is no AES-NI
+#ifndef OAES_HAVE_VPERM
+#ifdef OAES_ARCH_X86
+#define OAES_HAVE_VPERM 1
+#else
+#define OAES_HAVE_VPERM 0
+#endif
+#endif // OAES_HAVE_VPERM
+
+// carry-less multiply GHASH for GCM, picked at run time when the cpu
+// supports it, and fused with AES-NI when the key runs on that engine
+#ifndef OAES_HAVE_PCLMUL
+#ifdef OAES_ARCH_X86
+#define OAES_HAVE_PCLMUL 1
+#else
+#define OAES_HAVE_PCLMUL 0
+#endif
+#endif // OAES_HAVE_PCLMUL
+
+// engine that keeps no round keys and expands them as it goes, for when
+// many keys are live at once, only used when selected by name
+#ifndef OAES_HAVE_COMPACT
+#define OAES_HAVE_COMPACT 1
+#endif // OAES_HAVE_COMPACT
+
 #ifdef __cplusplus 
 }
 #endif
@@ -32,6 +32,7 @@
 #define _OAES_LIB_H
 
 #include <oaes_common.h>
+#include <oaes_config.h>
 
 #ifdef __cplusplus 
 extern "C" {
@@ -53,6 +54,9 @@ extern "C" {
 
 #define OAES_BLOCK_SIZE 16
 
+// bytes of the nonce of oaes_gcm_siv_encrypt() and oaes_gcm_siv_decrypt()
+#define OAES_GCM_SIV_NONCE_SIZE 12
+
 typedef void OAES_CTX;
 
 /*
@@ -68,7 +72,7 @@ typedef void OAES_CTX;
 // the value of the initialization vector, iv
 #define OAES_OPTION_CBC 2
 
-#ifdef OAES_DEBUG
+#if OAES_STEP_TRACE
 typedef int ( * oaes_step_cb ) (
 		const uint8_t state[OAES_BLOCK_SIZE],
 		const char * step_name,
@@ -79,10 +83,41 @@ typedef int ( * oaes_step_cb ) (
 #define OAES_OPTION_STEP_ON 4
 // disable state stepping mode
 #define OAES_OPTION_STEP_OFF 8
-#endif // OAES_DEBUG
+#endif // OAES_STEP_TRACE
+
+// select the block engine by name, see oaes_get_engine_info()
+// value is optional, NULL picks the engine named by the OAES_ENGINE
+// environment variable, or else the fastest one the cpu can run
+// returns OAES_RET_ARG3 if the engine is not compiled in or the cpu lacks
+// the features it needs
+#define OAES_OPTION_ENGINE 16
+// enable CTR mode, disable ECB and CBC modes, nothing is padded
+// the iv passed to oaes_encrypt() and oaes_decrypt() is the counter block,
+// it is left on the block after the last one used, a call that does not
+// end on a block boundary drops the rest of its last keystream block
+// value is optional, may pass uint8_t iv[OAES_BLOCK_SIZE] to specify
+// the value of the initialization vector, iv
+#define OAES_OPTION_CTR 32
+// the low order bits of the big endian counter block that are counted, the
+// counter wraps around within them and the bits above are a fixed nonce
+// value is required, must pass a const size_t * from 1 to 128, the
+// default is 128, encrypting more blocks than the counter has values in one
+// call returns OAES_RET_ARG3
+#define OAES_OPTION_CTR_WIDTH 64
+// keep a buffer of CTR keystream that oaes_ctr_prefetch() computes ahead of
+// time, a CTR call that starts on the counter it was computed for uses it
+// value is required, must pass a const size_t * with the depth in blocks,
+// 0 drops the buffer
+#define OAES_OPTION_CTR_PREFETCH 128
 
 typedef uint16_t OAES_OPTION;
 
+// cpu features an engine needs, as given by oaes_get_engine_info()
+#define OAES_CPU_SSE2 0x0001
+#define OAES_CPU_SSSE3 0x0002
+#define OAES_CPU_AESNI 0x0004
+#define OAES_CPU_PCLMUL 0x0008
+
 /*
  * // usage:
  * 
@@ -125,6 +160,17 @@ OAES_API OAES_RET oaes_free( OAES_CTX ** ctx );
 OAES_API OAES_RET oaes_set_option( OAES_CTX * ctx,
 		OAES_OPTION option, const void * value );
 
+// name of the engine the key runs on, or would run on if there is no key
+OAES_API const char * oaes_get_engine( OAES_CTX * ctx );
+
+/**
+ * describe the compiled in engine at index, fastest first
+ * available is set to 1 when the cpu can run it, 0 otherwise
+ * returns OAES_RET_ARG1 past the last engine
+ */
+OAES_API OAES_RET oaes_get_engine_info( size_t index,
+		const char ** name, uint32_t * cpu_features, int * available );
+
 OAES_API OAES_RET oaes_key_gen_128( OAES_CTX * ctx );
 
 OAES_API OAES_RET oaes_key_gen_192( OAES_CTX * ctx );
@@ -165,6 +211,380 @@ OAES_API OAES_RET oaes_decrypt( OAES_CTX * ctx,
 		const uint8_t * c, size_t c_len, uint8_t * m, size_t * m_len,
 		uint8_t iv[OAES_BLOCK_SIZE], uint8_t pad);
 
+/**
+ * encrypt c_len / OAES_BLOCK_SIZE independent blocks in place, no padding
+ * and no chaining, c_len must be a multiple of OAES_BLOCK_SIZE
+ */
+OAES_API OAES_RET oaes_encrypt_blocks( OAES_CTX * ctx,
+		uint8_t * c, size_t c_len );
+
+/**
+ * decrypt c_len / OAES_BLOCK_SIZE independent blocks in place, no padding
+ * and no chaining, c_len must be a multiple of OAES_BLOCK_SIZE
+ */
+OAES_API OAES_RET oaes_decrypt_blocks( OAES_CTX * ctx,
+		uint8_t * c, size_t c_len );
+
+/**
+ * CTR encrypt or decrypt len bytes of a stream that starts at counter block
+ * nonce, from byte_offset into it on, in and out may be the same buffer
+ * the counter block for byte_offset is computed directly, so only the
+ * blocks the range touches are encrypted, the counter width is the one set
+ * with OAES_OPTION_CTR_WIDTH, whichever mode is enabled
+ */
+OAES_API OAES_RET oaes_ctr_crypt_at( OAES_CTX * ctx,
+		const uint8_t nonce[OAES_BLOCK_SIZE], uint64_t byte_offset,
+		const uint8_t * in, size_t len, uint8_t * out );
+
+/**
+ * compute keystream into the OAES_OPTION_CTR_PREFETCH buffer for the
+ * counters from ctr on, the next CTR call starting at ctr only has to xor
+ * it in, call it when idle, or from another thread that the calls on ctx
+ * are serialized with
+ * keystream left over for ctr is kept, keystream for any other counter is
+ * dropped, it does nothing while there is no buffer
+ */
+OAES_API OAES_RET oaes_ctr_prefetch( OAES_CTX * ctx,
+		const uint8_t ctr[OAES_BLOCK_SIZE] );
+
+// the CTR keystream blocks taken from the prefetch buffer, and those that
+// had to be computed when they were needed while there was a buffer
+OAES_API OAES_RET oaes_ctr_prefetch_stats( OAES_CTX * ctx,
+		uint64_t * hits, uint64_t * misses );
+
+/**
+ * GCM encrypt m_len bytes of m into c, and authenticate them along with
+ * aad_len bytes of aad, m and c may be the same buffer
+ * a 12 byte iv is used directly, any other length is hashed first
+ * tag_len is 12 to 16, or 8 or 4 where short tags are acceptable
+ * this does not depend on the mode set with oaes_set_option()
+ */
+OAES_API OAES_RET oaes_gcm_encrypt( OAES_CTX * ctx,
+		const uint8_t * iv, size_t iv_len,
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * m, size_t m_len, uint8_t * c,
+		uint8_t * tag, size_t tag_len );
+
+/**
+ * GCM decrypt c_len bytes of c into m and verify tag over them and aad
+ * returns OAES_RET_AUTH and zeroes m if the tag does not match
+ */
+OAES_API OAES_RET oaes_gcm_decrypt( OAES_CTX * ctx,
+		const uint8_t * iv, size_t iv_len,
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * c, size_t c_len, uint8_t * m,
+		const uint8_t * tag, size_t tag_len );
+
+/**
+ * AES-GCM-SIV of RFC 8452, the key set on ctx is the 128 or 256 bit key
+ * generating key, the message keys are derived from it for every nonce
+ * reusing a nonce only reveals whether the same message was encrypted
+ * under it, m and c may be the same buffer
+ * returns OAES_RET_ARG1 if ctx has a 192 bit key
+ */
+OAES_API OAES_RET oaes_gcm_siv_encrypt( OAES_CTX * ctx,
+		const uint8_t nonce[OAES_GCM_SIV_NONCE_SIZE],
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * m, size_t m_len, uint8_t * c,
+		uint8_t tag[OAES_BLOCK_SIZE] );
+
+/**
+ * returns OAES_RET_AUTH and zeroes m if the tag does not match
+ */
+OAES_API OAES_RET oaes_gcm_siv_decrypt( OAES_CTX * ctx,
+		const uint8_t nonce[OAES_GCM_SIV_NONCE_SIZE],
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * c, size_t c_len, uint8_t * m,
+		const uint8_t tag[OAES_BLOCK_SIZE] );
+
+// import an XTS key of 32, 48 or 64 bytes, the first half is the data key
+// and becomes the key of ctx, the second half is the tweak key
+OAES_API OAES_RET oaes_xts_key_import_data( OAES_CTX * ctx,
+		const uint8_t * data, size_t data_len );
+
+/**
+ * XTS encrypt m_len / sector_len consecutive sectors from sector on, each
+ * on its own with the sector number as its tweak, m_len must be a multiple
+ * of sector_len, which runs from OAES_BLOCK_SIZE to 2^20 blocks, a
+ * sector_len that is not a multiple of OAES_BLOCK_SIZE is handled with
+ * ciphertext stealing, m and c may be the same buffer
+ * needs a key set with oaes_xts_key_import_data()
+ */
+OAES_API OAES_RET oaes_xts_encrypt( OAES_CTX * ctx, uint64_t sector,
+		size_t sector_len, const uint8_t * m, size_t m_len, uint8_t * c );
+
+OAES_API OAES_RET oaes_xts_decrypt( OAES_CTX * ctx, uint64_t sector,
+		size_t sector_len, const uint8_t * c, size_t c_len, uint8_t * m );
+
+/**
+ * OCB3 authenticated encryption of RFC 7253, nonce_len is 1 to 15 bytes and
+ * tag_len 1 to OAES_BLOCK_SIZE, the tag length goes into the computation so
+ * a shorter tag is not a prefix of a longer one, m and c may be the same
+ * buffer
+ */
+OAES_API OAES_RET oaes_ocb_encrypt( OAES_CTX * ctx,
+		const uint8_t * nonce, size_t nonce_len,
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * m, size_t m_len, uint8_t * c,
+		uint8_t * tag, size_t tag_len );
+
+// returns OAES_RET_AUTH and zeroes m if the tag does not match
+OAES_API OAES_RET oaes_ocb_decrypt( OAES_CTX * ctx,
+		const uint8_t * nonce, size_t nonce_len,
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * c, size_t c_len, uint8_t * m,
+		const uint8_t * tag, size_t tag_len );
+
+/**
+ * CCM authenticated encryption of NIST SP 800-38C, nonce_len is 7 to 13
+ * bytes, which leaves 15 - nonce_len bytes for the length of m, tag_len is
+ * 4 to 16 and even, m and c may be the same buffer
+ */
+OAES_API OAES_RET oaes_ccm_encrypt( OAES_CTX * ctx,
+		const uint8_t * nonce, size_t nonce_len,
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * m, size_t m_len, uint8_t * c,
+		uint8_t * tag, size_t tag_len );
+
+// returns OAES_RET_AUTH and zeroes m if the tag does not match
+OAES_API OAES_RET oaes_ccm_decrypt( OAES_CTX * ctx,
+		const uint8_t * nonce, size_t nonce_len,
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * c, size_t c_len, uint8_t * m,
+		const uint8_t * tag, size_t tag_len );
+
+/**
+ * start a CCM message of len bytes on ctx, to be passed in pieces of any
+ * size to oaes_ccm_encrypt_update() or oaes_ccm_decrypt_update(), and
+ * finished with the matching final call, a new start drops the message
+ * in progress
+ */
+OAES_API OAES_RET oaes_ccm_start( OAES_CTX * ctx,
+		const uint8_t * nonce, size_t nonce_len,
+		const uint8_t * aad, size_t aad_len,
+		size_t len, size_t tag_len );
+
+// returns OAES_RET_ARG3 past the len given to oaes_ccm_start()
+OAES_API OAES_RET oaes_ccm_encrypt_update( OAES_CTX * ctx,
+		const uint8_t * m, size_t m_len, uint8_t * c );
+
+OAES_API OAES_RET oaes_ccm_decrypt_update( OAES_CTX * ctx,
+		const uint8_t * c, size_t c_len, uint8_t * m );
+
+// writes the tag of tag_len bytes, returns OAES_RET_ERROR until the whole
+// message is in
+OAES_API OAES_RET oaes_ccm_encrypt_final( OAES_CTX * ctx, uint8_t * tag );
+
+/**
+ * returns OAES_RET_AUTH if the tag does not match, the plaintext is out by
+ * then, so the caller has to drop it
+ */
+OAES_API OAES_RET oaes_ccm_decrypt_final( OAES_CTX * ctx, const uint8_t * tag );
+
+/**
+ * start a CFB stream on ctx with segment_bits of 128 or 8, the stream is
+ * passed in pieces of any size to oaes_cfb_encrypt() or oaes_cfb_decrypt(),
+ * ctx keeps the place in the keystream in between, nothing is padded
+ * a new start drops the stream in progress, CFB and OFB share it
+ */
+OAES_API OAES_RET oaes_cfb_start( OAES_CTX * ctx,
+		const uint8_t iv[OAES_BLOCK_SIZE], size_t segment_bits );
+
+// m and c may be the same buffer
+OAES_API OAES_RET oaes_cfb_encrypt( OAES_CTX * ctx,
+		const uint8_t * m, size_t m_len, uint8_t * c );
+
+// decryption is not chained, so whole blocks run in batches
+OAES_API OAES_RET oaes_cfb_decrypt( OAES_CTX * ctx,
+		const uint8_t * c, size_t c_len, uint8_t * m );
+
+// start an OFB stream on ctx, see oaes_cfb_start()
+OAES_API OAES_RET oaes_ofb_start( OAES_CTX * ctx,
+		const uint8_t iv[OAES_BLOCK_SIZE] );
+
+// OFB encrypt or decrypt the next len bytes, in and out may be the same
+// buffer
+OAES_API OAES_RET oaes_ofb_crypt( OAES_CTX * ctx,
+		const uint8_t * in, size_t len, uint8_t * out );
+
+/**
+ * write the next len bytes of OFB keystream to ks and move the stream past
+ * them, to be xored in later, keystream can be computed ahead of the data
+ * this way, before it arrives
+ */
+OAES_API OAES_RET oaes_ofb_keystream( OAES_CTX * ctx,
+		uint8_t * ks, size_t len );
+
+/**
+ * CBC encrypt with ciphertext stealing in the CS3 form of the SP 800-38A
+ * addendum, c is exactly m_len bytes for any m_len of OAES_BLOCK_SIZE or
+ * more, the last two blocks are always swapped and the final one cut to
+ * the length of the plaintext tail, nothing is padded and there is no pad
+ * flag to keep, m and c may be the same buffer
+ */
+OAES_API OAES_RET oaes_cbc_cs3_encrypt( OAES_CTX * ctx,
+		const uint8_t iv[OAES_BLOCK_SIZE], const uint8_t * m, size_t m_len,
+		uint8_t * c );
+
+// the blocks ahead of the last two decrypt in batches
+OAES_API OAES_RET oaes_cbc_cs3_decrypt( OAES_CTX * ctx,
+		const uint8_t iv[OAES_BLOCK_SIZE], const uint8_t * c, size_t c_len,
+		uint8_t * m );
+
+// AES-CMAC of SP 800-38B, a shorter tag is a prefix of tag
+OAES_API OAES_RET oaes_cmac( OAES_CTX * ctx,
+		const uint8_t * m, size_t m_len, uint8_t tag[OAES_BLOCK_SIZE] );
+
+/**
+ * AES-CMAC of count independent messages m[i] of m_len[i] bytes, the tag
+ * of m[i] is written to tags + i * OAES_BLOCK_SIZE, the messages run side
+ * by side through the block kernel, so many short messages go at the
+ * throughput of the engine rather than its latency
+ */
+OAES_API OAES_RET oaes_cmac_batch( OAES_CTX * ctx,
+		const uint8_t * const * m, const size_t * m_len, size_t count,
+		uint8_t * tags );
+
+/**
+ * AES key wrap, KW of RFC 3394, m_len is a multiple of 8 of 16 or more and
+ * c takes m_len + 8 bytes, set c == NULL to get the required c_len
+ */
+OAES_API OAES_RET oaes_kw_wrap_key( OAES_CTX * ctx,
+		const uint8_t * m, size_t m_len, uint8_t * c, size_t * c_len );
+
+/**
+ * returns OAES_RET_AUTH if the wrapped key does not check out, m is zeroed
+ * then, set m == NULL to get the required m_len
+ */
+OAES_API OAES_RET oaes_kw_unwrap_key( OAES_CTX * ctx,
+		const uint8_t * c, size_t c_len, uint8_t * m, size_t * m_len );
+
+/**
+ * AES key wrap with padding, KWP of RFC 5649, for any m_len from 1 to
+ * 2^32 - 1, c takes m_len rounded up to a multiple of 8, plus 8
+ */
+OAES_API OAES_RET oaes_kwp_wrap_key( OAES_CTX * ctx,
+		const uint8_t * m, size_t m_len, uint8_t * c, size_t * c_len );
+
+/**
+ * m has to take c_len - 8 bytes, m_len is set to the length of the key
+ * once the padding has been checked
+ */
+OAES_API OAES_RET oaes_kwp_unwrap_key( OAES_CTX * ctx,
+		const uint8_t * c, size_t c_len, uint8_t * m, size_t * m_len );
+
+/**
+ * KW, or KWP when padded is set, wrap count keys m[i] of m_len[i] bytes to
+ * c[i], each sized as for oaes_kw_wrap_key() or oaes_kwp_wrap_key(), the
+ * keys run side by side through the block kernel, a key may be wrapped
+ * in place at c[i] + 8
+ */
+OAES_API OAES_RET oaes_kw_wrap_batch( OAES_CTX * ctx, int padded,
+		const uint8_t * const * m, const size_t * m_len, size_t count,
+		uint8_t * const * c );
+
+/**
+ * unwrap count keys c[i] of c_len[i] bytes to m[i], which takes
+ * c_len[i] - 8 bytes, m_len[i] gets the length of each key and rc[i]
+ * OAES_RET_AUTH if it does not check out, in which case m[i] is zeroed,
+ * returns OAES_RET_AUTH if any key fails
+ */
+OAES_API OAES_RET oaes_kw_unwrap_batch( OAES_CTX * ctx, int padded,
+		const uint8_t * const * c, const size_t * c_len, size_t count,
+		uint8_t * const * m, size_t * m_len, OAES_RET * rc );
+
+/**
+ * Poly1305-AES one-time MAC, with the key of ctx as k, r the 16 byte
+ * Poly1305 key, clamped here, and nonce enciphered into s, a k and r pair
+ * must never MAC two messages under the same nonce
+ */
+OAES_API OAES_RET oaes_poly1305_aes( OAES_CTX * ctx,
+		const uint8_t r[OAES_BLOCK_SIZE], const uint8_t nonce[OAES_BLOCK_SIZE],
+		const uint8_t * m, size_t m_len, uint8_t tag[OAES_BLOCK_SIZE] );
+
+/**
+ * start a Poly1305-AES message on ctx, passed in pieces of any size to
+ * oaes_poly1305_update(), oaes_poly1305_final() writes the tag and ends it
+ */
+OAES_API OAES_RET oaes_poly1305_start( OAES_CTX * ctx,
+		const uint8_t r[OAES_BLOCK_SIZE], const uint8_t nonce[OAES_BLOCK_SIZE] );
+
+OAES_API OAES_RET oaes_poly1305_update( OAES_CTX * ctx,
+		const uint8_t * m, size_t m_len );
+
+OAES_API OAES_RET oaes_poly1305_final( OAES_CTX * ctx,
+		uint8_t tag[OAES_BLOCK_SIZE] );
+
+/**
+ * encrypt then MAC, m is encrypted into c with oaes_encrypt() in the CBC or
+ * CTR mode set on ctx, a few KB at a time, each piece MACed right after it
+ * is encrypted, the tag is the Poly1305-AES of iv and c, c is as long as
+ * m, which for CBC has to be a multiple of OAES_BLOCK_SIZE, iv moves on as
+ * it does for oaes_encrypt()
+ */
+OAES_API OAES_RET oaes_poly1305_encrypt( OAES_CTX * ctx,
+		const uint8_t r[OAES_BLOCK_SIZE], const uint8_t nonce[OAES_BLOCK_SIZE],
+		uint8_t iv[OAES_BLOCK_SIZE], const uint8_t * m, size_t m_len,
+		uint8_t * c, uint8_t tag[OAES_BLOCK_SIZE] );
+
+/**
+ * returns OAES_RET_AUTH if the tag does not match, m is zeroed then, m and c
+ * may not be the same buffer
+ */
+OAES_API OAES_RET oaes_poly1305_decrypt( OAES_CTX * ctx,
+		const uint8_t r[OAES_BLOCK_SIZE], const uint8_t nonce[OAES_BLOCK_SIZE],
+		uint8_t iv[OAES_BLOCK_SIZE], const uint8_t * c, size_t c_len,
+		uint8_t * m, const uint8_t tag[OAES_BLOCK_SIZE] );
+
+/**
+ * FF1 format preserving encryption of SP 800-38G, x is len numerals, each
+ * below radix, most significant first, y gets len numerals in the same
+ * radix, radix runs from 2 to 65536 and len from 2 to 64, with radix^len
+ * at least a million, x and y may be the same buffer
+ */
+OAES_API OAES_RET oaes_ff1_encrypt( OAES_CTX * ctx, uint32_t radix,
+		const uint8_t * tweak, size_t tweak_len,
+		const uint16_t * x, size_t len, uint16_t * y );
+
+OAES_API OAES_RET oaes_ff1_decrypt( OAES_CTX * ctx, uint32_t radix,
+		const uint8_t * tweak, size_t tweak_len,
+		const uint16_t * y, size_t len, uint16_t * x );
+
+/**
+ * FF1 encrypt count values of len numerals each, one after the other in x,
+ * all under the same tweak, the values go through the Feistel rounds
+ * together, so the CBC-MAC of a round runs side by side for all of them
+ */
+OAES_API OAES_RET oaes_ff1_encrypt_batch( OAES_CTX * ctx, uint32_t radix,
+		const uint8_t * tweak, size_t tweak_len,
+		const uint16_t * x, size_t len, size_t count, uint16_t * y );
+
+OAES_API OAES_RET oaes_ff1_decrypt_batch( OAES_CTX * ctx, uint32_t radix,
+		const uint8_t * tweak, size_t tweak_len,
+		const uint16_t * y, size_t len, size_t count, uint16_t * x );
+
+/**
+ * a fast keyed hash for hash tables and sharding, not a MAC, of one AES
+ * round per 16 bytes of m in 4 lanes, seeded with blocks enciphered under
+ * the key of ctx, AESENC on the aesni engine and a T-table round on the
+ * others, hash_len is 8 or 16, m of up to 16 bytes takes 4 rounds in all
+ */
+OAES_API OAES_RET oaes_round_hash( OAES_CTX * ctx,
+		const uint8_t * m, size_t m_len, uint8_t * hash, size_t hash_len );
+
+/**
+ * start a round hash on ctx, passed in pieces of any size to
+ * oaes_round_hash_update(), oaes_round_hash_final() writes the hash of
+ * all of them, the same as oaes_round_hash() of the whole, and ends it
+ */
+OAES_API OAES_RET oaes_round_hash_start( OAES_CTX * ctx );
+
+OAES_API OAES_RET oaes_round_hash_update( OAES_CTX * ctx,
+		const uint8_t * m, size_t m_len );
+
+OAES_API OAES_RET oaes_round_hash_final( OAES_CTX * ctx,
+		uint8_t * hash, size_t hash_len );
+
 // set buf == NULL to get the required buf_len
 OAES_API OAES_RET oaes_sprintf(
 		char * buf, size_t * buf_len, const uint8_t * data, size_t data_len );
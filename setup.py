@@ -11,8 +11,12 @@ kw = {
 			include_dirs = ['inc', 'src/isaac'],
 			# define_macros=[('ENABLE_PYTHON', '1')],
 			sources = [
+				os.path.join('src/oaes_aesni.c'),
+				os.path.join('src/oaes_bitslice.c'),
 				os.path.join('src/oaes_lib.c'),
+				os.path.join('src/oaes_pclmul.c'),
 				os.path.join('src/oaes_py.c'),
+				os.path.join('src/oaes_vperm.c'),
 				os.path.join('src/isaac/rand.c')
 			]
 		)
@@ -0,0 +1,460 @@
+/* 
+ * ---------------------------------------------------------------------------
+ * OpenAES License
+ * ---------------------------------------------------------------------------
+ * Copyright (c) 2013, Nabil S. Al Ramli, www.nalramli.com
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ *   - Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   - Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * ---------------------------------------------------------------------------
+ */
+static const char _NR[] = {
+	0x4e,0x61,0x62,0x69,0x6c,0x20,0x53,0x2e,0x20,
+	0x41,0x6c,0x20,0x52,0x61,0x6d,0x6c,0x69,0x00 };
+
+#include <string.h>
+
+#include "oaes_config.h"
+#include "oaes_engine.h"
+
+#if OAES_HAVE_AESNI
+
+#include <emmintrin.h>
+#include <wmmintrin.h>
+
+// let gcc and clang emit AES-NI here without building the rest with -maes,
+// oaes_lib.c only calls in when oaes_cpu_features() has OAES_CPU_AESNI
+#if defined(__GNUC__) && !defined(__AES__)
+#define OAES_TARGET_AESNI __attribute__((target("aes,sse2")))
+#else
+#define OAES_TARGET_AESNI
+#endif
+
+static const uint8_t oaes_aesni_rcon[] = {
+	0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36 };
+
+// returns SubWord( RotWord( w ) ) when rot is set, SubWord( w ) otherwise
+OAES_TARGET_AESNI
+static uint32_t oaes_aesni_sub_word( uint32_t w, int rot )
+{
+	// AESKEYGENASSIST with a zero rcon leaves SubWord(X1) in dword 0 and
+	// RotWord(SubWord(X1)) in dword 1
+	__m128i _x = _mm_aeskeygenassist_si128(
+			_mm_shuffle_epi32( _mm_cvtsi32_si128( (int) w ), 0x00 ), 0x00 );
+
+	if( rot )
+		_x = _mm_shuffle_epi32( _x, 0x55 );
+
+	return (uint32_t) _mm_cvtsi128_si32( _x );
+}
+
+// k with each of its words xored into the ones above it, then t added,
+// for the round keys that follow k
+OAES_TARGET_AESNI
+static __m128i oaes_aesni_key_step( __m128i k, __m128i t )
+{
+	k = _mm_xor_si128( k, _mm_slli_si128( k, 4 ) );
+	k = _mm_xor_si128( k, _mm_slli_si128( k, 8 ) );
+
+	return _mm_xor_si128( k, t );
+}
+
+// the next AES-128 round key after _k, AESKEYGENASSIST takes rcon as an
+// immediate
+#define OAES_AESNI_KEY_128( rcon ) \
+	_k = oaes_aesni_key_step( _k, _mm_shuffle_epi32( \
+			_mm_aeskeygenassist_si128( _k, rcon ), 0xff ) ); \
+	_mm_store_si128( _rk++, _k );
+
+// the next two AES-256 round keys after _k and _k2
+#define OAES_AESNI_KEY_256( rcon ) \
+	_k = oaes_aesni_key_step( _k, _mm_shuffle_epi32( \
+			_mm_aeskeygenassist_si128( _k2, rcon ), 0xff ) ); \
+	_mm_store_si128( _rk++, _k ); \
+	_k2 = oaes_aesni_key_step( _k2, _mm_shuffle_epi32( \
+			_mm_aeskeygenassist_si128( _k, 0x00 ), 0xaa ) ); \
+	_mm_store_si128( _rk++, _k2 );
+
+// a whole round key per AESKEYGENASSIST where the key fills whole round
+// keys, returns 0 for a 192 bit key
+OAES_TARGET_AESNI
+static int oaes_aesni_key_expand_fast( const uint8_t * key, size_t key_len,
+		uint8_t * exp_data )
+{
+	__m128i * _rk = (__m128i *) exp_data;
+	__m128i _k = _mm_loadu_si128( (const __m128i *) key ), _k2;
+
+	_mm_store_si128( _rk++, _k );
+
+	if( 16 == key_len )
+	{
+		OAES_AESNI_KEY_128( 0x01 ) OAES_AESNI_KEY_128( 0x02 )
+		OAES_AESNI_KEY_128( 0x04 ) OAES_AESNI_KEY_128( 0x08 )
+		OAES_AESNI_KEY_128( 0x10 ) OAES_AESNI_KEY_128( 0x20 )
+		OAES_AESNI_KEY_128( 0x40 ) OAES_AESNI_KEY_128( 0x80 )
+		OAES_AESNI_KEY_128( 0x1b ) OAES_AESNI_KEY_128( 0x36 )
+		return 1;
+	}
+
+	if( 32 == key_len )
+	{
+		_k2 = _mm_loadu_si128( (const __m128i *) key + 1 );
+		_mm_store_si128( _rk++, _k2 );
+		OAES_AESNI_KEY_256( 0x01 ) OAES_AESNI_KEY_256( 0x02 )
+		OAES_AESNI_KEY_256( 0x04 ) OAES_AESNI_KEY_256( 0x08 )
+		OAES_AESNI_KEY_256( 0x10 ) OAES_AESNI_KEY_256( 0x20 )
+		// the last round key is the first half of a pair
+		_k = oaes_aesni_key_step( _k, _mm_shuffle_epi32(
+				_mm_aeskeygenassist_si128( _k2, 0x40 ), 0xff ) );
+		_mm_store_si128( _rk, _k );
+		return 1;
+	}
+
+	return 0;
+}
+
+OAES_TARGET_AESNI
+void oaes_aesni_key_expand( const uint8_t * key, size_t key_len,
+		uint8_t * exp_data, uint8_t * dec_data, size_t num_keys )
+{
+	size_t _i, _key_base = key_len / 4;
+	uint32_t _temp, _prev;
+	__m128i * _dk = (__m128i *) dec_data;
+	const __m128i * _rk = (const __m128i *) exp_data;
+
+	// the first key_len bytes are a direct copy
+	memcpy( exp_data, key, key_len );
+
+	for( _i = oaes_aesni_key_expand_fast( key, key_len, exp_data ) ?
+			num_keys * 4 : _key_base; _i < num_keys * 4; _i++ )
+	{
+		memcpy( &_temp, exp_data + ( _i - 1 ) * 4, 4 );
+
+		// transform key column
+		if( 0 == _i % _key_base )
+			_temp = oaes_aesni_sub_word( _temp, 1 ) ^
+					oaes_aesni_rcon[ _i / _key_base - 1 ];
+		else if( _key_base > 6 && 4 == _i % _key_base )
+			_temp = oaes_aesni_sub_word( _temp, 0 );
+
+		memcpy( &_prev, exp_data + ( _i - _key_base ) * 4, 4 );
+		_temp ^= _prev;
+		memcpy( exp_data + _i * 4, &_temp, 4 );
+	}
+
+	// AESDEC wants the middle round keys passed through InvMixColumns
+	_mm_store_si128( _dk, _mm_load_si128( _rk ) );
+	for( _i = 1; _i < num_keys - 1; _i++ )
+		_mm_store_si128( _dk + _i, _mm_aesimc_si128( _mm_load_si128( _rk + _i ) ) );
+	_mm_store_si128( _dk + _i, _mm_load_si128( _rk + _i ) );
+}
+
+OAES_TARGET_AESNI
+void oaes_aesni_encrypt( const uint8_t * exp_data, size_t num_keys,
+		uint8_t c[OAES_BLOCK_SIZE] )
+{
+	size_t _i;
+	const __m128i * _rk = (const __m128i *) exp_data;
+	__m128i _s = _mm_loadu_si128( (const __m128i *) c );
+
+	_s = _mm_xor_si128( _s, _mm_load_si128( _rk ) );
+	for( _i = 1; _i < num_keys - 1; _i++ )
+		_s = _mm_aesenc_si128( _s, _mm_load_si128( _rk + _i ) );
+	_s = _mm_aesenclast_si128( _s, _mm_load_si128( _rk + _i ) );
+
+	_mm_storeu_si128( (__m128i *) c, _s );
+}
+
+OAES_TARGET_AESNI
+void oaes_aesni_decrypt( const uint8_t * dec_data, size_t num_keys,
+		uint8_t c[OAES_BLOCK_SIZE] )
+{
+	size_t _i;
+	const __m128i * _dk = (const __m128i *) dec_data;
+	__m128i _s = _mm_loadu_si128( (const __m128i *) c );
+
+	_s = _mm_xor_si128( _s, _mm_load_si128( _dk + num_keys - 1 ) );
+	for( _i = num_keys - 2; _i > 0; _i-- )
+		_s = _mm_aesdec_si128( _s, _mm_load_si128( _dk + _i ) );
+	_s = _mm_aesdeclast_si128( _s, _mm_load_si128( _dk ) );
+
+	_mm_storeu_si128( (__m128i *) c, _s );
+}
+
+#define OAES_AESNI_LOAD8( c, k ) \
+	do { \
+		_s0 = _mm_xor_si128( _mm_loadu_si128( (const __m128i *) (c) ), k ); \
+		_s1 = _mm_xor_si128( _mm_loadu_si128( (const __m128i *) (c) + 1 ), k ); \
+		_s2 = _mm_xor_si128( _mm_loadu_si128( (const __m128i *) (c) + 2 ), k ); \
+		_s3 = _mm_xor_si128( _mm_loadu_si128( (const __m128i *) (c) + 3 ), k ); \
+		_s4 = _mm_xor_si128( _mm_loadu_si128( (const __m128i *) (c) + 4 ), k ); \
+		_s5 = _mm_xor_si128( _mm_loadu_si128( (const __m128i *) (c) + 5 ), k ); \
+		_s6 = _mm_xor_si128( _mm_loadu_si128( (const __m128i *) (c) + 6 ), k ); \
+		_s7 = _mm_xor_si128( _mm_loadu_si128( (const __m128i *) (c) + 7 ), k ); \
+	} while( 0 )
+
+#define OAES_AESNI_ROUND8( op, k ) \
+	do { \
+		_s0 = op( _s0, k ); \
+		_s1 = op( _s1, k ); \
+		_s2 = op( _s2, k ); \
+		_s3 = op( _s3, k ); \
+		_s4 = op( _s4, k ); \
+		_s5 = op( _s5, k ); \
+		_s6 = op( _s6, k ); \
+		_s7 = op( _s7, k ); \
+	} while( 0 )
+
+#define OAES_AESNI_STORE8( c ) \
+	do { \
+		_mm_storeu_si128( (__m128i *) (c), _s0 ); \
+		_mm_storeu_si128( (__m128i *) (c) + 1, _s1 ); \
+		_mm_storeu_si128( (__m128i *) (c) + 2, _s2 ); \
+		_mm_storeu_si128( (__m128i *) (c) + 3, _s3 ); \
+		_mm_storeu_si128( (__m128i *) (c) + 4, _s4 ); \
+		_mm_storeu_si128( (__m128i *) (c) + 5, _s5 ); \
+		_mm_storeu_si128( (__m128i *) (c) + 6, _s6 ); \
+		_mm_storeu_si128( (__m128i *) (c) + 7, _s7 ); \
+	} while( 0 )
+
+OAES_TARGET_AESNI
+void oaes_aesni_encrypt_blocks( const uint8_t * exp_data, size_t num_keys,
+		uint8_t * c, size_t count )
+{
+	size_t _i;
+	const __m128i * _rk = (const __m128i *) exp_data;
+	__m128i _s0, _s1, _s2, _s3, _s4, _s5, _s6, _s7, _k;
+
+	for( ; count >= 8; count -= 8, c += 8 * OAES_BLOCK_SIZE )
+	{
+		_k = _mm_load_si128( _rk );
+		OAES_AESNI_LOAD8( c, _k );
+		for( _i = 1; _i < num_keys - 1; _i++ )
+		{
+			_k = _mm_load_si128( _rk + _i );
+			OAES_AESNI_ROUND8( _mm_aesenc_si128, _k );
+		}
+		_k = _mm_load_si128( _rk + _i );
+		OAES_AESNI_ROUND8( _mm_aesenclast_si128, _k );
+		OAES_AESNI_STORE8( c );
+	}
+
+	for( ; count; count--, c += OAES_BLOCK_SIZE )
+		oaes_aesni_encrypt( exp_data, num_keys, c );
+}
+
+OAES_TARGET_AESNI
+void oaes_aesni_decrypt_blocks( const uint8_t * dec_data, size_t num_keys,
+		uint8_t * c, size_t count )
+{
+	size_t _i;
+	const __m128i * _dk = (const __m128i *) dec_data;
+	__m128i _s0, _s1, _s2, _s3, _s4, _s5, _s6, _s7, _k;
+
+	for( ; count >= 8; count -= 8, c += 8 * OAES_BLOCK_SIZE )
+	{
+		_k = _mm_load_si128( _dk + num_keys - 1 );
+		OAES_AESNI_LOAD8( c, _k );
+		for( _i = num_keys - 2; _i > 0; _i-- )
+		{
+			_k = _mm_load_si128( _dk + _i );
+			OAES_AESNI_ROUND8( _mm_aesdec_si128, _k );
+		}
+		_k = _mm_load_si128( _dk );
+		OAES_AESNI_ROUND8( _mm_aesdeclast_si128, _k );
+		OAES_AESNI_STORE8( c );
+	}
+
+	for( ; count; count--, c += OAES_BLOCK_SIZE )
+		oaes_aesni_decrypt( dec_data, num_keys, c );
+}
+
+#define OAES_AESNI_ENC( n ) \
+	_s = _mm_aesenc_si128( _s, _mm_load_si128( _rk + n ) );
+#define OAES_AESNI_DEC( n ) \
+	_s = _mm_aesdec_si128( _s, _mm_load_si128( _dk + n ) );
+#define OAES_AESNI_ENC8( n ) \
+	_k = _mm_load_si128( _rk + n ); \
+	OAES_AESNI_ROUND8( _mm_aesenc_si128, _k );
+#define OAES_AESNI_DEC8( n ) \
+	_k = _mm_load_si128( _dk + n ); \
+	OAES_AESNI_ROUND8( _mm_aesdec_si128, _k );
+
+#define OAES_AESNI_UNROLLED( nr, rounds, rounds_down ) \
+OAES_TARGET_AESNI \
+void oaes_aesni_encrypt_##nr( const uint8_t * exp_data, \
+		uint8_t c[OAES_BLOCK_SIZE] ) \
+{ \
+	const __m128i * _rk = (const __m128i *) exp_data; \
+	__m128i _s = _mm_loadu_si128( (const __m128i *) c ); \
+\
+	_s = _mm_xor_si128( _s, _mm_load_si128( _rk ) ); \
+	rounds( OAES_AESNI_ENC ) \
+	_s = _mm_aesenclast_si128( _s, _mm_load_si128( _rk + nr ) ); \
+\
+	_mm_storeu_si128( (__m128i *) c, _s ); \
+} \
+\
+OAES_TARGET_AESNI \
+void oaes_aesni_decrypt_##nr( const uint8_t * dec_data, \
+		uint8_t c[OAES_BLOCK_SIZE] ) \
+{ \
+	const __m128i * _dk = (const __m128i *) dec_data; \
+	__m128i _s = _mm_loadu_si128( (const __m128i *) c ); \
+\
+	_s = _mm_xor_si128( _s, _mm_load_si128( _dk + nr ) ); \
+	rounds_down( OAES_AESNI_DEC ) \
+	_s = _mm_aesdeclast_si128( _s, _mm_load_si128( _dk ) ); \
+\
+	_mm_storeu_si128( (__m128i *) c, _s ); \
+} \
+\
+OAES_TARGET_AESNI \
+void oaes_aesni_encrypt_blocks_##nr( const uint8_t * exp_data, \
+		uint8_t * c, size_t count ) \
+{ \
+	const __m128i * _rk = (const __m128i *) exp_data; \
+	__m128i _s0, _s1, _s2, _s3, _s4, _s5, _s6, _s7, _k; \
+\
+	for( ; count >= 8; count -= 8, c += 8 * OAES_BLOCK_SIZE ) \
+	{ \
+		_k = _mm_load_si128( _rk ); \
+		OAES_AESNI_LOAD8( c, _k ); \
+		rounds( OAES_AESNI_ENC8 ) \
+		_k = _mm_load_si128( _rk + nr ); \
+		OAES_AESNI_ROUND8( _mm_aesenclast_si128, _k ); \
+		OAES_AESNI_STORE8( c ); \
+	} \
+\
+	for( ; count; count--, c += OAES_BLOCK_SIZE ) \
+		oaes_aesni_encrypt_##nr( exp_data, c ); \
+} \
+\
+OAES_TARGET_AESNI \
+void oaes_aesni_decrypt_blocks_##nr( const uint8_t * dec_data, \
+		uint8_t * c, size_t count ) \
+{ \
+	const __m128i * _dk = (const __m128i *) dec_data; \
+	__m128i _s0, _s1, _s2, _s3, _s4, _s5, _s6, _s7, _k; \
+\
+	for( ; count >= 8; count -= 8, c += 8 * OAES_BLOCK_SIZE ) \
+	{ \
+		_k = _mm_load_si128( _dk + nr ); \
+		OAES_AESNI_LOAD8( c, _k ); \
+		rounds_down( OAES_AESNI_DEC8 ) \
+		_k = _mm_load_si128( _dk ); \
+		OAES_AESNI_ROUND8( _mm_aesdeclast_si128, _k ); \
+		OAES_AESNI_STORE8( c ); \
+	} \
+\
+	for( ; count; count--, c += OAES_BLOCK_SIZE ) \
+		oaes_aesni_decrypt_##nr( dec_data, c ); \
+}
+
+OAES_AESNI_UNROLLED( 10, OAES_ROUNDS_9, OAES_ROUNDS_9_DOWN )
+OAES_AESNI_UNROLLED( 12, OAES_ROUNDS_11, OAES_ROUNDS_11_DOWN )
+OAES_AESNI_UNROLLED( 14, OAES_ROUNDS_13, OAES_ROUNDS_13_DOWN )
+
+OAES_TARGET_AESNI
+void oaes_aesni_hash_short( uint8_t s[OAES_BLOCK_SIZE], const uint8_t * keys,
+		uint64_t len )
+{
+	const __m128i * _k = (const __m128i *) keys;
+	__m128i _s = _mm_loadu_si128( (const __m128i *) s );
+
+	// seed 0 and 1, then the last 3 key blocks, the first with len in it
+	_s = _mm_xor_si128( _s, _mm_load_si128( _k ) );
+	_s = _mm_aesenc_si128( _s, _mm_load_si128( _k + 1 ) );
+	_s = _mm_aesenc_si128( _s, _mm_xor_si128( _mm_load_si128( _k + 4 ),
+			_mm_set_epi32( 0, 0, (int) ( len >> 32 ), (int) len ) ) );
+	_s = _mm_aesenc_si128( _s, _mm_load_si128( _k + 5 ) );
+	_s = _mm_aesenc_si128( _s, _mm_load_si128( _k + 6 ) );
+
+	_mm_storeu_si128( (__m128i *) s, _s );
+}
+
+OAES_TARGET_AESNI
+void oaes_aesni_hash_close( const uint8_t * lanes, const uint8_t * sum,
+		const uint8_t * tail, size_t blocks, const uint8_t * keys,
+		uint64_t len, uint8_t s[OAES_BLOCK_SIZE] )
+{
+	size_t _i;
+	const __m128i * _k = (const __m128i *) keys;
+	__m128i _l[4], _m, _s;
+	__m128i _sum = _mm_loadu_si128( (const __m128i *) sum );
+
+	for( _i = 0; _i < 4; _i++ )
+		_l[_i] = _mm_loadu_si128( (const __m128i *) lanes + _i );
+	for( _i = 0; _i < blocks; _i++ )
+	{
+		_m = _mm_loadu_si128( (const __m128i *) tail + _i );
+		_l[_i] = _mm_aesenc_si128( _l[_i], _m );
+		_sum = _mm_add_epi64( _sum, _m );
+	}
+
+	_s = _mm_aesenc_si128( _l[0], _l[1] );
+	_s = _mm_aesenc_si128( _s, _l[2] );
+	_s = _mm_aesenc_si128( _s, _l[3] );
+	_s = _mm_aesenc_si128( _s, _sum );
+	_s = _mm_aesenc_si128( _s, _mm_xor_si128( _mm_load_si128( _k + 4 ),
+			_mm_set_epi32( 0, 0, (int) ( len >> 32 ), (int) len ) ) );
+	_s = _mm_aesenc_si128( _s, _mm_load_si128( _k + 5 ) );
+	_s = _mm_aesenc_si128( _s, _mm_load_si128( _k + 6 ) );
+
+	_mm_storeu_si128( (__m128i *) s, _s );
+}
+
+OAES_TARGET_AESNI
+void oaes_aesni_hash_stripes( uint8_t * lanes, const uint8_t * m,
+		size_t count )
+{
+	__m128i * _l = (__m128i *) lanes;
+	__m128i _s0 = _mm_loadu_si128( _l );
+	__m128i _s1 = _mm_loadu_si128( _l + 1 );
+	__m128i _s2 = _mm_loadu_si128( _l + 2 );
+	__m128i _s3 = _mm_loadu_si128( _l + 3 );
+	__m128i _sum = _mm_loadu_si128( _l + 4 );
+	__m128i _m0, _m1, _m2, _m3;
+
+	// the lanes do not wait on each other, so 4 AESENC are in flight
+	for( ; count; count--, m += 4 * OAES_BLOCK_SIZE )
+	{
+		_m0 = _mm_loadu_si128( (const __m128i *) m );
+		_m1 = _mm_loadu_si128( (const __m128i *) m + 1 );
+		_m2 = _mm_loadu_si128( (const __m128i *) m + 2 );
+		_m3 = _mm_loadu_si128( (const __m128i *) m + 3 );
+		_s0 = _mm_aesenc_si128( _s0, _m0 );
+		_s1 = _mm_aesenc_si128( _s1, _m1 );
+		_s2 = _mm_aesenc_si128( _s2, _m2 );
+		_s3 = _mm_aesenc_si128( _s3, _m3 );
+		_sum = _mm_add_epi64( _sum, _mm_add_epi64(
+				_mm_add_epi64( _m0, _m1 ), _mm_add_epi64( _m2, _m3 ) ) );
+	}
+
+	_mm_storeu_si128( _l, _s0 );
+	_mm_storeu_si128( _l + 1, _s1 );
+	_mm_storeu_si128( _l + 2, _s2 );
+	_mm_storeu_si128( _l + 3, _s3 );
+	_mm_storeu_si128( _l + 4, _sum );
+}
+
+#endif // OAES_HAVE_AESNI
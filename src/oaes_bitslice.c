@@ -0,0 +1,573 @@
+/* 
+ * ---------------------------------------------------------------------------
+ * OpenAES License
+ * ---------------------------------------------------------------------------
+ * Copyright (c) 2013, Nabil S. Al Ramli, www.nalramli.com
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ *   - Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   - Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * ---------------------------------------------------------------------------
+ */
+static const char _NR[] = {
+	0x4e,0x61,0x62,0x69,0x6c,0x20,0x53,0x2e,0x20,
+	0x41,0x6c,0x20,0x52,0x61,0x6d,0x6c,0x69,0x00 };
+
+#include <string.h>
+
+#include "oaes_config.h"
+#include "oaes_engine.h"
+
+#if OAES_HAVE_BITSLICE
+
+#include <emmintrin.h>
+
+// 32-bit x86 builds do not have SSE2 enabled by default
+#if defined(__GNUC__) && !defined(__SSE2__)
+#define OAES_TARGET_SSE2 __attribute__((target("sse2")))
+#else
+#define OAES_TARGET_SSE2
+#endif
+
+/*
+ * bitsliced AES over 8 blocks at a time
+ * 
+ * the 8 blocks are split into two groups of 4, and each group is spread
+ * over 8 64-bit words so that word i holds bit i of all 64 state bytes,
+ * byte ( row r, column c ) of block j being at bit 16 * r + 4 * c + j.
+ * the two groups sit side by side in the 64-bit lanes of 8 SSE2 registers,
+ * so every step is plain boolean logic and shifts with no secret dependent
+ * memory access
+ * 
+ * SubBytes is the Boyar-Peralta circuit, ShiftRows is a mask and shift
+ * within each row, MixColumns is a rotation by rows
+ */
+
+#define OAES_BS_XOR( a, b ) _mm_xor_si128( a, b )
+#define OAES_BS_AND( a, b ) _mm_and_si128( a, b )
+#define OAES_BS_OR( a, b ) _mm_or_si128( a, b )
+#define OAES_BS_NOT( a ) _mm_xor_si128( a, _mm_set1_epi32( -1 ) )
+#define OAES_BS_MASK( m ) _mm_set1_epi64x( (long long) (m) )
+
+// rotate each 64-bit lane right by one row, and by two rows
+#define OAES_BS_ROTR16( x ) \
+	_mm_or_si128( _mm_srli_epi64( x, 16 ), _mm_slli_epi64( x, 48 ) )
+#define OAES_BS_ROTR32( x ) _mm_shuffle_epi32( x, 0xb1 )
+
+OAES_TARGET_SSE2
+static void oaes_bs_sbox( __m128i q[8] )
+{
+	__m128i x0, x1, x2, x3, x4, x5, x6, x7;
+	__m128i y1, y2, y3, y4, y5, y6, y7, y8, y9;
+	__m128i y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+	__m128i y20, y21;
+	__m128i z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+	__m128i z10, z11, z12, z13, z14, z15, z16, z17;
+	__m128i t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+	__m128i t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+	__m128i t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+	__m128i t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+	__m128i t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+	__m128i t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+	__m128i t60, t61, t62, t63, t64, t65, t66, t67;
+	__m128i s0, s1, s2, s3, s4, s5, s6, s7;
+
+	// the circuit numbers bits from the most significant one
+	x0 = q[7];
+	x1 = q[6];
+	x2 = q[5];
+	x3 = q[4];
+	x4 = q[3];
+	x5 = q[2];
+	x6 = q[1];
+	x7 = q[0];
+
+	// top linear transformation
+	y14 = OAES_BS_XOR( x3, x5 );
+	y13 = OAES_BS_XOR( x0, x6 );
+	y9 = OAES_BS_XOR( x0, x3 );
+	y8 = OAES_BS_XOR( x0, x5 );
+	t0 = OAES_BS_XOR( x1, x2 );
+	y1 = OAES_BS_XOR( t0, x7 );
+	y4 = OAES_BS_XOR( y1, x3 );
+	y12 = OAES_BS_XOR( y13, y14 );
+	y2 = OAES_BS_XOR( y1, x0 );
+	y5 = OAES_BS_XOR( y1, x6 );
+	y3 = OAES_BS_XOR( y5, y8 );
+	t1 = OAES_BS_XOR( x4, y12 );
+	y15 = OAES_BS_XOR( t1, x5 );
+	y20 = OAES_BS_XOR( t1, x1 );
+	y6 = OAES_BS_XOR( y15, x7 );
+	y10 = OAES_BS_XOR( y15, t0 );
+	y11 = OAES_BS_XOR( y20, y9 );
+	y7 = OAES_BS_XOR( x7, y11 );
+	y17 = OAES_BS_XOR( y10, y11 );
+	y19 = OAES_BS_XOR( y10, y8 );
+	y16 = OAES_BS_XOR( t0, y11 );
+	y21 = OAES_BS_XOR( y13, y16 );
+	y18 = OAES_BS_XOR( x0, y16 );
+
+	// non-linear section
+	t2 = OAES_BS_AND( y12, y15 );
+	t3 = OAES_BS_AND( y3, y6 );
+	t4 = OAES_BS_XOR( t3, t2 );
+	t5 = OAES_BS_AND( y4, x7 );
+	t6 = OAES_BS_XOR( t5, t2 );
+	t7 = OAES_BS_AND( y13, y16 );
+	t8 = OAES_BS_AND( y5, y1 );
+	t9 = OAES_BS_XOR( t8, t7 );
+	t10 = OAES_BS_AND( y2, y7 );
+	t11 = OAES_BS_XOR( t10, t7 );
+	t12 = OAES_BS_AND( y9, y11 );
+	t13 = OAES_BS_AND( y14, y17 );
+	t14 = OAES_BS_XOR( t13, t12 );
+	t15 = OAES_BS_AND( y8, y10 );
+	t16 = OAES_BS_XOR( t15, t12 );
+	t17 = OAES_BS_XOR( t4, t14 );
+	t18 = OAES_BS_XOR( t6, t16 );
+	t19 = OAES_BS_XOR( t9, t14 );
+	t20 = OAES_BS_XOR( t11, t16 );
+	t21 = OAES_BS_XOR( t17, y20 );
+	t22 = OAES_BS_XOR( t18, y19 );
+	t23 = OAES_BS_XOR( t19, y21 );
+	t24 = OAES_BS_XOR( t20, y18 );
+
+	t25 = OAES_BS_XOR( t21, t22 );
+	t26 = OAES_BS_AND( t21, t23 );
+	t27 = OAES_BS_XOR( t24, t26 );
+	t28 = OAES_BS_AND( t25, t27 );
+	t29 = OAES_BS_XOR( t28, t22 );
+	t30 = OAES_BS_XOR( t23, t24 );
+	t31 = OAES_BS_XOR( t22, t26 );
+	t32 = OAES_BS_AND( t31, t30 );
+	t33 = OAES_BS_XOR( t32, t24 );
+	t34 = OAES_BS_XOR( t23, t33 );
+	t35 = OAES_BS_XOR( t27, t33 );
+	t36 = OAES_BS_AND( t24, t35 );
+	t37 = OAES_BS_XOR( t36, t34 );
+	t38 = OAES_BS_XOR( t27, t36 );
+	t39 = OAES_BS_AND( t29, t38 );
+	t40 = OAES_BS_XOR( t25, t39 );
+
+	t41 = OAES_BS_XOR( t40, t37 );
+	t42 = OAES_BS_XOR( t29, t33 );
+	t43 = OAES_BS_XOR( t29, t40 );
+	t44 = OAES_BS_XOR( t33, t37 );
+	t45 = OAES_BS_XOR( t42, t41 );
+	z0 = OAES_BS_AND( t44, y15 );
+	z1 = OAES_BS_AND( t37, y6 );
+	z2 = OAES_BS_AND( t33, x7 );
+	z3 = OAES_BS_AND( t43, y16 );
+	z4 = OAES_BS_AND( t40, y1 );
+	z5 = OAES_BS_AND( t29, y7 );
+	z6 = OAES_BS_AND( t42, y11 );
+	z7 = OAES_BS_AND( t45, y17 );
+	z8 = OAES_BS_AND( t41, y10 );
+	z9 = OAES_BS_AND( t44, y12 );
+	z10 = OAES_BS_AND( t37, y3 );
+	z11 = OAES_BS_AND( t33, y4 );
+	z12 = OAES_BS_AND( t43, y13 );
+	z13 = OAES_BS_AND( t40, y5 );
+	z14 = OAES_BS_AND( t29, y2 );
+	z15 = OAES_BS_AND( t42, y9 );
+	z16 = OAES_BS_AND( t45, y14 );
+	z17 = OAES_BS_AND( t41, y8 );
+
+	// bottom linear transformation
+	t46 = OAES_BS_XOR( z15, z16 );
+	t47 = OAES_BS_XOR( z10, z11 );
+	t48 = OAES_BS_XOR( z5, z13 );
+	t49 = OAES_BS_XOR( z9, z10 );
+	t50 = OAES_BS_XOR( z2, z12 );
+	t51 = OAES_BS_XOR( z2, z5 );
+	t52 = OAES_BS_XOR( z7, z8 );
+	t53 = OAES_BS_XOR( z0, z3 );
+	t54 = OAES_BS_XOR( z6, z7 );
+	t55 = OAES_BS_XOR( z16, z17 );
+	t56 = OAES_BS_XOR( z12, t48 );
+	t57 = OAES_BS_XOR( t50, t53 );
+	t58 = OAES_BS_XOR( z4, t46 );
+	t59 = OAES_BS_XOR( z3, t54 );
+	t60 = OAES_BS_XOR( t46, t57 );
+	t61 = OAES_BS_XOR( z14, t57 );
+	t62 = OAES_BS_XOR( t52, t58 );
+	t63 = OAES_BS_XOR( t49, t58 );
+	t64 = OAES_BS_XOR( z4, t59 );
+	t65 = OAES_BS_XOR( t61, t62 );
+	t66 = OAES_BS_XOR( z1, t63 );
+	s0 = OAES_BS_XOR( t59, t63 );
+	s6 = OAES_BS_XOR( t56, OAES_BS_NOT( t62 ) );
+	s7 = OAES_BS_XOR( t48, OAES_BS_NOT( t60 ) );
+	t67 = OAES_BS_XOR( t64, t65 );
+	s3 = OAES_BS_XOR( t53, t66 );
+	s4 = OAES_BS_XOR( t51, t66 );
+	s5 = OAES_BS_XOR( t47, t65 );
+	s1 = OAES_BS_XOR( t64, OAES_BS_NOT( s3 ) );
+	s2 = OAES_BS_XOR( t55, OAES_BS_NOT( t67 ) );
+
+	q[7] = s0;
+	q[6] = s1;
+	q[5] = s2;
+	q[4] = s3;
+	q[3] = s4;
+	q[2] = s5;
+	q[1] = s6;
+	q[0] = s7;
+}
+
+// InvSubBytes is SubBytes wrapped in the inverse of its affine transform
+OAES_TARGET_SSE2
+static void oaes_bs_inv_affine( __m128i q[8] )
+{
+	__m128i q0, q1, q2, q3, q4, q5, q6, q7;
+
+	q0 = OAES_BS_NOT( q[0] );
+	q1 = OAES_BS_NOT( q[1] );
+	q2 = q[2];
+	q3 = q[3];
+	q4 = q[4];
+	q5 = OAES_BS_NOT( q[5] );
+	q6 = OAES_BS_NOT( q[6] );
+	q7 = q[7];
+	q[7] = OAES_BS_XOR( q1, OAES_BS_XOR( q4, q6 ) );
+	q[6] = OAES_BS_XOR( q0, OAES_BS_XOR( q3, q5 ) );
+	q[5] = OAES_BS_XOR( q7, OAES_BS_XOR( q2, q4 ) );
+	q[4] = OAES_BS_XOR( q6, OAES_BS_XOR( q1, q3 ) );
+	q[3] = OAES_BS_XOR( q5, OAES_BS_XOR( q0, q2 ) );
+	q[2] = OAES_BS_XOR( q4, OAES_BS_XOR( q7, q1 ) );
+	q[1] = OAES_BS_XOR( q3, OAES_BS_XOR( q6, q0 ) );
+	q[0] = OAES_BS_XOR( q2, OAES_BS_XOR( q5, q7 ) );
+}
+
+OAES_TARGET_SSE2
+static void oaes_bs_inv_sbox( __m128i q[8] )
+{
+	oaes_bs_inv_affine( q );
+	oaes_bs_sbox( q );
+	oaes_bs_inv_affine( q );
+}
+
+OAES_TARGET_SSE2
+static void oaes_bs_shift_rows( __m128i q[8] )
+{
+	int _i;
+
+	for( _i = 0; _i < 8; _i++ )
+	{
+		__m128i _x = q[_i];
+
+		q[_i] = OAES_BS_OR(
+				OAES_BS_OR(
+					OAES_BS_AND( _x, OAES_BS_MASK( 0x000000000000ffffULL ) ),
+					_mm_srli_epi64(
+						OAES_BS_AND( _x, OAES_BS_MASK( 0x00000000fff00000ULL ) ), 4 ) ),
+				OAES_BS_OR(
+					OAES_BS_OR(
+						_mm_slli_epi64(
+							OAES_BS_AND( _x, OAES_BS_MASK( 0x00000000000f0000ULL ) ), 12 ),
+						_mm_srli_epi64(
+							OAES_BS_AND( _x, OAES_BS_MASK( 0x0000ff0000000000ULL ) ), 8 ) ),
+					OAES_BS_OR(
+						_mm_slli_epi64(
+							OAES_BS_AND( _x, OAES_BS_MASK( 0x000000ff00000000ULL ) ), 8 ),
+						OAES_BS_OR(
+							_mm_srli_epi64(
+								OAES_BS_AND( _x, OAES_BS_MASK( 0xf000000000000000ULL ) ), 12 ),
+							_mm_slli_epi64(
+								OAES_BS_AND( _x, OAES_BS_MASK( 0x0fff000000000000ULL ) ), 4 ) ) ) ) );
+	}
+}
+
+OAES_TARGET_SSE2
+static void oaes_bs_inv_shift_rows( __m128i q[8] )
+{
+	int _i;
+
+	for( _i = 0; _i < 8; _i++ )
+	{
+		__m128i _x = q[_i];
+
+		q[_i] = OAES_BS_OR(
+				OAES_BS_OR(
+					OAES_BS_AND( _x, OAES_BS_MASK( 0x000000000000ffffULL ) ),
+					_mm_slli_epi64(
+						OAES_BS_AND( _x, OAES_BS_MASK( 0x000000000fff0000ULL ) ), 4 ) ),
+				OAES_BS_OR(
+					OAES_BS_OR(
+						_mm_srli_epi64(
+							OAES_BS_AND( _x, OAES_BS_MASK( 0x00000000f0000000ULL ) ), 12 ),
+						_mm_slli_epi64(
+							OAES_BS_AND( _x, OAES_BS_MASK( 0x000000ff00000000ULL ) ), 8 ) ),
+					OAES_BS_OR(
+						_mm_srli_epi64(
+							OAES_BS_AND( _x, OAES_BS_MASK( 0x0000ff0000000000ULL ) ), 8 ),
+						OAES_BS_OR(
+							_mm_slli_epi64(
+								OAES_BS_AND( _x, OAES_BS_MASK( 0x000f000000000000ULL ) ), 12 ),
+							_mm_srli_epi64(
+								OAES_BS_AND( _x, OAES_BS_MASK( 0xfff0000000000000ULL ) ), 4 ) ) ) ) );
+	}
+}
+
+// multiply each state byte by x in GF(2^8)
+OAES_TARGET_SSE2
+static void oaes_bs_xtime( __m128i out[8], const __m128i a[8] )
+{
+	out[0] = a[7];
+	out[1] = OAES_BS_XOR( a[0], a[7] );
+	out[2] = a[1];
+	out[3] = OAES_BS_XOR( a[2], a[7] );
+	out[4] = OAES_BS_XOR( a[3], a[7] );
+	out[5] = a[4];
+	out[6] = a[5];
+	out[7] = a[6];
+}
+
+// row i becomes 2 * ( a[i] ^ a[i+1] ) ^ a[i+1] ^ a[i+2] ^ a[i+3]
+OAES_TARGET_SSE2
+static void oaes_bs_mix_cols( __m128i q[8] )
+{
+	__m128i _r[8], _u[8], _t[8];
+	int _i;
+
+	for( _i = 0; _i < 8; _i++ )
+	{
+		_r[_i] = OAES_BS_ROTR16( q[_i] );
+		_u[_i] = OAES_BS_XOR( q[_i], _r[_i] );
+	}
+	oaes_bs_xtime( _t, _u );
+	for( _i = 0; _i < 8; _i++ )
+		q[_i] = OAES_BS_XOR( OAES_BS_XOR( _t[_i], _r[_i] ),
+				OAES_BS_ROTR32( _u[_i] ) );
+}
+
+// InvMixColumns is MixColumns applied to a[i] ^ 4 * ( a[i] ^ a[i+2] )
+OAES_TARGET_SSE2
+static void oaes_bs_inv_mix_cols( __m128i q[8] )
+{
+	__m128i _u[8], _t[8];
+	int _i;
+
+	for( _i = 0; _i < 8; _i++ )
+		_u[_i] = OAES_BS_XOR( q[_i], OAES_BS_ROTR32( q[_i] ) );
+	oaes_bs_xtime( _t, _u );
+	oaes_bs_xtime( _u, _t );
+	for( _i = 0; _i < 8; _i++ )
+		q[_i] = OAES_BS_XOR( q[_i], _u[_i] );
+	oaes_bs_mix_cols( q );
+}
+
+#define OAES_BS_SWAPN( cl, ch, s, x, y ) \
+	do { \
+		__m128i _a = (x), _b = (y); \
+		(x) = OAES_BS_OR( OAES_BS_AND( _a, OAES_BS_MASK( cl ) ), \
+				_mm_slli_epi64( OAES_BS_AND( _b, OAES_BS_MASK( cl ) ), s ) ); \
+		(y) = OAES_BS_OR( _mm_srli_epi64( OAES_BS_AND( _a, OAES_BS_MASK( ch ) ), s ), \
+				OAES_BS_AND( _b, OAES_BS_MASK( ch ) ) ); \
+	} while( 0 )
+
+#define OAES_BS_SWAP2( x, y ) OAES_BS_SWAPN( \
+		0x5555555555555555ULL, 0xaaaaaaaaaaaaaaaaULL, 1, x, y )
+#define OAES_BS_SWAP4( x, y ) OAES_BS_SWAPN( \
+		0x3333333333333333ULL, 0xccccccccccccccccULL, 2, x, y )
+#define OAES_BS_SWAP8( x, y ) OAES_BS_SWAPN( \
+		0x0f0f0f0f0f0f0f0fULL, 0xf0f0f0f0f0f0f0f0ULL, 4, x, y )
+
+// transposes between byte order and bit planes, it is its own inverse
+OAES_TARGET_SSE2
+static void oaes_bs_ortho( __m128i q[8] )
+{
+	OAES_BS_SWAP2( q[0], q[1] );
+	OAES_BS_SWAP2( q[2], q[3] );
+	OAES_BS_SWAP2( q[4], q[5] );
+	OAES_BS_SWAP2( q[6], q[7] );
+
+	OAES_BS_SWAP4( q[0], q[2] );
+	OAES_BS_SWAP4( q[1], q[3] );
+	OAES_BS_SWAP4( q[4], q[6] );
+	OAES_BS_SWAP4( q[5], q[7] );
+
+	OAES_BS_SWAP8( q[0], q[4] );
+	OAES_BS_SWAP8( q[1], q[5] );
+	OAES_BS_SWAP8( q[2], q[6] );
+	OAES_BS_SWAP8( q[3], q[7] );
+}
+
+// spread 8 blocks over q, block i in the low lanes and block i + 4 in the
+// high lanes of q[i] and q[i + 4]
+OAES_TARGET_SSE2
+static void oaes_bs_load( __m128i q[8],
+		const uint8_t c[OAES_BITSLICE_BLOCKS * OAES_BLOCK_SIZE] )
+{
+	const __m128i _lo32 = OAES_BS_MASK( 0x00000000ffffffffULL );
+	const __m128i _m16 = OAES_BS_MASK( 0x0000ffff0000ffffULL );
+	const __m128i _m8 = OAES_BS_MASK( 0x00ff00ff00ff00ffULL );
+	int _i;
+
+	for( _i = 0; _i < 4; _i++ )
+	{
+		__m128i _lo = _mm_loadu_si128(
+				(const __m128i *) ( c + _i * OAES_BLOCK_SIZE ) );
+		__m128i _hi = _mm_loadu_si128(
+				(const __m128i *) ( c + ( _i + 4 ) * OAES_BLOCK_SIZE ) );
+		__m128i _a = _mm_unpacklo_epi64( _lo, _hi );
+		__m128i _b = _mm_unpackhi_epi64( _lo, _hi );
+		__m128i _x0 = OAES_BS_AND( _a, _lo32 );
+		__m128i _x1 = _mm_srli_epi64( _a, 32 );
+		__m128i _x2 = OAES_BS_AND( _b, _lo32 );
+		__m128i _x3 = _mm_srli_epi64( _b, 32 );
+
+		_x0 = OAES_BS_AND( OAES_BS_OR( _x0, _mm_slli_epi64( _x0, 16 ) ), _m16 );
+		_x1 = OAES_BS_AND( OAES_BS_OR( _x1, _mm_slli_epi64( _x1, 16 ) ), _m16 );
+		_x2 = OAES_BS_AND( OAES_BS_OR( _x2, _mm_slli_epi64( _x2, 16 ) ), _m16 );
+		_x3 = OAES_BS_AND( OAES_BS_OR( _x3, _mm_slli_epi64( _x3, 16 ) ), _m16 );
+		_x0 = OAES_BS_AND( OAES_BS_OR( _x0, _mm_slli_epi64( _x0, 8 ) ), _m8 );
+		_x1 = OAES_BS_AND( OAES_BS_OR( _x1, _mm_slli_epi64( _x1, 8 ) ), _m8 );
+		_x2 = OAES_BS_AND( OAES_BS_OR( _x2, _mm_slli_epi64( _x2, 8 ) ), _m8 );
+		_x3 = OAES_BS_AND( OAES_BS_OR( _x3, _mm_slli_epi64( _x3, 8 ) ), _m8 );
+
+		q[_i] = OAES_BS_OR( _x0, _mm_slli_epi64( _x2, 8 ) );
+		q[_i + 4] = OAES_BS_OR( _x1, _mm_slli_epi64( _x3, 8 ) );
+	}
+
+	oaes_bs_ortho( q );
+}
+
+// inverse of oaes_bs_load(), q is clobbered
+OAES_TARGET_SSE2
+static void oaes_bs_store( uint8_t c[OAES_BITSLICE_BLOCKS * OAES_BLOCK_SIZE],
+		__m128i q[8] )
+{
+	const __m128i _lo32 = OAES_BS_MASK( 0x00000000ffffffffULL );
+	const __m128i _m16 = OAES_BS_MASK( 0x0000ffff0000ffffULL );
+	const __m128i _m8 = OAES_BS_MASK( 0x00ff00ff00ff00ffULL );
+	int _i;
+
+	oaes_bs_ortho( q );
+
+	for( _i = 0; _i < 4; _i++ )
+	{
+		__m128i _x0 = OAES_BS_AND( q[_i], _m8 );
+		__m128i _x1 = OAES_BS_AND( q[_i + 4], _m8 );
+		__m128i _x2 = OAES_BS_AND( _mm_srli_epi64( q[_i], 8 ), _m8 );
+		__m128i _x3 = OAES_BS_AND( _mm_srli_epi64( q[_i + 4], 8 ), _m8 );
+		__m128i _a, _b;
+
+		_x0 = OAES_BS_AND( OAES_BS_OR( _x0, _mm_srli_epi64( _x0, 8 ) ), _m16 );
+		_x1 = OAES_BS_AND( OAES_BS_OR( _x1, _mm_srli_epi64( _x1, 8 ) ), _m16 );
+		_x2 = OAES_BS_AND( OAES_BS_OR( _x2, _mm_srli_epi64( _x2, 8 ) ), _m16 );
+		_x3 = OAES_BS_AND( OAES_BS_OR( _x3, _mm_srli_epi64( _x3, 8 ) ), _m16 );
+		_x0 = OAES_BS_AND( OAES_BS_OR( _x0, _mm_srli_epi64( _x0, 16 ) ), _lo32 );
+		_x1 = OAES_BS_AND( OAES_BS_OR( _x1, _mm_srli_epi64( _x1, 16 ) ), _lo32 );
+		_x2 = OAES_BS_AND( OAES_BS_OR( _x2, _mm_srli_epi64( _x2, 16 ) ), _lo32 );
+		_x3 = OAES_BS_AND( OAES_BS_OR( _x3, _mm_srli_epi64( _x3, 16 ) ), _lo32 );
+
+		_a = OAES_BS_OR( _x0, _mm_slli_epi64( _x1, 32 ) );
+		_b = OAES_BS_OR( _x2, _mm_slli_epi64( _x3, 32 ) );
+		_mm_storeu_si128( (__m128i *) ( c + _i * OAES_BLOCK_SIZE ),
+				_mm_unpacklo_epi64( _a, _b ) );
+		_mm_storeu_si128( (__m128i *) ( c + ( _i + 4 ) * OAES_BLOCK_SIZE ),
+				_mm_unpackhi_epi64( _a, _b ) );
+	}
+}
+
+OAES_TARGET_SSE2
+static void oaes_bs_add_round_key( __m128i q[8], const __m128i * sk )
+{
+	int _i;
+
+	for( _i = 0; _i < 8; _i++ )
+		q[_i] = OAES_BS_XOR( q[_i], _mm_load_si128( sk + _i ) );
+}
+
+OAES_TARGET_SSE2
+void oaes_bitslice_key_setup( const uint8_t * exp_data, size_t num_keys,
+		uint8_t * bs_data )
+{
+	size_t _i;
+	int _j;
+	uint8_t _copies[OAES_BITSLICE_BLOCKS * OAES_BLOCK_SIZE];
+	__m128i _q[8];
+	__m128i * _sk = (__m128i *) bs_data;
+
+	// a round key is applied to all 8 blocks, so slice 8 copies of it
+	for( _i = 0; _i < num_keys; _i++ )
+	{
+		for( _j = 0; _j < OAES_BITSLICE_BLOCKS; _j++ )
+			memcpy( _copies + _j * OAES_BLOCK_SIZE,
+					exp_data + _i * OAES_BLOCK_SIZE, OAES_BLOCK_SIZE );
+		oaes_bs_load( _q, _copies );
+		for( _j = 0; _j < 8; _j++ )
+			_mm_store_si128( _sk + _i * 8 + _j, _q[_j] );
+	}
+}
+
+OAES_TARGET_SSE2
+void oaes_bitslice_encrypt( const uint8_t * bs_data, size_t num_keys,
+		uint8_t c[OAES_BITSLICE_BLOCKS * OAES_BLOCK_SIZE] )
+{
+	size_t _i;
+	__m128i _q[8];
+	const __m128i * _sk = (const __m128i *) bs_data;
+
+	oaes_bs_load( _q, c );
+
+	oaes_bs_add_round_key( _q, _sk );
+	for( _i = 1; _i < num_keys - 1; _i++ )
+	{
+		oaes_bs_sbox( _q );
+		oaes_bs_shift_rows( _q );
+		oaes_bs_mix_cols( _q );
+		oaes_bs_add_round_key( _q, _sk + _i * 8 );
+	}
+	oaes_bs_sbox( _q );
+	oaes_bs_shift_rows( _q );
+	oaes_bs_add_round_key( _q, _sk + _i * 8 );
+
+	oaes_bs_store( c, _q );
+}
+
+OAES_TARGET_SSE2
+void oaes_bitslice_decrypt( const uint8_t * bs_data, size_t num_keys,
+		uint8_t c[OAES_BITSLICE_BLOCKS * OAES_BLOCK_SIZE] )
+{
+	size_t _i;
+	__m128i _q[8];
+	const __m128i * _sk = (const __m128i *) bs_data;
+
+	oaes_bs_load( _q, c );
+
+	oaes_bs_add_round_key( _q, _sk + ( num_keys - 1 ) * 8 );
+	for( _i = num_keys - 2; _i > 0; _i-- )
+	{
+		oaes_bs_inv_shift_rows( _q );
+		oaes_bs_inv_sbox( _q );
+		oaes_bs_add_round_key( _q, _sk + _i * 8 );
+		oaes_bs_inv_mix_cols( _q );
+	}
+	oaes_bs_inv_shift_rows( _q );
+	oaes_bs_inv_sbox( _q );
+	oaes_bs_add_round_key( _q, _sk );
+
+	oaes_bs_store( c, _q );
+}
+
+#endif // OAES_HAVE_BITSLICE
@@ -0,0 +1,187 @@
+/* 
+ * ---------------------------------------------------------------------------
+ * OpenAES License
+ * ---------------------------------------------------------------------------
+ * Copyright (c) 2013, Nabil S. Al Ramli, www.nalramli.com
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ *   - Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   - Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * ---------------------------------------------------------------------------
+ */
+
+#ifndef _OAES_ENGINE_H
+#define _OAES_ENGINE_H
+
+#include <stddef.h>
+
+#include "oaes_config.h"
+#include "oaes_lib.h"
+
+#ifdef __cplusplus 
+extern "C" {
+#endif
+
+/*
+ * block engines that live outside of oaes_lib.c
+ * 
+ * all of them work on the expanded key schedule as laid out by
+ * oaes_key_expand(): num_keys round keys of 16 bytes each, starting on a
+ * 16 byte boundary
+ */
+
+// the middle rounds of AES-128, AES-192 and AES-256 as lists of X( n ), for
+// kernels that are unrolled at compile time
+#define OAES_ROUNDS_9( X ) \
+	X( 1 ) X( 2 ) X( 3 ) X( 4 ) X( 5 ) X( 6 ) X( 7 ) X( 8 ) X( 9 )
+#define OAES_ROUNDS_11( X ) OAES_ROUNDS_9( X ) X( 10 ) X( 11 )
+#define OAES_ROUNDS_13( X ) OAES_ROUNDS_11( X ) X( 12 ) X( 13 )
+
+#define OAES_ROUNDS_9_DOWN( X ) \
+	X( 9 ) X( 8 ) X( 7 ) X( 6 ) X( 5 ) X( 4 ) X( 3 ) X( 2 ) X( 1 )
+#define OAES_ROUNDS_11_DOWN( X ) X( 11 ) X( 10 ) OAES_ROUNDS_9_DOWN( X )
+#define OAES_ROUNDS_13_DOWN( X ) X( 13 ) X( 12 ) OAES_ROUNDS_11_DOWN( X )
+
+// the OAES_CPU_* bits of this cpu
+uint32_t oaes_cpu_features( void );
+
+#if OAES_HAVE_AESNI
+// expand key into exp_data with AESKEYGENASSIST, and store the AESIMC
+// transformed decryption round keys into dec_data
+void oaes_aesni_key_expand( const uint8_t * key, size_t key_len,
+		uint8_t * exp_data, uint8_t * dec_data, size_t num_keys );
+
+void oaes_aesni_encrypt( const uint8_t * exp_data, size_t num_keys,
+		uint8_t c[OAES_BLOCK_SIZE] );
+
+void oaes_aesni_decrypt( const uint8_t * dec_data, size_t num_keys,
+		uint8_t c[OAES_BLOCK_SIZE] );
+
+// count consecutive blocks in place, 8 at a time to cover the latency of
+// AESENC and AESDEC
+void oaes_aesni_encrypt_blocks( const uint8_t * exp_data, size_t num_keys,
+		uint8_t * c, size_t count );
+
+void oaes_aesni_decrypt_blocks( const uint8_t * dec_data, size_t num_keys,
+		uint8_t * c, size_t count );
+
+// the above for a fixed number of rounds nr, fully unrolled
+#define OAES_AESNI_UNROLLED_DECL( nr ) \
+void oaes_aesni_encrypt_##nr( const uint8_t * exp_data, \
+		uint8_t c[OAES_BLOCK_SIZE] ); \
+void oaes_aesni_decrypt_##nr( const uint8_t * dec_data, \
+		uint8_t c[OAES_BLOCK_SIZE] ); \
+void oaes_aesni_encrypt_blocks_##nr( const uint8_t * exp_data, \
+		uint8_t * c, size_t count ); \
+void oaes_aesni_decrypt_blocks_##nr( const uint8_t * dec_data, \
+		uint8_t * c, size_t count );
+
+OAES_AESNI_UNROLLED_DECL( 10 )
+OAES_AESNI_UNROLLED_DECL( 12 )
+OAES_AESNI_UNROLLED_DECL( 14 )
+
+// the 4 rounds of a message of up to a block, s is the message zero padded
+// on the way in, the hash on the way out, keys the key blocks of the hash
+void oaes_aesni_hash_short( uint8_t s[OAES_BLOCK_SIZE], const uint8_t * keys,
+		uint64_t len );
+
+// blocks blocks of tail into the lanes, then lane 0 chained through rounds
+// keyed with lanes 1 to 3, sum and the last 3 key blocks into s
+void oaes_aesni_hash_close( const uint8_t * lanes, const uint8_t * sum,
+		const uint8_t * tail, size_t blocks, const uint8_t * keys,
+		uint64_t len, uint8_t s[OAES_BLOCK_SIZE] );
+
+// one AESENC round per block of count stripes of 4 blocks at m, block j of
+// a stripe is the round key of lane j, the 4 lanes are at lanes followed by
+// the sum of the blocks, as two 64 bit halves
+void oaes_aesni_hash_stripes( uint8_t * lanes, const uint8_t * m,
+		size_t count );
+#endif // OAES_HAVE_AESNI
+
+#if OAES_HAVE_BITSLICE
+// blocks processed by one call of the bitsliced engine
+#define OAES_BITSLICE_BLOCKS 8
+
+// bitsliced round keys take 8 * 16 bytes per round key
+#define OAES_BITSLICE_KEY_SIZE 128
+
+// derive the bitsliced round keys into bs_data from exp_data
+void oaes_bitslice_key_setup( const uint8_t * exp_data, size_t num_keys,
+		uint8_t * bs_data );
+
+void oaes_bitslice_encrypt( const uint8_t * bs_data, size_t num_keys,
+		uint8_t c[OAES_BITSLICE_BLOCKS * OAES_BLOCK_SIZE] );
+
+void oaes_bitslice_decrypt( const uint8_t * bs_data, size_t num_keys,
+		uint8_t c[OAES_BITSLICE_BLOCKS * OAES_BLOCK_SIZE] );
+#endif // OAES_HAVE_BITSLICE
+
+#if OAES_HAVE_VPERM
+// both directions run off exp_data, decryption uses the straight inverse
+// cipher
+void oaes_vperm_encrypt( const uint8_t * exp_data, size_t num_keys,
+		uint8_t c[OAES_BLOCK_SIZE] );
+
+void oaes_vperm_decrypt( const uint8_t * exp_data, size_t num_keys,
+		uint8_t c[OAES_BLOCK_SIZE] );
+#endif // OAES_HAVE_VPERM
+
+#if OAES_HAVE_PCLMUL
+// bytes of the GHASH key table that oaes_pclmul_ghash_init() fills, it has
+// to start on a 16 byte boundary
+#define OAES_PCLMUL_TABLE_LEN 256
+
+// derive H^1 to H^powers of the GHASH key table from the hash key h, runs
+// of 8 blocks or more need all 8, shorter ones only H^1
+void oaes_pclmul_ghash_init( const uint8_t h[OAES_BLOCK_SIZE], uint8_t * table,
+		size_t powers );
+
+// xi = ( xi ^ c ) * H for each of count blocks, 8 at a time with a single
+// reduction
+void oaes_pclmul_ghash( const uint8_t * table, uint8_t xi[OAES_BLOCK_SIZE],
+		const uint8_t * c, size_t count );
+
+// the same for POLYVAL, with table filled by oaes_pclmul_ghash_init() from
+// the GHASH key that matches the POLYVAL key, mulX_GHASH( ByteReverse( H ) )
+void oaes_pclmul_polyval( const uint8_t * table, uint8_t xi[OAES_BLOCK_SIZE],
+		const uint8_t * c, size_t count );
+
+#if OAES_HAVE_AESNI
+// GCM over 8 * ( count / 8 ) blocks in one pass, the keystream is made from
+// ctr with a 32 bit increment while the ciphertext is hashed into xi, ctr is
+// left on the next counter block, in and out may be the same buffer
+void oaes_pclmul_gcm_encrypt( const uint8_t * exp_data, size_t num_keys,
+		const uint8_t * table, uint8_t ctr[OAES_BLOCK_SIZE],
+		uint8_t xi[OAES_BLOCK_SIZE], const uint8_t * in, uint8_t * out,
+		size_t count );
+
+void oaes_pclmul_gcm_decrypt( const uint8_t * exp_data, size_t num_keys,
+		const uint8_t * table, uint8_t ctr[OAES_BLOCK_SIZE],
+		uint8_t xi[OAES_BLOCK_SIZE], const uint8_t * in, uint8_t * out,
+		size_t count );
+#endif // OAES_HAVE_AESNI
+#endif // OAES_HAVE_PCLMUL
+
+#ifdef __cplusplus 
+}
+#endif
+
+#endif // _OAES_ENGINE_H
@@ -43,6 +43,15 @@ static const char _NR[] = {
 
 #include "oaes_config.h"
 #include "oaes_lib.h"
+#include "oaes_engine.h"
+
+#ifdef OAES_ARCH_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif // OAES_ARCH_X86
 
 #ifdef OAES_HAVE_ISAAC
 #include "rand.h"
@@ -58,31 +67,278 @@ static const char _NR[] = {
 // the block is padded
 #define OAES_FLAG_PAD 0x01
 
+// counter blocks encrypted in one go for the CTR keystream
+#define OAES_CTR_BLOCKS 32
+
+// bytes of the GHASH key table, enough for the layout of either GHASH
+#define OAES_GHASH_TABLE_LEN 256
+
+// GCM takes up to 2^32 - 2 blocks of data for one iv
+#define OAES_GCM_MAX_LEN ( ( (uint64_t) 1 << 36 ) - 32 )
+
+// GCM-SIV takes up to 2^36 bytes of data and of aad
+#define OAES_GCM_SIV_MAX_LEN ( (uint64_t) 1 << 36 )
+
+// blocks of an XTS run encrypted in one go, whichever sectors they are from
+#define OAES_XTS_BLOCKS 32
+
+// an XTS sector is at most 2^20 blocks
+#define OAES_XTS_MAX_SECTOR_LEN ( ( (uint64_t) 1 << 20 ) * OAES_BLOCK_SIZE )
+
+// word indexes into the OCB L-table, each entry is two words: L_*, L_$,
+// the 7 offset deltas Offset_{8k+j} ^ Offset_{8k} for j = 1 to 7, and
+// L_0 to L_63, enough for any block index ntz() can be taken of
+#define OAES_OCB_L_STAR 0
+#define OAES_OCB_L_DOLLAR 2
+#define OAES_OCB_L_RUN 4
+#define OAES_OCB_L 18
+#define OAES_OCB_TABLE_LEN ( ( OAES_OCB_L + 2 * 64 ) * sizeof( uint64_t ) )
+
+#define OAES_OCB_ENCRYPT 0
+#define OAES_OCB_DECRYPT 1
+#define OAES_OCB_HASH 2
+
+// the messages CMAC and key wrap run side by side, the width the block
+// kernels interleave
+#define OAES_LANES 8
+
+// the keys a key wrap batch sets up at a time
+#define OAES_KW_CHUNK 64
+
+// the initial integrity values of KW, and of KWP ahead of the length
+#define OAES_KW_IV 0xa6a6a6a6a6a6a6a6ULL
+#define OAES_KWP_IV 0xa65959a600000000ULL
+
+// Poly1305 runs on 64 bit limbs where the compiler has a 128 bit product,
+// on 26 bit limbs elsewhere
+#ifndef OAES_POLY1305_64
+#if defined( __SIZEOF_INT128__ )
+#define OAES_POLY1305_64 1
+#else
+#define OAES_POLY1305_64 0
+#endif
+#endif
+
+// the bytes oaes_poly1305_encrypt() encrypts before it MACs them, small
+// enough that they are still in L1 for the MAC
+#define OAES_POLY1305_CHUNK 4096
+
+#define OAES_FF1_ROUNDS 10
+// the longest FF1 value, in numerals
+#define OAES_FF1_MAX_LEN 64
+// the limbs of a half, and the bytes of NUM( B ) for numerals of 16 bits
+#define OAES_FF1_LIMBS ( ( OAES_FF1_MAX_LEN + 1 ) / 2 )
+#define OAES_FF1_MAX_B ( 2 * OAES_FF1_LIMBS )
+// the round dependent end of Q, and the blocks of S
+#define OAES_FF1_TAIL ( OAES_FF1_MAX_B + OAES_BLOCK_SIZE )
+#define OAES_FF1_S_BLOCKS ( ( OAES_FF1_MAX_B + 8 ) / OAES_BLOCK_SIZE + 1 )
+// the values of a batch that go through the rounds together
+#define OAES_FF1_CHUNK 16
+
+// the round hash absorbs stripes of one block per lane
+#define OAES_ROUND_HASH_LANES 4
+#define OAES_ROUND_HASH_STRIPE ( OAES_ROUND_HASH_LANES * OAES_BLOCK_SIZE )
+// the key blocks, the lane seeds, then the keys of the last 3 rounds
+#define OAES_ROUND_HASH_KEYS ( OAES_ROUND_HASH_LANES + 3 )
+
 #ifndef min
 # define min(a,b) (((a)<(b)) ? (a) : (b))
 #endif /* min */
 
+#ifndef max
+# define max(a,b) (((a)>(b)) ? (a) : (b))
+#endif /* max */
+
+struct _oaes_engine;
+struct _oaes_kernels;
+
 typedef struct _oaes_key
 {
 	size_t data_len;
 	uint8_t *data;
 	size_t exp_data_len;
+	// 16 byte aligned
 	uint8_t *exp_data;
 	size_t num_keys;
 	size_t key_base;
+	// equivalent inverse cipher round keys, laid out like exp_data
+	uint8_t *dec_data;
+	// engine specific round keys, 16 byte aligned
+	uint8_t *engine_data;
+	const struct _oaes_engine * engine;
+	// engine->kernels, or the set unrolled for num_keys
+	const struct _oaes_kernels * kernels;
+	// GHASH key table for GCM, 16 byte aligned, derived on first use, or
+	// the POLYVAL key table of a GCM-SIV message key
+	uint8_t *gcm_data;
+	// the GCM-SIV message key last derived from this one, kept so that the
+	// next message can reuse its buffers
+	struct _oaes_key * siv_key;
+	// the XTS tweak key set with oaes_xts_key_import_data()
+	struct _oaes_key * xts_key;
+	// the OCB L-table, set up the first time the key is used for OCB
+	uint8_t *ocb_data;
+	// the CMAC subkeys K1 and K2, derived the first time they are needed
+	uint8_t *cmac_data;
+	// the round hash key blocks, derived the first time they are needed
+	uint8_t *hash_data;
+#if OAES_STEP_TRACE
+	// set while the traced kernels are bound
+	oaes_step_cb step_cb;
+#endif // OAES_STEP_TRACE
 } oaes_key;
 
+// a CCM message in progress
+typedef struct _oaes_ccm_state
+{
+	// the CBC-MAC so far, and p_len bytes of plaintext not yet in it
+	uint8_t x[OAES_BLOCK_SIZE];
+	uint8_t p[OAES_BLOCK_SIZE];
+	size_t p_len;
+	// the next counter block, and the keystream of the one before it, used
+	// up to ks_pos
+	uint8_t ctr[OAES_BLOCK_SIZE];
+	uint8_t ks[OAES_BLOCK_SIZE];
+	size_t ks_pos;
+	// E( K, A_0 ), which the tag is xored with
+	uint8_t s0[OAES_BLOCK_SIZE];
+	// bytes of the message still to come
+	uint64_t left;
+	// 0 when no message is in progress
+	size_t tag_len;
+} oaes_ccm_state;
+
+#define OAES_STREAM_CFB 1
+#define OAES_STREAM_CFB8 2
+#define OAES_STREAM_OFB 3
+
+// a CFB or OFB stream in progress
+typedef struct _oaes_stream_state
+{
+	// OAES_STREAM_*, 0 when no stream is started
+	int mode;
+	// for CFB the cipher input of the next keystream block, the ciphertext
+	// so far, for OFB the current keystream block
+	uint8_t reg[OAES_BLOCK_SIZE];
+	// the current CFB keystream block
+	uint8_t ks[OAES_BLOCK_SIZE];
+	// bytes of the current keystream block used
+	size_t pos;
+} oaes_stream_state;
+
+// a Poly1305-AES message in progress
+typedef struct _oaes_poly1305_state
+{
+	// the clamped r and the accumulator h, in limbs of 64 bits, with
+	// 5 / 4 r1 in r[2], or of 26 bits, see OAES_POLY1305_64
+	uint64_t r[5];
+	uint64_t h[5];
+	// AES( k, nonce ), added in at the end
+	uint8_t s[OAES_BLOCK_SIZE];
+	// buf_len bytes of message not yet in h
+	uint8_t buf[OAES_BLOCK_SIZE];
+	size_t buf_len;
+	int started;
+} oaes_poly1305_state;
+
+// what the values of an FF1 batch share, they have the same radix, length
+// and tweak
+typedef struct _oaes_ff1_shape
+{
+	uint32_t radix;
+	size_t n;
+	// the numerals of each half, u then v, and NUM( B ) and S in bytes
+	size_t half[2];
+	size_t b;
+	size_t d;
+	// numerals per limb, and for each half the limbs it takes and the base
+	// of its top limb, the other limbs have base radix^k
+	size_t k;
+	uint64_t w;
+	size_t limbs[2];
+	uint64_t top[2];
+	// the CBC-MAC of P and of the whole blocks of Q ahead of the round
+	uint8_t x0[OAES_BLOCK_SIZE];
+	// the rest of Q, with the round number and NUM( B ) left zero
+	uint8_t tail[OAES_FF1_TAIL];
+	size_t tail_len;
+} oaes_ff1_shape;
+
+// a round hash in progress
+typedef struct _oaes_round_hash_state
+{
+	// the lanes, then the sum of the blocks in them, as two 64 bit halves
+	uint8_t lanes[( OAES_ROUND_HASH_LANES + 1 ) * OAES_BLOCK_SIZE];
+	// buf_len bytes of message not yet in the lanes
+	uint8_t buf[OAES_ROUND_HASH_STRIPE];
+	size_t buf_len;
+	uint64_t len;
+	int started;
+} oaes_round_hash_state;
+
+// the block functions of an engine
+typedef struct _oaes_kernels
+{
+	void ( * encrypt )( const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE] );
+	void ( * decrypt )( const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE] );
+	// count consecutive blocks in place, NULL to go through encrypt/decrypt
+	void ( * encrypt_blocks )( const oaes_key * key, uint8_t * c, size_t count );
+	void ( * decrypt_blocks )( const oaes_key * key, uint8_t * c, size_t count );
+} oaes_kernels;
+
+// a block cipher implementation, bound to the key by oaes_key_expand()
+typedef struct _oaes_engine
+{
+	const char * name;
+	// OAES_CPU_* bits the engine needs
+	uint32_t cpu_features;
+	// fills exp_data and dec_data, NULL to use the portable key expansion
+	void ( * key_expand )( oaes_key * key );
+	// 1 if the kernels expand the round keys from data as they go, the key
+	// then keeps no exp_data or dec_data
+	int on_the_fly;
+	// bytes of engine_data per round key, 0 if the engine has none
+	size_t key_data_len;
+	// derives engine_data from exp_data, NULL if there is nothing to derive
+	void ( * key_setup )( oaes_key * key );
+	// for any number of rounds
+	oaes_kernels kernels;
+	// fully unrolled for 10, 12 and 14 rounds, NULL where there are none
+	const oaes_kernels * unrolled[3];
+} oaes_engine;
+
 typedef struct _oaes_ctx
 {
 #ifdef OAES_HAVE_ISAAC
   randctx * rctx;
 #endif // OAES_HAVE_ISAAC
 
-#ifdef OAES_DEBUG
+#if OAES_STEP_TRACE
 	oaes_step_cb step_cb;
-#endif // OAES_DEBUG
+#endif // OAES_STEP_TRACE
 
 	oaes_key * key;
+	// set with OAES_OPTION_ENGINE, NULL to select one for every key
+	const oaes_engine * engine;
+	// set with OAES_OPTION_CTR_WIDTH
+	size_t ctr_bits;
+	// keystream filled by oaes_ctr_prefetch(), ctr_ring_count blocks from
+	// ctr_ring_head on are ready, the first of them for counter ctr_ring_ctr
+	uint8_t * ctr_ring;
+	size_t ctr_ring_depth;
+	size_t ctr_ring_head;
+	size_t ctr_ring_count;
+	uint8_t ctr_ring_ctr[OAES_BLOCK_SIZE];
+	uint64_t ctr_ring_hits;
+	uint64_t ctr_ring_misses;
+	// the message of oaes_ccm_start()
+	oaes_ccm_state ccm;
+	// the stream of oaes_cfb_start() or oaes_ofb_start()
+	oaes_stream_state stream;
+	// the message of oaes_poly1305_start()
+	oaes_poly1305_state poly1305;
+	// the hash of oaes_round_hash_start()
+	oaes_round_hash_state round_hash;
 	OAES_OPTION options;
 	uint8_t iv[OAES_BLOCK_SIZE];
 } oaes_ctx;
@@ -135,6 +391,8 @@ static uint8_t oaes_inv_sub_byte_value[16][16] = {
 	/*f*/	0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d,
 };
 
+// only the traced MixColumns multiplies through these
+#if OAES_STEP_TRACE
 static uint8_t oaes_gf_mul_2[16][16] = {
 	// 		0,    1,    2,    3,    4,    5,    6,    7,    8,    9,    a,    b,    c,    d,    e,    f,
 	/*0*/	0x00, 0x02, 0x04, 0x06, 0x08, 0x0a, 0x0c, 0x0e, 0x10, 0x12, 0x14, 0x16, 0x18, 0x1a, 0x1c, 0x1e,
@@ -254,24 +512,297 @@ static uint8_t oaes_gf_mul_e[16][16] = {
 	/*e*/	0x37, 0x39, 0x2b, 0x25, 0x0f, 0x01, 0x13, 0x1d, 0x47, 0x49, 0x5b, 0x55, 0x7f, 0x71, 0x63, 0x6d,
 	/*f*/	0xd7, 0xd9, 0xcb, 0xc5, 0xef, 0xe1, 0xf3, 0xfd, 0xa7, 0xa9, 0xbb, 0xb5, 0x9f, 0x91, 0x83, 0x8d,
 };
+#endif // OAES_STEP_TRACE
+
+// SubBytes and MixColumns of a row 0 byte, columns as little-endian words
+static const uint32_t oaes_te0[256] = {
+	/*00*/	0xa56363c6, 0x847c7cf8, 0x997777ee, 0x8d7b7bf6, 0x0df2f2ff, 0xbd6b6bd6, 0xb16f6fde, 0x54c5c591,
+	/*08*/	0x50303060, 0x03010102, 0xa96767ce, 0x7d2b2b56, 0x19fefee7, 0x62d7d7b5, 0xe6abab4d, 0x9a7676ec,
+	/*10*/	0x45caca8f, 0x9d82821f, 0x40c9c989, 0x877d7dfa, 0x15fafaef, 0xeb5959b2, 0xc947478e, 0x0bf0f0fb,
+	/*18*/	0xecadad41, 0x67d4d4b3, 0xfda2a25f, 0xeaafaf45, 0xbf9c9c23, 0xf7a4a453, 0x967272e4, 0x5bc0c09b,
+	/*20*/	0xc2b7b775, 0x1cfdfde1, 0xae93933d, 0x6a26264c, 0x5a36366c, 0x413f3f7e, 0x02f7f7f5, 0x4fcccc83,
+	/*28*/	0x5c343468, 0xf4a5a551, 0x34e5e5d1, 0x08f1f1f9, 0x937171e2, 0x73d8d8ab, 0x53313162, 0x3f15152a,
+	/*30*/	0x0c040408, 0x52c7c795, 0x65232346, 0x5ec3c39d, 0x28181830, 0xa1969637, 0x0f05050a, 0xb59a9a2f,
+	/*38*/	0x0907070e, 0x36121224, 0x9b80801b, 0x3de2e2df, 0x26ebebcd, 0x6927274e, 0xcdb2b27f, 0x9f7575ea,
+	/*40*/	0x1b090912, 0x9e83831d, 0x742c2c58, 0x2e1a1a34, 0x2d1b1b36, 0xb26e6edc, 0xee5a5ab4, 0xfba0a05b,
+	/*48*/	0xf65252a4, 0x4d3b3b76, 0x61d6d6b7, 0xceb3b37d, 0x7b292952, 0x3ee3e3dd, 0x712f2f5e, 0x97848413,
+	/*50*/	0xf55353a6, 0x68d1d1b9, 0x00000000, 0x2cededc1, 0x60202040, 0x1ffcfce3, 0xc8b1b179, 0xed5b5bb6,
+	/*58*/	0xbe6a6ad4, 0x46cbcb8d, 0xd9bebe67, 0x4b393972, 0xde4a4a94, 0xd44c4c98, 0xe85858b0, 0x4acfcf85,
+	/*60*/	0x6bd0d0bb, 0x2aefefc5, 0xe5aaaa4f, 0x16fbfbed, 0xc5434386, 0xd74d4d9a, 0x55333366, 0x94858511,
+	/*68*/	0xcf45458a, 0x10f9f9e9, 0x06020204, 0x817f7ffe, 0xf05050a0, 0x443c3c78, 0xba9f9f25, 0xe3a8a84b,
+	/*70*/	0xf35151a2, 0xfea3a35d, 0xc0404080, 0x8a8f8f05, 0xad92923f, 0xbc9d9d21, 0x48383870, 0x04f5f5f1,
+	/*78*/	0xdfbcbc63, 0xc1b6b677, 0x75dadaaf, 0x63212142, 0x30101020, 0x1affffe5, 0x0ef3f3fd, 0x6dd2d2bf,
+	/*80*/	0x4ccdcd81, 0x140c0c18, 0x35131326, 0x2fececc3, 0xe15f5fbe, 0xa2979735, 0xcc444488, 0x3917172e,
+	/*88*/	0x57c4c493, 0xf2a7a755, 0x827e7efc, 0x473d3d7a, 0xac6464c8, 0xe75d5dba, 0x2b191932, 0x957373e6,
+	/*90*/	0xa06060c0, 0x98818119, 0xd14f4f9e, 0x7fdcdca3, 0x66222244, 0x7e2a2a54, 0xab90903b, 0x8388880b,
+	/*98*/	0xca46468c, 0x29eeeec7, 0xd3b8b86b, 0x3c141428, 0x79dedea7, 0xe25e5ebc, 0x1d0b0b16, 0x76dbdbad,
+	/*a0*/	0x3be0e0db, 0x56323264, 0x4e3a3a74, 0x1e0a0a14, 0xdb494992, 0x0a06060c, 0x6c242448, 0xe45c5cb8,
+	/*a8*/	0x5dc2c29f, 0x6ed3d3bd, 0xefacac43, 0xa66262c4, 0xa8919139, 0xa4959531, 0x37e4e4d3, 0x8b7979f2,
+	/*b0*/	0x32e7e7d5, 0x43c8c88b, 0x5937376e, 0xb76d6dda, 0x8c8d8d01, 0x64d5d5b1, 0xd24e4e9c, 0xe0a9a949,
+	/*b8*/	0xb46c6cd8, 0xfa5656ac, 0x07f4f4f3, 0x25eaeacf, 0xaf6565ca, 0x8e7a7af4, 0xe9aeae47, 0x18080810,
+	/*c0*/	0xd5baba6f, 0x887878f0, 0x6f25254a, 0x722e2e5c, 0x241c1c38, 0xf1a6a657, 0xc7b4b473, 0x51c6c697,
+	/*c8*/	0x23e8e8cb, 0x7cdddda1, 0x9c7474e8, 0x211f1f3e, 0xdd4b4b96, 0xdcbdbd61, 0x868b8b0d, 0x858a8a0f,
+	/*d0*/	0x907070e0, 0x423e3e7c, 0xc4b5b571, 0xaa6666cc, 0xd8484890, 0x05030306, 0x01f6f6f7, 0x120e0e1c,
+	/*d8*/	0xa36161c2, 0x5f35356a, 0xf95757ae, 0xd0b9b969, 0x91868617, 0x58c1c199, 0x271d1d3a, 0xb99e9e27,
+	/*e0*/	0x38e1e1d9, 0x13f8f8eb, 0xb398982b, 0x33111122, 0xbb6969d2, 0x70d9d9a9, 0x898e8e07, 0xa7949433,
+	/*e8*/	0xb69b9b2d, 0x221e1e3c, 0x92878715, 0x20e9e9c9, 0x49cece87, 0xff5555aa, 0x78282850, 0x7adfdfa5,
+	/*f0*/	0x8f8c8c03, 0xf8a1a159, 0x80898909, 0x170d0d1a, 0xdabfbf65, 0x31e6e6d7, 0xc6424284, 0xb86868d0,
+	/*f8*/	0xc3414182, 0xb0999929, 0x772d2d5a, 0x110f0f1e, 0xcbb0b07b, 0xfc5454a8, 0xd6bbbb6d, 0x3a16162c,
+};
 
-static OAES_RET oaes_sub_byte( uint8_t * byte )
-{
-	size_t _x, _y;
-	
-	if( NULL == byte )
-		return OAES_RET_ARG1;
+// oaes_te0 rotated left by 8 bits, for a row 1 byte
+static const uint32_t oaes_te1[256] = {
+	/*00*/	0x6363c6a5, 0x7c7cf884, 0x7777ee99, 0x7b7bf68d, 0xf2f2ff0d, 0x6b6bd6bd, 0x6f6fdeb1, 0xc5c59154,
+	/*08*/	0x30306050, 0x01010203, 0x6767cea9, 0x2b2b567d, 0xfefee719, 0xd7d7b562, 0xabab4de6, 0x7676ec9a,
+	/*10*/	0xcaca8f45, 0x82821f9d, 0xc9c98940, 0x7d7dfa87, 0xfafaef15, 0x5959b2eb, 0x47478ec9, 0xf0f0fb0b,
+	/*18*/	0xadad41ec, 0xd4d4b367, 0xa2a25ffd, 0xafaf45ea, 0x9c9c23bf, 0xa4a453f7, 0x7272e496, 0xc0c09b5b,
+	/*20*/	0xb7b775c2, 0xfdfde11c, 0x93933dae, 0x26264c6a, 0x36366c5a, 0x3f3f7e41, 0xf7f7f502, 0xcccc834f,
+	/*28*/	0x3434685c, 0xa5a551f4, 0xe5e5d134, 0xf1f1f908, 0x7171e293, 0xd8d8ab73, 0x31316253, 0x15152a3f,
+	/*30*/	0x0404080c, 0xc7c79552, 0x23234665, 0xc3c39d5e, 0x18183028, 0x969637a1, 0x05050a0f, 0x9a9a2fb5,
+	/*38*/	0x07070e09, 0x12122436, 0x80801b9b, 0xe2e2df3d, 0xebebcd26, 0x27274e69, 0xb2b27fcd, 0x7575ea9f,
+	/*40*/	0x0909121b, 0x83831d9e, 0x2c2c5874, 0x1a1a342e, 0x1b1b362d, 0x6e6edcb2, 0x5a5ab4ee, 0xa0a05bfb,
+	/*48*/	0x5252a4f6, 0x3b3b764d, 0xd6d6b761, 0xb3b37dce, 0x2929527b, 0xe3e3dd3e, 0x2f2f5e71, 0x84841397,
+	/*50*/	0x5353a6f5, 0xd1d1b968, 0x00000000, 0xededc12c, 0x20204060, 0xfcfce31f, 0xb1b179c8, 0x5b5bb6ed,
+	/*58*/	0x6a6ad4be, 0xcbcb8d46, 0xbebe67d9, 0x3939724b, 0x4a4a94de, 0x4c4c98d4, 0x5858b0e8, 0xcfcf854a,
+	/*60*/	0xd0d0bb6b, 0xefefc52a, 0xaaaa4fe5, 0xfbfbed16, 0x434386c5, 0x4d4d9ad7, 0x33336655, 0x85851194,
+	/*68*/	0x45458acf, 0xf9f9e910, 0x02020406, 0x7f7ffe81, 0x5050a0f0, 0x3c3c7844, 0x9f9f25ba, 0xa8a84be3,
+	/*70*/	0x5151a2f3, 0xa3a35dfe, 0x404080c0, 0x8f8f058a, 0x92923fad, 0x9d9d21bc, 0x38387048, 0xf5f5f104,
+	/*78*/	0xbcbc63df, 0xb6b677c1, 0xdadaaf75, 0x21214263, 0x10102030, 0xffffe51a, 0xf3f3fd0e, 0xd2d2bf6d,
+	/*80*/	0xcdcd814c, 0x0c0c1814, 0x13132635, 0xececc32f, 0x5f5fbee1, 0x979735a2, 0x444488cc, 0x17172e39,
+	/*88*/	0xc4c49357, 0xa7a755f2, 0x7e7efc82, 0x3d3d7a47, 0x6464c8ac, 0x5d5dbae7, 0x1919322b, 0x7373e695,
+	/*90*/	0x6060c0a0, 0x81811998, 0x4f4f9ed1, 0xdcdca37f, 0x22224466, 0x2a2a547e, 0x90903bab, 0x88880b83,
+	/*98*/	0x46468cca, 0xeeeec729, 0xb8b86bd3, 0x1414283c, 0xdedea779, 0x5e5ebce2, 0x0b0b161d, 0xdbdbad76,
+	/*a0*/	0xe0e0db3b, 0x32326456, 0x3a3a744e, 0x0a0a141e, 0x494992db, 0x06060c0a, 0x2424486c, 0x5c5cb8e4,
+	/*a8*/	0xc2c29f5d, 0xd3d3bd6e, 0xacac43ef, 0x6262c4a6, 0x919139a8, 0x959531a4, 0xe4e4d337, 0x7979f28b,
+	/*b0*/	0xe7e7d532, 0xc8c88b43, 0x37376e59, 0x6d6ddab7, 0x8d8d018c, 0xd5d5b164, 0x4e4e9cd2, 0xa9a949e0,
+	/*b8*/	0x6c6cd8b4, 0x5656acfa, 0xf4f4f307, 0xeaeacf25, 0x6565caaf, 0x7a7af48e, 0xaeae47e9, 0x08081018,
+	/*c0*/	0xbaba6fd5, 0x7878f088, 0x25254a6f, 0x2e2e5c72, 0x1c1c3824, 0xa6a657f1, 0xb4b473c7, 0xc6c69751,
+	/*c8*/	0xe8e8cb23, 0xdddda17c, 0x7474e89c, 0x1f1f3e21, 0x4b4b96dd, 0xbdbd61dc, 0x8b8b0d86, 0x8a8a0f85,
+	/*d0*/	0x7070e090, 0x3e3e7c42, 0xb5b571c4, 0x6666ccaa, 0x484890d8, 0x03030605, 0xf6f6f701, 0x0e0e1c12,
+	/*d8*/	0x6161c2a3, 0x35356a5f, 0x5757aef9, 0xb9b969d0, 0x86861791, 0xc1c19958, 0x1d1d3a27, 0x9e9e27b9,
+	/*e0*/	0xe1e1d938, 0xf8f8eb13, 0x98982bb3, 0x11112233, 0x6969d2bb, 0xd9d9a970, 0x8e8e0789, 0x949433a7,
+	/*e8*/	0x9b9b2db6, 0x1e1e3c22, 0x87871592, 0xe9e9c920, 0xcece8749, 0x5555aaff, 0x28285078, 0xdfdfa57a,
+	/*f0*/	0x8c8c038f, 0xa1a159f8, 0x89890980, 0x0d0d1a17, 0xbfbf65da, 0xe6e6d731, 0x424284c6, 0x6868d0b8,
+	/*f8*/	0x414182c3, 0x999929b0, 0x2d2d5a77, 0x0f0f1e11, 0xb0b07bcb, 0x5454a8fc, 0xbbbb6dd6, 0x16162c3a,
+};
 
-	_x = _y = *byte;
-	_x &= 0x0f;
-	_y &= 0xf0;
-	_y >>= 4;
-	*byte = oaes_sub_byte_value[_y][_x];
-	
-	return OAES_RET_SUCCESS;
-}
+// oaes_te0 rotated left by 16 bits, for a row 2 byte
+static const uint32_t oaes_te2[256] = {
+	/*00*/	0x63c6a563, 0x7cf8847c, 0x77ee9977, 0x7bf68d7b, 0xf2ff0df2, 0x6bd6bd6b, 0x6fdeb16f, 0xc59154c5,
+	/*08*/	0x30605030, 0x01020301, 0x67cea967, 0x2b567d2b, 0xfee719fe, 0xd7b562d7, 0xab4de6ab, 0x76ec9a76,
+	/*10*/	0xca8f45ca, 0x821f9d82, 0xc98940c9, 0x7dfa877d, 0xfaef15fa, 0x59b2eb59, 0x478ec947, 0xf0fb0bf0,
+	/*18*/	0xad41ecad, 0xd4b367d4, 0xa25ffda2, 0xaf45eaaf, 0x9c23bf9c, 0xa453f7a4, 0x72e49672, 0xc09b5bc0,
+	/*20*/	0xb775c2b7, 0xfde11cfd, 0x933dae93, 0x264c6a26, 0x366c5a36, 0x3f7e413f, 0xf7f502f7, 0xcc834fcc,
+	/*28*/	0x34685c34, 0xa551f4a5, 0xe5d134e5, 0xf1f908f1, 0x71e29371, 0xd8ab73d8, 0x31625331, 0x152a3f15,
+	/*30*/	0x04080c04, 0xc79552c7, 0x23466523, 0xc39d5ec3, 0x18302818, 0x9637a196, 0x050a0f05, 0x9a2fb59a,
+	/*38*/	0x070e0907, 0x12243612, 0x801b9b80, 0xe2df3de2, 0xebcd26eb, 0x274e6927, 0xb27fcdb2, 0x75ea9f75,
+	/*40*/	0x09121b09, 0x831d9e83, 0x2c58742c, 0x1a342e1a, 0x1b362d1b, 0x6edcb26e, 0x5ab4ee5a, 0xa05bfba0,
+	/*48*/	0x52a4f652, 0x3b764d3b, 0xd6b761d6, 0xb37dceb3, 0x29527b29, 0xe3dd3ee3, 0x2f5e712f, 0x84139784,
+	/*50*/	0x53a6f553, 0xd1b968d1, 0x00000000, 0xedc12ced, 0x20406020, 0xfce31ffc, 0xb179c8b1, 0x5bb6ed5b,
+	/*58*/	0x6ad4be6a, 0xcb8d46cb, 0xbe67d9be, 0x39724b39, 0x4a94de4a, 0x4c98d44c, 0x58b0e858, 0xcf854acf,
+	/*60*/	0xd0bb6bd0, 0xefc52aef, 0xaa4fe5aa, 0xfbed16fb, 0x4386c543, 0x4d9ad74d, 0x33665533, 0x85119485,
+	/*68*/	0x458acf45, 0xf9e910f9, 0x02040602, 0x7ffe817f, 0x50a0f050, 0x3c78443c, 0x9f25ba9f, 0xa84be3a8,
+	/*70*/	0x51a2f351, 0xa35dfea3, 0x4080c040, 0x8f058a8f, 0x923fad92, 0x9d21bc9d, 0x38704838, 0xf5f104f5,
+	/*78*/	0xbc63dfbc, 0xb677c1b6, 0xdaaf75da, 0x21426321, 0x10203010, 0xffe51aff, 0xf3fd0ef3, 0xd2bf6dd2,
+	/*80*/	0xcd814ccd, 0x0c18140c, 0x13263513, 0xecc32fec, 0x5fbee15f, 0x9735a297, 0x4488cc44, 0x172e3917,
+	/*88*/	0xc49357c4, 0xa755f2a7, 0x7efc827e, 0x3d7a473d, 0x64c8ac64, 0x5dbae75d, 0x19322b19, 0x73e69573,
+	/*90*/	0x60c0a060, 0x81199881, 0x4f9ed14f, 0xdca37fdc, 0x22446622, 0x2a547e2a, 0x903bab90, 0x880b8388,
+	/*98*/	0x468cca46, 0xeec729ee, 0xb86bd3b8, 0x14283c14, 0xdea779de, 0x5ebce25e, 0x0b161d0b, 0xdbad76db,
+	/*a0*/	0xe0db3be0, 0x32645632, 0x3a744e3a, 0x0a141e0a, 0x4992db49, 0x060c0a06, 0x24486c24, 0x5cb8e45c,
+	/*a8*/	0xc29f5dc2, 0xd3bd6ed3, 0xac43efac, 0x62c4a662, 0x9139a891, 0x9531a495, 0xe4d337e4, 0x79f28b79,
+	/*b0*/	0xe7d532e7, 0xc88b43c8, 0x376e5937, 0x6ddab76d, 0x8d018c8d, 0xd5b164d5, 0x4e9cd24e, 0xa949e0a9,
+	/*b8*/	0x6cd8b46c, 0x56acfa56, 0xf4f307f4, 0xeacf25ea, 0x65caaf65, 0x7af48e7a, 0xae47e9ae, 0x08101808,
+	/*c0*/	0xba6fd5ba, 0x78f08878, 0x254a6f25, 0x2e5c722e, 0x1c38241c, 0xa657f1a6, 0xb473c7b4, 0xc69751c6,
+	/*c8*/	0xe8cb23e8, 0xdda17cdd, 0x74e89c74, 0x1f3e211f, 0x4b96dd4b, 0xbd61dcbd, 0x8b0d868b, 0x8a0f858a,
+	/*d0*/	0x70e09070, 0x3e7c423e, 0xb571c4b5, 0x66ccaa66, 0x4890d848, 0x03060503, 0xf6f701f6, 0x0e1c120e,
+	/*d8*/	0x61c2a361, 0x356a5f35, 0x57aef957, 0xb969d0b9, 0x86179186, 0xc19958c1, 0x1d3a271d, 0x9e27b99e,
+	/*e0*/	0xe1d938e1, 0xf8eb13f8, 0x982bb398, 0x11223311, 0x69d2bb69, 0xd9a970d9, 0x8e07898e, 0x9433a794,
+	/*e8*/	0x9b2db69b, 0x1e3c221e, 0x87159287, 0xe9c920e9, 0xce8749ce, 0x55aaff55, 0x28507828, 0xdfa57adf,
+	/*f0*/	0x8c038f8c, 0xa159f8a1, 0x89098089, 0x0d1a170d, 0xbf65dabf, 0xe6d731e6, 0x4284c642, 0x68d0b868,
+	/*f8*/	0x4182c341, 0x9929b099, 0x2d5a772d, 0x0f1e110f, 0xb07bcbb0, 0x54a8fc54, 0xbb6dd6bb, 0x162c3a16,
+};
 
-static OAES_RET oaes_inv_sub_byte( uint8_t * byte )
+// oaes_te0 rotated left by 24 bits, for a row 3 byte
+static const uint32_t oaes_te3[256] = {
+	/*00*/	0xc6a56363, 0xf8847c7c, 0xee997777, 0xf68d7b7b, 0xff0df2f2, 0xd6bd6b6b, 0xdeb16f6f, 0x9154c5c5,
+	/*08*/	0x60503030, 0x02030101, 0xcea96767, 0x567d2b2b, 0xe719fefe, 0xb562d7d7, 0x4de6abab, 0xec9a7676,
+	/*10*/	0x8f45caca, 0x1f9d8282, 0x8940c9c9, 0xfa877d7d, 0xef15fafa, 0xb2eb5959, 0x8ec94747, 0xfb0bf0f0,
+	/*18*/	0x41ecadad, 0xb367d4d4, 0x5ffda2a2, 0x45eaafaf, 0x23bf9c9c, 0x53f7a4a4, 0xe4967272, 0x9b5bc0c0,
+	/*20*/	0x75c2b7b7, 0xe11cfdfd, 0x3dae9393, 0x4c6a2626, 0x6c5a3636, 0x7e413f3f, 0xf502f7f7, 0x834fcccc,
+	/*28*/	0x685c3434, 0x51f4a5a5, 0xd134e5e5, 0xf908f1f1, 0xe2937171, 0xab73d8d8, 0x62533131, 0x2a3f1515,
+	/*30*/	0x080c0404, 0x9552c7c7, 0x46652323, 0x9d5ec3c3, 0x30281818, 0x37a19696, 0x0a0f0505, 0x2fb59a9a,
+	/*38*/	0x0e090707, 0x24361212, 0x1b9b8080, 0xdf3de2e2, 0xcd26ebeb, 0x4e692727, 0x7fcdb2b2, 0xea9f7575,
+	/*40*/	0x121b0909, 0x1d9e8383, 0x58742c2c, 0x342e1a1a, 0x362d1b1b, 0xdcb26e6e, 0xb4ee5a5a, 0x5bfba0a0,
+	/*48*/	0xa4f65252, 0x764d3b3b, 0xb761d6d6, 0x7dceb3b3, 0x527b2929, 0xdd3ee3e3, 0x5e712f2f, 0x13978484,
+	/*50*/	0xa6f55353, 0xb968d1d1, 0x00000000, 0xc12ceded, 0x40602020, 0xe31ffcfc, 0x79c8b1b1, 0xb6ed5b5b,
+	/*58*/	0xd4be6a6a, 0x8d46cbcb, 0x67d9bebe, 0x724b3939, 0x94de4a4a, 0x98d44c4c, 0xb0e85858, 0x854acfcf,
+	/*60*/	0xbb6bd0d0, 0xc52aefef, 0x4fe5aaaa, 0xed16fbfb, 0x86c54343, 0x9ad74d4d, 0x66553333, 0x11948585,
+	/*68*/	0x8acf4545, 0xe910f9f9, 0x04060202, 0xfe817f7f, 0xa0f05050, 0x78443c3c, 0x25ba9f9f, 0x4be3a8a8,
+	/*70*/	0xa2f35151, 0x5dfea3a3, 0x80c04040, 0x058a8f8f, 0x3fad9292, 0x21bc9d9d, 0x70483838, 0xf104f5f5,
+	/*78*/	0x63dfbcbc, 0x77c1b6b6, 0xaf75dada, 0x42632121, 0x20301010, 0xe51affff, 0xfd0ef3f3, 0xbf6dd2d2,
+	/*80*/	0x814ccdcd, 0x18140c0c, 0x26351313, 0xc32fecec, 0xbee15f5f, 0x35a29797, 0x88cc4444, 0x2e391717,
+	/*88*/	0x9357c4c4, 0x55f2a7a7, 0xfc827e7e, 0x7a473d3d, 0xc8ac6464, 0xbae75d5d, 0x322b1919, 0xe6957373,
+	/*90*/	0xc0a06060, 0x19988181, 0x9ed14f4f, 0xa37fdcdc, 0x44662222, 0x547e2a2a, 0x3bab9090, 0x0b838888,
+	/*98*/	0x8cca4646, 0xc729eeee, 0x6bd3b8b8, 0x283c1414, 0xa779dede, 0xbce25e5e, 0x161d0b0b, 0xad76dbdb,
+	/*a0*/	0xdb3be0e0, 0x64563232, 0x744e3a3a, 0x141e0a0a, 0x92db4949, 0x0c0a0606, 0x486c2424, 0xb8e45c5c,
+	/*a8*/	0x9f5dc2c2, 0xbd6ed3d3, 0x43efacac, 0xc4a66262, 0x39a89191, 0x31a49595, 0xd337e4e4, 0xf28b7979,
+	/*b0*/	0xd532e7e7, 0x8b43c8c8, 0x6e593737, 0xdab76d6d, 0x018c8d8d, 0xb164d5d5, 0x9cd24e4e, 0x49e0a9a9,
+	/*b8*/	0xd8b46c6c, 0xacfa5656, 0xf307f4f4, 0xcf25eaea, 0xcaaf6565, 0xf48e7a7a, 0x47e9aeae, 0x10180808,
+	/*c0*/	0x6fd5baba, 0xf0887878, 0x4a6f2525, 0x5c722e2e, 0x38241c1c, 0x57f1a6a6, 0x73c7b4b4, 0x9751c6c6,
+	/*c8*/	0xcb23e8e8, 0xa17cdddd, 0xe89c7474, 0x3e211f1f, 0x96dd4b4b, 0x61dcbdbd, 0x0d868b8b, 0x0f858a8a,
+	/*d0*/	0xe0907070, 0x7c423e3e, 0x71c4b5b5, 0xccaa6666, 0x90d84848, 0x06050303, 0xf701f6f6, 0x1c120e0e,
+	/*d8*/	0xc2a36161, 0x6a5f3535, 0xaef95757, 0x69d0b9b9, 0x17918686, 0x9958c1c1, 0x3a271d1d, 0x27b99e9e,
+	/*e0*/	0xd938e1e1, 0xeb13f8f8, 0x2bb39898, 0x22331111, 0xd2bb6969, 0xa970d9d9, 0x07898e8e, 0x33a79494,
+	/*e8*/	0x2db69b9b, 0x3c221e1e, 0x15928787, 0xc920e9e9, 0x8749cece, 0xaaff5555, 0x50782828, 0xa57adfdf,
+	/*f0*/	0x038f8c8c, 0x59f8a1a1, 0x09808989, 0x1a170d0d, 0x65dabfbf, 0xd731e6e6, 0x84c64242, 0xd0b86868,
+	/*f8*/	0x82c34141, 0x29b09999, 0x5a772d2d, 0x1e110f0f, 0x7bcbb0b0, 0xa8fc5454, 0x6dd6bbbb, 0x2c3a1616,
+};
+
+// InvSubBytes and InvMixColumns of a row 0 byte, columns as little-endian words
+static const uint32_t oaes_td0[256] = {
+	/*00*/	0x50a7f451, 0x5365417e, 0xc3a4171a, 0x965e273a, 0xcb6bab3b, 0xf1459d1f, 0xab58faac, 0x9303e34b,
+	/*08*/	0x55fa3020, 0xf66d76ad, 0x9176cc88, 0x254c02f5, 0xfcd7e54f, 0xd7cb2ac5, 0x80443526, 0x8fa362b5,
+	/*10*/	0x495ab1de, 0x671bba25, 0x980eea45, 0xe1c0fe5d, 0x02752fc3, 0x12f04c81, 0xa397468d, 0xc6f9d36b,
+	/*18*/	0xe75f8f03, 0x959c9215, 0xeb7a6dbf, 0xda595295, 0x2d83bed4, 0xd3217458, 0x2969e049, 0x44c8c98e,
+	/*20*/	0x6a89c275, 0x78798ef4, 0x6b3e5899, 0xdd71b927, 0xb64fe1be, 0x17ad88f0, 0x66ac20c9, 0xb43ace7d,
+	/*28*/	0x184adf63, 0x82311ae5, 0x60335197, 0x457f5362, 0xe07764b1, 0x84ae6bbb, 0x1ca081fe, 0x942b08f9,
+	/*30*/	0x58684870, 0x19fd458f, 0x876cde94, 0xb7f87b52, 0x23d373ab, 0xe2024b72, 0x578f1fe3, 0x2aab5566,
+	/*38*/	0x0728ebb2, 0x03c2b52f, 0x9a7bc586, 0xa50837d3, 0xf2872830, 0xb2a5bf23, 0xba6a0302, 0x5c8216ed,
+	/*40*/	0x2b1ccf8a, 0x92b479a7, 0xf0f207f3, 0xa1e2694e, 0xcdf4da65, 0xd5be0506, 0x1f6234d1, 0x8afea6c4,
+	/*48*/	0x9d532e34, 0xa055f3a2, 0x32e18a05, 0x75ebf6a4, 0x39ec830b, 0xaaef6040, 0x069f715e, 0x51106ebd,
+	/*50*/	0xf98a213e, 0x3d06dd96, 0xae053edd, 0x46bde64d, 0xb58d5491, 0x055dc471, 0x6fd40604, 0xff155060,
+	/*58*/	0x24fb9819, 0x97e9bdd6, 0xcc434089, 0x779ed967, 0xbd42e8b0, 0x888b8907, 0x385b19e7, 0xdbeec879,
+	/*60*/	0x470a7ca1, 0xe90f427c, 0xc91e84f8, 0x00000000, 0x83868009, 0x48ed2b32, 0xac70111e, 0x4e725a6c,
+	/*68*/	0xfbff0efd, 0x5638850f, 0x1ed5ae3d, 0x27392d36, 0x64d90f0a, 0x21a65c68, 0xd1545b9b, 0x3a2e3624,
+	/*70*/	0xb1670a0c, 0x0fe75793, 0xd296eeb4, 0x9e919b1b, 0x4fc5c080, 0xa220dc61, 0x694b775a, 0x161a121c,
+	/*78*/	0x0aba93e2, 0xe52aa0c0, 0x43e0223c, 0x1d171b12, 0x0b0d090e, 0xadc78bf2, 0xb9a8b62d, 0xc8a91e14,
+	/*80*/	0x8519f157, 0x4c0775af, 0xbbdd99ee, 0xfd607fa3, 0x9f2601f7, 0xbcf5725c, 0xc53b6644, 0x347efb5b,
+	/*88*/	0x7629438b, 0xdcc623cb, 0x68fcedb6, 0x63f1e4b8, 0xcadc31d7, 0x10856342, 0x40229713, 0x2011c684,
+	/*90*/	0x7d244a85, 0xf83dbbd2, 0x1132f9ae, 0x6da129c7, 0x4b2f9e1d, 0xf330b2dc, 0xec52860d, 0xd0e3c177,
+	/*98*/	0x6c16b32b, 0x99b970a9, 0xfa489411, 0x2264e947, 0xc48cfca8, 0x1a3ff0a0, 0xd82c7d56, 0xef903322,
+	/*a0*/	0xc74e4987, 0xc1d138d9, 0xfea2ca8c, 0x360bd498, 0xcf81f5a6, 0x28de7aa5, 0x268eb7da, 0xa4bfad3f,
+	/*a8*/	0xe49d3a2c, 0x0d927850, 0x9bcc5f6a, 0x62467e54, 0xc2138df6, 0xe8b8d890, 0x5ef7392e, 0xf5afc382,
+	/*b0*/	0xbe805d9f, 0x7c93d069, 0xa92dd56f, 0xb31225cf, 0x3b99acc8, 0xa77d1810, 0x6e639ce8, 0x7bbb3bdb,
+	/*b8*/	0x097826cd, 0xf418596e, 0x01b79aec, 0xa89a4f83, 0x656e95e6, 0x7ee6ffaa, 0x08cfbc21, 0xe6e815ef,
+	/*c0*/	0xd99be7ba, 0xce366f4a, 0xd4099fea, 0xd67cb029, 0xafb2a431, 0x31233f2a, 0x3094a5c6, 0xc066a235,
+	/*c8*/	0x37bc4e74, 0xa6ca82fc, 0xb0d090e0, 0x15d8a733, 0x4a9804f1, 0xf7daec41, 0x0e50cd7f, 0x2ff69117,
+	/*d0*/	0x8dd64d76, 0x4db0ef43, 0x544daacc, 0xdf0496e4, 0xe3b5d19e, 0x1b886a4c, 0xb81f2cc1, 0x7f516546,
+	/*d8*/	0x04ea5e9d, 0x5d358c01, 0x737487fa, 0x2e410bfb, 0x5a1d67b3, 0x52d2db92, 0x335610e9, 0x1347d66d,
+	/*e0*/	0x8c61d79a, 0x7a0ca137, 0x8e14f859, 0x893c13eb, 0xee27a9ce, 0x35c961b7, 0xede51ce1, 0x3cb1477a,
+	/*e8*/	0x59dfd29c, 0x3f73f255, 0x79ce1418, 0xbf37c773, 0xeacdf753, 0x5baafd5f, 0x146f3ddf, 0x86db4478,
+	/*f0*/	0x81f3afca, 0x3ec468b9, 0x2c342438, 0x5f40a3c2, 0x72c31d16, 0x0c25e2bc, 0x8b493c28, 0x41950dff,
+	/*f8*/	0x7101a839, 0xdeb30c08, 0x9ce4b4d8, 0x90c15664, 0x6184cb7b, 0x70b632d5, 0x745c6c48, 0x4257b8d0,
+};
+
+// oaes_td0 rotated left by 8 bits, for a row 1 byte
+static const uint32_t oaes_td1[256] = {
+	/*00*/	0xa7f45150, 0x65417e53, 0xa4171ac3, 0x5e273a96, 0x6bab3bcb, 0x459d1ff1, 0x58faacab, 0x03e34b93,
+	/*08*/	0xfa302055, 0x6d76adf6, 0x76cc8891, 0x4c02f525, 0xd7e54ffc, 0xcb2ac5d7, 0x44352680, 0xa362b58f,
+	/*10*/	0x5ab1de49, 0x1bba2567, 0x0eea4598, 0xc0fe5de1, 0x752fc302, 0xf04c8112, 0x97468da3, 0xf9d36bc6,
+	/*18*/	0x5f8f03e7, 0x9c921595, 0x7a6dbfeb, 0x595295da, 0x83bed42d, 0x217458d3, 0x69e04929, 0xc8c98e44,
+	/*20*/	0x89c2756a, 0x798ef478, 0x3e58996b, 0x71b927dd, 0x4fe1beb6, 0xad88f017, 0xac20c966, 0x3ace7db4,
+	/*28*/	0x4adf6318, 0x311ae582, 0x33519760, 0x7f536245, 0x7764b1e0, 0xae6bbb84, 0xa081fe1c, 0x2b08f994,
+	/*30*/	0x68487058, 0xfd458f19, 0x6cde9487, 0xf87b52b7, 0xd373ab23, 0x024b72e2, 0x8f1fe357, 0xab55662a,
+	/*38*/	0x28ebb207, 0xc2b52f03, 0x7bc5869a, 0x0837d3a5, 0x872830f2, 0xa5bf23b2, 0x6a0302ba, 0x8216ed5c,
+	/*40*/	0x1ccf8a2b, 0xb479a792, 0xf207f3f0, 0xe2694ea1, 0xf4da65cd, 0xbe0506d5, 0x6234d11f, 0xfea6c48a,
+	/*48*/	0x532e349d, 0x55f3a2a0, 0xe18a0532, 0xebf6a475, 0xec830b39, 0xef6040aa, 0x9f715e06, 0x106ebd51,
+	/*50*/	0x8a213ef9, 0x06dd963d, 0x053eddae, 0xbde64d46, 0x8d5491b5, 0x5dc47105, 0xd406046f, 0x155060ff,
+	/*58*/	0xfb981924, 0xe9bdd697, 0x434089cc, 0x9ed96777, 0x42e8b0bd, 0x8b890788, 0x5b19e738, 0xeec879db,
+	/*60*/	0x0a7ca147, 0x0f427ce9, 0x1e84f8c9, 0x00000000, 0x86800983, 0xed2b3248, 0x70111eac, 0x725a6c4e,
+	/*68*/	0xff0efdfb, 0x38850f56, 0xd5ae3d1e, 0x392d3627, 0xd90f0a64, 0xa65c6821, 0x545b9bd1, 0x2e36243a,
+	/*70*/	0x670a0cb1, 0xe757930f, 0x96eeb4d2, 0x919b1b9e, 0xc5c0804f, 0x20dc61a2, 0x4b775a69, 0x1a121c16,
+	/*78*/	0xba93e20a, 0x2aa0c0e5, 0xe0223c43, 0x171b121d, 0x0d090e0b, 0xc78bf2ad, 0xa8b62db9, 0xa91e14c8,
+	/*80*/	0x19f15785, 0x0775af4c, 0xdd99eebb, 0x607fa3fd, 0x2601f79f, 0xf5725cbc, 0x3b6644c5, 0x7efb5b34,
+	/*88*/	0x29438b76, 0xc623cbdc, 0xfcedb668, 0xf1e4b863, 0xdc31d7ca, 0x85634210, 0x22971340, 0x11c68420,
+	/*90*/	0x244a857d, 0x3dbbd2f8, 0x32f9ae11, 0xa129c76d, 0x2f9e1d4b, 0x30b2dcf3, 0x52860dec, 0xe3c177d0,
+	/*98*/	0x16b32b6c, 0xb970a999, 0x489411fa, 0x64e94722, 0x8cfca8c4, 0x3ff0a01a, 0x2c7d56d8, 0x903322ef,
+	/*a0*/	0x4e4987c7, 0xd138d9c1, 0xa2ca8cfe, 0x0bd49836, 0x81f5a6cf, 0xde7aa528, 0x8eb7da26, 0xbfad3fa4,
+	/*a8*/	0x9d3a2ce4, 0x9278500d, 0xcc5f6a9b, 0x467e5462, 0x138df6c2, 0xb8d890e8, 0xf7392e5e, 0xafc382f5,
+	/*b0*/	0x805d9fbe, 0x93d0697c, 0x2dd56fa9, 0x1225cfb3, 0x99acc83b, 0x7d1810a7, 0x639ce86e, 0xbb3bdb7b,
+	/*b8*/	0x7826cd09, 0x18596ef4, 0xb79aec01, 0x9a4f83a8, 0x6e95e665, 0xe6ffaa7e, 0xcfbc2108, 0xe815efe6,
+	/*c0*/	0x9be7bad9, 0x366f4ace, 0x099fead4, 0x7cb029d6, 0xb2a431af, 0x233f2a31, 0x94a5c630, 0x66a235c0,
+	/*c8*/	0xbc4e7437, 0xca82fca6, 0xd090e0b0, 0xd8a73315, 0x9804f14a, 0xdaec41f7, 0x50cd7f0e, 0xf691172f,
+	/*d0*/	0xd64d768d, 0xb0ef434d, 0x4daacc54, 0x0496e4df, 0xb5d19ee3, 0x886a4c1b, 0x1f2cc1b8, 0x5165467f,
+	/*d8*/	0xea5e9d04, 0x358c015d, 0x7487fa73, 0x410bfb2e, 0x1d67b35a, 0xd2db9252, 0x5610e933, 0x47d66d13,
+	/*e0*/	0x61d79a8c, 0x0ca1377a, 0x14f8598e, 0x3c13eb89, 0x27a9ceee, 0xc961b735, 0xe51ce1ed, 0xb1477a3c,
+	/*e8*/	0xdfd29c59, 0x73f2553f, 0xce141879, 0x37c773bf, 0xcdf753ea, 0xaafd5f5b, 0x6f3ddf14, 0xdb447886,
+	/*f0*/	0xf3afca81, 0xc468b93e, 0x3424382c, 0x40a3c25f, 0xc31d1672, 0x25e2bc0c, 0x493c288b, 0x950dff41,
+	/*f8*/	0x01a83971, 0xb30c08de, 0xe4b4d89c, 0xc1566490, 0x84cb7b61, 0xb632d570, 0x5c6c4874, 0x57b8d042,
+};
+
+// oaes_td0 rotated left by 16 bits, for a row 2 byte
+static const uint32_t oaes_td2[256] = {
+	/*00*/	0xf45150a7, 0x417e5365, 0x171ac3a4, 0x273a965e, 0xab3bcb6b, 0x9d1ff145, 0xfaacab58, 0xe34b9303,
+	/*08*/	0x302055fa, 0x76adf66d, 0xcc889176, 0x02f5254c, 0xe54ffcd7, 0x2ac5d7cb, 0x35268044, 0x62b58fa3,
+	/*10*/	0xb1de495a, 0xba25671b, 0xea45980e, 0xfe5de1c0, 0x2fc30275, 0x4c8112f0, 0x468da397, 0xd36bc6f9,
+	/*18*/	0x8f03e75f, 0x9215959c, 0x6dbfeb7a, 0x5295da59, 0xbed42d83, 0x7458d321, 0xe0492969, 0xc98e44c8,
+	/*20*/	0xc2756a89, 0x8ef47879, 0x58996b3e, 0xb927dd71, 0xe1beb64f, 0x88f017ad, 0x20c966ac, 0xce7db43a,
+	/*28*/	0xdf63184a, 0x1ae58231, 0x51976033, 0x5362457f, 0x64b1e077, 0x6bbb84ae, 0x81fe1ca0, 0x08f9942b,
+	/*30*/	0x48705868, 0x458f19fd, 0xde94876c, 0x7b52b7f8, 0x73ab23d3, 0x4b72e202, 0x1fe3578f, 0x55662aab,
+	/*38*/	0xebb20728, 0xb52f03c2, 0xc5869a7b, 0x37d3a508, 0x2830f287, 0xbf23b2a5, 0x0302ba6a, 0x16ed5c82,
+	/*40*/	0xcf8a2b1c, 0x79a792b4, 0x07f3f0f2, 0x694ea1e2, 0xda65cdf4, 0x0506d5be, 0x34d11f62, 0xa6c48afe,
+	/*48*/	0x2e349d53, 0xf3a2a055, 0x8a0532e1, 0xf6a475eb, 0x830b39ec, 0x6040aaef, 0x715e069f, 0x6ebd5110,
+	/*50*/	0x213ef98a, 0xdd963d06, 0x3eddae05, 0xe64d46bd, 0x5491b58d, 0xc471055d, 0x06046fd4, 0x5060ff15,
+	/*58*/	0x981924fb, 0xbdd697e9, 0x4089cc43, 0xd967779e, 0xe8b0bd42, 0x8907888b, 0x19e7385b, 0xc879dbee,
+	/*60*/	0x7ca1470a, 0x427ce90f, 0x84f8c91e, 0x00000000, 0x80098386, 0x2b3248ed, 0x111eac70, 0x5a6c4e72,
+	/*68*/	0x0efdfbff, 0x850f5638, 0xae3d1ed5, 0x2d362739, 0x0f0a64d9, 0x5c6821a6, 0x5b9bd154, 0x36243a2e,
+	/*70*/	0x0a0cb167, 0x57930fe7, 0xeeb4d296, 0x9b1b9e91, 0xc0804fc5, 0xdc61a220, 0x775a694b, 0x121c161a,
+	/*78*/	0x93e20aba, 0xa0c0e52a, 0x223c43e0, 0x1b121d17, 0x090e0b0d, 0x8bf2adc7, 0xb62db9a8, 0x1e14c8a9,
+	/*80*/	0xf1578519, 0x75af4c07, 0x99eebbdd, 0x7fa3fd60, 0x01f79f26, 0x725cbcf5, 0x6644c53b, 0xfb5b347e,
+	/*88*/	0x438b7629, 0x23cbdcc6, 0xedb668fc, 0xe4b863f1, 0x31d7cadc, 0x63421085, 0x97134022, 0xc6842011,
+	/*90*/	0x4a857d24, 0xbbd2f83d, 0xf9ae1132, 0x29c76da1, 0x9e1d4b2f, 0xb2dcf330, 0x860dec52, 0xc177d0e3,
+	/*98*/	0xb32b6c16, 0x70a999b9, 0x9411fa48, 0xe9472264, 0xfca8c48c, 0xf0a01a3f, 0x7d56d82c, 0x3322ef90,
+	/*a0*/	0x4987c74e, 0x38d9c1d1, 0xca8cfea2, 0xd498360b, 0xf5a6cf81, 0x7aa528de, 0xb7da268e, 0xad3fa4bf,
+	/*a8*/	0x3a2ce49d, 0x78500d92, 0x5f6a9bcc, 0x7e546246, 0x8df6c213, 0xd890e8b8, 0x392e5ef7, 0xc382f5af,
+	/*b0*/	0x5d9fbe80, 0xd0697c93, 0xd56fa92d, 0x25cfb312, 0xacc83b99, 0x1810a77d, 0x9ce86e63, 0x3bdb7bbb,
+	/*b8*/	0x26cd0978, 0x596ef418, 0x9aec01b7, 0x4f83a89a, 0x95e6656e, 0xffaa7ee6, 0xbc2108cf, 0x15efe6e8,
+	/*c0*/	0xe7bad99b, 0x6f4ace36, 0x9fead409, 0xb029d67c, 0xa431afb2, 0x3f2a3123, 0xa5c63094, 0xa235c066,
+	/*c8*/	0x4e7437bc, 0x82fca6ca, 0x90e0b0d0, 0xa73315d8, 0x04f14a98, 0xec41f7da, 0xcd7f0e50, 0x91172ff6,
+	/*d0*/	0x4d768dd6, 0xef434db0, 0xaacc544d, 0x96e4df04, 0xd19ee3b5, 0x6a4c1b88, 0x2cc1b81f, 0x65467f51,
+	/*d8*/	0x5e9d04ea, 0x8c015d35, 0x87fa7374, 0x0bfb2e41, 0x67b35a1d, 0xdb9252d2, 0x10e93356, 0xd66d1347,
+	/*e0*/	0xd79a8c61, 0xa1377a0c, 0xf8598e14, 0x13eb893c, 0xa9ceee27, 0x61b735c9, 0x1ce1ede5, 0x477a3cb1,
+	/*e8*/	0xd29c59df, 0xf2553f73, 0x141879ce, 0xc773bf37, 0xf753eacd, 0xfd5f5baa, 0x3ddf146f, 0x447886db,
+	/*f0*/	0xafca81f3, 0x68b93ec4, 0x24382c34, 0xa3c25f40, 0x1d1672c3, 0xe2bc0c25, 0x3c288b49, 0x0dff4195,
+	/*f8*/	0xa8397101, 0x0c08deb3, 0xb4d89ce4, 0x566490c1, 0xcb7b6184, 0x32d570b6, 0x6c48745c, 0xb8d04257,
+};
+
+// oaes_td0 rotated left by 24 bits, for a row 3 byte
+static const uint32_t oaes_td3[256] = {
+	/*00*/	0x5150a7f4, 0x7e536541, 0x1ac3a417, 0x3a965e27, 0x3bcb6bab, 0x1ff1459d, 0xacab58fa, 0x4b9303e3,
+	/*08*/	0x2055fa30, 0xadf66d76, 0x889176cc, 0xf5254c02, 0x4ffcd7e5, 0xc5d7cb2a, 0x26804435, 0xb58fa362,
+	/*10*/	0xde495ab1, 0x25671bba, 0x45980eea, 0x5de1c0fe, 0xc302752f, 0x8112f04c, 0x8da39746, 0x6bc6f9d3,
+	/*18*/	0x03e75f8f, 0x15959c92, 0xbfeb7a6d, 0x95da5952, 0xd42d83be, 0x58d32174, 0x492969e0, 0x8e44c8c9,
+	/*20*/	0x756a89c2, 0xf478798e, 0x996b3e58, 0x27dd71b9, 0xbeb64fe1, 0xf017ad88, 0xc966ac20, 0x7db43ace,
+	/*28*/	0x63184adf, 0xe582311a, 0x97603351, 0x62457f53, 0xb1e07764, 0xbb84ae6b, 0xfe1ca081, 0xf9942b08,
+	/*30*/	0x70586848, 0x8f19fd45, 0x94876cde, 0x52b7f87b, 0xab23d373, 0x72e2024b, 0xe3578f1f, 0x662aab55,
+	/*38*/	0xb20728eb, 0x2f03c2b5, 0x869a7bc5, 0xd3a50837, 0x30f28728, 0x23b2a5bf, 0x02ba6a03, 0xed5c8216,
+	/*40*/	0x8a2b1ccf, 0xa792b479, 0xf3f0f207, 0x4ea1e269, 0x65cdf4da, 0x06d5be05, 0xd11f6234, 0xc48afea6,
+	/*48*/	0x349d532e, 0xa2a055f3, 0x0532e18a, 0xa475ebf6, 0x0b39ec83, 0x40aaef60, 0x5e069f71, 0xbd51106e,
+	/*50*/	0x3ef98a21, 0x963d06dd, 0xddae053e, 0x4d46bde6, 0x91b58d54, 0x71055dc4, 0x046fd406, 0x60ff1550,
+	/*58*/	0x1924fb98, 0xd697e9bd, 0x89cc4340, 0x67779ed9, 0xb0bd42e8, 0x07888b89, 0xe7385b19, 0x79dbeec8,
+	/*60*/	0xa1470a7c, 0x7ce90f42, 0xf8c91e84, 0x00000000, 0x09838680, 0x3248ed2b, 0x1eac7011, 0x6c4e725a,
+	/*68*/	0xfdfbff0e, 0x0f563885, 0x3d1ed5ae, 0x3627392d, 0x0a64d90f, 0x6821a65c, 0x9bd1545b, 0x243a2e36,
+	/*70*/	0x0cb1670a, 0x930fe757, 0xb4d296ee, 0x1b9e919b, 0x804fc5c0, 0x61a220dc, 0x5a694b77, 0x1c161a12,
+	/*78*/	0xe20aba93, 0xc0e52aa0, 0x3c43e022, 0x121d171b, 0x0e0b0d09, 0xf2adc78b, 0x2db9a8b6, 0x14c8a91e,
+	/*80*/	0x578519f1, 0xaf4c0775, 0xeebbdd99, 0xa3fd607f, 0xf79f2601, 0x5cbcf572, 0x44c53b66, 0x5b347efb,
+	/*88*/	0x8b762943, 0xcbdcc623, 0xb668fced, 0xb863f1e4, 0xd7cadc31, 0x42108563, 0x13402297, 0x842011c6,
+	/*90*/	0x857d244a, 0xd2f83dbb, 0xae1132f9, 0xc76da129, 0x1d4b2f9e, 0xdcf330b2, 0x0dec5286, 0x77d0e3c1,
+	/*98*/	0x2b6c16b3, 0xa999b970, 0x11fa4894, 0x472264e9, 0xa8c48cfc, 0xa01a3ff0, 0x56d82c7d, 0x22ef9033,
+	/*a0*/	0x87c74e49, 0xd9c1d138, 0x8cfea2ca, 0x98360bd4, 0xa6cf81f5, 0xa528de7a, 0xda268eb7, 0x3fa4bfad,
+	/*a8*/	0x2ce49d3a, 0x500d9278, 0x6a9bcc5f, 0x5462467e, 0xf6c2138d, 0x90e8b8d8, 0x2e5ef739, 0x82f5afc3,
+	/*b0*/	0x9fbe805d, 0x697c93d0, 0x6fa92dd5, 0xcfb31225, 0xc83b99ac, 0x10a77d18, 0xe86e639c, 0xdb7bbb3b,
+	/*b8*/	0xcd097826, 0x6ef41859, 0xec01b79a, 0x83a89a4f, 0xe6656e95, 0xaa7ee6ff, 0x2108cfbc, 0xefe6e815,
+	/*c0*/	0xbad99be7, 0x4ace366f, 0xead4099f, 0x29d67cb0, 0x31afb2a4, 0x2a31233f, 0xc63094a5, 0x35c066a2,
+	/*c8*/	0x7437bc4e, 0xfca6ca82, 0xe0b0d090, 0x3315d8a7, 0xf14a9804, 0x41f7daec, 0x7f0e50cd, 0x172ff691,
+	/*d0*/	0x768dd64d, 0x434db0ef, 0xcc544daa, 0xe4df0496, 0x9ee3b5d1, 0x4c1b886a, 0xc1b81f2c, 0x467f5165,
+	/*d8*/	0x9d04ea5e, 0x015d358c, 0xfa737487, 0xfb2e410b, 0xb35a1d67, 0x9252d2db, 0xe9335610, 0x6d1347d6,
+	/*e0*/	0x9a8c61d7, 0x377a0ca1, 0x598e14f8, 0xeb893c13, 0xceee27a9, 0xb735c961, 0xe1ede51c, 0x7a3cb147,
+	/*e8*/	0x9c59dfd2, 0x553f73f2, 0x1879ce14, 0x73bf37c7, 0x53eacdf7, 0x5f5baafd, 0xdf146f3d, 0x7886db44,
+	/*f0*/	0xca81f3af, 0xb93ec468, 0x382c3424, 0xc25f40a3, 0x1672c31d, 0xbc0c25e2, 0x288b493c, 0xff41950d,
+	/*f8*/	0x397101a8, 0x08deb30c, 0xd89ce4b4, 0x6490c156, 0x7b6184cb, 0xd570b632, 0x48745c6c, 0xd04257b8,
+};
+
+static OAES_RET oaes_sub_byte( uint8_t * byte )
 {
 	size_t _x, _y;
 	
@@ -282,7 +813,7 @@ static OAES_RET oaes_inv_sub_byte( uint8_t * byte )
 	_x &= 0x0f;
 	_y &= 0xf0;
 	_y >>= 4;
-	*byte = oaes_inv_sub_byte_value[_y][_x];
+	*byte = oaes_sub_byte_value[_y][_x];
 	
 	return OAES_RET_SUCCESS;
 }
@@ -315,1085 +846,6648 @@ static OAES_RET oaes_word_rot_left( uint8_t word[OAES_COL_LEN] )
 	return OAES_RET_SUCCESS;
 }
 
-static OAES_RET oaes_shift_rows( uint8_t block[OAES_BLOCK_SIZE] )
-{
-	uint8_t _temp[OAES_BLOCK_SIZE];
+// the state byte in row r of a column word, as a table index
+#define OAES_ROW0( w ) ( (w) & 0xff )
+#define OAES_ROW1( w ) ( ( (w) >> 8 ) & 0xff )
+#define OAES_ROW2( w ) ( ( (w) >> 16 ) & 0xff )
+#define OAES_ROW3( w ) ( (w) >> 24 )
 
-	if( NULL == block )
-		return OAES_RET_ARG1;
+#define OAES_SBOX( x ) oaes_sub_byte_value[(x) >> 4][(x) & 0x0f]
+#define OAES_INV_SBOX( x ) oaes_inv_sub_byte_value[(x) >> 4][(x) & 0x0f]
 
-	_temp[0x00] = block[0x00];
-	_temp[0x01] = block[0x05];
-	_temp[0x02] = block[0x0a];
-	_temp[0x03] = block[0x0f];
-	_temp[0x04] = block[0x04];
-	_temp[0x05] = block[0x09];
-	_temp[0x06] = block[0x0e];
-	_temp[0x07] = block[0x03];
-	_temp[0x08] = block[0x08];
-	_temp[0x09] = block[0x0d];
-	_temp[0x0a] = block[0x02];
-	_temp[0x0b] = block[0x07];
-	_temp[0x0c] = block[0x0c];
-	_temp[0x0d] = block[0x01];
-	_temp[0x0e] = block[0x06];
-	_temp[0x0f] = block[0x0b];
-	memcpy( block, _temp, OAES_BLOCK_SIZE );
-	
-	return OAES_RET_SUCCESS;
+static uint32_t oaes_get_word( const uint8_t * p )
+{
+	return (uint32_t) p[0] | ( (uint32_t) p[1] << 8 ) |
+			( (uint32_t) p[2] << 16 ) | ( (uint32_t) p[3] << 24 );
 }
 
-static OAES_RET oaes_inv_shift_rows( uint8_t block[OAES_BLOCK_SIZE] )
+static void oaes_put_word( uint8_t * p, uint32_t w )
 {
-	uint8_t _temp[OAES_BLOCK_SIZE];
-
-	if( NULL == block )
-		return OAES_RET_ARG1;
+	p[0] = (uint8_t) w;
+	p[1] = (uint8_t) ( w >> 8 );
+	p[2] = (uint8_t) ( w >> 16 );
+	p[3] = (uint8_t) ( w >> 24 );
+}
 
-	_temp[0x00] = block[0x00];
-	_temp[0x01] = block[0x0d];
-	_temp[0x02] = block[0x0a];
-	_temp[0x03] = block[0x07];
-	_temp[0x04] = block[0x04];
-	_temp[0x05] = block[0x01];
-	_temp[0x06] = block[0x0e];
-	_temp[0x07] = block[0x0b];
-	_temp[0x08] = block[0x08];
-	_temp[0x09] = block[0x05];
-	_temp[0x0a] = block[0x02];
-	_temp[0x0b] = block[0x0f];
-	_temp[0x0c] = block[0x0c];
-	_temp[0x0d] = block[0x09];
-	_temp[0x0e] = block[0x06];
-	_temp[0x0f] = block[0x03];
-	memcpy( block, _temp, OAES_BLOCK_SIZE );
-	
-	return OAES_RET_SUCCESS;
+// InvMixColumns of a round key column, oaes_td* undo the S-box of oaes_te*
+static uint32_t oaes_inv_mix_word( uint32_t w )
+{
+	return oaes_td0[ ( oaes_te0[ OAES_ROW0( w ) ] >> 8 ) & 0xff ] ^
+			oaes_td1[ ( oaes_te0[ OAES_ROW1( w ) ] >> 8 ) & 0xff ] ^
+			oaes_td2[ ( oaes_te0[ OAES_ROW2( w ) ] >> 8 ) & 0xff ] ^
+			oaes_td3[ ( oaes_te0[ OAES_ROW3( w ) ] >> 8 ) & 0xff ];
 }
 
-static uint8_t oaes_gf_mul(uint8_t left, uint8_t right)
+// the state is kept as four column words, each round is 16 table lookups
+static void oaes_table_encrypt( const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE] )
 {
-	size_t _x, _y;
-	
-	_x = _y = left;
-	_x &= 0x0f;
-	_y &= 0xf0;
-	_y >>= 4;
-	
-	switch( right )
+	size_t _i;
+	const uint8_t * _rk = key->exp_data;
+	uint32_t _s0, _s1, _s2, _s3, _t0, _t1, _t2, _t3;
+
+	// AddRoundKey(State, K0)
+	_s0 = oaes_get_word( c ) ^ oaes_get_word( _rk );
+	_s1 = oaes_get_word( c + 4 ) ^ oaes_get_word( _rk + 4 );
+	_s2 = oaes_get_word( c + 8 ) ^ oaes_get_word( _rk + 8 );
+	_s3 = oaes_get_word( c + 12 ) ^ oaes_get_word( _rk + 12 );
+
+	// for round = 1 step 1 to Nr–1
+	for( _i = 1; _i < key->num_keys - 1; _i++ )
 	{
-		case 0x02:
-			return oaes_gf_mul_2[_y][_x];
-			break;
-		case 0x03:
-			return oaes_gf_mul_3[_y][_x];
-			break;
-		case 0x09:
-			return oaes_gf_mul_9[_y][_x];
-			break;
-		case 0x0b:
-			return oaes_gf_mul_b[_y][_x];
-			break;
-		case 0x0d:
-			return oaes_gf_mul_d[_y][_x];
-			break;
-		case 0x0e:
-			return oaes_gf_mul_e[_y][_x];
-			break;
-		default:
-			return left;
-			break;
+		_rk += OAES_BLOCK_SIZE;
+
+		// SubBytes, ShiftRows, MixColumns and AddRoundKey
+		_t0 = oaes_te0[ OAES_ROW0( _s0 ) ] ^ oaes_te1[ OAES_ROW1( _s1 ) ] ^
+				oaes_te2[ OAES_ROW2( _s2 ) ] ^ oaes_te3[ OAES_ROW3( _s3 ) ] ^
+				oaes_get_word( _rk );
+		_t1 = oaes_te0[ OAES_ROW0( _s1 ) ] ^ oaes_te1[ OAES_ROW1( _s2 ) ] ^
+				oaes_te2[ OAES_ROW2( _s3 ) ] ^ oaes_te3[ OAES_ROW3( _s0 ) ] ^
+				oaes_get_word( _rk + 4 );
+		_t2 = oaes_te0[ OAES_ROW0( _s2 ) ] ^ oaes_te1[ OAES_ROW1( _s3 ) ] ^
+				oaes_te2[ OAES_ROW2( _s0 ) ] ^ oaes_te3[ OAES_ROW3( _s1 ) ] ^
+				oaes_get_word( _rk + 8 );
+		_t3 = oaes_te0[ OAES_ROW0( _s3 ) ] ^ oaes_te1[ OAES_ROW1( _s0 ) ] ^
+				oaes_te2[ OAES_ROW2( _s1 ) ] ^ oaes_te3[ OAES_ROW3( _s2 ) ] ^
+				oaes_get_word( _rk + 12 );
+		_s0 = _t0;
+		_s1 = _t1;
+		_s2 = _t2;
+		_s3 = _t3;
 	}
+
+	_rk += OAES_BLOCK_SIZE;
+
+	// SubBytes, ShiftRows and AddRoundKey, the S-box byte is picked out of
+	// whichever oaes_te* holds it unmultiplied in the right row
+	_t0 = ( oaes_te2[ OAES_ROW0( _s0 ) ] & 0x000000ff ) ^
+			( oaes_te3[ OAES_ROW1( _s1 ) ] & 0x0000ff00 ) ^
+			( oaes_te0[ OAES_ROW2( _s2 ) ] & 0x00ff0000 ) ^
+			( oaes_te1[ OAES_ROW3( _s3 ) ] & 0xff000000 ) ^ oaes_get_word( _rk );
+	_t1 = ( oaes_te2[ OAES_ROW0( _s1 ) ] & 0x000000ff ) ^
+			( oaes_te3[ OAES_ROW1( _s2 ) ] & 0x0000ff00 ) ^
+			( oaes_te0[ OAES_ROW2( _s3 ) ] & 0x00ff0000 ) ^
+			( oaes_te1[ OAES_ROW3( _s0 ) ] & 0xff000000 ) ^ oaes_get_word( _rk + 4 );
+	_t2 = ( oaes_te2[ OAES_ROW0( _s2 ) ] & 0x000000ff ) ^
+			( oaes_te3[ OAES_ROW1( _s3 ) ] & 0x0000ff00 ) ^
+			( oaes_te0[ OAES_ROW2( _s0 ) ] & 0x00ff0000 ) ^
+			( oaes_te1[ OAES_ROW3( _s1 ) ] & 0xff000000 ) ^ oaes_get_word( _rk + 8 );
+	_t3 = ( oaes_te2[ OAES_ROW0( _s3 ) ] & 0x000000ff ) ^
+			( oaes_te3[ OAES_ROW1( _s0 ) ] & 0x0000ff00 ) ^
+			( oaes_te0[ OAES_ROW2( _s1 ) ] & 0x00ff0000 ) ^
+			( oaes_te1[ OAES_ROW3( _s2 ) ] & 0xff000000 ) ^ oaes_get_word( _rk + 12 );
+
+	oaes_put_word( c, _t0 );
+	oaes_put_word( c + 4, _t1 );
+	oaes_put_word( c + 8, _t2 );
+	oaes_put_word( c + 12, _t3 );
 }
 
-static OAES_RET oaes_mix_cols( uint8_t word[OAES_COL_LEN] )
+// equivalent inverse cipher schedule, InvMixColumns is applied to the middle
+// round keys so that the fused oaes_td* rounds can add them after mixing
+static void oaes_key_expand_dec( oaes_key * key )
 {
-	uint8_t _temp[OAES_COL_LEN];
+	size_t _i, _j;
 
-	if( NULL == word )
-		return OAES_RET_ARG1;
-	
-	_temp[0] = oaes_gf_mul(word[0], 0x02) ^ oaes_gf_mul( word[1], 0x03 ) ^
-			word[2] ^ word[3];
-	_temp[1] = word[0] ^ oaes_gf_mul( word[1], 0x02 ) ^
-			oaes_gf_mul( word[2], 0x03 ) ^ word[3];
-	_temp[2] = word[0] ^ word[1] ^
-			oaes_gf_mul( word[2], 0x02 ) ^ oaes_gf_mul( word[3], 0x03 );
-	_temp[3] = oaes_gf_mul( word[0], 0x03 ) ^ word[1] ^
-			word[2] ^ oaes_gf_mul( word[3], 0x02 );
-	memcpy( word, _temp, OAES_COL_LEN );
-	
-	return OAES_RET_SUCCESS;
+	memcpy( key->dec_data, key->exp_data, OAES_BLOCK_SIZE );
+	for( _i = OAES_BLOCK_SIZE; _i < ( key->num_keys - 1 ) * OAES_BLOCK_SIZE;
+			_i += OAES_BLOCK_SIZE )
+		for( _j = 0; _j < OAES_BLOCK_SIZE; _j += OAES_COL_LEN )
+			oaes_put_word( key->dec_data + _i + _j,
+					oaes_inv_mix_word( oaes_get_word( key->exp_data + _i + _j ) ) );
+	memcpy( key->dec_data + _i, key->exp_data + _i, OAES_BLOCK_SIZE );
 }
 
-static OAES_RET oaes_inv_mix_cols( uint8_t word[OAES_COL_LEN] )
+static void oaes_table_decrypt( const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE] )
 {
-	uint8_t _temp[OAES_COL_LEN];
+	size_t _i;
+	const uint8_t * _rk =
+			key->dec_data + ( key->num_keys - 1 ) * OAES_BLOCK_SIZE;
+	uint32_t _s0, _s1, _s2, _s3, _t0, _t1, _t2, _t3;
 
-	if( NULL == word )
-		return OAES_RET_ARG1;
-	
-	_temp[0] = oaes_gf_mul( word[0], 0x0e ) ^ oaes_gf_mul( word[1], 0x0b ) ^
-			oaes_gf_mul( word[2], 0x0d ) ^ oaes_gf_mul( word[3], 0x09 );
-	_temp[1] = oaes_gf_mul( word[0], 0x09 ) ^ oaes_gf_mul( word[1], 0x0e ) ^
-			oaes_gf_mul( word[2], 0x0b ) ^ oaes_gf_mul( word[3], 0x0d );
-	_temp[2] = oaes_gf_mul( word[0], 0x0d ) ^ oaes_gf_mul( word[1], 0x09 ) ^
-			oaes_gf_mul( word[2], 0x0e ) ^ oaes_gf_mul( word[3], 0x0b );
-	_temp[3] = oaes_gf_mul( word[0], 0x0b ) ^ oaes_gf_mul( word[1], 0x0d ) ^
-			oaes_gf_mul( word[2], 0x09 ) ^ oaes_gf_mul( word[3], 0x0e );
-	memcpy( word, _temp, OAES_COL_LEN );
-	
-	return OAES_RET_SUCCESS;
+	// AddRoundKey(state, w[Nr*Nb, (Nr+1)*Nb-1])
+	_s0 = oaes_get_word( c ) ^ oaes_get_word( _rk );
+	_s1 = oaes_get_word( c + 4 ) ^ oaes_get_word( _rk + 4 );
+	_s2 = oaes_get_word( c + 8 ) ^ oaes_get_word( _rk + 8 );
+	_s3 = oaes_get_word( c + 12 ) ^ oaes_get_word( _rk + 12 );
+
+	for( _i = key->num_keys - 2; _i > 0; _i-- )
+	{
+		_rk -= OAES_BLOCK_SIZE;
+
+		// InvShiftRows, InvSubBytes, InvMixColumns and AddRoundKey
+		_t0 = oaes_td0[ OAES_ROW0( _s0 ) ] ^ oaes_td1[ OAES_ROW1( _s3 ) ] ^
+				oaes_td2[ OAES_ROW2( _s2 ) ] ^ oaes_td3[ OAES_ROW3( _s1 ) ] ^
+				oaes_get_word( _rk );
+		_t1 = oaes_td0[ OAES_ROW0( _s1 ) ] ^ oaes_td1[ OAES_ROW1( _s0 ) ] ^
+				oaes_td2[ OAES_ROW2( _s3 ) ] ^ oaes_td3[ OAES_ROW3( _s2 ) ] ^
+				oaes_get_word( _rk + 4 );
+		_t2 = oaes_td0[ OAES_ROW0( _s2 ) ] ^ oaes_td1[ OAES_ROW1( _s1 ) ] ^
+				oaes_td2[ OAES_ROW2( _s0 ) ] ^ oaes_td3[ OAES_ROW3( _s3 ) ] ^
+				oaes_get_word( _rk + 8 );
+		_t3 = oaes_td0[ OAES_ROW0( _s3 ) ] ^ oaes_td1[ OAES_ROW1( _s2 ) ] ^
+				oaes_td2[ OAES_ROW2( _s1 ) ] ^ oaes_td3[ OAES_ROW3( _s0 ) ] ^
+				oaes_get_word( _rk + 12 );
+		_s0 = _t0;
+		_s1 = _t1;
+		_s2 = _t2;
+		_s3 = _t3;
+	}
+
+	_rk -= OAES_BLOCK_SIZE;
+
+	// InvShiftRows, InvSubBytes and AddRoundKey(state, w[0, Nb-1])
+	_t0 = ( (uint32_t) OAES_INV_SBOX( OAES_ROW0( _s0 ) ) ) ^
+			( (uint32_t) OAES_INV_SBOX( OAES_ROW1( _s3 ) ) << 8 ) ^
+			( (uint32_t) OAES_INV_SBOX( OAES_ROW2( _s2 ) ) << 16 ) ^
+			( (uint32_t) OAES_INV_SBOX( OAES_ROW3( _s1 ) ) << 24 ) ^
+			oaes_get_word( _rk );
+	_t1 = ( (uint32_t) OAES_INV_SBOX( OAES_ROW0( _s1 ) ) ) ^
+			( (uint32_t) OAES_INV_SBOX( OAES_ROW1( _s0 ) ) << 8 ) ^
+			( (uint32_t) OAES_INV_SBOX( OAES_ROW2( _s3 ) ) << 16 ) ^
+			( (uint32_t) OAES_INV_SBOX( OAES_ROW3( _s2 ) ) << 24 ) ^
+			oaes_get_word( _rk + 4 );
+	_t2 = ( (uint32_t) OAES_INV_SBOX( OAES_ROW0( _s2 ) ) ) ^
+			( (uint32_t) OAES_INV_SBOX( OAES_ROW1( _s1 ) ) << 8 ) ^
+			( (uint32_t) OAES_INV_SBOX( OAES_ROW2( _s0 ) ) << 16 ) ^
+			( (uint32_t) OAES_INV_SBOX( OAES_ROW3( _s3 ) ) << 24 ) ^
+			oaes_get_word( _rk + 8 );
+	_t3 = ( (uint32_t) OAES_INV_SBOX( OAES_ROW0( _s3 ) ) ) ^
+			( (uint32_t) OAES_INV_SBOX( OAES_ROW1( _s2 ) ) << 8 ) ^
+			( (uint32_t) OAES_INV_SBOX( OAES_ROW2( _s1 ) ) << 16 ) ^
+			( (uint32_t) OAES_INV_SBOX( OAES_ROW3( _s0 ) ) << 24 ) ^
+			oaes_get_word( _rk + 12 );
+
+	oaes_put_word( c, _t0 );
+	oaes_put_word( c + 4, _t1 );
+	oaes_put_word( c + 8, _t2 );
+	oaes_put_word( c + 12, _t3 );
 }
 
-OAES_RET oaes_sprintf(
-		char * buf, size_t * buf_len, const uint8_t * data, size_t data_len )
+// one fused round over the column words s0..s3 into t0..t3
+#define OAES_TE_ROUND( s0, s1, s2, s3, t0, t1, t2, t3, k0, k1, k2, k3 ) \
+	do { \
+		t0 = oaes_te0[ OAES_ROW0( s0 ) ] ^ oaes_te1[ OAES_ROW1( s1 ) ] ^ \
+				oaes_te2[ OAES_ROW2( s2 ) ] ^ oaes_te3[ OAES_ROW3( s3 ) ] ^ k0; \
+		t1 = oaes_te0[ OAES_ROW0( s1 ) ] ^ oaes_te1[ OAES_ROW1( s2 ) ] ^ \
+				oaes_te2[ OAES_ROW2( s3 ) ] ^ oaes_te3[ OAES_ROW3( s0 ) ] ^ k1; \
+		t2 = oaes_te0[ OAES_ROW0( s2 ) ] ^ oaes_te1[ OAES_ROW1( s3 ) ] ^ \
+				oaes_te2[ OAES_ROW2( s0 ) ] ^ oaes_te3[ OAES_ROW3( s1 ) ] ^ k2; \
+		t3 = oaes_te0[ OAES_ROW0( s3 ) ] ^ oaes_te1[ OAES_ROW1( s0 ) ] ^ \
+				oaes_te2[ OAES_ROW2( s1 ) ] ^ oaes_te3[ OAES_ROW3( s2 ) ] ^ k3; \
+	} while( 0 )
+
+#define OAES_TD_ROUND( s0, s1, s2, s3, t0, t1, t2, t3, k0, k1, k2, k3 ) \
+	do { \
+		t0 = oaes_td0[ OAES_ROW0( s0 ) ] ^ oaes_td1[ OAES_ROW1( s3 ) ] ^ \
+				oaes_td2[ OAES_ROW2( s2 ) ] ^ oaes_td3[ OAES_ROW3( s1 ) ] ^ k0; \
+		t1 = oaes_td0[ OAES_ROW0( s1 ) ] ^ oaes_td1[ OAES_ROW1( s0 ) ] ^ \
+				oaes_td2[ OAES_ROW2( s3 ) ] ^ oaes_td3[ OAES_ROW3( s2 ) ] ^ k1; \
+		t2 = oaes_td0[ OAES_ROW0( s2 ) ] ^ oaes_td1[ OAES_ROW1( s1 ) ] ^ \
+				oaes_td2[ OAES_ROW2( s0 ) ] ^ oaes_td3[ OAES_ROW3( s3 ) ] ^ k2; \
+		t3 = oaes_td0[ OAES_ROW0( s3 ) ] ^ oaes_td1[ OAES_ROW1( s2 ) ] ^ \
+				oaes_td2[ OAES_ROW2( s1 ) ] ^ oaes_td3[ OAES_ROW3( s0 ) ] ^ k3; \
+	} while( 0 )
+
+// the last rounds, the S-box bytes are picked as in oaes_table_encrypt()
+#define OAES_TE_LAST( c, s0, s1, s2, s3, k0, k1, k2, k3 ) \
+	do { \
+		oaes_put_word( c, ( oaes_te2[ OAES_ROW0( s0 ) ] & 0x000000ff ) ^ \
+				( oaes_te3[ OAES_ROW1( s1 ) ] & 0x0000ff00 ) ^ \
+				( oaes_te0[ OAES_ROW2( s2 ) ] & 0x00ff0000 ) ^ \
+				( oaes_te1[ OAES_ROW3( s3 ) ] & 0xff000000 ) ^ k0 ); \
+		oaes_put_word( c + 4, ( oaes_te2[ OAES_ROW0( s1 ) ] & 0x000000ff ) ^ \
+				( oaes_te3[ OAES_ROW1( s2 ) ] & 0x0000ff00 ) ^ \
+				( oaes_te0[ OAES_ROW2( s3 ) ] & 0x00ff0000 ) ^ \
+				( oaes_te1[ OAES_ROW3( s0 ) ] & 0xff000000 ) ^ k1 ); \
+		oaes_put_word( c + 8, ( oaes_te2[ OAES_ROW0( s2 ) ] & 0x000000ff ) ^ \
+				( oaes_te3[ OAES_ROW1( s3 ) ] & 0x0000ff00 ) ^ \
+				( oaes_te0[ OAES_ROW2( s0 ) ] & 0x00ff0000 ) ^ \
+				( oaes_te1[ OAES_ROW3( s1 ) ] & 0xff000000 ) ^ k2 ); \
+		oaes_put_word( c + 12, ( oaes_te2[ OAES_ROW0( s3 ) ] & 0x000000ff ) ^ \
+				( oaes_te3[ OAES_ROW1( s0 ) ] & 0x0000ff00 ) ^ \
+				( oaes_te0[ OAES_ROW2( s1 ) ] & 0x00ff0000 ) ^ \
+				( oaes_te1[ OAES_ROW3( s2 ) ] & 0xff000000 ) ^ k3 ); \
+	} while( 0 )
+
+#define OAES_TD_LAST( c, s0, s1, s2, s3, k0, k1, k2, k3 ) \
+	do { \
+		oaes_put_word( c, ( (uint32_t) OAES_INV_SBOX( OAES_ROW0( s0 ) ) ) ^ \
+				( (uint32_t) OAES_INV_SBOX( OAES_ROW1( s3 ) ) << 8 ) ^ \
+				( (uint32_t) OAES_INV_SBOX( OAES_ROW2( s2 ) ) << 16 ) ^ \
+				( (uint32_t) OAES_INV_SBOX( OAES_ROW3( s1 ) ) << 24 ) ^ k0 ); \
+		oaes_put_word( c + 4, ( (uint32_t) OAES_INV_SBOX( OAES_ROW0( s1 ) ) ) ^ \
+				( (uint32_t) OAES_INV_SBOX( OAES_ROW1( s0 ) ) << 8 ) ^ \
+				( (uint32_t) OAES_INV_SBOX( OAES_ROW2( s3 ) ) << 16 ) ^ \
+				( (uint32_t) OAES_INV_SBOX( OAES_ROW3( s2 ) ) << 24 ) ^ k1 ); \
+		oaes_put_word( c + 8, ( (uint32_t) OAES_INV_SBOX( OAES_ROW0( s2 ) ) ) ^ \
+				( (uint32_t) OAES_INV_SBOX( OAES_ROW1( s1 ) ) << 8 ) ^ \
+				( (uint32_t) OAES_INV_SBOX( OAES_ROW2( s0 ) ) << 16 ) ^ \
+				( (uint32_t) OAES_INV_SBOX( OAES_ROW3( s3 ) ) << 24 ) ^ k2 ); \
+		oaes_put_word( c + 12, ( (uint32_t) OAES_INV_SBOX( OAES_ROW0( s3 ) ) ) ^ \
+				( (uint32_t) OAES_INV_SBOX( OAES_ROW1( s2 ) ) << 8 ) ^ \
+				( (uint32_t) OAES_INV_SBOX( OAES_ROW2( s1 ) ) << 16 ) ^ \
+				( (uint32_t) OAES_INV_SBOX( OAES_ROW3( s0 ) ) << 24 ) ^ k3 ); \
+	} while( 0 )
+
+#define OAES_TABLE_LOAD( c, s0, s1, s2, s3, k ) \
+	do { \
+		s0 = oaes_get_word( c ) ^ oaes_get_word( k ); \
+		s1 = oaes_get_word( c + 4 ) ^ oaes_get_word( k + 4 ); \
+		s2 = oaes_get_word( c + 8 ) ^ oaes_get_word( k + 8 ); \
+		s3 = oaes_get_word( c + 12 ) ^ oaes_get_word( k + 12 ); \
+	} while( 0 )
+
+// OAES_TABLE_WAYS blocks go through the rounds side by side, so that the
+// lookups of one block overlap with those of the others instead of waiting
+// on a single dependency chain
+#define OAES_TABLE_WAYS 4
+
+static void oaes_table_encrypt_ways( const oaes_key * key,
+		uint8_t c[OAES_TABLE_WAYS * OAES_BLOCK_SIZE] )
 {
-	size_t _i, _buf_len_in;
-	char _temp[4];
-	
-	if( NULL == buf_len )
-		return OAES_RET_ARG2;
+	size_t _i;
+	const uint8_t * _rk = key->exp_data;
+	uint32_t _a0, _a1, _a2, _a3, _b0, _b1, _b2, _b3;
+	uint32_t _c0, _c1, _c2, _c3, _d0, _d1, _d2, _d3;
+	uint32_t _t0, _t1, _t2, _t3, _k0, _k1, _k2, _k3;
 
-	_buf_len_in = *buf_len;
-	*buf_len = data_len * 3 + data_len / OAES_BLOCK_SIZE + 1;
-	
-	if( NULL == buf )
-		return OAES_RET_SUCCESS;
+	OAES_TABLE_LOAD( c, _a0, _a1, _a2, _a3, _rk );
+	OAES_TABLE_LOAD( c + 1 * OAES_BLOCK_SIZE, _b0, _b1, _b2, _b3, _rk );
+	OAES_TABLE_LOAD( c + 2 * OAES_BLOCK_SIZE, _c0, _c1, _c2, _c3, _rk );
+	OAES_TABLE_LOAD( c + 3 * OAES_BLOCK_SIZE, _d0, _d1, _d2, _d3, _rk );
 
-	if( *buf_len > _buf_len_in )
-		return OAES_RET_BUF;
+	for( _i = 1; _i < key->num_keys - 1; _i++ )
+	{
+		_rk += OAES_BLOCK_SIZE;
+		_k0 = oaes_get_word( _rk );
+		_k1 = oaes_get_word( _rk + 4 );
+		_k2 = oaes_get_word( _rk + 8 );
+		_k3 = oaes_get_word( _rk + 12 );
+
+		OAES_TE_ROUND( _a0, _a1, _a2, _a3, _t0, _t1, _t2, _t3, _k0, _k1, _k2, _k3 );
+		_a0 = _t0; _a1 = _t1; _a2 = _t2; _a3 = _t3;
+		OAES_TE_ROUND( _b0, _b1, _b2, _b3, _t0, _t1, _t2, _t3, _k0, _k1, _k2, _k3 );
+		_b0 = _t0; _b1 = _t1; _b2 = _t2; _b3 = _t3;
+		OAES_TE_ROUND( _c0, _c1, _c2, _c3, _t0, _t1, _t2, _t3, _k0, _k1, _k2, _k3 );
+		_c0 = _t0; _c1 = _t1; _c2 = _t2; _c3 = _t3;
+		OAES_TE_ROUND( _d0, _d1, _d2, _d3, _t0, _t1, _t2, _t3, _k0, _k1, _k2, _k3 );
+		_d0 = _t0; _d1 = _t1; _d2 = _t2; _d3 = _t3;
+	}
 
-	if( NULL == data )
-		return OAES_RET_ARG3;
+	_rk += OAES_BLOCK_SIZE;
+	_k0 = oaes_get_word( _rk );
+	_k1 = oaes_get_word( _rk + 4 );
+	_k2 = oaes_get_word( _rk + 8 );
+	_k3 = oaes_get_word( _rk + 12 );
 
-	strcpy( buf, "" );
-	
-	for( _i = 0; _i < data_len; _i++ )
+	OAES_TE_LAST( c, _a0, _a1, _a2, _a3, _k0, _k1, _k2, _k3 );
+	OAES_TE_LAST( c + 1 * OAES_BLOCK_SIZE, _b0, _b1, _b2, _b3, _k0, _k1, _k2, _k3 );
+	OAES_TE_LAST( c + 2 * OAES_BLOCK_SIZE, _c0, _c1, _c2, _c3, _k0, _k1, _k2, _k3 );
+	OAES_TE_LAST( c + 3 * OAES_BLOCK_SIZE, _d0, _d1, _d2, _d3, _k0, _k1, _k2, _k3 );
+}
+
+static void oaes_table_decrypt_ways( const oaes_key * key,
+		uint8_t c[OAES_TABLE_WAYS * OAES_BLOCK_SIZE] )
+{
+	size_t _i;
+	const uint8_t * _rk = key->dec_data + ( key->num_keys - 1 ) * OAES_BLOCK_SIZE;
+	uint32_t _a0, _a1, _a2, _a3, _b0, _b1, _b2, _b3;
+	uint32_t _c0, _c1, _c2, _c3, _d0, _d1, _d2, _d3;
+	uint32_t _t0, _t1, _t2, _t3, _k0, _k1, _k2, _k3;
+
+	OAES_TABLE_LOAD( c, _a0, _a1, _a2, _a3, _rk );
+	OAES_TABLE_LOAD( c + 1 * OAES_BLOCK_SIZE, _b0, _b1, _b2, _b3, _rk );
+	OAES_TABLE_LOAD( c + 2 * OAES_BLOCK_SIZE, _c0, _c1, _c2, _c3, _rk );
+	OAES_TABLE_LOAD( c + 3 * OAES_BLOCK_SIZE, _d0, _d1, _d2, _d3, _rk );
+
+	for( _i = key->num_keys - 2; _i > 0; _i-- )
 	{
-		sprintf( _temp, "%02x ", data[_i] );
-		strcat( buf, _temp );
-		if( _i && 0 == ( _i + 1 ) % OAES_BLOCK_SIZE )
-			strcat( buf, "\n" );
+		_rk -= OAES_BLOCK_SIZE;
+		_k0 = oaes_get_word( _rk );
+		_k1 = oaes_get_word( _rk + 4 );
+		_k2 = oaes_get_word( _rk + 8 );
+		_k3 = oaes_get_word( _rk + 12 );
+
+		OAES_TD_ROUND( _a0, _a1, _a2, _a3, _t0, _t1, _t2, _t3, _k0, _k1, _k2, _k3 );
+		_a0 = _t0; _a1 = _t1; _a2 = _t2; _a3 = _t3;
+		OAES_TD_ROUND( _b0, _b1, _b2, _b3, _t0, _t1, _t2, _t3, _k0, _k1, _k2, _k3 );
+		_b0 = _t0; _b1 = _t1; _b2 = _t2; _b3 = _t3;
+		OAES_TD_ROUND( _c0, _c1, _c2, _c3, _t0, _t1, _t2, _t3, _k0, _k1, _k2, _k3 );
+		_c0 = _t0; _c1 = _t1; _c2 = _t2; _c3 = _t3;
+		OAES_TD_ROUND( _d0, _d1, _d2, _d3, _t0, _t1, _t2, _t3, _k0, _k1, _k2, _k3 );
+		_d0 = _t0; _d1 = _t1; _d2 = _t2; _d3 = _t3;
 	}
-	
-	return OAES_RET_SUCCESS;
+
+	_rk -= OAES_BLOCK_SIZE;
+	_k0 = oaes_get_word( _rk );
+	_k1 = oaes_get_word( _rk + 4 );
+	_k2 = oaes_get_word( _rk + 8 );
+	_k3 = oaes_get_word( _rk + 12 );
+
+	OAES_TD_LAST( c, _a0, _a1, _a2, _a3, _k0, _k1, _k2, _k3 );
+	OAES_TD_LAST( c + 1 * OAES_BLOCK_SIZE, _b0, _b1, _b2, _b3, _k0, _k1, _k2, _k3 );
+	OAES_TD_LAST( c + 2 * OAES_BLOCK_SIZE, _c0, _c1, _c2, _c3, _k0, _k1, _k2, _k3 );
+	OAES_TD_LAST( c + 3 * OAES_BLOCK_SIZE, _d0, _d1, _d2, _d3, _k0, _k1, _k2, _k3 );
 }
 
-#ifdef OAES_HAVE_ISAAC
-static void oaes_get_seed( char buf[RANDSIZ + 1] )
+static void oaes_table_encrypt_blocks(
+		const oaes_key * key, uint8_t * c, size_t count )
 {
-	struct timeb timer;
-	struct tm *gmTimer;
-	char * _test = NULL;
-	
-	ftime (&timer);
-	gmTimer = gmtime( &timer.time );
-	_test = (char *) calloc( sizeof( char ), timer.millitm );
-	sprintf( buf, "%04d%02d%02d%02d%02d%02d%03d%p%d",
-		gmTimer->tm_year + 1900, gmTimer->tm_mon + 1, gmTimer->tm_mday,
-		gmTimer->tm_hour, gmTimer->tm_min, gmTimer->tm_sec, timer.millitm,
-		_test + timer.millitm, getpid() );
-	
-	if( _test )
-		free( _test );
+	for( ; count >= OAES_TABLE_WAYS; count -= OAES_TABLE_WAYS )
+	{
+		oaes_table_encrypt_ways( key, c );
+		c += OAES_TABLE_WAYS * OAES_BLOCK_SIZE;
+	}
+	for( ; count; count-- )
+	{
+		oaes_table_encrypt( key, c );
+		c += OAES_BLOCK_SIZE;
+	}
 }
-#else
-static uint32_t oaes_get_seed()
+
+static void oaes_table_decrypt_blocks(
+		const oaes_key * key, uint8_t * c, size_t count )
 {
-	struct timeb timer;
-	struct tm *gmTimer;
-	char * _test = NULL;
-	uint32_t _ret = 0;
-	
-	ftime (&timer);
-	gmTimer = gmtime( &timer.time );
-	_test = (char *) calloc( sizeof( char ), timer.millitm );
-	_ret = gmTimer->tm_year + 1900 + gmTimer->tm_mon + 1 + gmTimer->tm_mday +
-			gmTimer->tm_hour + gmTimer->tm_min + gmTimer->tm_sec + timer.millitm +
+	for( ; count >= OAES_TABLE_WAYS; count -= OAES_TABLE_WAYS )
+	{
+		oaes_table_decrypt_ways( key, c );
+		c += OAES_TABLE_WAYS * OAES_BLOCK_SIZE;
+	}
+	for( ; count; count-- )
+	{
+		oaes_table_decrypt( key, c );
+		c += OAES_BLOCK_SIZE;
+	}
+}
+
+#define OAES_TABLE_RK( n, w ) oaes_get_word( _rk + (n) * OAES_BLOCK_SIZE + (w) * 4 )
+
+#define OAES_TE_STEP( n ) \
+	OAES_TE_ROUND( _s0, _s1, _s2, _s3, _t0, _t1, _t2, _t3, \
+			OAES_TABLE_RK( n, 0 ), OAES_TABLE_RK( n, 1 ), \
+			OAES_TABLE_RK( n, 2 ), OAES_TABLE_RK( n, 3 ) ); \
+	_s0 = _t0; _s1 = _t1; _s2 = _t2; _s3 = _t3;
+
+#define OAES_TD_STEP( n ) \
+	OAES_TD_ROUND( _s0, _s1, _s2, _s3, _t0, _t1, _t2, _t3, \
+			OAES_TABLE_RK( n, 0 ), OAES_TABLE_RK( n, 1 ), \
+			OAES_TABLE_RK( n, 2 ), OAES_TABLE_RK( n, 3 ) ); \
+	_s0 = _t0; _s1 = _t1; _s2 = _t2; _s3 = _t3;
+
+// oaes_table_encrypt() and oaes_table_decrypt() with the rounds spelled out,
+// the blocks functions stay generic, unrolling them would take 4 times the
+// code for little gain
+#define OAES_TABLE_UNROLLED( nr, rounds, rounds_down ) \
+static void oaes_table_encrypt_##nr( \
+		const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE] ) \
+{ \
+	const uint8_t * _rk = key->exp_data; \
+	uint32_t _s0, _s1, _s2, _s3, _t0, _t1, _t2, _t3; \
+\
+	OAES_TABLE_LOAD( c, _s0, _s1, _s2, _s3, _rk ); \
+	rounds( OAES_TE_STEP ) \
+	OAES_TE_LAST( c, _s0, _s1, _s2, _s3, \
+			OAES_TABLE_RK( nr, 0 ), OAES_TABLE_RK( nr, 1 ), \
+			OAES_TABLE_RK( nr, 2 ), OAES_TABLE_RK( nr, 3 ) ); \
+} \
+\
+static void oaes_table_decrypt_##nr( \
+		const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE] ) \
+{ \
+	const uint8_t * _rk = key->dec_data; \
+	uint32_t _s0, _s1, _s2, _s3, _t0, _t1, _t2, _t3; \
+\
+	OAES_TABLE_LOAD( c, _s0, _s1, _s2, _s3, _rk + (nr) * OAES_BLOCK_SIZE ); \
+	rounds_down( OAES_TD_STEP ) \
+	OAES_TD_LAST( c, _s0, _s1, _s2, _s3, \
+			OAES_TABLE_RK( 0, 0 ), OAES_TABLE_RK( 0, 1 ), \
+			OAES_TABLE_RK( 0, 2 ), OAES_TABLE_RK( 0, 3 ) ); \
+} \
+\
+static const oaes_kernels oaes_kernels_table_##nr = { \
+	oaes_table_encrypt_##nr, \
+	oaes_table_decrypt_##nr, \
+	oaes_table_encrypt_blocks, \
+	oaes_table_decrypt_blocks, \
+};
+
+OAES_TABLE_UNROLLED( 10, OAES_ROUNDS_9, OAES_ROUNDS_9_DOWN )
+OAES_TABLE_UNROLLED( 12, OAES_ROUNDS_11, OAES_ROUNDS_11_DOWN )
+OAES_TABLE_UNROLLED( 14, OAES_ROUNDS_13, OAES_ROUNDS_13_DOWN )
+
+static const oaes_engine oaes_engine_table = {
+	"table",
+	0,
+	NULL,
+	0,
+	0,
+	NULL,
+	{
+		oaes_table_encrypt,
+		oaes_table_decrypt,
+		oaes_table_encrypt_blocks,
+		oaes_table_decrypt_blocks,
+	},
+	{
+		&oaes_kernels_table_10,
+		&oaes_kernels_table_12,
+		&oaes_kernels_table_14,
+	},
+};
+
+#if OAES_HAVE_AESNI
+static void oaes_engine_aesni_key_expand( oaes_key * key )
+{
+	oaes_aesni_key_expand( key->data, key->data_len,
+			key->exp_data, key->dec_data, key->num_keys );
+}
+
+static void oaes_engine_aesni_encrypt(
+		const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE] )
+{
+	oaes_aesni_encrypt( key->exp_data, key->num_keys, c );
+}
+
+static void oaes_engine_aesni_decrypt(
+		const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE] )
+{
+	oaes_aesni_decrypt( key->dec_data, key->num_keys, c );
+}
+
+static void oaes_engine_aesni_encrypt_blocks(
+		const oaes_key * key, uint8_t * c, size_t count )
+{
+	oaes_aesni_encrypt_blocks( key->exp_data, key->num_keys, c, count );
+}
+
+static void oaes_engine_aesni_decrypt_blocks(
+		const oaes_key * key, uint8_t * c, size_t count )
+{
+	oaes_aesni_decrypt_blocks( key->dec_data, key->num_keys, c, count );
+}
+
+#define OAES_ENGINE_AESNI_UNROLLED( nr ) \
+static void oaes_engine_aesni_encrypt_##nr( \
+		const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE] ) \
+{ \
+	oaes_aesni_encrypt_##nr( key->exp_data, c ); \
+} \
+\
+static void oaes_engine_aesni_decrypt_##nr( \
+		const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE] ) \
+{ \
+	oaes_aesni_decrypt_##nr( key->dec_data, c ); \
+} \
+\
+static void oaes_engine_aesni_encrypt_blocks_##nr( \
+		const oaes_key * key, uint8_t * c, size_t count ) \
+{ \
+	oaes_aesni_encrypt_blocks_##nr( key->exp_data, c, count ); \
+} \
+\
+static void oaes_engine_aesni_decrypt_blocks_##nr( \
+		const oaes_key * key, uint8_t * c, size_t count ) \
+{ \
+	oaes_aesni_decrypt_blocks_##nr( key->dec_data, c, count ); \
+} \
+\
+static const oaes_kernels oaes_kernels_aesni_##nr = { \
+	oaes_engine_aesni_encrypt_##nr, \
+	oaes_engine_aesni_decrypt_##nr, \
+	oaes_engine_aesni_encrypt_blocks_##nr, \
+	oaes_engine_aesni_decrypt_blocks_##nr, \
+};
+
+OAES_ENGINE_AESNI_UNROLLED( 10 )
+OAES_ENGINE_AESNI_UNROLLED( 12 )
+OAES_ENGINE_AESNI_UNROLLED( 14 )
+
+static const oaes_engine oaes_engine_aesni = {
+	"aesni",
+	OAES_CPU_AESNI,
+	oaes_engine_aesni_key_expand,
+	0,
+	0,
+	NULL,
+	{
+		oaes_engine_aesni_encrypt,
+		oaes_engine_aesni_decrypt,
+		oaes_engine_aesni_encrypt_blocks,
+		oaes_engine_aesni_decrypt_blocks,
+	},
+	{
+		&oaes_kernels_aesni_10,
+		&oaes_kernels_aesni_12,
+		&oaes_kernels_aesni_14,
+	},
+};
+#endif // OAES_HAVE_AESNI
+
+#if OAES_HAVE_BITSLICE
+static void oaes_engine_bitslice_key_setup( oaes_key * key )
+{
+	oaes_bitslice_key_setup( key->exp_data, key->num_keys, key->engine_data );
+}
+
+static void oaes_engine_bitslice_encrypt_blocks(
+		const oaes_key * key, uint8_t * c, size_t count )
+{
+	uint8_t _buf[OAES_BITSLICE_BLOCKS * OAES_BLOCK_SIZE];
+
+	for( ; count >= OAES_BITSLICE_BLOCKS; count -= OAES_BITSLICE_BLOCKS )
+	{
+		oaes_bitslice_encrypt( key->engine_data, key->num_keys, c );
+		c += OAES_BITSLICE_BLOCKS * OAES_BLOCK_SIZE;
+	}
+	
+	// a short batch still goes through the bitsliced rounds, the tables
+	// would bring back the cache timing leak
+	if( count )
+	{
+		memset( _buf, 0, sizeof( _buf ) );
+		memcpy( _buf, c, count * OAES_BLOCK_SIZE );
+		oaes_bitslice_encrypt( key->engine_data, key->num_keys, _buf );
+		memcpy( c, _buf, count * OAES_BLOCK_SIZE );
+	}
+}
+
+static void oaes_engine_bitslice_decrypt_blocks(
+		const oaes_key * key, uint8_t * c, size_t count )
+{
+	uint8_t _buf[OAES_BITSLICE_BLOCKS * OAES_BLOCK_SIZE];
+
+	for( ; count >= OAES_BITSLICE_BLOCKS; count -= OAES_BITSLICE_BLOCKS )
+	{
+		oaes_bitslice_decrypt( key->engine_data, key->num_keys, c );
+		c += OAES_BITSLICE_BLOCKS * OAES_BLOCK_SIZE;
+	}
+	
+	if( count )
+	{
+		memset( _buf, 0, sizeof( _buf ) );
+		memcpy( _buf, c, count * OAES_BLOCK_SIZE );
+		oaes_bitslice_decrypt( key->engine_data, key->num_keys, _buf );
+		memcpy( c, _buf, count * OAES_BLOCK_SIZE );
+	}
+}
+
+static void oaes_engine_bitslice_encrypt(
+		const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE] )
+{
+	oaes_engine_bitslice_encrypt_blocks( key, c, 1 );
+}
+
+static void oaes_engine_bitslice_decrypt(
+		const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE] )
+{
+	oaes_engine_bitslice_decrypt_blocks( key, c, 1 );
+}
+
+static const oaes_engine oaes_engine_bitslice = {
+	"bitslice",
+	OAES_CPU_SSE2,
+	NULL,
+	0,
+	OAES_BITSLICE_KEY_SIZE,
+	oaes_engine_bitslice_key_setup,
+	{
+		oaes_engine_bitslice_encrypt,
+		oaes_engine_bitslice_decrypt,
+		oaes_engine_bitslice_encrypt_blocks,
+		oaes_engine_bitslice_decrypt_blocks,
+	},
+	{ NULL, NULL, NULL },
+};
+#endif // OAES_HAVE_BITSLICE
+
+#if OAES_HAVE_VPERM
+static void oaes_engine_vperm_encrypt(
+		const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE] )
+{
+	oaes_vperm_encrypt( key->exp_data, key->num_keys, c );
+}
+
+static void oaes_engine_vperm_decrypt(
+		const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE] )
+{
+	oaes_vperm_decrypt( key->exp_data, key->num_keys, c );
+}
+
+// serial work runs one block at a time through PSHUFB, batches of
+// independent blocks go to the bitsliced rounds when they are built in
+static const oaes_engine oaes_engine_vperm = {
+	"vperm",
+	OAES_CPU_SSSE3,
+	NULL,
+	0,
+#if OAES_HAVE_BITSLICE
+	OAES_BITSLICE_KEY_SIZE,
+	oaes_engine_bitslice_key_setup,
+#else
+	0,
+	NULL,
+#endif // OAES_HAVE_BITSLICE
+	{
+		oaes_engine_vperm_encrypt,
+		oaes_engine_vperm_decrypt,
+#if OAES_HAVE_BITSLICE
+		oaes_engine_bitslice_encrypt_blocks,
+		oaes_engine_bitslice_decrypt_blocks,
+#else
+		NULL,
+		NULL,
+#endif // OAES_HAVE_BITSLICE
+	},
+	{ NULL, NULL, NULL },
+};
+#endif // OAES_HAVE_VPERM
+
+#if OAES_HAVE_COMPACT
+// the compact engine keeps nothing but key->data, the round keys are expanded
+// as the rounds need them, the S-boxes are the only tables it looks up and
+// MixColumns is done with xtime on whole columns
+
+// the blocks a batch runs through each round together, sharing the round key
+#define OAES_COMPACT_BLOCKS 16
+
+#define OAES_ROTR8( w ) ( ( (w) >> 8 ) | ( (w) << 24 ) )
+#define OAES_ROTR16( w ) ( ( (w) >> 16 ) | ( (w) << 16 ) )
+
+// xtime of the four bytes of a column at once
+static uint32_t oaes_compact_xtime( uint32_t w )
+{
+	return ( ( w & 0x7f7f7f7f ) << 1 ) ^ ( ( ( w >> 7 ) & 0x01010101 ) * 0x1b );
+}
+
+static uint32_t oaes_compact_sub_word( uint32_t w )
+{
+	return (uint32_t) OAES_SBOX( OAES_ROW0( w ) ) |
+			( (uint32_t) OAES_SBOX( OAES_ROW1( w ) ) << 8 ) |
+			( (uint32_t) OAES_SBOX( OAES_ROW2( w ) ) << 16 ) |
+			( (uint32_t) OAES_SBOX( OAES_ROW3( w ) ) << 24 );
+}
+
+// ring holds nk consecutive words of the key schedule, w[i] in the slot of
+// w[i - nk], xoring in the word derived from w[i - 1] turns w[i - nk] into
+// w[i] going forward, and w[i] back into w[i - nk] going backward
+static void oaes_compact_key_step( uint32_t * ring, size_t nk, size_t i )
+{
+	uint32_t _temp = ring[ ( i - 1 ) % nk ];
+	
+	if( 0 == i % nk )
+		_temp = oaes_compact_sub_word( OAES_ROTR8( _temp ) ) ^
+				oaes_gf_8[ i / nk - 1 ];
+	else if( nk > 6 && 4 == i % nk )
+		_temp = oaes_compact_sub_word( _temp );
+	
+	ring[ i % nk ] ^= _temp;
+}
+
+static uint32_t oaes_compact_mix_col( uint32_t w )
+{
+	uint32_t _r = OAES_ROTR8( w );
+	
+	return oaes_compact_xtime( w ^ _r ) ^ _r ^ OAES_ROTR16( w ) ^
+			OAES_ROTR8( OAES_ROTR16( w ) );
+}
+
+// InvMixColumns is MixColumns after multiplying by 04 x^2 + 05
+static uint32_t oaes_compact_inv_mix_col( uint32_t w )
+{
+	return oaes_compact_mix_col( w ^
+			oaes_compact_xtime( oaes_compact_xtime( w ^ OAES_ROTR16( w ) ) ) );
+}
+
+// SubBytes and ShiftRows for one column, row r comes from r columns right
+#define OAES_COMPACT_SUB_SHIFT( s0, s1, s2, s3 ) \
+	( (uint32_t) OAES_SBOX( OAES_ROW0( s0 ) ) | \
+	( (uint32_t) OAES_SBOX( OAES_ROW1( s1 ) ) << 8 ) | \
+	( (uint32_t) OAES_SBOX( OAES_ROW2( s2 ) ) << 16 ) | \
+	( (uint32_t) OAES_SBOX( OAES_ROW3( s3 ) ) << 24 ) )
+
+// InvShiftRows and InvSubBytes for one column, row r comes from r columns left
+#define OAES_COMPACT_INV_SUB_SHIFT( s0, s1, s2, s3 ) \
+	( (uint32_t) OAES_INV_SBOX( OAES_ROW0( s0 ) ) | \
+	( (uint32_t) OAES_INV_SBOX( OAES_ROW1( s3 ) ) << 8 ) | \
+	( (uint32_t) OAES_INV_SBOX( OAES_ROW2( s2 ) ) << 16 ) | \
+	( (uint32_t) OAES_INV_SBOX( OAES_ROW3( s1 ) ) << 24 ) )
+
+static void oaes_compact_encrypt_batch(
+		const oaes_key * key, uint8_t * c, size_t count )
+{
+	size_t _i, _round, _next;
+	size_t _nk = key->key_base;
+	uint32_t _ring[8];
+	uint32_t _k0, _k1, _k2, _k3, _s0, _s1, _s2, _s3, _t0, _t1, _t2, _t3;
+	
+	for( _i = 0; _i < _nk; _i++ )
+		_ring[_i] = oaes_get_word( key->data + _i * OAES_COL_LEN );
+	
+	for( _i = 0; _i < count * OAES_BLOCK_SIZE; _i += OAES_COL_LEN )
+		oaes_put_word( c + _i,
+				oaes_get_word( c + _i ) ^ _ring[ _i / OAES_COL_LEN % OAES_RKEY_LEN ] );
+	
+	for( _round = 1, _next = _nk; _round < key->num_keys; _round++ )
+	{
+		for( ; _next < ( _round + 1 ) * OAES_RKEY_LEN; _next++ )
+			oaes_compact_key_step( _ring, _nk, _next );
+		
+		_k0 = _ring[ ( _round * OAES_RKEY_LEN ) % _nk ];
+		_k1 = _ring[ ( _round * OAES_RKEY_LEN + 1 ) % _nk ];
+		_k2 = _ring[ ( _round * OAES_RKEY_LEN + 2 ) % _nk ];
+		_k3 = _ring[ ( _round * OAES_RKEY_LEN + 3 ) % _nk ];
+		
+		for( _i = 0; _i < count * OAES_BLOCK_SIZE; _i += OAES_BLOCK_SIZE )
+		{
+			_s0 = oaes_get_word( c + _i );
+			_s1 = oaes_get_word( c + _i + 4 );
+			_s2 = oaes_get_word( c + _i + 8 );
+			_s3 = oaes_get_word( c + _i + 12 );
+			_t0 = OAES_COMPACT_SUB_SHIFT( _s0, _s1, _s2, _s3 );
+			_t1 = OAES_COMPACT_SUB_SHIFT( _s1, _s2, _s3, _s0 );
+			_t2 = OAES_COMPACT_SUB_SHIFT( _s2, _s3, _s0, _s1 );
+			_t3 = OAES_COMPACT_SUB_SHIFT( _s3, _s0, _s1, _s2 );
+			
+			if( _round < key->num_keys - 1 )
+			{
+				_t0 = oaes_compact_mix_col( _t0 );
+				_t1 = oaes_compact_mix_col( _t1 );
+				_t2 = oaes_compact_mix_col( _t2 );
+				_t3 = oaes_compact_mix_col( _t3 );
+			}
+			
+			oaes_put_word( c + _i, _t0 ^ _k0 );
+			oaes_put_word( c + _i + 4, _t1 ^ _k1 );
+			oaes_put_word( c + _i + 8, _t2 ^ _k2 );
+			oaes_put_word( c + _i + 12, _t3 ^ _k3 );
+		}
+	}
+}
+
+static void oaes_compact_decrypt_batch(
+		const oaes_key * key, uint8_t * c, size_t count )
+{
+	size_t _i, _round, _low;
+	size_t _nk = key->key_base;
+	uint32_t _ring[8];
+	uint32_t _k0, _k1, _k2, _k3, _s0, _s1, _s2, _s3, _t0, _t1, _t2, _t3;
+	
+	// run the schedule up to the last round key, then step it back down
+	for( _i = 0; _i < _nk; _i++ )
+		_ring[_i] = oaes_get_word( key->data + _i * OAES_COL_LEN );
+	
+	for( _i = _nk; _i < key->num_keys * OAES_RKEY_LEN; _i++ )
+		oaes_compact_key_step( _ring, _nk, _i );
+	
+	_low = _i - _nk;
+	
+	for( _i = 0; _i < count * OAES_BLOCK_SIZE; _i += OAES_COL_LEN )
+		oaes_put_word( c + _i, oaes_get_word( c + _i ) ^ _ring[
+				( ( key->num_keys - 1 ) * OAES_RKEY_LEN +
+				_i / OAES_COL_LEN % OAES_RKEY_LEN ) % _nk ] );
+	
+	for( _round = key->num_keys - 1; _round > 0; _round-- )
+	{
+		for( ; _low > ( _round - 1 ) * OAES_RKEY_LEN; _low-- )
+			oaes_compact_key_step( _ring, _nk, _low - 1 + _nk );
+		
+		_k0 = _ring[ ( ( _round - 1 ) * OAES_RKEY_LEN ) % _nk ];
+		_k1 = _ring[ ( ( _round - 1 ) * OAES_RKEY_LEN + 1 ) % _nk ];
+		_k2 = _ring[ ( ( _round - 1 ) * OAES_RKEY_LEN + 2 ) % _nk ];
+		_k3 = _ring[ ( ( _round - 1 ) * OAES_RKEY_LEN + 3 ) % _nk ];
+		
+		for( _i = 0; _i < count * OAES_BLOCK_SIZE; _i += OAES_BLOCK_SIZE )
+		{
+			_s0 = oaes_get_word( c + _i );
+			_s1 = oaes_get_word( c + _i + 4 );
+			_s2 = oaes_get_word( c + _i + 8 );
+			_s3 = oaes_get_word( c + _i + 12 );
+			_t0 = OAES_COMPACT_INV_SUB_SHIFT( _s0, _s1, _s2, _s3 ) ^ _k0;
+			_t1 = OAES_COMPACT_INV_SUB_SHIFT( _s1, _s2, _s3, _s0 ) ^ _k1;
+			_t2 = OAES_COMPACT_INV_SUB_SHIFT( _s2, _s3, _s0, _s1 ) ^ _k2;
+			_t3 = OAES_COMPACT_INV_SUB_SHIFT( _s3, _s0, _s1, _s2 ) ^ _k3;
+			
+			if( _round > 1 )
+			{
+				_t0 = oaes_compact_inv_mix_col( _t0 );
+				_t1 = oaes_compact_inv_mix_col( _t1 );
+				_t2 = oaes_compact_inv_mix_col( _t2 );
+				_t3 = oaes_compact_inv_mix_col( _t3 );
+			}
+			
+			oaes_put_word( c + _i, _t0 );
+			oaes_put_word( c + _i + 4, _t1 );
+			oaes_put_word( c + _i + 8, _t2 );
+			oaes_put_word( c + _i + 12, _t3 );
+		}
+	}
+}
+
+static void oaes_engine_compact_encrypt_blocks(
+		const oaes_key * key, uint8_t * c, size_t count )
+{
+	size_t _count;
+	
+	for( ; count; count -= _count, c += _count * OAES_BLOCK_SIZE )
+	{
+		_count = min( count, OAES_COMPACT_BLOCKS );
+		oaes_compact_encrypt_batch( key, c, _count );
+	}
+}
+
+static void oaes_engine_compact_decrypt_blocks(
+		const oaes_key * key, uint8_t * c, size_t count )
+{
+	size_t _count;
+	
+	for( ; count; count -= _count, c += _count * OAES_BLOCK_SIZE )
+	{
+		_count = min( count, OAES_COMPACT_BLOCKS );
+		oaes_compact_decrypt_batch( key, c, _count );
+	}
+}
+
+static void oaes_engine_compact_encrypt(
+		const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE] )
+{
+	oaes_compact_encrypt_batch( key, c, 1 );
+}
+
+static void oaes_engine_compact_decrypt(
+		const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE] )
+{
+	oaes_compact_decrypt_batch( key, c, 1 );
+}
+
+// never the fastest, only used when asked for by name
+static const oaes_engine oaes_engine_compact = {
+	"compact",
+	0,
+	NULL,
+	1,
+	0,
+	NULL,
+	{
+		oaes_engine_compact_encrypt,
+		oaes_engine_compact_decrypt,
+		oaes_engine_compact_encrypt_blocks,
+		oaes_engine_compact_decrypt_blocks,
+	},
+	{ NULL, NULL, NULL },
+};
+#endif // OAES_HAVE_COMPACT
+
+uint32_t oaes_cpu_features( void )
+{
+	static int _probed = 0;
+	static uint32_t _features = 0;
+	uint32_t _ret = 0;
+
+	if( _probed )
+		return _features;
+
+#ifdef OAES_ARCH_X86
+	{
+		unsigned int _regs[4] = { 0, 0, 0, 0 };
+
+#ifdef _MSC_VER
+		__cpuid( (int *) _regs, 1 );
+#else
+		__get_cpuid( 1, &_regs[0], &_regs[1], &_regs[2], &_regs[3] );
+#endif
+		if( _regs[3] & ( 1 << 26 ) )
+			_ret |= OAES_CPU_SSE2;
+		if( _regs[2] & ( 1 << 9 ) )
+			_ret |= OAES_CPU_SSSE3;
+		if( _regs[2] & ( 1 << 25 ) )
+			_ret |= OAES_CPU_AESNI;
+		if( _regs[2] & ( 1 << 1 ) )
+			_ret |= OAES_CPU_PCLMUL;
+	}
+#endif // OAES_ARCH_X86
+
+	_features = _ret;
+	_probed = 1;
+
+	return _ret;
+}
+
+// the compiled in engines, fastest first
+static const oaes_engine * const oaes_engines[] = {
+#if OAES_HAVE_AESNI
+	&oaes_engine_aesni,
+#endif // OAES_HAVE_AESNI
+#if OAES_HAVE_VPERM
+	&oaes_engine_vperm,
+#endif // OAES_HAVE_VPERM
+#if OAES_HAVE_BITSLICE
+	&oaes_engine_bitslice,
+#endif // OAES_HAVE_BITSLICE
+	&oaes_engine_table,
+#if OAES_HAVE_COMPACT
+	&oaes_engine_compact,
+#endif // OAES_HAVE_COMPACT
+};
+
+#define OAES_ENGINE_COUNT ( sizeof( oaes_engines ) / sizeof( oaes_engines[0] ) )
+
+static int oaes_engine_available( const oaes_engine * engine )
+{
+	return engine->cpu_features ==
+			( oaes_cpu_features() & engine->cpu_features );
+}
+
+// the compiled in engine called name if this cpu can run it, NULL otherwise
+static const oaes_engine * oaes_engine_find( const char * name )
+{
+	size_t _i;
+	
+	if( NULL == name )
+		return NULL;
+	
+	for( _i = 0; _i < OAES_ENGINE_COUNT; _i++ )
+		if( 0 == strcmp( oaes_engines[_i]->name, name ) )
+			return oaes_engine_available( oaes_engines[_i] ) ?
+					oaes_engines[_i] : NULL;
+	
+	return NULL;
+}
+
+// the engine set with OAES_OPTION_ENGINE, else the one named by the
+// OAES_ENGINE environment variable, else the fastest this cpu can run
+static const oaes_engine * oaes_engine_select( const oaes_ctx * ctx )
+{
+	size_t _i;
+	const oaes_engine * _engine = ctx->engine;
+	
+	if( _engine )
+		return _engine;
+	
+	_engine = oaes_engine_find( getenv( "OAES_ENGINE" ) );
+	
+	if( _engine )
+		return _engine;
+	
+	for( _i = 0; _i < OAES_ENGINE_COUNT; _i++ )
+		if( oaes_engine_available( oaes_engines[_i] ) )
+			return oaes_engines[_i];
+	
+	return &oaes_engine_table;
+}
+
+// the kernels unrolled for num_keys - 1 rounds if the engine has them
+static const oaes_kernels * oaes_engine_kernels(
+		const oaes_engine * engine, size_t num_keys )
+{
+	size_t _nr = num_keys - 1;
+
+	if( ( 10 == _nr || 12 == _nr || 14 == _nr ) &&
+			engine->unrolled[ ( _nr - 10 ) / 2 ] )
+		return engine->unrolled[ ( _nr - 10 ) / 2 ];
+
+	return &engine->kernels;
+}
+
+#if OAES_STEP_TRACE
+// the byte oriented rounds and their helpers, bound in place of the engine
+// kernels while a step callback is installed so that the engines never
+// test for one
+static OAES_RET oaes_inv_sub_byte( uint8_t * byte )
+{
+	size_t _x, _y;
+	
+	if( NULL == byte )
+		return OAES_RET_ARG1;
+
+	_x = _y = *byte;
+	_x &= 0x0f;
+	_y &= 0xf0;
+	_y >>= 4;
+	*byte = oaes_inv_sub_byte_value[_y][_x];
+	
+	return OAES_RET_SUCCESS;
+}
+
+static OAES_RET oaes_shift_rows( uint8_t block[OAES_BLOCK_SIZE] )
+{
+	uint8_t _temp[OAES_BLOCK_SIZE];
+
+	if( NULL == block )
+		return OAES_RET_ARG1;
+
+	_temp[0x00] = block[0x00];
+	_temp[0x01] = block[0x05];
+	_temp[0x02] = block[0x0a];
+	_temp[0x03] = block[0x0f];
+	_temp[0x04] = block[0x04];
+	_temp[0x05] = block[0x09];
+	_temp[0x06] = block[0x0e];
+	_temp[0x07] = block[0x03];
+	_temp[0x08] = block[0x08];
+	_temp[0x09] = block[0x0d];
+	_temp[0x0a] = block[0x02];
+	_temp[0x0b] = block[0x07];
+	_temp[0x0c] = block[0x0c];
+	_temp[0x0d] = block[0x01];
+	_temp[0x0e] = block[0x06];
+	_temp[0x0f] = block[0x0b];
+	memcpy( block, _temp, OAES_BLOCK_SIZE );
+	
+	return OAES_RET_SUCCESS;
+}
+
+static OAES_RET oaes_inv_shift_rows( uint8_t block[OAES_BLOCK_SIZE] )
+{
+	uint8_t _temp[OAES_BLOCK_SIZE];
+
+	if( NULL == block )
+		return OAES_RET_ARG1;
+
+	_temp[0x00] = block[0x00];
+	_temp[0x01] = block[0x0d];
+	_temp[0x02] = block[0x0a];
+	_temp[0x03] = block[0x07];
+	_temp[0x04] = block[0x04];
+	_temp[0x05] = block[0x01];
+	_temp[0x06] = block[0x0e];
+	_temp[0x07] = block[0x0b];
+	_temp[0x08] = block[0x08];
+	_temp[0x09] = block[0x05];
+	_temp[0x0a] = block[0x02];
+	_temp[0x0b] = block[0x0f];
+	_temp[0x0c] = block[0x0c];
+	_temp[0x0d] = block[0x09];
+	_temp[0x0e] = block[0x06];
+	_temp[0x0f] = block[0x03];
+	memcpy( block, _temp, OAES_BLOCK_SIZE );
+	
+	return OAES_RET_SUCCESS;
+}
+
+static uint8_t oaes_gf_mul(uint8_t left, uint8_t right)
+{
+	size_t _x, _y;
+	
+	_x = _y = left;
+	_x &= 0x0f;
+	_y &= 0xf0;
+	_y >>= 4;
+	
+	switch( right )
+	{
+		case 0x02:
+			return oaes_gf_mul_2[_y][_x];
+			break;
+		case 0x03:
+			return oaes_gf_mul_3[_y][_x];
+			break;
+		case 0x09:
+			return oaes_gf_mul_9[_y][_x];
+			break;
+		case 0x0b:
+			return oaes_gf_mul_b[_y][_x];
+			break;
+		case 0x0d:
+			return oaes_gf_mul_d[_y][_x];
+			break;
+		case 0x0e:
+			return oaes_gf_mul_e[_y][_x];
+			break;
+		default:
+			return left;
+			break;
+	}
+}
+
+static OAES_RET oaes_mix_cols( uint8_t word[OAES_COL_LEN] )
+{
+	uint8_t _temp[OAES_COL_LEN];
+
+	if( NULL == word )
+		return OAES_RET_ARG1;
+	
+	_temp[0] = oaes_gf_mul(word[0], 0x02) ^ oaes_gf_mul( word[1], 0x03 ) ^
+			word[2] ^ word[3];
+	_temp[1] = word[0] ^ oaes_gf_mul( word[1], 0x02 ) ^
+			oaes_gf_mul( word[2], 0x03 ) ^ word[3];
+	_temp[2] = word[0] ^ word[1] ^
+			oaes_gf_mul( word[2], 0x02 ) ^ oaes_gf_mul( word[3], 0x03 );
+	_temp[3] = oaes_gf_mul( word[0], 0x03 ) ^ word[1] ^
+			word[2] ^ oaes_gf_mul( word[3], 0x02 );
+	memcpy( word, _temp, OAES_COL_LEN );
+	
+	return OAES_RET_SUCCESS;
+}
+
+static OAES_RET oaes_inv_mix_cols( uint8_t word[OAES_COL_LEN] )
+{
+	uint8_t _temp[OAES_COL_LEN];
+
+	if( NULL == word )
+		return OAES_RET_ARG1;
+	
+	_temp[0] = oaes_gf_mul( word[0], 0x0e ) ^ oaes_gf_mul( word[1], 0x0b ) ^
+			oaes_gf_mul( word[2], 0x0d ) ^ oaes_gf_mul( word[3], 0x09 );
+	_temp[1] = oaes_gf_mul( word[0], 0x09 ) ^ oaes_gf_mul( word[1], 0x0e ) ^
+			oaes_gf_mul( word[2], 0x0b ) ^ oaes_gf_mul( word[3], 0x0d );
+	_temp[2] = oaes_gf_mul( word[0], 0x0d ) ^ oaes_gf_mul( word[1], 0x09 ) ^
+			oaes_gf_mul( word[2], 0x0e ) ^ oaes_gf_mul( word[3], 0x0b );
+	_temp[3] = oaes_gf_mul( word[0], 0x0b ) ^ oaes_gf_mul( word[1], 0x0d ) ^
+			oaes_gf_mul( word[2], 0x09 ) ^ oaes_gf_mul( word[3], 0x0e );
+	memcpy( word, _temp, OAES_COL_LEN );
+	
+	return OAES_RET_SUCCESS;
+}
+
+static void oaes_step_encrypt(
+		const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE] )
+{
+	size_t _i, _j;
+	
+	key->step_cb( c, "input", 1, NULL );
+
+	// AddRoundKey(State, K0)
+	for( _i = 0; _i < OAES_BLOCK_SIZE; _i++ )
+		c[_i] = c[_i] ^ key->exp_data[_i];
+	
+	key->step_cb( key->exp_data, "k_sch", 1, NULL );
+	key->step_cb( c, "k_add", 1, NULL );
+
+	// for round = 1 step 1 to Nr–1
+	for( _i = 1; _i < key->num_keys - 1; _i++ )
+	{
+		// SubBytes(state)
+		for( _j = 0; _j < OAES_BLOCK_SIZE; _j++ )
+			oaes_sub_byte( c + _j );
+
+		key->step_cb( c, "s_box", _i, NULL );
+
+		// ShiftRows(state)
+		oaes_shift_rows( c );
+
+		key->step_cb( c, "s_row", _i, NULL );
+
+		// MixColumns(state)
+		oaes_mix_cols( c );
+		oaes_mix_cols( c + 4 );
+		oaes_mix_cols( c + 8 );
+		oaes_mix_cols( c + 12 );
+
+		key->step_cb( c, "m_col", _i, NULL );
+
+		// AddRoundKey(state, w[round*Nb, (round+1)*Nb-1])
+		for( _j = 0; _j < OAES_BLOCK_SIZE; _j++ )
+			c[_j] = c[_j] ^
+					key->exp_data[_i * OAES_RKEY_LEN * OAES_COL_LEN + _j];
+
+		key->step_cb( key->exp_data + _i * OAES_RKEY_LEN * OAES_COL_LEN,
+				"k_sch", _i, NULL );
+		key->step_cb( c, "k_add", _i, NULL );
+	}
+	
+	// SubBytes(state)
+	for( _i = 0; _i < OAES_BLOCK_SIZE; _i++ )
+		oaes_sub_byte( c + _i );
+	
+	key->step_cb( c, "s_box", key->num_keys - 1, NULL );
+
+	// ShiftRows(state)
+	oaes_shift_rows( c );
+
+	key->step_cb( c, "s_row", key->num_keys - 1, NULL );
+
+	// AddRoundKey(state, w[Nr*Nb, (Nr+1)*Nb-1])
+	for( _i = 0; _i < OAES_BLOCK_SIZE; _i++ )
+		c[_i] = c[_i] ^ key->exp_data[
+				( key->num_keys - 1 ) * OAES_RKEY_LEN * OAES_COL_LEN + _i ];
+
+	key->step_cb( key->exp_data +
+			( key->num_keys - 1 ) * OAES_RKEY_LEN * OAES_COL_LEN,
+			"k_sch", key->num_keys - 1, NULL );
+	key->step_cb( c, "output", key->num_keys - 1, NULL );
+}
+
+static void oaes_step_decrypt(
+		const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE] )
+{
+	size_t _i, _j;
+	
+	key->step_cb( c, "iinput", key->num_keys - 1, NULL );
+
+	// AddRoundKey(state, w[Nr*Nb, (Nr+1)*Nb-1])
+	for( _i = 0; _i < OAES_BLOCK_SIZE; _i++ )
+		c[_i] = c[_i] ^ key->exp_data[
+				( key->num_keys - 1 ) * OAES_RKEY_LEN * OAES_COL_LEN + _i ];
+
+	key->step_cb( key->exp_data +
+			( key->num_keys - 1 ) * OAES_RKEY_LEN * OAES_COL_LEN,
+			"ik_sch", key->num_keys - 1, NULL );
+	key->step_cb( c, "ik_add", key->num_keys - 1, NULL );
+
+	for( _i = key->num_keys - 2; _i > 0; _i-- )
+	{
+		// InvShiftRows(state)
+		oaes_inv_shift_rows( c );
+
+		key->step_cb( c, "is_row", _i, NULL );
+
+		// InvSubBytes(state)
+		for( _j = 0; _j < OAES_BLOCK_SIZE; _j++ )
+			oaes_inv_sub_byte( c + _j );
+
+		key->step_cb( c, "is_box", _i, NULL );
+
+		// AddRoundKey(state, w[round*Nb, (round+1)*Nb-1])
+		for( _j = 0; _j < OAES_BLOCK_SIZE; _j++ )
+			c[_j] = c[_j] ^
+					key->exp_data[_i * OAES_RKEY_LEN * OAES_COL_LEN + _j];
+
+		key->step_cb( key->exp_data + _i * OAES_RKEY_LEN * OAES_COL_LEN,
+				"ik_sch", _i, NULL );
+		key->step_cb( c, "ik_add", _i, NULL );
+
+		// InvMixColums(state)
+		oaes_inv_mix_cols( c );
+		oaes_inv_mix_cols( c + 4 );
+		oaes_inv_mix_cols( c + 8 );
+		oaes_inv_mix_cols( c + 12 );
+
+		key->step_cb( c, "im_col", _i, NULL );
+	}
+
+	// InvShiftRows(state)
+	oaes_inv_shift_rows( c );
+
+	key->step_cb( c, "is_row", 1, NULL );
+
+	// InvSubBytes(state)
+	for( _i = 0; _i < OAES_BLOCK_SIZE; _i++ )
+		oaes_inv_sub_byte( c + _i );
+
+	key->step_cb( c, "is_box", 1, NULL );
+
+	// AddRoundKey(state, w[0, Nb-1])
+	for( _i = 0; _i < OAES_BLOCK_SIZE; _i++ )
+		c[_i] = c[_i] ^ key->exp_data[_i];
+	
+	key->step_cb( key->exp_data, "ik_sch", 1, NULL );
+	key->step_cb( c, "ioutput", 1, NULL );
+}
+
+static void oaes_step_encrypt_blocks(
+		const oaes_key * key, uint8_t * c, size_t count )
+{
+	for( ; count; count--, c += OAES_BLOCK_SIZE )
+		oaes_step_encrypt( key, c );
+}
+
+static void oaes_step_decrypt_blocks(
+		const oaes_key * key, uint8_t * c, size_t count )
+{
+	for( ; count; count--, c += OAES_BLOCK_SIZE )
+		oaes_step_decrypt( key, c );
+}
+
+static const oaes_kernels oaes_kernels_step = {
+	oaes_step_encrypt, oaes_step_decrypt,
+	oaes_step_encrypt_blocks, oaes_step_decrypt_blocks
+};
+#endif // OAES_STEP_TRACE
+
+// picks the kernels for key, the traced ones if ctx has a step callback
+static void oaes_key_bind_kernels( oaes_ctx * ctx, oaes_key * key )
+{
+	if( NULL == key || NULL == key->engine )
+		return;
+	
+#if OAES_STEP_TRACE
+	key->step_cb = ctx->step_cb;
+	
+	if( ctx->step_cb )
+	{
+		key->kernels = &oaes_kernels_step;
+		return;
+	}
+#endif // OAES_STEP_TRACE
+
+	key->kernels = oaes_engine_kernels( key->engine, key->num_keys );
+}
+
+// calloc() a buffer that starts on a 16 byte boundary, the distance back to
+// the start of the allocation is kept in the byte just before it
+static uint8_t * oaes_calloc_aligned( size_t len )
+{
+	uint8_t * _raw = (uint8_t *) calloc( len + 16, sizeof( uint8_t ) );
+	uint8_t * _ret;
+
+	if( NULL == _raw )
+		return NULL;
+
+	_ret = _raw + 16 - ( (uintptr_t) _raw & 0x0f );
+	_ret[-1] = (uint8_t) ( _ret - _raw );
+
+	return _ret;
+}
+
+static void oaes_free_aligned( uint8_t * buf )
+{
+	if( buf )
+		free( buf - buf[-1] );
+}
+
+OAES_RET oaes_sprintf(
+		char * buf, size_t * buf_len, const uint8_t * data, size_t data_len )
+{
+	size_t _i, _buf_len_in;
+	char _temp[4];
+	
+	if( NULL == buf_len )
+		return OAES_RET_ARG2;
+
+	_buf_len_in = *buf_len;
+	*buf_len = data_len * 3 + data_len / OAES_BLOCK_SIZE + 1;
+	
+	if( NULL == buf )
+		return OAES_RET_SUCCESS;
+
+	if( *buf_len > _buf_len_in )
+		return OAES_RET_BUF;
+
+	if( NULL == data )
+		return OAES_RET_ARG3;
+
+	strcpy( buf, "" );
+	
+	for( _i = 0; _i < data_len; _i++ )
+	{
+		sprintf( _temp, "%02x ", data[_i] );
+		strcat( buf, _temp );
+		if( _i && 0 == ( _i + 1 ) % OAES_BLOCK_SIZE )
+			strcat( buf, "\n" );
+	}
+	
+	return OAES_RET_SUCCESS;
+}
+
+#ifdef OAES_HAVE_ISAAC
+static void oaes_get_seed( char buf[RANDSIZ + 1] )
+{
+	struct timeb timer;
+	struct tm *gmTimer;
+	char * _test = NULL;
+	
+	ftime (&timer);
+	gmTimer = gmtime( &timer.time );
+	_test = (char *) calloc( sizeof( char ), timer.millitm );
+	sprintf( buf, "%04d%02d%02d%02d%02d%02d%03d%p%d",
+		gmTimer->tm_year + 1900, gmTimer->tm_mon + 1, gmTimer->tm_mday,
+		gmTimer->tm_hour, gmTimer->tm_min, gmTimer->tm_sec, timer.millitm,
+		_test + timer.millitm, getpid() );
+	
+	if( _test )
+		free( _test );
+}
+#else
+static uint32_t oaes_get_seed()
+{
+	struct timeb timer;
+	struct tm *gmTimer;
+	char * _test = NULL;
+	uint32_t _ret = 0;
+	
+	ftime (&timer);
+	gmTimer = gmtime( &timer.time );
+	_test = (char *) calloc( sizeof( char ), timer.millitm );
+	_ret = gmTimer->tm_year + 1900 + gmTimer->tm_mon + 1 + gmTimer->tm_mday +
+			gmTimer->tm_hour + gmTimer->tm_min + gmTimer->tm_sec + timer.millitm +
 			(uint32_t) ( _test + timer.millitm ) + getpid();
 
-	if( _test )
-		free( _test );
-	
-	return _ret;
+	if( _test )
+		free( _test );
+	
+	return _ret;
+}
+#endif // OAES_HAVE_ISAAC
+
+static OAES_RET oaes_key_destroy( oaes_key ** key )
+{
+	if( NULL == *key )
+		return OAES_RET_SUCCESS;
+	
+	if( (*key)->data )
+	{
+		free( (*key)->data );
+		(*key)->data = NULL;
+	}
+	
+	if( (*key)->exp_data )
+	{
+		oaes_free_aligned( (*key)->exp_data );
+		(*key)->exp_data = NULL;
+	}
+	
+	if( (*key)->dec_data )
+	{
+		oaes_free_aligned( (*key)->dec_data );
+		(*key)->dec_data = NULL;
+	}
+	
+	if( (*key)->engine_data )
+	{
+		oaes_free_aligned( (*key)->engine_data );
+		(*key)->engine_data = NULL;
+	}
+	
+	if( (*key)->gcm_data )
+	{
+		oaes_free_aligned( (*key)->gcm_data );
+		(*key)->gcm_data = NULL;
+	}
+	
+	if( (*key)->ocb_data )
+	{
+		oaes_free_aligned( (*key)->ocb_data );
+		(*key)->ocb_data = NULL;
+	}
+	
+	if( (*key)->cmac_data )
+	{
+		oaes_free_aligned( (*key)->cmac_data );
+		(*key)->cmac_data = NULL;
+	}
+	
+	if( (*key)->hash_data )
+	{
+		oaes_free_aligned( (*key)->hash_data );
+		(*key)->hash_data = NULL;
+	}
+	
+	oaes_key_destroy( &(*key)->siv_key );
+	oaes_key_destroy( &(*key)->xts_key );
+	
+	(*key)->data_len = 0;
+	(*key)->exp_data_len = 0;
+	(*key)->num_keys = 0;
+	(*key)->key_base = 0;
+	(*key)->engine = NULL;
+	(*key)->kernels = NULL;
+	free( *key );
+	*key = NULL;
+	
+	return OAES_RET_SUCCESS;
+}
+
+// drops the round keys, the next oaes_key_schedule() allocates them again
+static void oaes_key_drop_schedule( oaes_key * key )
+{
+	if( key->exp_data )
+	{
+		oaes_free_aligned( key->exp_data );
+		key->exp_data = NULL;
+	}
+	
+	if( key->dec_data )
+	{
+		oaes_free_aligned( key->dec_data );
+		key->dec_data = NULL;
+	}
+	
+	if( key->engine_data )
+	{
+		oaes_free_aligned( key->engine_data );
+		key->engine_data = NULL;
+	}
+	
+	key->exp_data_len = 0;
+}
+
+// fills the round keys of key for key->engine, the buffers of an earlier
+// schedule are filled again as they are, so the engine and the key size
+// must be the same as then
+// dec is 0 for a key that only ever encrypts, its decryption round keys are
+// then not computed by the portable key expansion
+static OAES_RET oaes_key_schedule( oaes_ctx * ctx, oaes_key * key, int dec )
+{
+	size_t _i, _j;
+	
+	key->key_base = key->data_len / OAES_RKEY_LEN;
+	key->num_keys =  key->key_base + OAES_ROUND_BASE;
+	
+	oaes_key_bind_kernels( ctx, key );
+	
+	// the traced kernels need the schedule whatever the engine
+	if( key->engine->on_the_fly
+#if OAES_STEP_TRACE
+			&& NULL == ctx->step_cb
+#endif // OAES_STEP_TRACE
+			)
+		return OAES_RET_SUCCESS;
+	
+	if( NULL == key->exp_data )
+	{
+		key->exp_data_len = key->num_keys * OAES_RKEY_LEN * OAES_COL_LEN;
+		key->exp_data = oaes_calloc_aligned( key->exp_data_len );
+		
+		if( NULL == key->exp_data )
+			return OAES_RET_MEM;
+		
+		key->dec_data = oaes_calloc_aligned( key->exp_data_len );
+		
+		if( NULL == key->dec_data )
+			return OAES_RET_MEM;
+		
+		if( key->engine->key_data_len )
+		{
+			key->engine_data = oaes_calloc_aligned(
+					key->num_keys * key->engine->key_data_len );
+			
+			if( NULL == key->engine_data )
+				return OAES_RET_MEM;
+		}
+	}
+	
+	if( key->engine->key_expand )
+	{
+		key->engine->key_expand( key );
+		
+		return OAES_RET_SUCCESS;
+	}
+	
+	// the first key->data_len are a direct copy
+	memcpy( key->exp_data, key->data, key->data_len );
+
+	// apply ExpandKey algorithm for remainder
+	for( _i = key->key_base; _i < key->num_keys * OAES_RKEY_LEN; _i++ )
+	{
+		uint8_t _temp[OAES_COL_LEN];
+		
+		memcpy( _temp,
+				key->exp_data + ( _i - 1 ) * OAES_RKEY_LEN, OAES_COL_LEN );
+		
+		// transform key column
+		if( 0 == _i % key->key_base )
+		{
+			oaes_word_rot_left( _temp );
+
+			for( _j = 0; _j < OAES_COL_LEN; _j++ )
+				oaes_sub_byte( _temp + _j );
+
+			_temp[0] = _temp[0] ^ oaes_gf_8[ _i / key->key_base - 1 ];
+		}
+		else if( key->key_base > 6 && 4 == _i % key->key_base )
+		{
+			for( _j = 0; _j < OAES_COL_LEN; _j++ )
+				oaes_sub_byte( _temp + _j );
+		}
+		
+		for( _j = 0; _j < OAES_COL_LEN; _j++ )
+		{
+			key->exp_data[ _i * OAES_RKEY_LEN + _j ] =
+					key->exp_data[ ( _i - key->key_base ) *
+					OAES_RKEY_LEN + _j ] ^ _temp[_j];
+		}
+	}
+	
+	// done once here rather than for every block decrypted
+	if( dec )
+		oaes_key_expand_dec( key );
+	
+	if( key->engine->key_setup )
+		key->engine->key_setup( key );
+	
+	return OAES_RET_SUCCESS;
+}
+
+static OAES_RET oaes_key_expand( OAES_CTX * ctx )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == _ctx->key )
+		return OAES_RET_NOKEY;
+	
+	// the prefetched keystream belongs to the old key
+	_ctx->ctr_ring_count = 0;
+	
+	_ctx->key->engine = oaes_engine_select( _ctx );
+	
+	return oaes_key_schedule( _ctx, _ctx->key, 1 );
+}
+
+// expands the key again, for the engine oaes_engine_select() now gives and
+// for the kernels oaes_key_bind_kernels() now picks
+static OAES_RET oaes_key_rebind_engine( oaes_ctx * ctx )
+{
+	OAES_RET _rc;
+	
+	if( NULL == ctx->key )
+		return OAES_RET_SUCCESS;
+	
+	oaes_key_drop_schedule( ctx->key );
+	// a GCM-SIV message key is derived again on the new engine
+	oaes_key_destroy( &ctx->key->siv_key );
+	
+	ctx->key->engine = NULL;
+	ctx->key->kernels = NULL;
+	
+	_rc = oaes_key_expand( ctx );
+	if( OAES_RET_SUCCESS != _rc || NULL == ctx->key->xts_key )
+		return _rc;
+	
+	// the XTS tweak key follows the data key onto the new engine
+	oaes_key_drop_schedule( ctx->key->xts_key );
+	ctx->key->xts_key->engine = ctx->key->engine;
+	
+	return oaes_key_schedule( ctx, ctx->key->xts_key, 0 );
+}
+
+static OAES_RET oaes_key_gen( OAES_CTX * ctx, size_t key_size )
+{
+	size_t _i;
+	oaes_key * _key = NULL;
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc = OAES_RET_SUCCESS;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	_key = (oaes_key *) calloc( sizeof( oaes_key ), 1 );
+	
+	if( NULL == _key )
+		return OAES_RET_MEM;
+	
+	if( _ctx->key )
+		oaes_key_destroy( &(_ctx->key) );
+	
+	_key->data_len = key_size;
+	_key->data = (uint8_t *) calloc( key_size, sizeof( uint8_t ));
+	
+	if( NULL == _key->data )
+	{
+		free(_key);
+		return OAES_RET_MEM;
+	}
+
+	
+	for( _i = 0; _i < key_size; _i++ )
+		_key->data[_i] = (uint8_t) OAES_RAND(_ctx->rctx);
+	
+	_ctx->key = _key;
+	_rc = _rc || oaes_key_expand( ctx );
+	
+	if( _rc != OAES_RET_SUCCESS )
+	{
+		oaes_key_destroy( &(_ctx->key) );
+		return _rc;
+	}
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_key_gen_128( OAES_CTX * ctx )
+{
+	return oaes_key_gen( ctx, 16 );
+}
+
+OAES_RET oaes_key_gen_192( OAES_CTX * ctx )
+{
+	return oaes_key_gen( ctx, 24 );
+}
+
+OAES_RET oaes_key_gen_256( OAES_CTX * ctx )
+{
+	return oaes_key_gen( ctx, 32 );
+}
+
+OAES_RET oaes_key_export( OAES_CTX * ctx,
+		uint8_t * data, size_t * data_len )
+{
+	size_t _data_len_in;
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == _ctx->key )
+		return OAES_RET_NOKEY;
+	
+	if( NULL == data_len )
+		return OAES_RET_ARG3;
+
+	_data_len_in = *data_len;
+	// data + header
+	*data_len = _ctx->key->data_len + OAES_BLOCK_SIZE;
+
+	if( NULL == data )
+		return OAES_RET_SUCCESS;
+	
+	if( _data_len_in < *data_len )
+		return OAES_RET_BUF;
+	
+	// header
+	memcpy( data, oaes_header, OAES_BLOCK_SIZE );
+	data[5] = 0x01;
+	data[7] = _ctx->key->data_len;
+	memcpy( data + OAES_BLOCK_SIZE, _ctx->key->data, _ctx->key->data_len );
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_key_export_data( OAES_CTX * ctx,
+		uint8_t * data, size_t * data_len )
+{
+	size_t _data_len_in;
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == _ctx->key )
+		return OAES_RET_NOKEY;
+	
+	if( NULL == data_len )
+		return OAES_RET_ARG3;
+
+	_data_len_in = *data_len;
+	*data_len = _ctx->key->data_len;
+
+	if( NULL == data )
+		return OAES_RET_SUCCESS;
+	
+	if( _data_len_in < *data_len )
+		return OAES_RET_BUF;
+	
+	memcpy( data, _ctx->key->data, *data_len );
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_key_import( OAES_CTX * ctx,
+		const uint8_t * data, size_t data_len )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc = OAES_RET_SUCCESS;
+	int _key_length;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == data )
+		return OAES_RET_ARG2;
+	
+	switch( data_len )
+	{
+		case 16 + OAES_BLOCK_SIZE:
+		case 24 + OAES_BLOCK_SIZE:
+		case 32 + OAES_BLOCK_SIZE:
+			break;
+		default:
+			return OAES_RET_ARG3;
+	}
+	
+	// header
+	if( 0 != memcmp( data, oaes_header, 4 ) )
+		return OAES_RET_HEADER;
+
+	// header version
+	switch( data[4] )
+	{
+		case 0x01:
+			break;
+		default:
+			return OAES_RET_HEADER;
+	}
+	
+	// header type
+	switch( data[5] )
+	{
+		case 0x01:
+			break;
+		default:
+			return OAES_RET_HEADER;
+	}
+	
+	// options
+	_key_length = data[7];
+	switch( _key_length )
+	{
+		case 16:
+		case 24:
+		case 32:
+			break;
+		default:
+			return OAES_RET_HEADER;
+	}
+	
+	if( data_len != _key_length + OAES_BLOCK_SIZE )
+			return OAES_RET_ARG3;
+	
+	if( _ctx->key )
+		oaes_key_destroy( &(_ctx->key) );
+	
+	_ctx->key = (oaes_key *) calloc( sizeof( oaes_key ), 1 );
+	
+	if( NULL == _ctx->key )
+		return OAES_RET_MEM;
+	
+	_ctx->key->data_len = _key_length;
+	_ctx->key->data = (uint8_t *)
+			calloc( _key_length, sizeof( uint8_t ));
+	
+	if( NULL == _ctx->key->data )
+	{
+		oaes_key_destroy( &(_ctx->key) );
+		return OAES_RET_MEM;
+	}
+
+	memcpy( _ctx->key->data, data + OAES_BLOCK_SIZE, _key_length );
+	_rc = _rc || oaes_key_expand( ctx );
+	
+	if( _rc != OAES_RET_SUCCESS )
+	{
+		oaes_key_destroy( &(_ctx->key) );
+		return _rc;
+	}
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_key_import_data( OAES_CTX * ctx,
+		const uint8_t * data, size_t data_len )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc = OAES_RET_SUCCESS;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == data )
+		return OAES_RET_ARG2;
+	
+	switch( data_len )
+	{
+		case 16:
+		case 24:
+		case 32:
+			break;
+		default:
+			return OAES_RET_ARG3;
+	}
+	
+	if( _ctx->key )
+		oaes_key_destroy( &(_ctx->key) );
+	
+	_ctx->key = (oaes_key *) calloc( sizeof( oaes_key ), 1 );
+	
+	if( NULL == _ctx->key )
+		return OAES_RET_MEM;
+	
+	_ctx->key->data_len = data_len;
+	_ctx->key->data = (uint8_t *)
+			calloc( data_len, sizeof( uint8_t ));
+	
+	if( NULL == _ctx->key->data )
+	{
+		oaes_key_destroy( &(_ctx->key) );
+		return OAES_RET_MEM;
+	}
+
+	memcpy( _ctx->key->data, data, data_len );
+	_rc = _rc || oaes_key_expand( ctx );
+	
+	if( _rc != OAES_RET_SUCCESS )
+	{
+		oaes_key_destroy( &(_ctx->key) );
+		return _rc;
+	}
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_CTX * oaes_alloc()
+{
+	oaes_ctx * _ctx = (oaes_ctx *) calloc( sizeof( oaes_ctx ), 1 );
+	
+	if( NULL == _ctx )
+		return NULL;
+
+#ifdef OAES_HAVE_ISAAC
+	{
+		ub4 _i = 0;
+		char _seed[RANDSIZ + 1];
+		
+		_ctx->rctx = (randctx *) calloc( sizeof( randctx ), 1 );
+
+		if( NULL == _ctx->rctx )
+		{
+			free( _ctx );
+			return NULL;
+		}
+
+		oaes_get_seed( _seed );
+		memset( _ctx->rctx->randrsl, 0, RANDSIZ );
+		memcpy( _ctx->rctx->randrsl, _seed, RANDSIZ );
+		randinit( _ctx->rctx, TRUE);
+	}
+#else
+		srand( oaes_get_seed() );
+#endif // OAES_HAVE_ISAAC
+
+	_ctx->key = NULL;
+	_ctx->engine = NULL;
+	_ctx->ctr_bits = 8 * OAES_BLOCK_SIZE;
+	oaes_set_option( _ctx, OAES_OPTION_CBC, NULL );
+
+#if OAES_STEP_TRACE
+	_ctx->step_cb = NULL;
+	oaes_set_option( _ctx, OAES_OPTION_STEP_OFF, NULL );
+#endif // OAES_STEP_TRACE
+
+	return (OAES_CTX *) _ctx;
+}
+
+OAES_RET oaes_free( OAES_CTX ** ctx )
+{
+	oaes_ctx ** _ctx = (oaes_ctx **) ctx;
+
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == *_ctx )
+		return OAES_RET_SUCCESS;
+	
+	if( (*_ctx)->key )
+		oaes_key_destroy( &((*_ctx)->key) );
+
+	if( (*_ctx)->ctr_ring )
+	{
+		oaes_free_aligned( (*_ctx)->ctr_ring );
+		(*_ctx)->ctr_ring = NULL;
+	}
+
+#ifdef OAES_HAVE_ISAAC
+	if( (*_ctx)->rctx )
+	{
+		free( (*_ctx)->rctx );
+		(*_ctx)->rctx = NULL;
+	}
+#endif // OAES_HAVE_ISAAC
+	
+	free( *_ctx );
+	*_ctx = NULL;
+
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_set_option( OAES_CTX * ctx,
+		OAES_OPTION option, const void * value )
+{
+	size_t _i;
+#if OAES_STEP_TRACE
+	OAES_RET _rc;
+#endif // OAES_STEP_TRACE
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+
+	switch( option )
+	{
+		case OAES_OPTION_ECB:
+			_ctx->options &= ~( OAES_OPTION_CBC | OAES_OPTION_CTR );
+			memset( _ctx->iv, 0, OAES_BLOCK_SIZE );
+			break;
+
+		case OAES_OPTION_CBC:
+		case OAES_OPTION_CTR:
+			_ctx->options &= ~( OAES_OPTION_ECB | OAES_OPTION_CBC |
+					OAES_OPTION_CTR );
+			if( value )
+				memcpy( _ctx->iv, value, OAES_BLOCK_SIZE );
+			else
+			{
+				for( _i = 0; _i < OAES_BLOCK_SIZE; _i++ )
+					_ctx->iv[_i] = (uint8_t) OAES_RAND(_ctx->rctx);
+			}
+			break;
+
+#if OAES_STEP_TRACE
+
+		case OAES_OPTION_STEP_ON:
+			if( value )
+			{
+				_ctx->options &= ~OAES_OPTION_STEP_OFF;
+				_ctx->step_cb = value;
+				// a compact key has no schedule to trace yet
+				_rc = oaes_key_rebind_engine( _ctx );
+				
+				if( OAES_RET_SUCCESS != _rc )
+					return _rc;
+			}
+			else
+			{
+				_ctx->options &= ~OAES_OPTION_STEP_ON;
+				_ctx->options |= OAES_OPTION_STEP_OFF;
+				_ctx->step_cb = NULL;
+				oaes_key_rebind_engine( _ctx );
+				return OAES_RET_ARG3;
+			}
+			break;
+
+		case OAES_OPTION_STEP_OFF:
+			_ctx->options &= ~OAES_OPTION_STEP_ON;
+			_ctx->step_cb = NULL;
+			_rc = oaes_key_rebind_engine( _ctx );
+			
+			if( OAES_RET_SUCCESS != _rc )
+				return _rc;
+			break;
+
+#endif // OAES_STEP_TRACE
+
+		case OAES_OPTION_ENGINE:
+			if( value )
+			{
+				const oaes_engine * _engine = oaes_engine_find( value );
+				
+				if( NULL == _engine )
+					return OAES_RET_ARG3;
+				
+				_ctx->engine = _engine;
+			}
+			else
+				_ctx->engine = NULL;
+			// not a message option, it stays out of the header
+			return oaes_key_rebind_engine( _ctx );
+
+		case OAES_OPTION_CTR_WIDTH:
+			if( NULL == value )
+				return OAES_RET_ARG3;
+			
+			if( *(const size_t *) value < 1 ||
+					*(const size_t *) value > 8 * OAES_BLOCK_SIZE )
+				return OAES_RET_ARG3;
+			
+			_ctx->ctr_bits = *(const size_t *) value;
+			_ctx->ctr_ring_count = 0;
+			return OAES_RET_SUCCESS;
+
+		case OAES_OPTION_CTR_PREFETCH:
+			if( NULL == value )
+				return OAES_RET_ARG3;
+			
+			if( _ctx->ctr_ring )
+			{
+				oaes_free_aligned( _ctx->ctr_ring );
+				_ctx->ctr_ring = NULL;
+			}
+			
+			_ctx->ctr_ring_depth = 0;
+			_ctx->ctr_ring_head = 0;
+			_ctx->ctr_ring_count = 0;
+			
+			if( *(const size_t *) value )
+			{
+				_ctx->ctr_ring = oaes_calloc_aligned(
+						*(const size_t *) value * OAES_BLOCK_SIZE );
+				
+				if( NULL == _ctx->ctr_ring )
+					return OAES_RET_MEM;
+				
+				_ctx->ctr_ring_depth = *(const size_t *) value;
+			}
+			return OAES_RET_SUCCESS;
+
+		default:
+			return OAES_RET_ARG2;
+	}
+
+	_ctx->options |= option;
+
+	return OAES_RET_SUCCESS;
+}
+
+const char * oaes_get_engine( OAES_CTX * ctx )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	
+	if( NULL == _ctx )
+		return NULL;
+	
+	if( _ctx->key && _ctx->key->engine )
+		return _ctx->key->engine->name;
+	
+	return oaes_engine_select( _ctx )->name;
+}
+
+OAES_RET oaes_get_engine_info( size_t index,
+		const char ** name, uint32_t * cpu_features, int * available )
+{
+	if( index >= OAES_ENGINE_COUNT )
+		return OAES_RET_ARG1;
+	
+	if( name )
+		*name = oaes_engines[index]->name;
+	
+	if( cpu_features )
+		*cpu_features = oaes_engines[index]->cpu_features;
+	
+	if( available )
+		*available = oaes_engine_available( oaes_engines[index] );
+	
+	return OAES_RET_SUCCESS;
+}
+
+static OAES_RET oaes_encrypt_block(
+		OAES_CTX * ctx, uint8_t * c, size_t c_len )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == c )
+		return OAES_RET_ARG2;
+	
+	if( c_len != OAES_BLOCK_SIZE )
+		return OAES_RET_ARG3;
+	
+	if( NULL == _ctx->key )
+		return OAES_RET_NOKEY;
+	
+	_ctx->key->kernels->encrypt( _ctx->key, c );
+
+	return OAES_RET_SUCCESS;
+}
+
+// the blocks are handed to the engine in one go so that it can work on
+// several of them at once
+static void oaes_key_encrypt_blocks( const oaes_key * key,
+		uint8_t * c, size_t count )
+{
+	if( key->kernels->encrypt_blocks )
+		key->kernels->encrypt_blocks( key, c, count );
+	else
+		for( ; count; count--, c += OAES_BLOCK_SIZE )
+			key->kernels->encrypt( key, c );
+}
+
+static void oaes_key_decrypt_blocks( const oaes_key * key,
+		uint8_t * c, size_t count )
+{
+	if( key->kernels->decrypt_blocks )
+		key->kernels->decrypt_blocks( key, c, count );
+	else
+		for( ; count; count--, c += OAES_BLOCK_SIZE )
+			key->kernels->decrypt( key, c );
+}
+
+OAES_RET oaes_encrypt_blocks( OAES_CTX * ctx, uint8_t * c, size_t c_len )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == c )
+		return OAES_RET_ARG2;
+	
+	if( c_len % OAES_BLOCK_SIZE )
+		return OAES_RET_ARG3;
+	
+	if( NULL == _ctx->key )
+		return OAES_RET_NOKEY;
+	
+	oaes_key_encrypt_blocks( _ctx->key, c, c_len / OAES_BLOCK_SIZE );
+
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_decrypt_blocks( OAES_CTX * ctx, uint8_t * c, size_t c_len )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == c )
+		return OAES_RET_ARG2;
+	
+	if( c_len % OAES_BLOCK_SIZE )
+		return OAES_RET_ARG3;
+	
+	if( NULL == _ctx->key )
+		return OAES_RET_NOKEY;
+	
+	oaes_key_decrypt_blocks( _ctx->key, c, c_len / OAES_BLOCK_SIZE );
+
+	return OAES_RET_SUCCESS;
+}
+
+// out = in ^ ks, eight bytes at a time where it can
+static void oaes_xor_bytes( uint8_t * out, const uint8_t * in,
+		const uint8_t * ks, size_t len )
+{
+	size_t _i;
+	uint64_t _a, _b;
+	
+	for( _i = 0; _i + sizeof( _a ) <= len; _i += sizeof( _a ) )
+	{
+		memcpy( &_a, in + _i, sizeof( _a ) );
+		memcpy( &_b, ks + _i, sizeof( _b ) );
+		_a ^= _b;
+		memcpy( out + _i, &_a, sizeof( _a ) );
+	}
+	
+	for( ; _i < len; _i++ )
+		out[_i] = in[_i] ^ ks[_i];
+}
+
+static uint32_t oaes_get_be32( const uint8_t * p )
+{
+	return ( (uint32_t) p[0] << 24 ) | ( (uint32_t) p[1] << 16 ) |
+			( (uint32_t) p[2] << 8 ) | (uint32_t) p[3];
+}
+
+static uint64_t oaes_get_be64( const uint8_t * p )
+{
+	return ( (uint64_t) p[0] << 56 ) | ( (uint64_t) p[1] << 48 ) |
+			( (uint64_t) p[2] << 40 ) | ( (uint64_t) p[3] << 32 ) |
+			( (uint64_t) p[4] << 24 ) | ( (uint64_t) p[5] << 16 ) |
+			( (uint64_t) p[6] << 8 ) | (uint64_t) p[7];
+}
+
+static void oaes_put_be64( uint8_t * p, uint64_t w )
+{
+	p[0] = (uint8_t) ( w >> 56 );
+	p[1] = (uint8_t) ( w >> 48 );
+	p[2] = (uint8_t) ( w >> 40 );
+	p[3] = (uint8_t) ( w >> 32 );
+	p[4] = (uint8_t) ( w >> 24 );
+	p[5] = (uint8_t) ( w >> 16 );
+	p[6] = (uint8_t) ( w >> 8 );
+	p[7] = (uint8_t) w;
+}
+
+static uint64_t oaes_get_le64( const uint8_t * p )
+{
+	return (uint64_t) oaes_get_word( p ) |
+			( (uint64_t) oaes_get_word( p + 4 ) << 32 );
+}
+
+static void oaes_put_le64( uint8_t * p, uint64_t w )
+{
+	oaes_put_word( p, (uint32_t) w );
+	oaes_put_word( p + 4, (uint32_t) ( w >> 32 ) );
+}
+
+// 8 bytes as a host order word, for blocks that are only ever xored
+static uint64_t oaes_get_raw64( const uint8_t * p )
+{
+	uint64_t _w;
+	
+	memcpy( &_w, p, sizeof( _w ) );
+	
+	return _w;
+}
+
+static void oaes_put_raw64( uint8_t * p, uint64_t w )
+{
+	memcpy( p, &w, sizeof( w ) );
+}
+
+// the bits of each big endian half of the counter block that count
+static void oaes_ctr_masks( size_t bits, uint64_t * hi_mask, uint64_t * lo_mask )
+{
+	*lo_mask = bits >= 64 ? ~(uint64_t) 0 : ( (uint64_t) 1 << bits ) - 1;
+	*hi_mask = bits <= 64 ? 0 : bits == 128 ? ~(uint64_t) 0 :
+			( (uint64_t) 1 << ( bits - 64 ) ) - 1;
+}
+
+// moves ctr n blocks on, wrapping around within the low bits bits
+static void oaes_ctr_add( uint8_t ctr[OAES_BLOCK_SIZE], size_t bits, uint64_t n )
+{
+	uint64_t _hi = oaes_get_be64( ctr );
+	uint64_t _lo = oaes_get_be64( ctr + 8 );
+	uint64_t _sum = _lo + n;
+	uint64_t _hi_mask, _lo_mask;
+	
+	oaes_ctr_masks( bits, &_hi_mask, &_lo_mask );
+	
+	if( _sum < _lo )
+		_hi = ( _hi & ~_hi_mask ) | ( ( _hi + 1 ) & _hi_mask );
+	
+	_lo = ( _lo & ~_lo_mask ) | ( _sum & _lo_mask );
+	oaes_put_be64( ctr, _hi );
+	oaes_put_be64( ctr + 8, _lo );
+}
+
+// writes count consecutive counter blocks from ctr to ks and leaves ctr on
+// the next one, only the low bits bits count and they wrap around, the low
+// half is kept in a register so no block is read back after a byte store
+static void oaes_ctr_fill( uint8_t * ks, uint8_t ctr[OAES_BLOCK_SIZE],
+		size_t bits, size_t count )
+{
+	uint64_t _hi = oaes_get_be64( ctr );
+	uint64_t _lo = oaes_get_be64( ctr + 8 );
+	uint64_t _hi_mask, _lo_mask;
+	
+	oaes_ctr_masks( bits, &_hi_mask, &_lo_mask );
+	
+	for( ; count; count--, ks += OAES_BLOCK_SIZE )
+	{
+		memcpy( ks, ctr, 8 );
+		oaes_put_be64( ks + 8, _lo );
+		_lo = ( _lo & ~_lo_mask ) | ( ( _lo + 1 ) & _lo_mask );
+		
+		// the high half only moves when a wide counter carries into it
+		if( 0 == ( _lo & _lo_mask ) && _hi_mask )
+		{
+			_hi = ( _hi & ~_hi_mask ) | ( ( _hi + 1 ) & _hi_mask );
+			oaes_put_be64( ctr, _hi );
+		}
+	}
+	
+	oaes_put_be64( ctr + 8, _lo );
+}
+
+// xors len bytes of keystream into in, in and out may be the same buffer
+// the keystream is encrypted OAES_CTR_BLOCKS counter blocks at a time so
+// that the engine can interleave them
+static OAES_RET oaes_ctr_crypt( oaes_ctx * ctx, const uint8_t * in,
+		size_t len, uint8_t * out, uint8_t ctr[OAES_BLOCK_SIZE] )
+{
+	size_t _len, _blocks;
+	uint8_t _ks[OAES_CTR_BLOCKS * OAES_BLOCK_SIZE];
+	OAES_RET _rc;
+	
+	// more blocks than the counter has values would repeat the keystream
+	if( ctx->ctr_bits < 64 && ( len + OAES_BLOCK_SIZE - 1 ) / OAES_BLOCK_SIZE >
+			( (uint64_t) 1 << ctx->ctr_bits ) )
+		return OAES_RET_ARG3;
+	
+	// prefetched keystream is used when it starts at this counter
+	if( ctx->ctr_ring_count && len &&
+			0 == memcmp( ctx->ctr_ring_ctr, ctr, OAES_BLOCK_SIZE ) )
+	{
+		_blocks = min( ctx->ctr_ring_count,
+				( len + OAES_BLOCK_SIZE - 1 ) / OAES_BLOCK_SIZE );
+		_len = min( len, _blocks * OAES_BLOCK_SIZE );
+		oaes_xor_bytes( out, in,
+				ctx->ctr_ring + ctx->ctr_ring_head * OAES_BLOCK_SIZE, _len );
+		in += _len;
+		out += _len;
+		len -= _len;
+		
+		oaes_ctr_add( ctr, ctx->ctr_bits, _blocks );
+		memcpy( ctx->ctr_ring_ctr, ctr, OAES_BLOCK_SIZE );
+		ctx->ctr_ring_head += _blocks;
+		ctx->ctr_ring_count -= _blocks;
+		ctx->ctr_ring_hits += _blocks;
+	}
+	
+	// without a buffer there is nothing to miss
+	if( ctx->ctr_ring_depth )
+		ctx->ctr_ring_misses += ( len + OAES_BLOCK_SIZE - 1 ) / OAES_BLOCK_SIZE;
+	
+	for( ; len; len -= _len, in += _len, out += _len )
+	{
+		_len = min( len, sizeof( _ks ) );
+		_blocks = ( _len + OAES_BLOCK_SIZE - 1 ) / OAES_BLOCK_SIZE;
+		
+		oaes_ctr_fill( _ks, ctr, ctx->ctr_bits, _blocks );
+		
+		_rc = oaes_encrypt_blocks( ctx, _ks, _blocks * OAES_BLOCK_SIZE );
+		if( OAES_RET_SUCCESS != _rc )
+			return _rc;
+		
+		oaes_xor_bytes( out, in, _ks, _len );
+	}
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_encrypt( OAES_CTX * ctx,
+		const uint8_t * m, size_t m_len, uint8_t * c, size_t * c_len,
+		uint8_t iv[OAES_BLOCK_SIZE], uint8_t * pad )
+{
+	size_t _i, _j, _c_len_in;
+	size_t _pad_len = m_len % OAES_BLOCK_SIZE == 0 ?
+			0 : OAES_BLOCK_SIZE - m_len % OAES_BLOCK_SIZE;
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc = OAES_RET_SUCCESS;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == m )
+		return OAES_RET_ARG2;
+	
+	if( NULL == c_len )
+		return OAES_RET_ARG5;
+	
+	// CTR is a stream cipher, there is nothing to pad
+	if( _ctx->options & OAES_OPTION_CTR )
+		_pad_len = 0;
+	
+	_c_len_in = *c_len;
+	// data + pad
+	*c_len = m_len + _pad_len;
+
+	if( NULL == c )
+		return OAES_RET_SUCCESS;
+	
+	if( _c_len_in < *c_len )
+		return OAES_RET_BUF;
+	
+	if( NULL == iv )
+		return OAES_RET_ARG6;
+
+	if( NULL == pad )
+		return OAES_RET_ARG7;
+
+	if (NULL == _ctx->key)
+		return OAES_RET_NOKEY;
+	
+	*pad = _pad_len ? 1 : 0;
+	
+	if( _ctx->options & OAES_OPTION_CTR )
+		return oaes_ctr_crypt( _ctx, m, m_len, c, iv );
+	
+	memcpy(c, m, m_len );
+	
+	// insert pad
+	for( _j = 0; _j < _pad_len; _j++ )
+		c[ m_len + _j ] = _j + 1;
+	
+	// ECB blocks are independent, let the engine batch them
+	if( 0 == ( _ctx->options & OAES_OPTION_CBC ) )
+		return oaes_encrypt_blocks( ctx, c, *c_len );
+	
+	// CBC
+	for( _i = 0; _i < *c_len; _i += OAES_BLOCK_SIZE )
+	{
+		for( _j = 0; _j < OAES_BLOCK_SIZE; _j++ )
+			c[ _i + _j ] = c[ _i + _j ] ^ iv[_j];
+
+		_rc = _rc ||
+				oaes_encrypt_block( ctx, c + _i, OAES_BLOCK_SIZE );
+		memcpy( iv, c + _i, OAES_BLOCK_SIZE );
+	}
+	
+	return _rc;
+}
+
+OAES_RET oaes_decrypt( OAES_CTX * ctx,
+		const uint8_t * c, size_t c_len, uint8_t * m, size_t * m_len,
+		uint8_t iv[OAES_BLOCK_SIZE], uint8_t pad)
+{
+	size_t _i, _j, _m_len_in;
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc = OAES_RET_SUCCESS;
+	uint8_t _flags;
+	OAES_OPTION _options;
+	
+	if( NULL == ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == c )
+		return OAES_RET_ARG2;
+	
+	if( c_len % OAES_BLOCK_SIZE &&
+			0 == ( _ctx->options & OAES_OPTION_CTR ) )
+		return OAES_RET_ARG3;
+	
+	if( NULL == m_len )
+		return OAES_RET_ARG5;
+	
+	_m_len_in = *m_len;
+	*m_len = c_len;
+	
+	if( NULL == m )
+		return OAES_RET_SUCCESS;
+	
+	if( _m_len_in < *m_len )
+		return OAES_RET_BUF;
+
+	if (NULL == iv)
+		return OAES_RET_ARG6;
+
+	if (NULL == _ctx->key)
+		return OAES_RET_NOKEY;
+	
+	// options
+	_options = _ctx->options;
+	// validate that all options are valid
+	if( _options & ~(
+				OAES_OPTION_ECB
+			| OAES_OPTION_CBC
+			| OAES_OPTION_CTR
+#if OAES_STEP_TRACE
+			| OAES_OPTION_STEP_ON
+			| OAES_OPTION_STEP_OFF
+#endif // OAES_STEP_TRACE
+			) )
+		return OAES_RET_HEADER;
+	if( ( _options & OAES_OPTION_ECB ) &&
+			( _options & OAES_OPTION_CBC ) )
+		return OAES_RET_HEADER;
+	if( ( _options & OAES_OPTION_CTR ) &&
+			( _options & ( OAES_OPTION_ECB | OAES_OPTION_CBC ) ) )
+		return OAES_RET_HEADER;
+	if( _options == OAES_OPTION_NONE )
+		return OAES_RET_HEADER;
+	
+	// CTR decrypts by encrypting the same keystream, pad is not used
+	if( _options & OAES_OPTION_CTR )
+		return oaes_ctr_crypt( _ctx, c, *m_len, m, iv );
+	
+	// data + pad
+	memcpy(m, c, *m_len);
+	
+	// both ECB and CBC decrypt every block independently, the chaining is
+	// applied afterwards from the ciphertext
+	_rc = oaes_decrypt_blocks( ctx, m, *m_len );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	// CBC
+	if( _options & OAES_OPTION_CBC )
+	{
+		for( _i = 0; _i < *m_len; _i += OAES_BLOCK_SIZE )
+		{
+			const uint8_t * _prev = _i ? c - OAES_BLOCK_SIZE + _i : iv;
+			
+			for( _j = 0; _j < OAES_BLOCK_SIZE; _j++ )
+				m[ _i + _j ] = m[ _i + _j ] ^ _prev[_j];
+		}
+		if( _i > 0 )
+			memcpy(iv, c - OAES_BLOCK_SIZE + _i, OAES_BLOCK_SIZE);
+	}
+
+	// remove pad
+	if( pad )
+	{
+		int _is_pad = 1;
+		size_t _temp = (size_t) m[*m_len - 1];
+
+		if( _temp	<= 0x00 || _temp > 0x0f )
+			return OAES_RET_HEADER;
+		for( _i = 0; _i < _temp; _i++ )
+			if( m[*m_len - 1 - _i] != _temp - _i )
+				_is_pad = 0;
+		if( _is_pad )
+		{
+			memset( m + *m_len - _temp, 0, _temp );
+			*m_len -= _temp;
+		}
+		else
+			return OAES_RET_HEADER;
+	}
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_ctr_crypt_at( OAES_CTX * ctx,
+		const uint8_t nonce[OAES_BLOCK_SIZE], uint64_t byte_offset,
+		const uint8_t * in, size_t len, uint8_t * out )
+{
+	size_t _skip = (size_t) ( byte_offset % OAES_BLOCK_SIZE );
+	size_t _len;
+	uint8_t _ctr[OAES_BLOCK_SIZE];
+	uint8_t _ks[OAES_BLOCK_SIZE];
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == nonce )
+		return OAES_RET_ARG2;
+	
+	if( NULL == in && len )
+		return OAES_RET_ARG4;
+	
+	if( NULL == out && len )
+		return OAES_RET_ARG6;
+	
+	if( NULL == _ctx->key )
+		return OAES_RET_NOKEY;
+	
+	// the blocks up to the end of the range must not wrap the counter
+	if( _ctx->ctr_bits < 64 && byte_offset / OAES_BLOCK_SIZE +
+			( _skip + len + OAES_BLOCK_SIZE - 1 ) / OAES_BLOCK_SIZE >
+			( (uint64_t) 1 << _ctx->ctr_bits ) )
+		return OAES_RET_ARG3;
+	
+	// the counter block for the offset is computed, nothing before it is
+	memcpy( _ctr, nonce, OAES_BLOCK_SIZE );
+	oaes_ctr_add( _ctr, _ctx->ctr_bits, byte_offset / OAES_BLOCK_SIZE );
+	
+	// the part of the first block from the offset on
+	if( _skip && len )
+	{
+		_len = min( len, OAES_BLOCK_SIZE - _skip );
+		oaes_ctr_fill( _ks, _ctr, _ctx->ctr_bits, 1 );
+		
+		_rc = oaes_encrypt_blocks( ctx, _ks, OAES_BLOCK_SIZE );
+		if( OAES_RET_SUCCESS != _rc )
+			return _rc;
+		
+		oaes_xor_bytes( out, in, _ks + _skip, _len );
+		in += _len;
+		out += _len;
+		len -= _len;
+	}
+	
+	return oaes_ctr_crypt( _ctx, in, len, out, _ctr );
+}
+
+OAES_RET oaes_ctr_prefetch( OAES_CTX * ctx, const uint8_t ctr[OAES_BLOCK_SIZE] )
+{
+	size_t _blocks;
+	uint8_t _next[OAES_BLOCK_SIZE];
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == ctr )
+		return OAES_RET_ARG2;
+	
+	if( NULL == _ctx->key )
+		return OAES_RET_NOKEY;
+	
+	if( 0 == _ctx->ctr_ring_depth )
+		return OAES_RET_SUCCESS;
+	
+	// keystream for another counter is of no use any more
+	if( _ctx->ctr_ring_count &&
+			memcmp( _ctx->ctr_ring_ctr, ctr, OAES_BLOCK_SIZE ) )
+		_ctx->ctr_ring_count = 0;
+	
+	if( 0 == _ctx->ctr_ring_count )
+		memcpy( _ctx->ctr_ring_ctr, ctr, OAES_BLOCK_SIZE );
+	
+	// move what is left to the front and top it up to the full depth
+	memmove( _ctx->ctr_ring,
+			_ctx->ctr_ring + _ctx->ctr_ring_head * OAES_BLOCK_SIZE,
+			_ctx->ctr_ring_count * OAES_BLOCK_SIZE );
+	_ctx->ctr_ring_head = 0;
+	
+	_blocks = _ctx->ctr_ring_depth - _ctx->ctr_ring_count;
+	if( 0 == _blocks )
+		return OAES_RET_SUCCESS;
+	
+	// only as many counter values as there are
+	if( _ctx->ctr_bits < 64 &&
+			_ctx->ctr_ring_depth > ( (uint64_t) 1 << _ctx->ctr_bits ) )
+		_blocks = (size_t) ( ( (uint64_t) 1 << _ctx->ctr_bits ) -
+				_ctx->ctr_ring_count );
+	
+	memcpy( _next, _ctx->ctr_ring_ctr, OAES_BLOCK_SIZE );
+	oaes_ctr_add( _next, _ctx->ctr_bits, _ctx->ctr_ring_count );
+	oaes_ctr_fill( _ctx->ctr_ring + _ctx->ctr_ring_count * OAES_BLOCK_SIZE,
+			_next, _ctx->ctr_bits, _blocks );
+	
+	_rc = oaes_encrypt_blocks( ctx,
+			_ctx->ctr_ring + _ctx->ctr_ring_count * OAES_BLOCK_SIZE,
+			_blocks * OAES_BLOCK_SIZE );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	_ctx->ctr_ring_count += _blocks;
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_ctr_prefetch_stats( OAES_CTX * ctx,
+		uint64_t * hits, uint64_t * misses )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( hits )
+		*hits = _ctx->ctr_ring_hits;
+	
+	if( misses )
+		*misses = _ctx->ctr_ring_misses;
+	
+	return OAES_RET_SUCCESS;
+}
+
+#if OAES_HAVE_PCLMUL
+// 1 when the GHASH key table is laid out for oaes_pclmul_ghash(), 0 when it
+// is for oaes_ghash_table_mul()
+static int oaes_ghash_pclmul( void )
+{
+	uint32_t _need = OAES_CPU_SSE2 | OAES_CPU_SSSE3 | OAES_CPU_PCLMUL;
+	
+	return _need == ( oaes_cpu_features() & _need );
+}
+#endif // OAES_HAVE_PCLMUL
+
+// the reduction of the 4 bits oaes_ghash_table_mul() shifts out at a time
+static const uint64_t oaes_ghash_rem4[16] = {
+	0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+	0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0 };
+
+// H times each 4 bit value, the high halves go to table[0] to table[15]
+// and the low halves to table[16] to table[31]
+static void oaes_ghash_table_init( const uint8_t h[OAES_BLOCK_SIZE],
+		uint64_t * table )
+{
+	size_t _i, _j;
+	uint64_t _hi = oaes_get_be64( h );
+	uint64_t _lo = oaes_get_be64( h + 8 );
+	uint64_t _t;
+	
+	table[0] = table[16] = 0;
+	table[8] = _hi;
+	table[24] = _lo;
+	
+	// a shift to the right is a multiply by x in the GHASH bit order
+	for( _i = 4; _i > 0; _i >>= 1 )
+	{
+		_t = ( _lo & 1 ) * 0xe100000000000000ULL;
+		_lo = ( _hi << 63 ) | ( _lo >> 1 );
+		_hi = ( _hi >> 1 ) ^ _t;
+		table[_i] = _hi;
+		table[16 + _i] = _lo;
+	}
+	
+	for( _i = 2; _i <= 8; _i *= 2 )
+		for( _j = 1; _j < _i; _j++ )
+		{
+			table[_i + _j] = table[_i] ^ table[_j];
+			table[16 + _i + _j] = table[16 + _i] ^ table[16 + _j];
+		}
+}
+
+// x = x * H, a nibble at a time from the last one back
+static void oaes_ghash_table_mul( const uint64_t * table,
+		uint8_t x[OAES_BLOCK_SIZE] )
+{
+	int _i;
+	uint8_t _n = x[OAES_BLOCK_SIZE - 1] & 0x0f;
+	uint64_t _hi = table[_n];
+	uint64_t _lo = table[16 + _n];
+	uint64_t _rem;
+	
+	for( _i = OAES_BLOCK_SIZE - 1; _i >= 0; _i-- )
+	{
+		if( _i != OAES_BLOCK_SIZE - 1 )
+		{
+			_n = x[_i] & 0x0f;
+			_rem = _lo & 0x0f;
+			_lo = ( _hi << 60 ) | ( _lo >> 4 );
+			_hi = ( _hi >> 4 ) ^ ( oaes_ghash_rem4[_rem] << 48 );
+			_hi ^= table[_n];
+			_lo ^= table[16 + _n];
+		}
+		
+		_n = x[_i] >> 4;
+		_rem = _lo & 0x0f;
+		_lo = ( _hi << 60 ) | ( _lo >> 4 );
+		_hi = ( _hi >> 4 ) ^ ( oaes_ghash_rem4[_rem] << 48 );
+		_hi ^= table[_n];
+		_lo ^= table[16 + _n];
+	}
+	
+	oaes_put_be64( x, _hi );
+	oaes_put_be64( x + 8, _lo );
+}
+
+// xi = ( xi ^ c ) * H for each of count blocks of c
+static void oaes_ghash( const oaes_key * key, uint8_t xi[OAES_BLOCK_SIZE],
+		const uint8_t * c, size_t count )
+{
+#if OAES_HAVE_PCLMUL
+	if( oaes_ghash_pclmul() )
+	{
+		oaes_pclmul_ghash( key->gcm_data, xi, c, count );
+		return;
+	}
+#endif // OAES_HAVE_PCLMUL
+	
+	for( ; count; count--, c += OAES_BLOCK_SIZE )
+	{
+		oaes_xor_bytes( xi, xi, c, OAES_BLOCK_SIZE );
+		oaes_ghash_table_mul( (const uint64_t *) key->gcm_data, xi );
+	}
+}
+
+// hashes len bytes of data into xi, the last block padded with zeros
+static void oaes_ghash_update( const oaes_key * key,
+		uint8_t xi[OAES_BLOCK_SIZE], const uint8_t * data, size_t len )
+{
+	uint8_t _pad[OAES_BLOCK_SIZE];
+	
+	oaes_ghash( key, xi, data, len / OAES_BLOCK_SIZE );
+	
+	if( len % OAES_BLOCK_SIZE )
+	{
+		memset( _pad, 0, OAES_BLOCK_SIZE );
+		memcpy( _pad, data + len - len % OAES_BLOCK_SIZE, len % OAES_BLOCK_SIZE );
+		oaes_ghash( key, xi, _pad, 1 );
+	}
+}
+
+// derives the GHASH key table from H = E( K, 0^128 ) the first time the key
+// is used for GCM
+static OAES_RET oaes_gcm_key_setup( oaes_ctx * ctx )
+{
+	uint8_t _h[OAES_BLOCK_SIZE];
+	OAES_RET _rc;
+	
+	if( ctx->key->gcm_data )
+		return OAES_RET_SUCCESS;
+	
+	memset( _h, 0, OAES_BLOCK_SIZE );
+	_rc = oaes_encrypt_blocks( ctx, _h, OAES_BLOCK_SIZE );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	ctx->key->gcm_data = oaes_calloc_aligned( OAES_GHASH_TABLE_LEN );
+	if( NULL == ctx->key->gcm_data )
+		return OAES_RET_MEM;
+	
+#if OAES_HAVE_PCLMUL
+	if( oaes_ghash_pclmul() )
+	{
+		oaes_pclmul_ghash_init( _h, ctx->key->gcm_data, 8 );
+		return OAES_RET_SUCCESS;
+	}
+#endif // OAES_HAVE_PCLMUL
+	
+	oaes_ghash_table_init( _h, (uint64_t *) ctx->key->gcm_data );
+	
+	return OAES_RET_SUCCESS;
+}
+
+#if OAES_HAVE_PCLMUL && OAES_HAVE_AESNI
+// 1 when the AES-NI round keys and the PCLMULQDQ GHASH can run in one loop
+static int oaes_gcm_fused( const oaes_ctx * ctx )
+{
+#if OAES_STEP_TRACE
+	// the traced kernels have to see every block
+	if( ctx->step_cb )
+		return 0;
+#endif // OAES_STEP_TRACE
+	
+	return &oaes_engine_aesni == ctx->key->engine && oaes_ghash_pclmul();
+}
+#endif // OAES_HAVE_PCLMUL && OAES_HAVE_AESNI
+
+// checks the arguments both directions share, and sets up the pre-counter
+// block j0, the first counter block ctr, and xi with the aad hashed into it
+static OAES_RET oaes_gcm_start( oaes_ctx * ctx,
+		const uint8_t * iv, size_t iv_len,
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * in, size_t len, uint8_t * out,
+		const uint8_t * tag, size_t tag_len,
+		uint8_t j0[OAES_BLOCK_SIZE], uint8_t ctr[OAES_BLOCK_SIZE],
+		uint8_t xi[OAES_BLOCK_SIZE] )
+{
+	uint8_t _len[OAES_BLOCK_SIZE];
+	OAES_RET _rc;
+	
+	if( NULL == ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == iv )
+		return OAES_RET_ARG2;
+	
+	if( 0 == iv_len || (uint64_t) iv_len >> 61 )
+		return OAES_RET_ARG3;
+	
+	if( NULL == aad && aad_len )
+		return OAES_RET_ARG4;
+	
+	if( (uint64_t) aad_len >> 61 )
+		return OAES_RET_ARG5;
+	
+	if( NULL == in && len )
+		return OAES_RET_ARG6;
+	
+	if( (uint64_t) len > OAES_GCM_MAX_LEN )
+		return OAES_RET_ARG7;
+	
+	if( NULL == out && len )
+		return OAES_RET_ARG8;
+	
+	if( NULL == tag )
+		return OAES_RET_ARG9;
+	
+	// 128 to 96 bits, or 64 and 32 bits for the uses that allow them
+	if( tag_len > OAES_BLOCK_SIZE || ( tag_len < 12 && 8 != tag_len &&
+			4 != tag_len ) )
+		return OAES_RET_ARG10;
+	
+	if( NULL == ctx->key )
+		return OAES_RET_NOKEY;
+	
+	_rc = oaes_gcm_key_setup( ctx );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	// a 96 bit iv is taken as is, with a 32 bit counter from 1
+	if( 12 == iv_len )
+	{
+		memcpy( j0, iv, 12 );
+		oaes_put_word( j0 + 12, 0 );
+		j0[15] = 1;
+	}
+	else
+	{
+		memset( j0, 0, OAES_BLOCK_SIZE );
+		oaes_ghash_update( ctx->key, j0, iv, iv_len );
+		memset( _len, 0, OAES_BLOCK_SIZE );
+		oaes_put_be64( _len + 8, (uint64_t) iv_len * 8 );
+		oaes_ghash( ctx->key, j0, _len, 1 );
+	}
+	
+	memcpy( ctr, j0, OAES_BLOCK_SIZE );
+	oaes_ctr_add( ctr, 32, 1 );
+	
+	memset( xi, 0, OAES_BLOCK_SIZE );
+	oaes_ghash_update( ctx->key, xi, aad, aad_len );
+	
+	return OAES_RET_SUCCESS;
+}
+
+// CTR from ctr with a 32 bit counter, with the ciphertext hashed into xi
+// while it is still in L1, OAES_CTR_BLOCKS at a time or all at once when
+// the engine and the GHASH run in one loop, in and out may be the same
+// buffer
+static OAES_RET oaes_gcm_crypt( oaes_ctx * ctx, const uint8_t * in,
+		size_t len, uint8_t * out, uint8_t ctr[OAES_BLOCK_SIZE],
+		uint8_t xi[OAES_BLOCK_SIZE], int decrypt )
+{
+	size_t _len, _blocks;
+	uint8_t _ks[OAES_CTR_BLOCKS * OAES_BLOCK_SIZE];
+	OAES_RET _rc;
+	
+#if OAES_HAVE_PCLMUL && OAES_HAVE_AESNI
+	if( oaes_gcm_fused( ctx ) )
+	{
+		_blocks = len / OAES_BLOCK_SIZE / 8 * 8;
+		
+		if( decrypt )
+			oaes_pclmul_gcm_decrypt( ctx->key->exp_data, ctx->key->num_keys,
+					ctx->key->gcm_data, ctr, xi, in, out, _blocks );
+		else
+			oaes_pclmul_gcm_encrypt( ctx->key->exp_data, ctx->key->num_keys,
+					ctx->key->gcm_data, ctr, xi, in, out, _blocks );
+		
+		in += _blocks * OAES_BLOCK_SIZE;
+		out += _blocks * OAES_BLOCK_SIZE;
+		len -= _blocks * OAES_BLOCK_SIZE;
+	}
+#endif // OAES_HAVE_PCLMUL && OAES_HAVE_AESNI
+	
+	for( ; len; len -= _len, in += _len, out += _len )
+	{
+		_len = min( len, sizeof( _ks ) );
+		_blocks = ( _len + OAES_BLOCK_SIZE - 1 ) / OAES_BLOCK_SIZE;
+		
+		oaes_ctr_fill( _ks, ctr, 32, _blocks );
+		
+		_rc = oaes_encrypt_blocks( ctx, _ks, _blocks * OAES_BLOCK_SIZE );
+		if( OAES_RET_SUCCESS != _rc )
+			return _rc;
+		
+		if( decrypt )
+			oaes_ghash_update( ctx->key, xi, in, _len );
+		
+		oaes_xor_bytes( out, in, _ks, _len );
+		
+		if( 0 == decrypt )
+			oaes_ghash_update( ctx->key, xi, out, _len );
+	}
+	
+	return OAES_RET_SUCCESS;
+}
+
+// T = E( K, j0 ) ^ GHASH( A || C || len( A ) || len( C ) ), the lengths in
+// bits
+static OAES_RET oaes_gcm_tag( oaes_ctx * ctx, const uint8_t j0[OAES_BLOCK_SIZE],
+		uint8_t xi[OAES_BLOCK_SIZE], size_t aad_len, size_t len,
+		uint8_t tag[OAES_BLOCK_SIZE] )
+{
+	uint8_t _len[OAES_BLOCK_SIZE];
+	OAES_RET _rc;
+	
+	oaes_put_be64( _len, (uint64_t) aad_len * 8 );
+	oaes_put_be64( _len + 8, (uint64_t) len * 8 );
+	oaes_ghash( ctx->key, xi, _len, 1 );
+	
+	memcpy( tag, j0, OAES_BLOCK_SIZE );
+	_rc = oaes_encrypt_blocks( ctx, tag, OAES_BLOCK_SIZE );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	oaes_xor_bytes( tag, tag, xi, OAES_BLOCK_SIZE );
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_gcm_encrypt( OAES_CTX * ctx,
+		const uint8_t * iv, size_t iv_len,
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * m, size_t m_len, uint8_t * c,
+		uint8_t * tag, size_t tag_len )
+{
+	uint8_t _j0[OAES_BLOCK_SIZE];
+	uint8_t _ctr[OAES_BLOCK_SIZE];
+	uint8_t _xi[OAES_BLOCK_SIZE];
+	uint8_t _tag[OAES_BLOCK_SIZE];
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	_rc = oaes_gcm_start( _ctx, iv, iv_len, aad, aad_len, m, m_len, c,
+			tag, tag_len, _j0, _ctr, _xi );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	_rc = oaes_gcm_crypt( _ctx, m, m_len, c, _ctr, _xi, 0 );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	_rc = oaes_gcm_tag( _ctx, _j0, _xi, aad_len, m_len, _tag );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	memcpy( tag, _tag, tag_len );
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_gcm_decrypt( OAES_CTX * ctx,
+		const uint8_t * iv, size_t iv_len,
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * c, size_t c_len, uint8_t * m,
+		const uint8_t * tag, size_t tag_len )
+{
+	size_t _i;
+	uint8_t _diff = 0;
+	uint8_t _j0[OAES_BLOCK_SIZE];
+	uint8_t _ctr[OAES_BLOCK_SIZE];
+	uint8_t _xi[OAES_BLOCK_SIZE];
+	uint8_t _tag[OAES_BLOCK_SIZE];
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	_rc = oaes_gcm_start( _ctx, iv, iv_len, aad, aad_len, c, c_len, m,
+			tag, tag_len, _j0, _ctr, _xi );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	_rc = oaes_gcm_crypt( _ctx, c, c_len, m, _ctr, _xi, 1 );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	_rc = oaes_gcm_tag( _ctx, _j0, _xi, aad_len, c_len, _tag );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	// compared in constant time, and no plaintext is left behind on failure
+	for( _i = 0; _i < tag_len; _i++ )
+		_diff |= _tag[_i] ^ tag[_i];
+	
+	if( _diff )
+	{
+		if( c_len )
+			memset( m, 0, c_len );
+		return OAES_RET_AUTH;
+	}
+	
+	return OAES_RET_SUCCESS;
+}
+
+static void oaes_reverse_block( uint8_t out[OAES_BLOCK_SIZE],
+		const uint8_t in[OAES_BLOCK_SIZE] )
+{
+	size_t _i;
+	
+	for( _i = 0; _i < OAES_BLOCK_SIZE; _i++ )
+		out[_i] = in[OAES_BLOCK_SIZE - 1 - _i];
+}
+
+// derives the POLYVAL key table of key from the authentication key h,
+// POLYVAL with h is GHASH with mulX_GHASH( ByteReverse( h ) ) on blocks
+// that are byte reversed
+// the table is good for runs of up to max_blocks blocks
+static void oaes_polyval_init( oaes_key * key, const uint8_t h[OAES_BLOCK_SIZE],
+		size_t max_blocks )
+{
+	uint8_t _g[OAES_BLOCK_SIZE];
+	uint64_t _hi, _lo, _t;
+	
+	oaes_reverse_block( _g, h );
+	_hi = oaes_get_be64( _g );
+	_lo = oaes_get_be64( _g + 8 );
+	_t = ( _lo & 1 ) * 0xe100000000000000ULL;
+	oaes_put_be64( _g, ( _hi >> 1 ) ^ _t );
+	oaes_put_be64( _g + 8, ( _hi << 63 ) | ( _lo >> 1 ) );
+	
+#if OAES_HAVE_PCLMUL
+	if( oaes_ghash_pclmul() )
+	{
+		oaes_pclmul_ghash_init( _g, key->gcm_data, max_blocks < 8 ? 1 : 8 );
+		return;
+	}
+#endif // OAES_HAVE_PCLMUL
+	
+	oaes_ghash_table_init( _g, (uint64_t *) key->gcm_data );
+}
+
+// xi = ( xi ^ c ) * H * x^-128 for each of count blocks of c
+static void oaes_polyval( const oaes_key * key, uint8_t xi[OAES_BLOCK_SIZE],
+		const uint8_t * c, size_t count )
+{
+	uint8_t _x[OAES_BLOCK_SIZE];
+	uint8_t _b[OAES_BLOCK_SIZE];
+	
+#if OAES_HAVE_PCLMUL
+	if( oaes_ghash_pclmul() )
+	{
+		oaes_pclmul_polyval( key->gcm_data, xi, c, count );
+		return;
+	}
+#endif // OAES_HAVE_PCLMUL
+	
+	oaes_reverse_block( _x, xi );
+	for( ; count; count--, c += OAES_BLOCK_SIZE )
+	{
+		oaes_reverse_block( _b, c );
+		oaes_xor_bytes( _x, _x, _b, OAES_BLOCK_SIZE );
+		oaes_ghash_table_mul( (const uint64_t *) key->gcm_data, _x );
+	}
+	oaes_reverse_block( xi, _x );
+}
+
+// hashes len bytes of data into xi, the last block padded with zeros
+static void oaes_polyval_update( const oaes_key * key,
+		uint8_t xi[OAES_BLOCK_SIZE], const uint8_t * data, size_t len )
+{
+	uint8_t _pad[OAES_BLOCK_SIZE];
+	
+	oaes_polyval( key, xi, data, len / OAES_BLOCK_SIZE );
+	
+	if( len % OAES_BLOCK_SIZE )
+	{
+		memset( _pad, 0, OAES_BLOCK_SIZE );
+		memcpy( _pad, data + len - len % OAES_BLOCK_SIZE, len % OAES_BLOCK_SIZE );
+		oaes_polyval( key, xi, _pad, 1 );
+	}
+}
+
+// derives the message keys of nonce from the key generating key of ctx into
+// ctx->key->siv_key, the first message allocates it and the ones after
+// refill its buffers, so that only the schedule itself is computed again,
+// and only the POLYVAL key powers that runs of max_blocks blocks use
+static OAES_RET oaes_gcm_siv_derive( oaes_ctx * ctx,
+		const uint8_t nonce[OAES_GCM_SIV_NONCE_SIZE], size_t max_blocks )
+{
+	size_t _i, _count = 2 + ctx->key->data_len / 8;
+	uint8_t _blocks[6 * OAES_BLOCK_SIZE];
+	uint8_t _auth[OAES_BLOCK_SIZE];
+	oaes_key * _key = ctx->key->siv_key;
+	OAES_RET _rc;
+	
+	// the first half of E( K, LE32( i ) || nonce ) for each 64 bits of key
+	for( _i = 0; _i < _count; _i++ )
+	{
+		oaes_put_word( _blocks + _i * OAES_BLOCK_SIZE, (uint32_t) _i );
+		memcpy( _blocks + _i * OAES_BLOCK_SIZE + 4, nonce,
+				OAES_GCM_SIV_NONCE_SIZE );
+	}
+	oaes_key_encrypt_blocks( ctx->key, _blocks, _count );
+	
+	if( NULL == _key )
+	{
+		_key = (oaes_key *) calloc( sizeof( oaes_key ), 1 );
+		if( NULL == _key )
+			return OAES_RET_MEM;
+		
+		_key->data_len = ctx->key->data_len;
+		_key->data = (uint8_t *) calloc( _key->data_len, sizeof( uint8_t ) );
+		_key->gcm_data = oaes_calloc_aligned( OAES_GHASH_TABLE_LEN );
+		_key->engine = ctx->key->engine;
+		
+		if( NULL == _key->data || NULL == _key->gcm_data )
+		{
+			oaes_key_destroy( &_key );
+			return OAES_RET_MEM;
+		}
+		
+		ctx->key->siv_key = _key;
+	}
+	
+	for( _i = 0; _i < 2; _i++ )
+		memcpy( _auth + _i * 8, _blocks + _i * OAES_BLOCK_SIZE, 8 );
+	
+	for( _i = 2; _i < _count; _i++ )
+		memcpy( _key->data + ( _i - 2 ) * 8, _blocks + _i * OAES_BLOCK_SIZE, 8 );
+	
+	oaes_polyval_init( _key, _auth, max_blocks );
+	
+	// the message key only ever encrypts
+	_rc = oaes_key_schedule( ctx, _key, 0 );
+	if( OAES_RET_SUCCESS != _rc )
+		oaes_key_destroy( &ctx->key->siv_key );
+	
+	return _rc;
+}
+
+// checks the arguments both directions share, and derives the message keys
+static OAES_RET oaes_gcm_siv_start( oaes_ctx * ctx,
+		const uint8_t * nonce, const uint8_t * aad, size_t aad_len,
+		const uint8_t * in, size_t len, uint8_t * out, const uint8_t * tag )
+{
+	if( NULL == ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == nonce )
+		return OAES_RET_ARG2;
+	
+	if( NULL == aad && aad_len )
+		return OAES_RET_ARG3;
+	
+	if( (uint64_t) aad_len > OAES_GCM_SIV_MAX_LEN )
+		return OAES_RET_ARG4;
+	
+	if( NULL == in && len )
+		return OAES_RET_ARG5;
+	
+	if( (uint64_t) len > OAES_GCM_SIV_MAX_LEN )
+		return OAES_RET_ARG6;
+	
+	if( NULL == out && len )
+		return OAES_RET_ARG7;
+	
+	if( NULL == tag )
+		return OAES_RET_ARG8;
+	
+	if( NULL == ctx->key )
+		return OAES_RET_NOKEY;
+	
+	// there is no GCM-SIV for 192 bit keys
+	if( 16 != ctx->key->data_len && 32 != ctx->key->data_len )
+		return OAES_RET_ARG1;
+	
+	return oaes_gcm_siv_derive( ctx, nonce,
+			max( aad_len, len ) / OAES_BLOCK_SIZE );
+}
+
+// the tag over aad and the plaintext m, with the message keys of nonce
+static void oaes_gcm_siv_tag( const oaes_key * key,
+		const uint8_t nonce[OAES_GCM_SIV_NONCE_SIZE],
+		const uint8_t * aad, size_t aad_len, const uint8_t * m, size_t m_len,
+		uint8_t tag[OAES_BLOCK_SIZE] )
+{
+	size_t _i;
+	uint8_t _len[OAES_BLOCK_SIZE];
+	
+	memset( tag, 0, OAES_BLOCK_SIZE );
+	oaes_polyval_update( key, tag, aad, aad_len );
+	oaes_polyval_update( key, tag, m, m_len );
+	
+	// LE64( bits of aad ) || LE64( bits of m )
+	oaes_put_le64( _len, (uint64_t) aad_len * 8 );
+	oaes_put_le64( _len + 8, (uint64_t) m_len * 8 );
+	oaes_polyval( key, tag, _len, 1 );
+	
+	for( _i = 0; _i < OAES_GCM_SIV_NONCE_SIZE; _i++ )
+		tag[_i] ^= nonce[_i];
+	tag[OAES_BLOCK_SIZE - 1] &= 0x7f;
+	
+	oaes_key_encrypt_blocks( key, tag, 1 );
+}
+
+// CTR from the tag with its top bit set, the first 32 bits of the counter
+// block count up little endian, OAES_CTR_BLOCKS blocks go to the engine at
+// a time
+static void oaes_gcm_siv_ctr( const oaes_key * key,
+		const uint8_t tag[OAES_BLOCK_SIZE], const uint8_t * in, size_t len,
+		uint8_t * out )
+{
+	size_t _i, _len, _blocks;
+	uint32_t _ctr;
+	uint8_t _block[OAES_BLOCK_SIZE];
+	uint8_t _ks[OAES_CTR_BLOCKS * OAES_BLOCK_SIZE];
+	
+	memcpy( _block, tag, OAES_BLOCK_SIZE );
+	_block[OAES_BLOCK_SIZE - 1] |= 0x80;
+	_ctr = oaes_get_word( _block );
+	
+	for( ; len; len -= _len, in += _len, out += _len )
+	{
+		_len = min( len, sizeof( _ks ) );
+		_blocks = ( _len + OAES_BLOCK_SIZE - 1 ) / OAES_BLOCK_SIZE;
+		
+		for( _i = 0; _i < _blocks; _i++, _ctr++ )
+		{
+			memcpy( _ks + _i * OAES_BLOCK_SIZE, _block, OAES_BLOCK_SIZE );
+			oaes_put_word( _ks + _i * OAES_BLOCK_SIZE, _ctr );
+		}
+		
+		oaes_key_encrypt_blocks( key, _ks, _blocks );
+		oaes_xor_bytes( out, in, _ks, _len );
+	}
+}
+
+OAES_RET oaes_gcm_siv_encrypt( OAES_CTX * ctx,
+		const uint8_t nonce[OAES_GCM_SIV_NONCE_SIZE],
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * m, size_t m_len, uint8_t * c,
+		uint8_t tag[OAES_BLOCK_SIZE] )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	_rc = oaes_gcm_siv_start( _ctx, nonce, aad, aad_len, m, m_len, c, tag );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	oaes_gcm_siv_tag( _ctx->key->siv_key, nonce, aad, aad_len, m, m_len, tag );
+	oaes_gcm_siv_ctr( _ctx->key->siv_key, tag, m, m_len, c );
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_gcm_siv_decrypt( OAES_CTX * ctx,
+		const uint8_t nonce[OAES_GCM_SIV_NONCE_SIZE],
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * c, size_t c_len, uint8_t * m,
+		const uint8_t tag[OAES_BLOCK_SIZE] )
+{
+	size_t _i;
+	uint8_t _diff = 0;
+	uint8_t _tag[OAES_BLOCK_SIZE];
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	_rc = oaes_gcm_siv_start( _ctx, nonce, aad, aad_len, c, c_len, m, tag );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	// the tag is over the plaintext, so it is decrypted first
+	oaes_gcm_siv_ctr( _ctx->key->siv_key, tag, c, c_len, m );
+	oaes_gcm_siv_tag( _ctx->key->siv_key, nonce, aad, aad_len, m, c_len, _tag );
+	
+	for( _i = 0; _i < OAES_BLOCK_SIZE; _i++ )
+		_diff |= _tag[_i] ^ tag[_i];
+	
+	if( _diff )
+	{
+		if( c_len )
+			memset( m, 0, c_len );
+		return OAES_RET_AUTH;
+	}
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_xts_key_import_data( OAES_CTX * ctx,
+		const uint8_t * data, size_t data_len )
+{
+	oaes_key * _key;
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == data )
+		return OAES_RET_ARG2;
+	
+	switch( data_len )
+	{
+		case 32:
+		case 48:
+		case 64:
+			break;
+		default:
+			return OAES_RET_ARG3;
+	}
+	
+	// the data key is the key of ctx, the tweak key hangs off it
+	_rc = oaes_key_import_data( ctx, data, data_len / 2 );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	_key = (oaes_key *) calloc( sizeof( oaes_key ), 1 );
+	if( NULL == _key )
+	{
+		oaes_key_destroy( &(_ctx->key) );
+		return OAES_RET_MEM;
+	}
+	
+	_key->data_len = data_len / 2;
+	_key->data = (uint8_t *) calloc( _key->data_len, sizeof( uint8_t ) );
+	_key->engine = _ctx->key->engine;
+	_ctx->key->xts_key = _key;
+	
+	if( NULL == _key->data )
+	{
+		oaes_key_destroy( &(_ctx->key) );
+		return OAES_RET_MEM;
+	}
+	
+	memcpy( _key->data, data + _key->data_len, _key->data_len );
+	
+	// the tweak key only ever encrypts
+	_rc = oaes_key_schedule( _ctx, _key, 0 );
+	if( OAES_RET_SUCCESS != _rc )
+		oaes_key_destroy( &(_ctx->key) );
+	
+	return _rc;
+}
+
+// the tweak of the next block, t * x in GF(2^128), t little endian
+static void oaes_xts_double( uint64_t * lo, uint64_t * hi )
+{
+	uint64_t _carry = *hi >> 63;
+	
+	*hi = ( *hi << 1 ) | ( *lo >> 63 );
+	*lo = ( *lo << 1 ) ^ ( _carry * 0x87 );
+}
+
+// c = E( c ^ t ) ^ t, or D( c ^ t ) ^ t when decrypt is set
+static void oaes_xts_block( const oaes_key * key, uint8_t c[OAES_BLOCK_SIZE],
+		const uint8_t t[OAES_BLOCK_SIZE], int decrypt )
+{
+	oaes_xor_bytes( c, c, t, OAES_BLOCK_SIZE );
+	
+	if( decrypt )
+		key->kernels->decrypt( key, c );
+	else
+		key->kernels->encrypt( key, c );
+	
+	oaes_xor_bytes( c, c, t, OAES_BLOCK_SIZE );
+}
+
+// runs the count blocks gathered in buf, already xored with their tweaks
+// in t as lo, hi pairs, through the data key in one go, and xors the tweaks
+// back in on the way out to dst
+static void oaes_xts_flush( const oaes_key * key, uint8_t * buf,
+		const uint64_t * t, uint8_t ** dst, size_t count, int decrypt )
+{
+	size_t _i;
+	
+	if( decrypt )
+		oaes_key_decrypt_blocks( key, buf, count );
+	else
+		oaes_key_encrypt_blocks( key, buf, count );
+	
+	for( _i = 0; _i < count; _i++, buf += OAES_BLOCK_SIZE )
+	{
+		oaes_put_le64( dst[_i], oaes_get_le64( buf ) ^ t[2 * _i] );
+		oaes_put_le64( dst[_i] + 8, oaes_get_le64( buf + 8 ) ^ t[2 * _i + 1] );
+	}
+}
+
+// ciphertext stealing over the last whole block of a sector and the tail
+// of tail bytes after it, lo and hi are the tweak of the last whole block
+static void oaes_xts_steal( const oaes_key * key, const uint8_t * in,
+		uint8_t * out, size_t tail, uint64_t lo, uint64_t hi, int decrypt )
+{
+	uint8_t _t[2][OAES_BLOCK_SIZE];
+	uint8_t _cc[OAES_BLOCK_SIZE];
+	uint8_t _pp[OAES_BLOCK_SIZE];
+	
+	// decryption undoes the stealing, so it takes the tweaks the other way
+	oaes_put_le64( _t[decrypt], lo );
+	oaes_put_le64( _t[decrypt] + 8, hi );
+	oaes_xts_double( &lo, &hi );
+	oaes_put_le64( _t[1 - decrypt], lo );
+	oaes_put_le64( _t[1 - decrypt] + 8, hi );
+	
+	memcpy( _cc, in, OAES_BLOCK_SIZE );
+	oaes_xts_block( key, _cc, _t[0], decrypt );
+	
+	// the tail takes the head of that block, and the block the tail
+	memcpy( _pp, in + OAES_BLOCK_SIZE, tail );
+	memcpy( _pp + tail, _cc + tail, OAES_BLOCK_SIZE - tail );
+	memcpy( out + OAES_BLOCK_SIZE, _cc, tail );
+	
+	oaes_xts_block( key, _pp, _t[1], decrypt );
+	memcpy( out, _pp, OAES_BLOCK_SIZE );
+}
+
+// the blocks of up to OAES_XTS_BLOCKS sectors at a time are gathered into
+// one buffer, so that the engine interleaves them whatever the sector size,
+// the tweak of each block is the one before it doubled
+static OAES_RET oaes_xts_crypt( OAES_CTX * ctx, uint64_t sector,
+		size_t sector_len, const uint8_t * in, size_t len, uint8_t * out,
+		int decrypt )
+{
+	size_t _i, _j, _n, _sectors, _blocks, _tail, _count = 0;
+	uint64_t _lo, _hi;
+	uint8_t _tweaks[OAES_XTS_BLOCKS * OAES_BLOCK_SIZE];
+	uint64_t _t[OAES_XTS_BLOCKS * 2];
+	uint8_t _buf[OAES_XTS_BLOCKS * OAES_BLOCK_SIZE];
+	uint8_t * _dst[OAES_XTS_BLOCKS];
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( sector_len < OAES_BLOCK_SIZE ||
+			(uint64_t) sector_len > OAES_XTS_MAX_SECTOR_LEN )
+		return OAES_RET_ARG3;
+	
+	if( NULL == in && len )
+		return OAES_RET_ARG4;
+	
+	if( len % sector_len )
+		return OAES_RET_ARG5;
+	
+	if( NULL == out && len )
+		return OAES_RET_ARG6;
+	
+	if( NULL == _ctx->key || NULL == _ctx->key->xts_key )
+		return OAES_RET_NOKEY;
+	
+	_blocks = sector_len / OAES_BLOCK_SIZE;
+	_tail = sector_len % OAES_BLOCK_SIZE;
+	
+	for( _sectors = len / sector_len; _sectors; _sectors -= _n )
+	{
+		_n = min( _sectors, OAES_XTS_BLOCKS );
+		
+		// the first tweaks of the next _n sectors, E( K2, LE128( sector ) )
+		for( _i = 0; _i < _n; _i++ )
+		{
+			oaes_put_le64( _tweaks + _i * OAES_BLOCK_SIZE, sector + _i );
+			oaes_put_le64( _tweaks + _i * OAES_BLOCK_SIZE + 8, 0 );
+		}
+		oaes_key_encrypt_blocks( _ctx->key->xts_key, _tweaks, _n );
+		
+		for( _i = 0; _i < _n; _i++, sector++, in += sector_len, out += sector_len )
+		{
+			_lo = oaes_get_le64( _tweaks + _i * OAES_BLOCK_SIZE );
+			_hi = oaes_get_le64( _tweaks + _i * OAES_BLOCK_SIZE + 8 );
+			
+			// with a tail the last whole block is left to the stealing
+			for( _j = 0; _j < _blocks - ( _tail ? 1 : 0 ); _j++ )
+			{
+				_t[2 * _count] = _lo;
+				_t[2 * _count + 1] = _hi;
+				oaes_put_le64( _buf + _count * OAES_BLOCK_SIZE,
+						oaes_get_le64( in + _j * OAES_BLOCK_SIZE ) ^ _lo );
+				oaes_put_le64( _buf + _count * OAES_BLOCK_SIZE + 8,
+						oaes_get_le64( in + _j * OAES_BLOCK_SIZE + 8 ) ^ _hi );
+				_dst[_count++] = out + _j * OAES_BLOCK_SIZE;
+				oaes_xts_double( &_lo, &_hi );
+				
+				if( OAES_XTS_BLOCKS == _count )
+				{
+					oaes_xts_flush( _ctx->key, _buf, _t, _dst, _count, decrypt );
+					_count = 0;
+				}
+			}
+			
+			// the blocks gathered so far are already read, so in may be out
+			if( _tail )
+				oaes_xts_steal( _ctx->key, in + _j * OAES_BLOCK_SIZE,
+						out + _j * OAES_BLOCK_SIZE, _tail, _lo, _hi, decrypt );
+		}
+	}
+	
+	if( _count )
+		oaes_xts_flush( _ctx->key, _buf, _t, _dst, _count, decrypt );
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_xts_encrypt( OAES_CTX * ctx, uint64_t sector,
+		size_t sector_len, const uint8_t * m, size_t m_len, uint8_t * c )
+{
+	return oaes_xts_crypt( ctx, sector, sector_len, m, m_len, c, 0 );
+}
+
+OAES_RET oaes_xts_decrypt( OAES_CTX * ctx, uint64_t sector,
+		size_t sector_len, const uint8_t * c, size_t c_len, uint8_t * m )
+{
+	return oaes_xts_crypt( ctx, sector, sector_len, c, c_len, m, 1 );
+}
+
+// doubling in GF(2^128) as OCB defines it, big endian
+static void oaes_ocb_double( uint8_t out[OAES_BLOCK_SIZE],
+		const uint8_t in[OAES_BLOCK_SIZE] )
+{
+	size_t _i;
+	uint8_t _carry = in[0] >> 7;
+	
+	for( _i = 0; _i < OAES_BLOCK_SIZE - 1; _i++ )
+		out[_i] = (uint8_t) ( ( in[_i] << 1 ) | ( in[_i + 1] >> 7 ) );
+	out[OAES_BLOCK_SIZE - 1] =
+			(uint8_t) ( ( in[OAES_BLOCK_SIZE - 1] << 1 ) ^ ( _carry * 0x87 ) );
+}
+
+// number of trailing zero bits of i, i > 0
+static size_t oaes_ocb_ntz( uint64_t i )
+{
+	size_t _n = 0;
+	
+	for( ; 0 == ( i & 1 ); i >>= 1 )
+		_n++;
+	
+	return _n;
+}
+
+// derives the L-table from L_* = E( K, 0^128 ) the first time the key is
+// used for OCB, the entries are kept as host order words as OCB only ever
+// xors them into blocks
+static OAES_RET oaes_ocb_key_setup( oaes_ctx * ctx )
+{
+	size_t _i;
+	uint8_t _l[OAES_BLOCK_SIZE];
+	uint64_t * _t;
+	OAES_RET _rc;
+	
+	if( ctx->key->ocb_data )
+		return OAES_RET_SUCCESS;
+	
+	memset( _l, 0, OAES_BLOCK_SIZE );
+	_rc = oaes_encrypt_blocks( ctx, _l, OAES_BLOCK_SIZE );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	ctx->key->ocb_data = oaes_calloc_aligned( OAES_OCB_TABLE_LEN );
+	if( NULL == ctx->key->ocb_data )
+		return OAES_RET_MEM;
+	
+	_t = (uint64_t *) ctx->key->ocb_data;
+	_t[OAES_OCB_L_STAR] = oaes_get_raw64( _l );
+	_t[OAES_OCB_L_STAR + 1] = oaes_get_raw64( _l + 8 );
+	
+	oaes_ocb_double( _l, _l );
+	_t[OAES_OCB_L_DOLLAR] = oaes_get_raw64( _l );
+	_t[OAES_OCB_L_DOLLAR + 1] = oaes_get_raw64( _l + 8 );
+	
+	for( _i = 0; _i < 64; _i++ )
+	{
+		oaes_ocb_double( _l, _l );
+		_t[OAES_OCB_L + 2 * _i] = oaes_get_raw64( _l );
+		_t[OAES_OCB_L + 2 * _i + 1] = oaes_get_raw64( _l + 8 );
+	}
+	
+	// L_{ntz( j )} summed over j = 1 to 7
+	_t[OAES_OCB_L_RUN] = _t[OAES_OCB_L];
+	_t[OAES_OCB_L_RUN + 1] = _t[OAES_OCB_L + 1];
+	for( _i = 2; _i < 8; _i++ )
+	{
+		_t[OAES_OCB_L_RUN + 2 * _i - 2] = _t[OAES_OCB_L_RUN + 2 * _i - 4] ^
+				_t[OAES_OCB_L + 2 * oaes_ocb_ntz( _i )];
+		_t[OAES_OCB_L_RUN + 2 * _i - 1] = _t[OAES_OCB_L_RUN + 2 * _i - 3] ^
+				_t[OAES_OCB_L + 2 * oaes_ocb_ntz( _i ) + 1];
+	}
+	
+	return OAES_RET_SUCCESS;
+}
+
+/*
+ * OCB over count whole blocks after block *index, with offset holding
+ * Offset_{*index} and both moved along, a chunk at a time so the engine
+ * interleaves the blocks, for OAES_OCB_HASH in is aad, out is unused and
+ * sum gets the enciphered blocks, otherwise sum gets the plaintext
+ * checksum, in and out may be the same buffer
+ */
+static void oaes_ocb_blocks( const oaes_key * key, const uint8_t * in,
+		uint8_t * out, size_t count, uint64_t * index, uint64_t offset[2],
+		uint64_t sum[2], int mode )
+{
+	size_t _i, _j, _n;
+	uint64_t _o0 = offset[0], _o1 = offset[1], _s0 = sum[0], _s1 = sum[1];
+	uint64_t _x0, _x1;
+	uint64_t _off[OAES_CTR_BLOCKS * 2];
+	uint8_t _buf[OAES_CTR_BLOCKS * OAES_BLOCK_SIZE];
+	const uint64_t * _l = (const uint64_t *) key->ocb_data;
+	
+	for( ; count; count -= _n, in += _n * OAES_BLOCK_SIZE )
+	{
+		_n = min( count, OAES_CTR_BLOCKS );
+		
+		for( _i = 0; _i < _n; )
+		{
+			// a run of 8 from a multiple of 8 needs no ntz() until its end,
+			// and none of its offsets waits on the one before
+			if( 0 == ( *index & 7 ) && _n - _i >= 8 )
+			{
+				for( _j = 0; _j < 7; _j++ )
+				{
+					_off[2 * ( _i + _j )] = _o0 ^ _l[OAES_OCB_L_RUN + 2 * _j];
+					_off[2 * ( _i + _j ) + 1] = _o1 ^ _l[OAES_OCB_L_RUN + 2 * _j + 1];
+				}
+				*index += 8;
+				_j = OAES_OCB_L + 2 * oaes_ocb_ntz( *index );
+				_o0 = _off[2 * ( _i + 6 )] ^ _l[_j];
+				_o1 = _off[2 * ( _i + 6 ) + 1] ^ _l[_j + 1];
+				_i += 7;
+			}
+			else
+			{
+				(*index)++;
+				_j = OAES_OCB_L + 2 * oaes_ocb_ntz( *index );
+				_o0 ^= _l[_j];
+				_o1 ^= _l[_j + 1];
+			}
+			_off[2 * _i] = _o0;
+			_off[2 * _i + 1] = _o1;
+			_i++;
+		}
+		
+		for( _i = 0; _i < _n; _i++ )
+		{
+			_x0 = oaes_get_raw64( in + _i * OAES_BLOCK_SIZE );
+			_x1 = oaes_get_raw64( in + _i * OAES_BLOCK_SIZE + 8 );
+			if( OAES_OCB_ENCRYPT == mode )
+			{
+				_s0 ^= _x0;
+				_s1 ^= _x1;
+			}
+			oaes_put_raw64( _buf + _i * OAES_BLOCK_SIZE, _x0 ^ _off[2 * _i] );
+			oaes_put_raw64( _buf + _i * OAES_BLOCK_SIZE + 8, _x1 ^ _off[2 * _i + 1] );
+		}
+		
+		if( OAES_OCB_DECRYPT == mode )
+			oaes_key_decrypt_blocks( key, _buf, _n );
+		else
+			oaes_key_encrypt_blocks( key, _buf, _n );
+		
+		for( _i = 0; _i < _n; _i++ )
+		{
+			_x0 = oaes_get_raw64( _buf + _i * OAES_BLOCK_SIZE );
+			_x1 = oaes_get_raw64( _buf + _i * OAES_BLOCK_SIZE + 8 );
+			if( OAES_OCB_HASH == mode )
+			{
+				_s0 ^= _x0;
+				_s1 ^= _x1;
+				continue;
+			}
+			_x0 ^= _off[2 * _i];
+			_x1 ^= _off[2 * _i + 1];
+			if( OAES_OCB_DECRYPT == mode )
+			{
+				_s0 ^= _x0;
+				_s1 ^= _x1;
+			}
+			oaes_put_raw64( out, _x0 );
+			oaes_put_raw64( out + 8, _x1 );
+			out += OAES_BLOCK_SIZE;
+		}
+	}
+	
+	offset[0] = _o0;
+	offset[1] = _o1;
+	sum[0] = _s0;
+	sum[1] = _s1;
+}
+
+// x ^= p || 1 || 0*, for a last partial block of len bytes
+static void oaes_ocb_xor_padded( uint64_t x[2], const uint8_t * p, size_t len )
+{
+	uint8_t _x[OAES_BLOCK_SIZE];
+	
+	memset( _x, 0, OAES_BLOCK_SIZE );
+	memcpy( _x, p, len );
+	_x[len] = 0x80;
+	x[0] ^= oaes_get_raw64( _x );
+	x[1] ^= oaes_get_raw64( _x + 8 );
+}
+
+// checks the arguments both directions share, sets up the L-table and
+// Offset_0 from the nonce, and hashes the aad into hash
+static OAES_RET oaes_ocb_start( oaes_ctx * ctx,
+		const uint8_t * nonce, size_t nonce_len,
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * in, size_t len, uint8_t * out,
+		const uint8_t * tag, size_t tag_len,
+		uint64_t offset[2], uint64_t hash[2] )
+{
+	size_t _i, _bottom;
+	uint64_t _index = 0, _offset[2] = { 0, 0 };
+	uint8_t _n[OAES_BLOCK_SIZE];
+	uint8_t _stretch[OAES_BLOCK_SIZE + 8 + 1];
+	uint8_t _x[OAES_BLOCK_SIZE];
+	const uint64_t * _l;
+	OAES_RET _rc;
+	
+	if( NULL == ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == nonce )
+		return OAES_RET_ARG2;
+	
+	// up to 120 bits
+	if( 0 == nonce_len || nonce_len >= OAES_BLOCK_SIZE )
+		return OAES_RET_ARG3;
+	
+	if( NULL == aad && aad_len )
+		return OAES_RET_ARG4;
+	
+	if( NULL == in && len )
+		return OAES_RET_ARG6;
+	
+	if( NULL == out && len )
+		return OAES_RET_ARG8;
+	
+	if( NULL == tag )
+		return OAES_RET_ARG9;
+	
+	if( 0 == tag_len || tag_len > OAES_BLOCK_SIZE )
+		return OAES_RET_ARG10;
+	
+	if( NULL == ctx->key )
+		return OAES_RET_NOKEY;
+	
+	_rc = oaes_ocb_key_setup( ctx );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	_l = (const uint64_t *) ctx->key->ocb_data;
+	
+	// Nonce = num2str( TAGLEN mod 128, 7 ) || 0* || 1 || N
+	memset( _n, 0, OAES_BLOCK_SIZE );
+	_n[0] = (uint8_t) ( ( tag_len * 8 % 128 ) << 1 );
+	_n[OAES_BLOCK_SIZE - 1 - nonce_len] |= 1;
+	memcpy( _n + OAES_BLOCK_SIZE - nonce_len, nonce, nonce_len );
+	
+	// Ktop = E( K, Nonce with its last 6 bits cleared ), the 6 bits pick
+	// where in Stretch = Ktop || ( Ktop[1..64] ^ Ktop[9..72] ) Offset_0 is
+	_bottom = _n[OAES_BLOCK_SIZE - 1] & 0x3f;
+	_n[OAES_BLOCK_SIZE - 1] &= 0xc0;
+	oaes_key_encrypt_blocks( ctx->key, _n, 1 );
+	
+	memcpy( _stretch, _n, OAES_BLOCK_SIZE );
+	for( _i = 0; _i < 8; _i++ )
+		_stretch[OAES_BLOCK_SIZE + _i] = _n[_i] ^ _n[_i + 1];
+	_stretch[OAES_BLOCK_SIZE + 8] = 0;
+	
+	for( _i = 0; _i < OAES_BLOCK_SIZE; _i++ )
+		_x[_i] = (uint8_t) ( ( _stretch[_i + _bottom / 8] << ( _bottom % 8 ) ) |
+				( _stretch[_i + _bottom / 8 + 1] >> ( 8 - _bottom % 8 ) ) );
+	offset[0] = oaes_get_raw64( _x );
+	offset[1] = oaes_get_raw64( _x + 8 );
+	
+	// HASH( K, A ) runs its own offsets from 0
+	hash[0] = hash[1] = 0;
+	oaes_ocb_blocks( ctx->key, aad, NULL, aad_len / OAES_BLOCK_SIZE,
+			&_index, _offset, hash, OAES_OCB_HASH );
+	
+	// a last partial block is padded with 10* and enciphered at Offset_*
+	if( aad_len % OAES_BLOCK_SIZE )
+	{
+		_offset[0] ^= _l[OAES_OCB_L_STAR];
+		_offset[1] ^= _l[OAES_OCB_L_STAR + 1];
+		oaes_ocb_xor_padded( _offset, aad + aad_len / OAES_BLOCK_SIZE *
+				OAES_BLOCK_SIZE, aad_len % OAES_BLOCK_SIZE );
+		oaes_put_raw64( _n, _offset[0] );
+		oaes_put_raw64( _n + 8, _offset[1] );
+		oaes_key_encrypt_blocks( ctx->key, _n, 1 );
+		hash[0] ^= oaes_get_raw64( _n );
+		hash[1] ^= oaes_get_raw64( _n + 8 );
+	}
+	
+	return OAES_RET_SUCCESS;
+}
+
+// encrypts or decrypts from Offset_0 in offset, and computes the full tag
+// E( K, Checksum ^ Offset ^ L_$ ) ^ HASH( K, A ), in and out may be the
+// same buffer
+static void oaes_ocb_crypt( oaes_ctx * ctx, const uint8_t * in, size_t len,
+		uint8_t * out, uint64_t offset[2], const uint64_t hash[2],
+		uint8_t tag[OAES_BLOCK_SIZE], int decrypt )
+{
+	size_t _full = len / OAES_BLOCK_SIZE * OAES_BLOCK_SIZE;
+	uint64_t _index = 0, _sum[2] = { 0, 0 };
+	uint8_t _pad[OAES_BLOCK_SIZE];
+	const uint64_t * _l = (const uint64_t *) ctx->key->ocb_data;
+	
+	oaes_ocb_blocks( ctx->key, in, out, len / OAES_BLOCK_SIZE,
+			&_index, offset, _sum, decrypt ? OAES_OCB_DECRYPT : OAES_OCB_ENCRYPT );
+	
+	// the last partial block is xored with Pad = E( K, Offset_* ), and
+	// goes into the checksum as plaintext padded with 10*
+	if( len > _full )
+	{
+		offset[0] ^= _l[OAES_OCB_L_STAR];
+		offset[1] ^= _l[OAES_OCB_L_STAR + 1];
+		oaes_put_raw64( _pad, offset[0] );
+		oaes_put_raw64( _pad + 8, offset[1] );
+		oaes_key_encrypt_blocks( ctx->key, _pad, 1 );
+		
+		if( 0 == decrypt )
+			oaes_ocb_xor_padded( _sum, in + _full, len - _full );
+		oaes_xor_bytes( out + _full, in + _full, _pad, len - _full );
+		if( decrypt )
+			oaes_ocb_xor_padded( _sum, out + _full, len - _full );
+	}
+	
+	oaes_put_raw64( tag, _sum[0] ^ offset[0] ^ _l[OAES_OCB_L_DOLLAR] );
+	oaes_put_raw64( tag + 8, _sum[1] ^ offset[1] ^ _l[OAES_OCB_L_DOLLAR + 1] );
+	oaes_key_encrypt_blocks( ctx->key, tag, 1 );
+	oaes_put_raw64( tag, oaes_get_raw64( tag ) ^ hash[0] );
+	oaes_put_raw64( tag + 8, oaes_get_raw64( tag + 8 ) ^ hash[1] );
+}
+
+OAES_RET oaes_ocb_encrypt( OAES_CTX * ctx,
+		const uint8_t * nonce, size_t nonce_len,
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * m, size_t m_len, uint8_t * c,
+		uint8_t * tag, size_t tag_len )
+{
+	uint64_t _offset[2], _hash[2];
+	uint8_t _tag[OAES_BLOCK_SIZE];
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	_rc = oaes_ocb_start( _ctx, nonce, nonce_len, aad, aad_len, m, m_len, c,
+			tag, tag_len, _offset, _hash );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	oaes_ocb_crypt( _ctx, m, m_len, c, _offset, _hash, _tag, 0 );
+	memcpy( tag, _tag, tag_len );
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_ocb_decrypt( OAES_CTX * ctx,
+		const uint8_t * nonce, size_t nonce_len,
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * c, size_t c_len, uint8_t * m,
+		const uint8_t * tag, size_t tag_len )
+{
+	size_t _i;
+	uint8_t _diff = 0;
+	uint64_t _offset[2], _hash[2];
+	uint8_t _tag[OAES_BLOCK_SIZE];
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	_rc = oaes_ocb_start( _ctx, nonce, nonce_len, aad, aad_len, c, c_len, m,
+			tag, tag_len, _offset, _hash );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	oaes_ocb_crypt( _ctx, c, c_len, m, _offset, _hash, _tag, 1 );
+	
+	// compared in constant time, and no plaintext is left behind on failure
+	for( _i = 0; _i < tag_len; _i++ )
+		_diff |= _tag[_i] ^ tag[_i];
+	
+	if( _diff )
+	{
+		if( c_len )
+			memset( m, 0, c_len );
+		return OAES_RET_AUTH;
+	}
+	
+	return OAES_RET_SUCCESS;
+}
+
+// 4 to 16 bytes, even
+static int oaes_ccm_tag_len_ok( size_t tag_len )
+{
+	return tag_len >= 4 && tag_len <= OAES_BLOCK_SIZE && 0 == tag_len % 2;
+}
+
+// the length of the message has to fit the 15 - nonce_len bytes of the
+// counter
+static int oaes_ccm_len_ok( size_t nonce_len, size_t len )
+{
+	size_t _q = OAES_BLOCK_SIZE - 1 - nonce_len;
+	
+	return _q >= 8 || 0 == ( (uint64_t) len >> ( 8 * _q ) );
+}
+
+// feeds len bytes into the CBC-MAC, a block at a time
+static void oaes_ccm_mac( const oaes_key * key, oaes_ccm_state * state,
+		const uint8_t * data, size_t len )
+{
+	size_t _len;
+	
+	for( ; len; len -= _len, data += _len )
+	{
+		_len = min( len, OAES_BLOCK_SIZE - state->p_len );
+		memcpy( state->p + state->p_len, data, _len );
+		state->p_len += _len;
+		
+		if( OAES_BLOCK_SIZE == state->p_len )
+		{
+			oaes_xor_bytes( state->x, state->x, state->p, OAES_BLOCK_SIZE );
+			oaes_key_encrypt_blocks( key, state->x, 1 );
+			state->p_len = 0;
+		}
+	}
+}
+
+// zero pads what is left of the last block into the CBC-MAC
+static void oaes_ccm_mac_pad( const oaes_key * key, oaes_ccm_state * state )
+{
+	if( 0 == state->p_len )
+		return;
+	
+	memset( state->p + state->p_len, 0, OAES_BLOCK_SIZE - state->p_len );
+	oaes_xor_bytes( state->x, state->x, state->p, OAES_BLOCK_SIZE );
+	oaes_key_encrypt_blocks( key, state->x, 1 );
+	state->p_len = 0;
+}
+
+// B_0 with the message length, and the aad with its length in front of it
+// go into the CBC-MAC, and the counter is set up, the lengths are already
+// checked
+static void oaes_ccm_init( const oaes_key * key, oaes_ccm_state * state,
+		const uint8_t * nonce, size_t nonce_len,
+		const uint8_t * aad, size_t aad_len, size_t len, size_t tag_len )
+{
+	size_t _i, _q = OAES_BLOCK_SIZE - 1 - nonce_len, _a_len, _prefix = 2;
+	uint8_t _a[10];
+	
+	// flags: aad present, ( t - 2 ) / 2, q - 1
+	memset( state->x, 0, OAES_BLOCK_SIZE );
+	state->x[0] = (uint8_t) ( ( aad_len ? 0x40 : 0 ) |
+			( ( tag_len - 2 ) / 2 ) << 3 | ( _q - 1 ) );
+	memcpy( state->x + 1, nonce, nonce_len );
+	for( _i = 0; _i < _q && _i < 8; _i++ )
+		state->x[OAES_BLOCK_SIZE - 1 - _i] = (uint8_t) ( (uint64_t) len >> ( 8 * _i ) );
+	oaes_key_encrypt_blocks( key, state->x, 1 );
+	state->p_len = 0;
+	
+	if( aad_len )
+	{
+		// a short length as is, longer ones after 0xfffe or 0xffff
+		if( (uint64_t) aad_len < 0xff00 )
+		{
+			_a_len = 2;
+			_prefix = 0;
+		}
+		else if( 0 == (uint64_t) aad_len >> 32 )
+		{
+			_a[0] = 0xff;
+			_a[1] = 0xfe;
+			_a_len = 6;
+		}
+		else
+		{
+			_a[0] = 0xff;
+			_a[1] = 0xff;
+			_a_len = 10;
+		}
+		for( _i = 0; _i < _a_len - _prefix; _i++ )
+			_a[_a_len - 1 - _i] = (uint8_t) ( (uint64_t) aad_len >> ( 8 * _i ) );
+		
+		oaes_ccm_mac( key, state, _a, _a_len );
+		oaes_ccm_mac( key, state, aad, aad_len );
+		oaes_ccm_mac_pad( key, state );
+	}
+	
+	// A_i: q - 1, the nonce and i, A_0 is for the tag
+	memset( state->ctr, 0, OAES_BLOCK_SIZE );
+	state->ctr[0] = (uint8_t) ( _q - 1 );
+	memcpy( state->ctr + 1, nonce, nonce_len );
+	memcpy( state->s0, state->ctr, OAES_BLOCK_SIZE );
+	oaes_key_encrypt_blocks( key, state->s0, 1 );
+	oaes_ctr_add( state->ctr, 8 * _q, 1 );
+	
+	state->ks_pos = OAES_BLOCK_SIZE;
+	state->left = len;
+	state->tag_len = tag_len;
+}
+
+// the next counter block, paired with the CBC-MAC of the plaintext block
+// before it when there is one, so the engine overlaps the two, b holds
+// the MAC input and the counter block and gets both enciphered
+static void oaes_ccm_step( const oaes_key * key, oaes_ccm_state * state,
+		uint8_t b[2 * OAES_BLOCK_SIZE] )
+{
+	// only the first block has no plaintext block before it
+	if( OAES_BLOCK_SIZE == state->p_len )
+	{
+		oaes_xor_bytes( b, state->x, state->p, OAES_BLOCK_SIZE );
+		oaes_key_encrypt_blocks( key, b, 2 );
+		memcpy( state->x, b, OAES_BLOCK_SIZE );
+		state->p_len = 0;
+	}
+	else
+		oaes_key_encrypt_blocks( key, b + OAES_BLOCK_SIZE, 1 );
+}
+
+/*
+ * CCM over len bytes in one pass, each counter block is enciphered along
+ * with the CBC-MAC of the plaintext block before it, the counter blocks of
+ * whole blocks are laid out OAES_CTR_BLOCKS at a time, in and out may be
+ * the same buffer
+ */
+static void oaes_ccm_update( const oaes_key * key, oaes_ccm_state * state,
+		const uint8_t * in, size_t len, uint8_t * out, int decrypt )
+{
+	size_t _i, _n, _len;
+	// the counter is the last q bytes, the flags byte holds q - 1
+	size_t _bits = 8 * ( state->ctr[0] + 1 );
+	uint8_t _b[2 * OAES_BLOCK_SIZE];
+	uint8_t _ctrs[OAES_CTR_BLOCKS * OAES_BLOCK_SIZE];
+	
+	state->left -= len;
+	
+	while( len )
+	{
+		_n = min( len / OAES_BLOCK_SIZE, OAES_CTR_BLOCKS );
+		
+		// whole blocks, from a block boundary on
+		if( OAES_BLOCK_SIZE == state->ks_pos && _n )
+		{
+			oaes_ctr_fill( _ctrs, state->ctr, _bits, _n );
+			
+			for( _i = 0; _i < _n; _i++ )
+			{
+				memcpy( _b + OAES_BLOCK_SIZE, _ctrs + _i * OAES_BLOCK_SIZE,
+						OAES_BLOCK_SIZE );
+				oaes_ccm_step( key, state, _b );
+				
+				if( 0 == decrypt )
+					memcpy( state->p, in, OAES_BLOCK_SIZE );
+				oaes_xor_bytes( out, in, _b + OAES_BLOCK_SIZE, OAES_BLOCK_SIZE );
+				if( decrypt )
+					memcpy( state->p, out, OAES_BLOCK_SIZE );
+				state->p_len = OAES_BLOCK_SIZE;
+				
+				in += OAES_BLOCK_SIZE;
+				out += OAES_BLOCK_SIZE;
+			}
+			
+			len -= _n * OAES_BLOCK_SIZE;
+			continue;
+		}
+		
+		// a piece of a block, with its keystream kept for the next call
+		if( OAES_BLOCK_SIZE == state->ks_pos )
+		{
+			oaes_ctr_fill( _b + OAES_BLOCK_SIZE, state->ctr, _bits, 1 );
+			oaes_ccm_step( key, state, _b );
+			memcpy( state->ks, _b + OAES_BLOCK_SIZE, OAES_BLOCK_SIZE );
+			state->ks_pos = 0;
+		}
+		
+		_len = min( len, OAES_BLOCK_SIZE - state->ks_pos );
+		
+		if( 0 == decrypt )
+			memcpy( state->p + state->p_len, in, _len );
+		oaes_xor_bytes( out, in, state->ks + state->ks_pos, _len );
+		if( decrypt )
+			memcpy( state->p + state->p_len, out, _len );
+		
+		state->p_len += _len;
+		state->ks_pos += _len;
+		in += _len;
+		out += _len;
+		len -= _len;
+	}
+}
+
+// T = first tag_len bytes of CBC-MAC ^ E( K, A_0 ), and the message is over
+static void oaes_ccm_tag( const oaes_key * key, oaes_ccm_state * state,
+		uint8_t tag[OAES_BLOCK_SIZE] )
+{
+	oaes_ccm_mac_pad( key, state );
+	oaes_xor_bytes( tag, state->x, state->s0, OAES_BLOCK_SIZE );
+	state->tag_len = 0;
+}
+
+// checks the arguments of the one-shot calls
+static OAES_RET oaes_ccm_check( oaes_ctx * ctx,
+		const uint8_t * nonce, size_t nonce_len,
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * in, size_t len, uint8_t * out,
+		const uint8_t * tag, size_t tag_len )
+{
+	if( NULL == ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == nonce )
+		return OAES_RET_ARG2;
+	
+	if( nonce_len < 7 || nonce_len > 13 )
+		return OAES_RET_ARG3;
+	
+	if( NULL == aad && aad_len )
+		return OAES_RET_ARG4;
+	
+	if( NULL == in && len )
+		return OAES_RET_ARG6;
+	
+	if( 0 == oaes_ccm_len_ok( nonce_len, len ) )
+		return OAES_RET_ARG7;
+	
+	if( NULL == out && len )
+		return OAES_RET_ARG8;
+	
+	if( NULL == tag )
+		return OAES_RET_ARG9;
+	
+	if( 0 == oaes_ccm_tag_len_ok( tag_len ) )
+		return OAES_RET_ARG10;
+	
+	if( NULL == ctx->key )
+		return OAES_RET_NOKEY;
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_ccm_encrypt( OAES_CTX * ctx,
+		const uint8_t * nonce, size_t nonce_len,
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * m, size_t m_len, uint8_t * c,
+		uint8_t * tag, size_t tag_len )
+{
+	oaes_ccm_state _state;
+	uint8_t _tag[OAES_BLOCK_SIZE];
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	_rc = oaes_ccm_check( _ctx, nonce, nonce_len, aad, aad_len, m, m_len, c,
+			tag, tag_len );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	oaes_ccm_init( _ctx->key, &_state, nonce, nonce_len, aad, aad_len,
+			m_len, tag_len );
+	oaes_ccm_update( _ctx->key, &_state, m, m_len, c, 0 );
+	oaes_ccm_tag( _ctx->key, &_state, _tag );
+	memcpy( tag, _tag, tag_len );
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_ccm_decrypt( OAES_CTX * ctx,
+		const uint8_t * nonce, size_t nonce_len,
+		const uint8_t * aad, size_t aad_len,
+		const uint8_t * c, size_t c_len, uint8_t * m,
+		const uint8_t * tag, size_t tag_len )
+{
+	size_t _i;
+	uint8_t _diff = 0;
+	oaes_ccm_state _state;
+	uint8_t _tag[OAES_BLOCK_SIZE];
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	_rc = oaes_ccm_check( _ctx, nonce, nonce_len, aad, aad_len, c, c_len, m,
+			tag, tag_len );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	oaes_ccm_init( _ctx->key, &_state, nonce, nonce_len, aad, aad_len,
+			c_len, tag_len );
+	oaes_ccm_update( _ctx->key, &_state, c, c_len, m, 1 );
+	oaes_ccm_tag( _ctx->key, &_state, _tag );
+	
+	// compared in constant time, and no plaintext is left behind on failure
+	for( _i = 0; _i < tag_len; _i++ )
+		_diff |= _tag[_i] ^ tag[_i];
+	
+	if( _diff )
+	{
+		if( c_len )
+			memset( m, 0, c_len );
+		return OAES_RET_AUTH;
+	}
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_ccm_start( OAES_CTX * ctx,
+		const uint8_t * nonce, size_t nonce_len,
+		const uint8_t * aad, size_t aad_len,
+		size_t len, size_t tag_len )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == nonce )
+		return OAES_RET_ARG2;
+	
+	if( nonce_len < 7 || nonce_len > 13 )
+		return OAES_RET_ARG3;
+	
+	if( NULL == aad && aad_len )
+		return OAES_RET_ARG4;
+	
+	if( 0 == oaes_ccm_len_ok( nonce_len, len ) )
+		return OAES_RET_ARG6;
+	
+	if( 0 == oaes_ccm_tag_len_ok( tag_len ) )
+		return OAES_RET_ARG7;
+	
+	if( NULL == _ctx->key )
+		return OAES_RET_NOKEY;
+	
+	oaes_ccm_init( _ctx->key, &_ctx->ccm, nonce, nonce_len, aad, aad_len,
+			len, tag_len );
+	
+	return OAES_RET_SUCCESS;
+}
+
+// checks the arguments of the incremental calls
+static OAES_RET oaes_ccm_check_update( oaes_ctx * ctx,
+		const uint8_t * in, size_t len, uint8_t * out )
+{
+	if( NULL == ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == in && len )
+		return OAES_RET_ARG2;
+	
+	if( 0 == ctx->ccm.tag_len )
+		return OAES_RET_ERROR;
+	
+	// no more than oaes_ccm_start() was told of
+	if( (uint64_t) len > ctx->ccm.left )
+		return OAES_RET_ARG3;
+	
+	if( NULL == out && len )
+		return OAES_RET_ARG4;
+	
+	if( NULL == ctx->key )
+		return OAES_RET_NOKEY;
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_ccm_encrypt_update( OAES_CTX * ctx,
+		const uint8_t * m, size_t m_len, uint8_t * c )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	_rc = oaes_ccm_check_update( _ctx, m, m_len, c );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	oaes_ccm_update( _ctx->key, &_ctx->ccm, m, m_len, c, 0 );
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_ccm_decrypt_update( OAES_CTX * ctx,
+		const uint8_t * c, size_t c_len, uint8_t * m )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	_rc = oaes_ccm_check_update( _ctx, c, c_len, m );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	oaes_ccm_update( _ctx->key, &_ctx->ccm, c, c_len, m, 1 );
+	
+	return OAES_RET_SUCCESS;
+}
+
+// checks the arguments of the final calls, and computes the tag
+static OAES_RET oaes_ccm_final( oaes_ctx * ctx, const uint8_t * tag,
+		uint8_t out[OAES_BLOCK_SIZE] )
+{
+	if( NULL == ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == tag )
+		return OAES_RET_ARG2;
+	
+	// the whole message has to be in
+	if( 0 == ctx->ccm.tag_len || ctx->ccm.left )
+		return OAES_RET_ERROR;
+	
+	if( NULL == ctx->key )
+		return OAES_RET_NOKEY;
+	
+	oaes_ccm_tag( ctx->key, &ctx->ccm, out );
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_ccm_encrypt_final( OAES_CTX * ctx, uint8_t * tag )
+{
+	size_t _tag_len;
+	uint8_t _tag[OAES_BLOCK_SIZE];
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	_tag_len = _ctx ? _ctx->ccm.tag_len : 0;
+	_rc = oaes_ccm_final( _ctx, tag, _tag );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	memcpy( tag, _tag, _tag_len );
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_ccm_decrypt_final( OAES_CTX * ctx, const uint8_t * tag )
+{
+	size_t _i, _tag_len;
+	uint8_t _diff = 0;
+	uint8_t _tag[OAES_BLOCK_SIZE];
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	_tag_len = _ctx ? _ctx->ccm.tag_len : 0;
+	_rc = oaes_ccm_final( _ctx, tag, _tag );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	for( _i = 0; _i < _tag_len; _i++ )
+		_diff |= _tag[_i] ^ tag[_i];
+	
+	return _diff ? OAES_RET_AUTH : OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_cfb_start( OAES_CTX * ctx,
+		const uint8_t iv[OAES_BLOCK_SIZE], size_t segment_bits )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == iv )
+		return OAES_RET_ARG2;
+	
+	if( 8 != segment_bits && 8 * OAES_BLOCK_SIZE != segment_bits )
+		return OAES_RET_ARG3;
+	
+	_ctx->stream.mode = 8 == segment_bits ? OAES_STREAM_CFB8 : OAES_STREAM_CFB;
+	memcpy( _ctx->stream.reg, iv, OAES_BLOCK_SIZE );
+	_ctx->stream.pos = OAES_BLOCK_SIZE;
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_ofb_start( OAES_CTX * ctx, const uint8_t iv[OAES_BLOCK_SIZE] )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == iv )
+		return OAES_RET_ARG2;
+	
+	_ctx->stream.mode = OAES_STREAM_OFB;
+	memcpy( _ctx->stream.reg, iv, OAES_BLOCK_SIZE );
+	_ctx->stream.pos = OAES_BLOCK_SIZE;
+	
+	return OAES_RET_SUCCESS;
+}
+
+// checks the arguments of the stream calls, and that the stream is one of
+// mode or alt_mode
+static OAES_RET oaes_stream_check( oaes_ctx * ctx,
+		const uint8_t * in, size_t len, uint8_t * out, int mode, int alt_mode )
+{
+	if( NULL == ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == in && len )
+		return OAES_RET_ARG2;
+	
+	if( NULL == out && len )
+		return OAES_RET_ARG4;
+	
+	if( mode != ctx->stream.mode && alt_mode != ctx->stream.mode )
+		return OAES_RET_ERROR;
+	
+	if( NULL == ctx->key )
+		return OAES_RET_NOKEY;
+	
+	return OAES_RET_SUCCESS;
+}
+
+// CFB-8, a block cipher call for every byte, the register shifts in the
+// ciphertext byte
+static void oaes_cfb8_encrypt( const oaes_key * key, oaes_stream_state * st,
+		const uint8_t * in, size_t len, uint8_t * out )
+{
+	for( ; len; len--, in++, out++ )
+	{
+		memcpy( st->ks, st->reg, OAES_BLOCK_SIZE );
+		oaes_key_encrypt_blocks( key, st->ks, 1 );
+		memmove( st->reg, st->reg + 1, OAES_BLOCK_SIZE - 1 );
+		*out = *in ^ st->ks[0];
+		st->reg[OAES_BLOCK_SIZE - 1] = *out;
+	}
+}
+
+// every cipher input is known ciphertext, the register for byte i is the
+// 16 bytes before it, so OAES_CTR_BLOCKS of them go to the engine at once
+static void oaes_cfb8_decrypt( const oaes_key * key, oaes_stream_state * st,
+		const uint8_t * in, size_t len, uint8_t * out )
+{
+	size_t _i, _n;
+	uint8_t _w[OAES_BLOCK_SIZE + OAES_CTR_BLOCKS];
+	uint8_t _buf[OAES_CTR_BLOCKS * OAES_BLOCK_SIZE];
+	
+	for( ; len; len -= _n, in += _n, out += _n )
+	{
+		_n = min( len, OAES_CTR_BLOCKS );
+		
+		memcpy( _w, st->reg, OAES_BLOCK_SIZE );
+		memcpy( _w + OAES_BLOCK_SIZE, in, _n );
+		for( _i = 0; _i < _n; _i++ )
+			memcpy( _buf + _i * OAES_BLOCK_SIZE, _w + _i, OAES_BLOCK_SIZE );
+		oaes_key_encrypt_blocks( key, _buf, _n );
+		
+		for( _i = 0; _i < _n; _i++ )
+			out[_i] = _w[OAES_BLOCK_SIZE + _i] ^ _buf[_i * OAES_BLOCK_SIZE];
+		memcpy( st->reg, _w + _n, OAES_BLOCK_SIZE );
+	}
+}
+
+// CFB-128 keystream bytes up to the end of the current block, the
+// ciphertext goes into the register as it comes, a new keystream block is
+// enciphered from it once it is whole
+static size_t oaes_cfb_partial( const oaes_key * key, oaes_stream_state * st,
+		const uint8_t * in, size_t len, uint8_t * out, int decrypt )
+{
+	if( OAES_BLOCK_SIZE == st->pos )
+	{
+		memcpy( st->ks, st->reg, OAES_BLOCK_SIZE );
+		oaes_key_encrypt_blocks( key, st->ks, 1 );
+		st->pos = 0;
+	}
+	
+	len = min( len, OAES_BLOCK_SIZE - st->pos );
+	
+	if( decrypt )
+		memcpy( st->reg + st->pos, in, len );
+	oaes_xor_bytes( out, in, st->ks + st->pos, len );
+	if( 0 == decrypt )
+		memcpy( st->reg + st->pos, out, len );
+	st->pos += len;
+	
+	return len;
+}
+
+OAES_RET oaes_cfb_encrypt( OAES_CTX * ctx,
+		const uint8_t * m, size_t m_len, uint8_t * c )
+{
+	size_t _len;
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	_rc = oaes_stream_check( _ctx, m, m_len, c,
+			OAES_STREAM_CFB, OAES_STREAM_CFB8 );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	if( OAES_STREAM_CFB8 == _ctx->stream.mode )
+	{
+		oaes_cfb8_encrypt( _ctx->key, &_ctx->stream, m, m_len, c );
+		return OAES_RET_SUCCESS;
+	}
+	
+	if( _ctx->stream.pos < OAES_BLOCK_SIZE && m_len )
+	{
+		_len = oaes_cfb_partial( _ctx->key, &_ctx->stream, m, m_len, c, 0 );
+		m += _len;
+		c += _len;
+		m_len -= _len;
+	}
+	
+	// each block waits on the ciphertext of the one before, which is
+	// enciphered in place in the register
+	for( ; m_len >= OAES_BLOCK_SIZE; m_len -= OAES_BLOCK_SIZE,
+			m += OAES_BLOCK_SIZE, c += OAES_BLOCK_SIZE )
+	{
+		oaes_key_encrypt_blocks( _ctx->key, _ctx->stream.reg, 1 );
+		oaes_xor_bytes( _ctx->stream.reg, _ctx->stream.reg, m, OAES_BLOCK_SIZE );
+		memcpy( c, _ctx->stream.reg, OAES_BLOCK_SIZE );
+	}
+	
+	if( m_len )
+		oaes_cfb_partial( _ctx->key, &_ctx->stream, m, m_len, c, 0 );
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_cfb_decrypt( OAES_CTX * ctx,
+		const uint8_t * c, size_t c_len, uint8_t * m )
+{
+	size_t _n, _len;
+	uint8_t _buf[OAES_CTR_BLOCKS * OAES_BLOCK_SIZE];
+	oaes_stream_state * _st;
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	_rc = oaes_stream_check( _ctx, c, c_len, m,
+			OAES_STREAM_CFB, OAES_STREAM_CFB8 );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	_st = &_ctx->stream;
+	
+	if( OAES_STREAM_CFB8 == _st->mode )
+	{
+		oaes_cfb8_decrypt( _ctx->key, _st, c, c_len, m );
+		return OAES_RET_SUCCESS;
+	}
+	
+	// the rest of the current block
+	if( _st->pos < OAES_BLOCK_SIZE && c_len )
+	{
+		_len = oaes_cfb_partial( _ctx->key, _st, c, c_len, m, 1 );
+		c += _len;
+		m += _len;
+		c_len -= _len;
+	}
+	
+	// whole blocks decipher from the register and the ciphertext blocks
+	// before them, OAES_CTR_BLOCKS at a time
+	for( ; c_len >= OAES_BLOCK_SIZE; c_len -= _n * OAES_BLOCK_SIZE )
+	{
+		_n = min( c_len / OAES_BLOCK_SIZE, OAES_CTR_BLOCKS );
+		
+		memcpy( _buf, _st->reg, OAES_BLOCK_SIZE );
+		memcpy( _buf + OAES_BLOCK_SIZE, c, ( _n - 1 ) * OAES_BLOCK_SIZE );
+		memcpy( _st->reg, c + ( _n - 1 ) * OAES_BLOCK_SIZE, OAES_BLOCK_SIZE );
+		oaes_key_encrypt_blocks( _ctx->key, _buf, _n );
+		oaes_xor_bytes( m, c, _buf, _n * OAES_BLOCK_SIZE );
+		
+		c += _n * OAES_BLOCK_SIZE;
+		m += _n * OAES_BLOCK_SIZE;
+	}
+	
+	if( c_len )
+		oaes_cfb_partial( _ctx->key, _st, c, c_len, m, 1 );
+	
+	return OAES_RET_SUCCESS;
+}
+
+// the next len bytes of OFB keystream, each block enciphered from the one
+// before it
+static void oaes_ofb_fill( const oaes_key * key, oaes_stream_state * st,
+		uint8_t * ks, size_t len )
+{
+	size_t _len;
+	
+	for( ; len; len -= _len, ks += _len )
+	{
+		if( OAES_BLOCK_SIZE == st->pos )
+		{
+			oaes_key_encrypt_blocks( key, st->reg, 1 );
+			st->pos = 0;
+		}
+		
+		_len = min( len, OAES_BLOCK_SIZE - st->pos );
+		memcpy( ks, st->reg + st->pos, _len );
+		st->pos += _len;
+	}
+}
+
+OAES_RET oaes_ofb_crypt( OAES_CTX * ctx,
+		const uint8_t * in, size_t len, uint8_t * out )
+{
+	size_t _len;
+	uint8_t _ks[OAES_CTR_BLOCKS * OAES_BLOCK_SIZE];
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	_rc = oaes_stream_check( _ctx, in, len, out,
+			OAES_STREAM_OFB, OAES_STREAM_OFB );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	for( ; len; len -= _len, in += _len, out += _len )
+	{
+		_len = min( len, sizeof( _ks ) );
+		oaes_ofb_fill( _ctx->key, &_ctx->stream, _ks, _len );
+		oaes_xor_bytes( out, in, _ks, _len );
+	}
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_ofb_keystream( OAES_CTX * ctx, uint8_t * ks, size_t len )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == ks && len )
+		return OAES_RET_ARG2;
+	
+	if( OAES_STREAM_OFB != _ctx->stream.mode )
+		return OAES_RET_ERROR;
+	
+	if( NULL == _ctx->key )
+		return OAES_RET_NOKEY;
+	
+	oaes_ofb_fill( _ctx->key, &_ctx->stream, ks, len );
+	
+	return OAES_RET_SUCCESS;
+}
+
+// CBC encrypts the whole blocks of in into out, chain holds the iv going in
+// and the last ciphertext block coming out, and is enciphered in place
+static void oaes_cbc_encrypt_run( const oaes_key * key,
+		uint8_t chain[OAES_BLOCK_SIZE], const uint8_t * in, size_t len,
+		uint8_t * out )
+{
+	for( ; len; len -= OAES_BLOCK_SIZE,
+			in += OAES_BLOCK_SIZE, out += OAES_BLOCK_SIZE )
+	{
+		oaes_xor_bytes( chain, chain, in, OAES_BLOCK_SIZE );
+		oaes_key_encrypt_blocks( key, chain, 1 );
+		memcpy( out, chain, OAES_BLOCK_SIZE );
+	}
+}
+
+// CBC decrypts the whole blocks of in into out OAES_CTR_BLOCKS at a time,
+// chain works as in oaes_cbc_encrypt_run(), each batch is xored from its
+// last block back so that in may be out
+static void oaes_cbc_decrypt_run( const oaes_key * key,
+		uint8_t chain[OAES_BLOCK_SIZE], const uint8_t * in, size_t len,
+		uint8_t * out )
+{
+	size_t _i, _len;
+	uint8_t _buf[OAES_CTR_BLOCKS * OAES_BLOCK_SIZE];
+	uint8_t _next[OAES_BLOCK_SIZE];
+	
+	for( ; len; len -= _len, in += _len, out += _len )
+	{
+		_len = min( len, sizeof( _buf ) );
+		memcpy( _buf, in, _len );
+		memcpy( _next, in + _len - OAES_BLOCK_SIZE, OAES_BLOCK_SIZE );
+		oaes_key_decrypt_blocks( key, _buf, _len / OAES_BLOCK_SIZE );
+		
+		for( _i = _len - OAES_BLOCK_SIZE; _i; _i -= OAES_BLOCK_SIZE )
+			oaes_xor_bytes( out + _i, _buf + _i, in + _i - OAES_BLOCK_SIZE,
+					OAES_BLOCK_SIZE );
+		oaes_xor_bytes( out, _buf, chain, OAES_BLOCK_SIZE );
+		memcpy( chain, _next, OAES_BLOCK_SIZE );
+	}
+}
+
+static OAES_RET oaes_cbc_cs3_check( oaes_ctx * ctx,
+		const uint8_t * iv, const uint8_t * in, size_t len, uint8_t * out )
+{
+	if( NULL == ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == iv )
+		return OAES_RET_ARG2;
+	
+	if( NULL == in )
+		return OAES_RET_ARG3;
+	
+	// there is nothing to steal from with less than a block
+	if( len < OAES_BLOCK_SIZE )
+		return OAES_RET_ARG4;
+	
+	if( NULL == out )
+		return OAES_RET_ARG5;
+	
+	if( NULL == ctx->key )
+		return OAES_RET_NOKEY;
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_cbc_cs3_encrypt( OAES_CTX * ctx,
+		const uint8_t iv[OAES_BLOCK_SIZE], const uint8_t * m, size_t m_len,
+		uint8_t * c )
+{
+	// the last, maybe partial, block and the whole block before it
+	size_t _tail = ( m_len - 1 ) % OAES_BLOCK_SIZE + 1;
+	size_t _head = m_len - _tail - OAES_BLOCK_SIZE;
+	uint8_t _chain[OAES_BLOCK_SIZE];
+	uint8_t _last[OAES_BLOCK_SIZE];
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	_rc = oaes_cbc_cs3_check( _ctx, iv, m, m_len, c );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	memcpy( _chain, iv, OAES_BLOCK_SIZE );
+	
+	// a single block is plain CBC
+	if( OAES_BLOCK_SIZE == m_len )
+	{
+		oaes_cbc_encrypt_run( _ctx->key, _chain, m, m_len, c );
+		return OAES_RET_SUCCESS;
+	}
+	
+	oaes_cbc_encrypt_run( _ctx->key, _chain, m, _head, c );
+	oaes_cbc_encrypt_run( _ctx->key, _chain, m + _head, OAES_BLOCK_SIZE, _last );
+	
+	// the tail is padded with zeros, which xor to the chain unchanged
+	oaes_xor_bytes( _chain, _chain, m + _head + OAES_BLOCK_SIZE, _tail );
+	oaes_key_encrypt_blocks( _ctx->key, _chain, 1 );
+	
+	// the last two blocks swap places and the final one is cut to the tail
+	memcpy( c + _head, _chain, OAES_BLOCK_SIZE );
+	memcpy( c + _head + OAES_BLOCK_SIZE, _last, _tail );
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_cbc_cs3_decrypt( OAES_CTX * ctx,
+		const uint8_t iv[OAES_BLOCK_SIZE], const uint8_t * c, size_t c_len,
+		uint8_t * m )
+{
+	size_t _tail = ( c_len - 1 ) % OAES_BLOCK_SIZE + 1;
+	size_t _head = c_len - _tail - OAES_BLOCK_SIZE;
+	uint8_t _chain[OAES_BLOCK_SIZE];
+	uint8_t _z[OAES_BLOCK_SIZE];
+	uint8_t _prev[OAES_BLOCK_SIZE];
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	_rc = oaes_cbc_cs3_check( _ctx, iv, c, c_len, m );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	memcpy( _chain, iv, OAES_BLOCK_SIZE );
+	
+	if( OAES_BLOCK_SIZE == c_len )
+	{
+		oaes_cbc_decrypt_run( _ctx->key, _chain, c, c_len, m );
+		return OAES_RET_SUCCESS;
+	}
+	
+	oaes_cbc_decrypt_run( _ctx->key, _chain, c, _head, m );
+	
+	// the whole block at _head is the last one enciphered, its decryption
+	// xored with the cut block gives the tail and also holds the bytes
+	// that were cut off it
+	memcpy( _z, c + _head, OAES_BLOCK_SIZE );
+	memcpy( _prev, c + _head + OAES_BLOCK_SIZE, _tail );
+	oaes_key_decrypt_blocks( _ctx->key, _z, 1 );
+	memcpy( _prev + _tail, _z + _tail, OAES_BLOCK_SIZE - _tail );
+	oaes_xor_bytes( m + _head + OAES_BLOCK_SIZE, _z, _prev, _tail );
+	
+	oaes_key_decrypt_blocks( _ctx->key, _prev, 1 );
+	oaes_xor_bytes( m + _head, _prev, _chain, OAES_BLOCK_SIZE );
+	
+	return OAES_RET_SUCCESS;
+}
+
+// derives K1 and K2 from L = E( K, 0^128 ) the first time the key is used
+// for CMAC, with the same doubling as OCB
+static OAES_RET oaes_cmac_key_setup( oaes_ctx * ctx )
+{
+	uint8_t _l[OAES_BLOCK_SIZE];
+	OAES_RET _rc;
+	
+	if( ctx->key->cmac_data )
+		return OAES_RET_SUCCESS;
+	
+	memset( _l, 0, OAES_BLOCK_SIZE );
+	_rc = oaes_encrypt_blocks( ctx, _l, OAES_BLOCK_SIZE );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	ctx->key->cmac_data = oaes_calloc_aligned( 2 * OAES_BLOCK_SIZE );
+	if( NULL == ctx->key->cmac_data )
+		return OAES_RET_MEM;
+	
+	oaes_ocb_double( ctx->key->cmac_data, _l );
+	oaes_ocb_double( ctx->key->cmac_data + OAES_BLOCK_SIZE,
+			ctx->key->cmac_data );
+	
+	return OAES_RET_SUCCESS;
+}
+
+// xors the next block of a message into x, the last block, of left bytes,
+// is masked with K1 when it is whole and padded and masked with K2 when not
+static void oaes_cmac_absorb( const uint8_t * k, uint8_t x[OAES_BLOCK_SIZE],
+		const uint8_t * m, size_t left )
+{
+	uint8_t _last[OAES_BLOCK_SIZE];
+	
+	if( left > OAES_BLOCK_SIZE )
+	{
+		oaes_put_raw64( x, oaes_get_raw64( x ) ^ oaes_get_raw64( m ) );
+		oaes_put_raw64( x + 8, oaes_get_raw64( x + 8 ) ^ oaes_get_raw64( m + 8 ) );
+		return;
+	}
+	
+	if( OAES_BLOCK_SIZE == left )
+		memcpy( _last, k, OAES_BLOCK_SIZE );
+	else
+	{
+		memcpy( _last, k + OAES_BLOCK_SIZE, OAES_BLOCK_SIZE );
+		_last[left] ^= 0x80;
+	}
+	
+	oaes_xor_bytes( _last, _last, m, left );
+	oaes_xor_bytes( x, x, _last, OAES_BLOCK_SIZE );
+}
+
+/*
+ * CMAC of count messages, OAES_LANES of them at a time, each step
+ * takes one block from every lane into a single call to the block kernel,
+ * a lane whose message is done takes the next message, so lanes are kept
+ * busy whatever the lengths, the tag of message i goes to tags + 16 * i
+ */
+static void oaes_cmac_lanes( const oaes_key * key, const uint8_t * const * m,
+		const size_t * m_len, size_t count, uint8_t * tags )
+{
+	size_t _i, _n = 0, _next = 0;
+	const uint8_t * _m[OAES_LANES];
+	size_t _left[OAES_LANES];
+	size_t _msg[OAES_LANES];
+	uint8_t _x[OAES_LANES * OAES_BLOCK_SIZE];
+	
+	while( _n || _next < count )
+	{
+		for( ; _n < OAES_LANES && _next < count; _n++, _next++ )
+		{
+			_m[_n] = m[_next];
+			_left[_n] = m_len[_next];
+			_msg[_n] = _next;
+			memset( _x + _n * OAES_BLOCK_SIZE, 0, OAES_BLOCK_SIZE );
+		}
+		
+		for( _i = 0; _i < _n; _i++ )
+			oaes_cmac_absorb( key->cmac_data, _x + _i * OAES_BLOCK_SIZE,
+					_m[_i], _left[_i] );
+		
+		oaes_key_encrypt_blocks( key, _x, _n );
+		
+		// a finished lane hands its tag out and the last lane moves into it
+		for( _i = _n; _i--; )
+		{
+			if( _left[_i] > OAES_BLOCK_SIZE )
+			{
+				_m[_i] += OAES_BLOCK_SIZE;
+				_left[_i] -= OAES_BLOCK_SIZE;
+				continue;
+			}
+			
+			memcpy( tags + _msg[_i] * OAES_BLOCK_SIZE,
+					_x + _i * OAES_BLOCK_SIZE, OAES_BLOCK_SIZE );
+			_n--;
+			_m[_i] = _m[_n];
+			_left[_i] = _left[_n];
+			_msg[_i] = _msg[_n];
+			memcpy( _x + _i * OAES_BLOCK_SIZE, _x + _n * OAES_BLOCK_SIZE,
+					OAES_BLOCK_SIZE );
+		}
+	}
+}
+
+OAES_RET oaes_cmac( OAES_CTX * ctx, const uint8_t * m, size_t m_len,
+		uint8_t tag[OAES_BLOCK_SIZE] )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == m && m_len )
+		return OAES_RET_ARG2;
+	
+	if( NULL == tag )
+		return OAES_RET_ARG4;
+	
+	if( NULL == _ctx->key )
+		return OAES_RET_NOKEY;
+	
+	_rc = oaes_cmac_key_setup( _ctx );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	oaes_cmac_lanes( _ctx->key, &m, &m_len, 1, tag );
+	
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_cmac_batch( OAES_CTX * ctx, const uint8_t * const * m,
+		const size_t * m_len, size_t count, uint8_t * tags )
+{
+	size_t _i;
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == m && count )
+		return OAES_RET_ARG2;
+	
+	if( NULL == m_len && count )
+		return OAES_RET_ARG3;
+	
+	if( NULL == tags && count )
+		return OAES_RET_ARG5;
+	
+	for( _i = 0; _i < count; _i++ )
+		if( NULL == m[_i] && m_len[_i] )
+			return OAES_RET_ARG2;
+	
+	if( NULL == _ctx->key )
+		return OAES_RET_NOKEY;
+	
+	_rc = oaes_cmac_key_setup( _ctx );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	oaes_cmac_lanes( _ctx->key, m, m_len, count, tags );
+	
+	return OAES_RET_SUCCESS;
+}
+
+/*
+ * the wrapping function W of SP 800-38F over count keys, or its inverse,
+ * a[8 * i] is the integrity value of key i and r[i] its n[i] semiblocks,
+ * both updated in place, OAES_LANES keys run at a time, a lane whose key
+ * is done after its 6 * n[i] steps takes the next one
+ */
+static void oaes_kw_lanes( const oaes_key * key, uint8_t * a,
+		uint8_t * const * r, const size_t * n, size_t count, int decrypt )
+{
+	size_t _i, _lanes = 0, _next = 0;
+	size_t _msg[OAES_LANES];
+	size_t _pos[OAES_LANES];
+	uint64_t _t[OAES_LANES];
+	uint8_t _x[OAES_LANES * OAES_BLOCK_SIZE];
+	
+	while( _lanes || _next < count )
+	{
+		for( ; _lanes < OAES_LANES && _next < count; _lanes++, _next++ )
+		{
+			_msg[_lanes] = _next;
+			_t[_lanes] = decrypt ? 6 * (uint64_t) n[_next] : 1;
+			_pos[_lanes] = decrypt ? n[_next] - 1 : 0;
+			memcpy( _x + _lanes * OAES_BLOCK_SIZE, a + 8 * _next, 8 );
+		}
+		
+		// A | R[i], with A xored with t ahead of decryption
+		for( _i = 0; _i < _lanes; _i++ )
+		{
+			memcpy( _x + _i * OAES_BLOCK_SIZE + 8, r[_msg[_i]] + 8 * _pos[_i], 8 );
+			if( decrypt )
+				oaes_put_be64( _x + _i * OAES_BLOCK_SIZE,
+						oaes_get_be64( _x + _i * OAES_BLOCK_SIZE ) ^ _t[_i] );
+		}
+		
+		if( decrypt )
+			oaes_key_decrypt_blocks( key, _x, _lanes );
+		else
+			oaes_key_encrypt_blocks( key, _x, _lanes );
+		
+		for( _i = _lanes; _i--; )
+		{
+			uint8_t * _b = _x + _i * OAES_BLOCK_SIZE;
+			size_t _n = n[_msg[_i]];
+			
+			memcpy( r[_msg[_i]] + 8 * _pos[_i], _b + 8, 8 );
+			
+			if( 0 == decrypt )
+			{
+				oaes_put_be64( _b, oaes_get_be64( _b ) ^ _t[_i] );
+				_pos[_i] = _pos[_i] + 1 == _n ? 0 : _pos[_i] + 1;
+				if( ++_t[_i] <= 6 * (uint64_t) _n )
+					continue;
+			}
+			else
+			{
+				_pos[_i] = _pos[_i] ? _pos[_i] - 1 : _n - 1;
+				if( --_t[_i] )
+					continue;
+			}
+			
+			memcpy( a + 8 * _msg[_i], _b, 8 );
+			_lanes--;
+			_msg[_i] = _msg[_lanes];
+			_pos[_i] = _pos[_lanes];
+			_t[_i] = _t[_lanes];
+			memcpy( _b, _x + _lanes * OAES_BLOCK_SIZE, OAES_BLOCK_SIZE );
+		}
+	}
+}
+
+// the wrapped length of a key of len bytes
+static size_t oaes_kw_wrapped_len( size_t len, int padded )
+{
+	return ( padded ? ( len + 7 ) / 8 * 8 : len ) + 8;
+}
+
+static int oaes_kw_len_ok( size_t len, int padded )
+{
+	if( padded )
+		return len > 0 && (uint64_t) len <= 0xffffffffUL;
+	return len >= 16 && 0 == len % 8;
+}
+
+/*
+ * wraps count keys OAES_KW_CHUNK at a time, KW starts from the integrity
+ * value A6A6A6A6A6A6A6A6, KWP from A65959A6 and the 32 bit length, and a
+ * KWP key that pads to a single semiblock is one plain block encryption,
+ * those are gathered into a batch of their own
+ */
+static void oaes_kw_wrap_run( const oaes_key * key, int padded,
+		const uint8_t * const * m, const size_t * m_len, size_t count,
+		uint8_t * const * c )
+{
+	size_t _i, _j, _len, _jobs, _ones;
+	uint8_t _a[OAES_KW_CHUNK * 8];
+	uint8_t * _r[OAES_KW_CHUNK];
+	size_t _n[OAES_KW_CHUNK];
+	size_t _job_msg[OAES_KW_CHUNK];
+	uint8_t _one[OAES_KW_CHUNK * OAES_BLOCK_SIZE];
+	size_t _one_msg[OAES_KW_CHUNK];
+	
+	for( ; count; count -= _len, m += _len, m_len += _len, c += _len )
+	{
+		_len = min( count, OAES_KW_CHUNK );
+		
+		for( _i = 0, _jobs = 0, _ones = 0; _i < _len; _i++ )
+		{
+			size_t _padded_len = oaes_kw_wrapped_len( m_len[_i], padded ) - 8;
+			uint8_t * _iv = _jobs * 8 + _a;
+			
+			if( padded && 8 == _padded_len )
+				_iv = _one + _ones * OAES_BLOCK_SIZE;
+			
+			oaes_put_be64( _iv, padded ?
+					OAES_KWP_IV | (uint64_t) m_len[_i] : OAES_KW_IV );
+			
+			if( padded && 8 == _padded_len )
+			{
+				memset( _iv + 8, 0, 8 );
+				memcpy( _iv + 8, m[_i], m_len[_i] );
+				_one_msg[_ones++] = _i;
+				continue;
+			}
+			
+			// the key is wrapped in place in its output, after A
+			memmove( c[_i] + 8, m[_i], m_len[_i] );
+			memset( c[_i] + 8 + m_len[_i], 0, _padded_len - m_len[_i] );
+			_r[_jobs] = c[_i] + 8;
+			_n[_jobs] = _padded_len / 8;
+			_job_msg[_jobs++] = _i;
+		}
+		
+		oaes_kw_lanes( key, _a, _r, _n, _jobs, 0 );
+		for( _j = 0; _j < _jobs; _j++ )
+			memcpy( c[_job_msg[_j]], _a + 8 * _j, 8 );
+		
+		oaes_key_encrypt_blocks( key, _one, _ones );
+		for( _j = 0; _j < _ones; _j++ )
+			memcpy( c[_one_msg[_j]], _one + _j * OAES_BLOCK_SIZE, OAES_BLOCK_SIZE );
+	}
+}
+
+// checks the integrity value a of an unwrapped key of n semiblocks at m,
+// and sets m_len to the length of the key in it
+static OAES_RET oaes_kw_check( const uint8_t a[8], const uint8_t * m,
+		size_t n, size_t * m_len, int padded )
+{
+	size_t _i;
+	uint64_t _a = oaes_get_be64( a );
+	uint64_t _len = _a & 0xffffffffUL;
+	uint8_t _diff = 0;
+	
+	if( 0 == padded )
+	{
+		*m_len = 8 * n;
+		return _a == OAES_KW_IV ? OAES_RET_SUCCESS : OAES_RET_AUTH;
+	}
+	
+	// the length has to land in the last semiblock, and the rest be zeros
+	if( ( _a & ~(uint64_t) 0xffffffffUL ) != OAES_KWP_IV ||
+			_len > 8 * n || _len + 8 <= 8 * n )
+		return OAES_RET_AUTH;
+	
+	for( _i = (size_t) _len; _i < 8 * n; _i++ )
+		_diff |= m[_i];
+	if( _diff )
+		return OAES_RET_AUTH;
+	
+	*m_len = (size_t) _len;
+	
+	return OAES_RET_SUCCESS;
+}
+
+// unwraps count keys as oaes_kw_wrap_run() wraps them, rc[i] is
+// OAES_RET_AUTH for a key that fails its check, its output is zeroed
+static void oaes_kw_unwrap_run( const oaes_key * key, int padded,
+		const uint8_t * const * c, const size_t * c_len, size_t count,
+		uint8_t * const * m, size_t * m_len, OAES_RET * rc )
+{
+	size_t _i, _j, _len, _jobs, _ones;
+	uint8_t _a[OAES_KW_CHUNK * 8];
+	uint8_t * _r[OAES_KW_CHUNK];
+	size_t _n[OAES_KW_CHUNK];
+	size_t _job_msg[OAES_KW_CHUNK];
+	uint8_t _one[OAES_KW_CHUNK * OAES_BLOCK_SIZE];
+	size_t _one_msg[OAES_KW_CHUNK];
+	
+	for( ; count; count -= _len, c += _len, c_len += _len,
+			m += _len, m_len += _len, rc += _len )
+	{
+		_len = min( count, OAES_KW_CHUNK );
+		
+		for( _i = 0, _jobs = 0, _ones = 0; _i < _len; _i++ )
+		{
+			if( padded && OAES_BLOCK_SIZE == c_len[_i] )
+			{
+				memcpy( _one + _ones * OAES_BLOCK_SIZE, c[_i], OAES_BLOCK_SIZE );
+				_one_msg[_ones++] = _i;
+				continue;
+			}
+			
+			memcpy( _a + 8 * _jobs, c[_i], 8 );
+			memmove( m[_i], c[_i] + 8, c_len[_i] - 8 );
+			_r[_jobs] = m[_i];
+			_n[_jobs] = ( c_len[_i] - 8 ) / 8;
+			_job_msg[_jobs++] = _i;
+		}
+		
+		oaes_kw_lanes( key, _a, _r, _n, _jobs, 1 );
+		for( _j = 0; _j < _jobs; _j++ )
+		{
+			_i = _job_msg[_j];
+			rc[_i] = oaes_kw_check( _a + 8 * _j, m[_i], _n[_j], m_len + _i, padded );
+		}
+		
+		oaes_key_decrypt_blocks( key, _one, _ones );
+		for( _j = 0; _j < _ones; _j++ )
+		{
+			_i = _one_msg[_j];
+			memcpy( m[_i], _one + _j * OAES_BLOCK_SIZE + 8, 8 );
+			rc[_i] = oaes_kw_check( _one + _j * OAES_BLOCK_SIZE, m[_i], 1,
+					m_len + _i, padded );
+		}
+		
+		// nothing of a key that fails is handed out
+		for( _i = 0; _i < _len; _i++ )
+			if( OAES_RET_SUCCESS != rc[_i] )
+			{
+				memset( m[_i], 0, c_len[_i] - 8 );
+				m_len[_i] = 0;
+			}
+	}
+}
+
+static OAES_RET oaes_kw_wrap( OAES_CTX * ctx, int padded,
+		const uint8_t * m, size_t m_len, uint8_t * c, size_t * c_len )
+{
+	size_t _c_len_in;
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == m )
+		return OAES_RET_ARG2;
+	
+	if( 0 == oaes_kw_len_ok( m_len, padded ) )
+		return OAES_RET_ARG3;
+	
+	if( NULL == c_len )
+		return OAES_RET_ARG5;
+	
+	_c_len_in = *c_len;
+	*c_len = oaes_kw_wrapped_len( m_len, padded );
+	
+	if( NULL == c )
+		return OAES_RET_SUCCESS;
+	
+	if( _c_len_in < *c_len )
+		return OAES_RET_BUF;
+	
+	if( NULL == _ctx->key )
+		return OAES_RET_NOKEY;
+	
+	oaes_kw_wrap_run( _ctx->key, padded, &m, &m_len, 1, &c );
+	
+	return OAES_RET_SUCCESS;
+}
+
+static OAES_RET oaes_kw_unwrap( OAES_CTX * ctx, int padded,
+		const uint8_t * c, size_t c_len, uint8_t * m, size_t * m_len )
+{
+	size_t _m_len_in;
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
+	
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == c )
+		return OAES_RET_ARG2;
+	
+	if( c_len % 8 || c_len < ( padded ? 16 : 24 ) )
+		return OAES_RET_ARG3;
+	
+	if( NULL == m_len )
+		return OAES_RET_ARG5;
+	
+	// the padding is only known once unwrapped, so m takes all of it
+	_m_len_in = *m_len;
+	*m_len = c_len - 8;
+	
+	if( NULL == m )
+		return OAES_RET_SUCCESS;
+	
+	if( _m_len_in < *m_len )
+		return OAES_RET_BUF;
+	
+	if( NULL == _ctx->key )
+		return OAES_RET_NOKEY;
+	
+	oaes_kw_unwrap_run( _ctx->key, padded, &c, &c_len, 1, &m, m_len, &_rc );
+	
+	return _rc;
+}
+
+OAES_RET oaes_kw_wrap_key( OAES_CTX * ctx,
+		const uint8_t * m, size_t m_len, uint8_t * c, size_t * c_len )
+{
+	return oaes_kw_wrap( ctx, 0, m, m_len, c, c_len );
+}
+
+OAES_RET oaes_kw_unwrap_key( OAES_CTX * ctx,
+		const uint8_t * c, size_t c_len, uint8_t * m, size_t * m_len )
+{
+	return oaes_kw_unwrap( ctx, 0, c, c_len, m, m_len );
+}
+
+OAES_RET oaes_kwp_wrap_key( OAES_CTX * ctx,
+		const uint8_t * m, size_t m_len, uint8_t * c, size_t * c_len )
+{
+	return oaes_kw_wrap( ctx, 1, m, m_len, c, c_len );
 }
-#endif // OAES_HAVE_ISAAC
 
-static OAES_RET oaes_key_destroy( oaes_key ** key )
+OAES_RET oaes_kwp_unwrap_key( OAES_CTX * ctx,
+		const uint8_t * c, size_t c_len, uint8_t * m, size_t * m_len )
 {
-	if( NULL == *key )
-		return OAES_RET_SUCCESS;
-	
-	if( (*key)->data )
-	{
-		free( (*key)->data );
-		(*key)->data = NULL;
-	}
-	
-	if( (*key)->exp_data )
-	{
-		free( (*key)->exp_data );
-		(*key)->exp_data = NULL;
-	}
-	
-	(*key)->data_len = 0;
-	(*key)->exp_data_len = 0;
-	(*key)->num_keys = 0;
-	(*key)->key_base = 0;
-	free( *key );
-	*key = NULL;
-	
-	return OAES_RET_SUCCESS;
+	return oaes_kw_unwrap( ctx, 1, c, c_len, m, m_len );
 }
 
-static OAES_RET oaes_key_expand( OAES_CTX * ctx )
+OAES_RET oaes_kw_wrap_batch( OAES_CTX * ctx, int padded,
+		const uint8_t * const * m, const size_t * m_len, size_t count,
+		uint8_t * const * c )
 {
-	size_t _i, _j;
+	size_t _i;
 	oaes_ctx * _ctx = (oaes_ctx *) ctx;
 	
 	if( NULL == _ctx )
 		return OAES_RET_ARG1;
 	
-	if( NULL == _ctx->key )
-		return OAES_RET_NOKEY;
+	if( NULL == m && count )
+		return OAES_RET_ARG3;
 	
-	_ctx->key->key_base = _ctx->key->data_len / OAES_RKEY_LEN;
-	_ctx->key->num_keys =  _ctx->key->key_base + OAES_ROUND_BASE;
-					
-	_ctx->key->exp_data_len = _ctx->key->num_keys * OAES_RKEY_LEN * OAES_COL_LEN;
-	_ctx->key->exp_data = (uint8_t *)
-			calloc( _ctx->key->exp_data_len, sizeof( uint8_t ));
+	if( NULL == m_len && count )
+		return OAES_RET_ARG4;
 	
-	if( NULL == _ctx->key->exp_data )
-		return OAES_RET_MEM;
+	if( NULL == c && count )
+		return OAES_RET_ARG6;
 	
-	// the first _ctx->key->data_len are a direct copy
-	memcpy( _ctx->key->exp_data, _ctx->key->data, _ctx->key->data_len );
-
-	// apply ExpandKey algorithm for remainder
-	for( _i = _ctx->key->key_base; _i < _ctx->key->num_keys * OAES_RKEY_LEN; _i++ )
+	for( _i = 0; _i < count; _i++ )
 	{
-		uint8_t _temp[OAES_COL_LEN];
-		
-		memcpy( _temp,
-				_ctx->key->exp_data + ( _i - 1 ) * OAES_RKEY_LEN, OAES_COL_LEN );
-		
-		// transform key column
-		if( 0 == _i % _ctx->key->key_base )
-		{
-			oaes_word_rot_left( _temp );
-
-			for( _j = 0; _j < OAES_COL_LEN; _j++ )
-				oaes_sub_byte( _temp + _j );
-
-			_temp[0] = _temp[0] ^ oaes_gf_8[ _i / _ctx->key->key_base - 1 ];
-		}
-		else if( _ctx->key->key_base > 6 && 4 == _i % _ctx->key->key_base )
-		{
-			for( _j = 0; _j < OAES_COL_LEN; _j++ )
-				oaes_sub_byte( _temp + _j );
-		}
-		
-		for( _j = 0; _j < OAES_COL_LEN; _j++ )
-		{
-			_ctx->key->exp_data[ _i * OAES_RKEY_LEN + _j ] =
-					_ctx->key->exp_data[ ( _i - _ctx->key->key_base ) *
-					OAES_RKEY_LEN + _j ] ^ _temp[_j];
-		}
+		if( NULL == m[_i] )
+			return OAES_RET_ARG3;
+		if( 0 == oaes_kw_len_ok( m_len[_i], padded ) )
+			return OAES_RET_ARG4;
+		if( NULL == c[_i] )
+			return OAES_RET_ARG6;
 	}
 	
+	if( NULL == _ctx->key )
+		return OAES_RET_NOKEY;
+	
+	oaes_kw_wrap_run( _ctx->key, padded, m, m_len, count, c );
+	
 	return OAES_RET_SUCCESS;
 }
 
-static OAES_RET oaes_key_gen( OAES_CTX * ctx, size_t key_size )
+OAES_RET oaes_kw_unwrap_batch( OAES_CTX * ctx, int padded,
+		const uint8_t * const * c, const size_t * c_len, size_t count,
+		uint8_t * const * m, size_t * m_len, OAES_RET * rc )
 {
 	size_t _i;
-	oaes_key * _key = NULL;
 	oaes_ctx * _ctx = (oaes_ctx *) ctx;
 	OAES_RET _rc = OAES_RET_SUCCESS;
 	
 	if( NULL == _ctx )
 		return OAES_RET_ARG1;
 	
-	_key = (oaes_key *) calloc( sizeof( oaes_key ), 1 );
+	if( NULL == c && count )
+		return OAES_RET_ARG3;
 	
-	if( NULL == _key )
-		return OAES_RET_MEM;
+	if( NULL == c_len && count )
+		return OAES_RET_ARG4;
 	
-	if( _ctx->key )
-		oaes_key_destroy( &(_ctx->key) );
+	if( NULL == m && count )
+		return OAES_RET_ARG6;
 	
-	_key->data_len = key_size;
-	_key->data = (uint8_t *) calloc( key_size, sizeof( uint8_t ));
+	if( NULL == m_len && count )
+		return OAES_RET_ARG7;
 	
-	if( NULL == _key->data )
+	if( NULL == rc && count )
+		return OAES_RET_ARG8;
+	
+	for( _i = 0; _i < count; _i++ )
 	{
-		free(_key);
-		return OAES_RET_MEM;
+		if( NULL == c[_i] )
+			return OAES_RET_ARG3;
+		if( c_len[_i] % 8 || c_len[_i] < ( padded ? 16 : 24 ) )
+			return OAES_RET_ARG4;
+		if( NULL == m[_i] )
+			return OAES_RET_ARG6;
 	}
+	
+	if( NULL == _ctx->key )
+		return OAES_RET_NOKEY;
+	
+	oaes_kw_unwrap_run( _ctx->key, padded, c, c_len, count, m, m_len, rc );
+	
+	for( _i = 0; _i < count; _i++ )
+		if( OAES_RET_SUCCESS != rc[_i] )
+			_rc = OAES_RET_AUTH;
+	
+	return _rc;
+}
+
+#if OAES_POLY1305_64
+typedef unsigned __int128 oaes_u128;
+#endif
 
+// sets up st for a message with key r, clamped here, and s = AES( k, nonce )
+static void oaes_poly1305_init( const oaes_key * key, oaes_poly1305_state * st,
+		const uint8_t r[OAES_BLOCK_SIZE], const uint8_t nonce[OAES_BLOCK_SIZE] )
+{
+	memset( st, 0, sizeof( *st ) );
 	
-	for( _i = 0; _i < key_size; _i++ )
-		_key->data[_i] = (uint8_t) OAES_RAND(_ctx->rctx);
+#if OAES_POLY1305_64
+	st->r[0] = oaes_get_le64( r ) & 0x0ffffffc0fffffffULL;
+	st->r[1] = oaes_get_le64( r + 8 ) & 0x0ffffffc0ffffffcULL;
+	st->r[2] = st->r[1] + ( st->r[1] >> 2 );
+#else
+	st->r[0] = oaes_get_word( r ) & 0x3ffffff;
+	st->r[1] = ( oaes_get_word( r + 3 ) >> 2 ) & 0x3ffff03;
+	st->r[2] = ( oaes_get_word( r + 6 ) >> 4 ) & 0x3ffc0ff;
+	st->r[3] = ( oaes_get_word( r + 9 ) >> 6 ) & 0x3f03fff;
+	st->r[4] = ( oaes_get_word( r + 12 ) >> 8 ) & 0x00fffff;
+#endif // OAES_POLY1305_64
 	
-	_ctx->key = _key;
-	_rc = _rc || oaes_key_expand( ctx );
+	memcpy( st->s, nonce, OAES_BLOCK_SIZE );
+	oaes_key_encrypt_blocks( key, st->s, 1 );
+	st->started = 1;
+}
+
+// h = ( h + block ) * r, partly reduced mod 2^130 - 5, for count blocks,
+// hibit is the bit above each block, 1 but for a padded last block
+static void oaes_poly1305_blocks( oaes_poly1305_state * st,
+		const uint8_t * m, size_t count, uint64_t hibit )
+{
+#if OAES_POLY1305_64
+	uint64_t _r0 = st->r[0], _r1 = st->r[1], _s1 = st->r[2];
+	uint64_t _h0 = st->h[0], _h1 = st->h[1], _h2 = st->h[2], _c;
+	oaes_u128 _d0, _d1;
 	
-	if( _rc != OAES_RET_SUCCESS )
+	for( ; count; count--, m += OAES_BLOCK_SIZE )
 	{
-		oaes_key_destroy( &(_ctx->key) );
-		return _rc;
+		_d0 = (oaes_u128) _h0 + oaes_get_le64( m );
+		_h0 = (uint64_t) _d0;
+		_d1 = (oaes_u128) _h1 + (uint64_t) ( _d0 >> 64 ) + oaes_get_le64( m + 8 );
+		_h1 = (uint64_t) _d1;
+		_h2 += (uint64_t) ( _d1 >> 64 ) + hibit;
+		
+		// r1 has its low 2 bits clear, so h1 r1 2^128 is h1 5 / 4 r1 2^130
+		_d0 = (oaes_u128) _h0 * _r0 + (oaes_u128) _h1 * _s1;
+		_d1 = (oaes_u128) _h0 * _r1 + (oaes_u128) _h1 * _r0 +
+				(oaes_u128) _h2 * _s1;
+		_h2 *= _r0;
+		
+		_h0 = (uint64_t) _d0;
+		_d1 += (uint64_t) ( _d0 >> 64 );
+		_h1 = (uint64_t) _d1;
+		_h2 += (uint64_t) ( _d1 >> 64 );
+		
+		// the bits from 2^130 up fold back in times 5
+		_c = ( _h2 >> 2 ) + ( _h2 & ~(uint64_t) 3 );
+		_h2 &= 3;
+		_h0 += _c;
+		_c = _h0 < _c;
+		_h1 += _c;
+		_c = _h1 < _c;
+		_h2 += _c;
 	}
 	
-	return OAES_RET_SUCCESS;
+	st->h[0] = _h0;
+	st->h[1] = _h1;
+	st->h[2] = _h2;
+#else
+	const uint64_t _m = 0x3ffffff;
+	uint64_t _r0 = st->r[0], _r1 = st->r[1], _r2 = st->r[2];
+	uint64_t _r3 = st->r[3], _r4 = st->r[4];
+	uint64_t _s1 = _r1 * 5, _s2 = _r2 * 5, _s3 = _r3 * 5, _s4 = _r4 * 5;
+	uint64_t _h0 = st->h[0], _h1 = st->h[1], _h2 = st->h[2];
+	uint64_t _h3 = st->h[3], _h4 = st->h[4];
+	uint64_t _d0, _d1, _d2, _d3, _d4, _c;
+	
+	for( ; count; count--, m += OAES_BLOCK_SIZE )
+	{
+		_h0 += oaes_get_word( m ) & _m;
+		_h1 += ( oaes_get_word( m + 3 ) >> 2 ) & _m;
+		_h2 += ( oaes_get_word( m + 6 ) >> 4 ) & _m;
+		_h3 += ( oaes_get_word( m + 9 ) >> 6 ) & _m;
+		_h4 += ( oaes_get_word( m + 12 ) >> 8 ) | ( hibit << 24 );
+		
+		_d0 = _h0 * _r0 + _h1 * _s4 + _h2 * _s3 + _h3 * _s2 + _h4 * _s1;
+		_d1 = _h0 * _r1 + _h1 * _r0 + _h2 * _s4 + _h3 * _s3 + _h4 * _s2;
+		_d2 = _h0 * _r2 + _h1 * _r1 + _h2 * _r0 + _h3 * _s4 + _h4 * _s3;
+		_d3 = _h0 * _r3 + _h1 * _r2 + _h2 * _r1 + _h3 * _r0 + _h4 * _s4;
+		_d4 = _h0 * _r4 + _h1 * _r3 + _h2 * _r2 + _h3 * _r1 + _h4 * _r0;
+		
+		_c = _d0 >> 26;
+		_h0 = _d0 & _m;
+		_d1 += _c;
+		_c = _d1 >> 26;
+		_h1 = _d1 & _m;
+		_d2 += _c;
+		_c = _d2 >> 26;
+		_h2 = _d2 & _m;
+		_d3 += _c;
+		_c = _d3 >> 26;
+		_h3 = _d3 & _m;
+		_d4 += _c;
+		_c = _d4 >> 26;
+		_h4 = _d4 & _m;
+		_h0 += _c * 5;
+		_c = _h0 >> 26;
+		_h0 &= _m;
+		_h1 += _c;
+	}
+	
+	st->h[0] = _h0;
+	st->h[1] = _h1;
+	st->h[2] = _h2;
+	st->h[3] = _h3;
+	st->h[4] = _h4;
+#endif // OAES_POLY1305_64
 }
 
-OAES_RET oaes_key_gen_128( OAES_CTX * ctx )
+static void oaes_poly1305_update_state( oaes_poly1305_state * st,
+		const uint8_t * m, size_t m_len )
 {
-	return oaes_key_gen( ctx, 16 );
+	size_t _len;
+	
+	if( st->buf_len )
+	{
+		_len = min( m_len, OAES_BLOCK_SIZE - st->buf_len );
+		memcpy( st->buf + st->buf_len, m, _len );
+		st->buf_len += _len;
+		m += _len;
+		m_len -= _len;
+		
+		if( st->buf_len < OAES_BLOCK_SIZE )
+			return;
+		
+		oaes_poly1305_blocks( st, st->buf, 1, 1 );
+		st->buf_len = 0;
+	}
+	
+	oaes_poly1305_blocks( st, m, m_len / OAES_BLOCK_SIZE, 1 );
+	
+	_len = m_len % OAES_BLOCK_SIZE;
+	memcpy( st->buf, m + m_len - _len, _len );
+	st->buf_len = _len;
 }
 
-OAES_RET oaes_key_gen_192( OAES_CTX * ctx )
+// pads and takes in what is left, reduces h mod 2^130 - 5 and adds s
+static void oaes_poly1305_tag( oaes_poly1305_state * st,
+		uint8_t tag[OAES_BLOCK_SIZE] )
 {
-	return oaes_key_gen( ctx, 24 );
+	uint64_t _h0, _h1, _h2, _g0, _g1, _g2, _mask;
+#if OAES_POLY1305_64
+	oaes_u128 _d;
+#else
+	const uint64_t _m = 0x3ffffff;
+	uint64_t _h3, _h4, _g3, _g4, _c;
+#endif // OAES_POLY1305_64
+	
+	if( st->buf_len )
+	{
+		st->buf[st->buf_len] = 1;
+		memset( st->buf + st->buf_len + 1, 0,
+				OAES_BLOCK_SIZE - st->buf_len - 1 );
+		oaes_poly1305_blocks( st, st->buf, 1, 0 );
+	}
+	
+#if OAES_POLY1305_64
+	_h0 = st->h[0];
+	_h1 = st->h[1];
+	_h2 = st->h[2];
+	
+	// h is under 2 p, so h - p, that is h + 5 - 2^130, is h mod p when
+	// it reaches bit 130
+	_d = (oaes_u128) _h0 + 5;
+	_g0 = (uint64_t) _d;
+	_d = (oaes_u128) _h1 + (uint64_t) ( _d >> 64 );
+	_g1 = (uint64_t) _d;
+	_g2 = _h2 + (uint64_t) ( _d >> 64 );
+	
+	_mask = 0 - ( _g2 >> 2 );
+	_h0 = ( _h0 & ~_mask ) | ( _g0 & _mask );
+	_h1 = ( _h1 & ~_mask ) | ( _g1 & _mask );
+	
+	_d = (oaes_u128) _h0 + oaes_get_le64( st->s );
+	_h0 = (uint64_t) _d;
+	_h1 += oaes_get_le64( st->s + 8 ) + (uint64_t) ( _d >> 64 );
+	
+	oaes_put_le64( tag, _h0 );
+	oaes_put_le64( tag + 8, _h1 );
+#else
+	_h0 = st->h[0];
+	_h1 = st->h[1];
+	_h2 = st->h[2];
+	_h3 = st->h[3];
+	_h4 = st->h[4];
+	
+	_c = _h1 >> 26;
+	_h1 &= _m;
+	_h2 += _c;
+	_c = _h2 >> 26;
+	_h2 &= _m;
+	_h3 += _c;
+	_c = _h3 >> 26;
+	_h3 &= _m;
+	_h4 += _c;
+	_c = _h4 >> 26;
+	_h4 &= _m;
+	_h0 += _c * 5;
+	_c = _h0 >> 26;
+	_h0 &= _m;
+	_h1 += _c;
+	
+	// h - p, kept when it does not go below zero
+	_g0 = _h0 + 5;
+	_c = _g0 >> 26;
+	_g0 &= _m;
+	_g1 = _h1 + _c;
+	_c = _g1 >> 26;
+	_g1 &= _m;
+	_g2 = _h2 + _c;
+	_c = _g2 >> 26;
+	_g2 &= _m;
+	_g3 = _h3 + _c;
+	_c = _g3 >> 26;
+	_g3 &= _m;
+	_g4 = _h4 + _c - ( (uint64_t) 1 << 26 );
+	
+	_mask = ( _g4 >> 63 ) - 1;
+	_h0 = ( _h0 & ~_mask ) | ( _g0 & _mask );
+	_h1 = ( _h1 & ~_mask ) | ( _g1 & _mask );
+	_h2 = ( _h2 & ~_mask ) | ( _g2 & _mask );
+	_h3 = ( _h3 & ~_mask ) | ( _g3 & _mask );
+	_h4 = ( _h4 & ~_mask ) | ( _g4 & _mask );
+	
+	// h mod 2^128 as four 32 bit words, plus s
+	_h0 = ( _h0 | ( _h1 << 26 ) ) & 0xffffffff;
+	_h1 = ( ( _h1 >> 6 ) | ( _h2 << 20 ) ) & 0xffffffff;
+	_h2 = ( ( _h2 >> 12 ) | ( _h3 << 14 ) ) & 0xffffffff;
+	_h3 = ( ( _h3 >> 18 ) | ( _h4 << 8 ) ) & 0xffffffff;
+	
+	_c = _h0 + oaes_get_word( st->s );
+	oaes_put_word( tag, (uint32_t) _c );
+	_c = _h1 + oaes_get_word( st->s + 4 ) + ( _c >> 32 );
+	oaes_put_word( tag + 4, (uint32_t) _c );
+	_c = _h2 + oaes_get_word( st->s + 8 ) + ( _c >> 32 );
+	oaes_put_word( tag + 8, (uint32_t) _c );
+	_c = _h3 + oaes_get_word( st->s + 12 ) + ( _c >> 32 );
+	oaes_put_word( tag + 12, (uint32_t) _c );
+#endif // OAES_POLY1305_64
+	
+	memset( st, 0, sizeof( *st ) );
 }
 
-OAES_RET oaes_key_gen_256( OAES_CTX * ctx )
+static OAES_RET oaes_poly1305_check( oaes_ctx * ctx,
+		const uint8_t * r, const uint8_t * nonce )
 {
-	return oaes_key_gen( ctx, 32 );
+	if( NULL == ctx )
+		return OAES_RET_ARG1;
+	
+	if( NULL == r )
+		return OAES_RET_ARG2;
+	
+	if( NULL == nonce )
+		return OAES_RET_ARG3;
+	
+	if( NULL == ctx->key )
+		return OAES_RET_NOKEY;
+	
+	return OAES_RET_SUCCESS;
 }
 
-OAES_RET oaes_key_export( OAES_CTX * ctx,
-		uint8_t * data, size_t * data_len )
+OAES_RET oaes_poly1305_aes( OAES_CTX * ctx,
+		const uint8_t r[OAES_BLOCK_SIZE], const uint8_t nonce[OAES_BLOCK_SIZE],
+		const uint8_t * m, size_t m_len, uint8_t tag[OAES_BLOCK_SIZE] )
 {
-	size_t _data_len_in;
 	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	oaes_poly1305_state _st;
+	OAES_RET _rc;
 	
-	if( NULL == _ctx )
-		return OAES_RET_ARG1;
+	_rc = oaes_poly1305_check( _ctx, r, nonce );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
 	
-	if( NULL == _ctx->key )
-		return OAES_RET_NOKEY;
+	if( NULL == m && m_len )
+		return OAES_RET_ARG4;
 	
-	if( NULL == data_len )
-		return OAES_RET_ARG3;
-
-	_data_len_in = *data_len;
-	// data + header
-	*data_len = _ctx->key->data_len + OAES_BLOCK_SIZE;
+	if( NULL == tag )
+		return OAES_RET_ARG6;
+	
+	oaes_poly1305_init( _ctx->key, &_st, r, nonce );
+	oaes_poly1305_update_state( &_st, m, m_len );
+	oaes_poly1305_tag( &_st, tag );
+	
+	return OAES_RET_SUCCESS;
+}
 
-	if( NULL == data )
-		return OAES_RET_SUCCESS;
+OAES_RET oaes_poly1305_start( OAES_CTX * ctx,
+		const uint8_t r[OAES_BLOCK_SIZE], const uint8_t nonce[OAES_BLOCK_SIZE] )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
 	
-	if( _data_len_in < *data_len )
-		return OAES_RET_BUF;
+	_rc = oaes_poly1305_check( _ctx, r, nonce );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
 	
-	// header
-	memcpy( data, oaes_header, OAES_BLOCK_SIZE );
-	data[5] = 0x01;
-	data[7] = _ctx->key->data_len;
-	memcpy( data + OAES_BLOCK_SIZE, _ctx->key->data, _ctx->key->data_len );
+	oaes_poly1305_init( _ctx->key, &_ctx->poly1305, r, nonce );
 	
 	return OAES_RET_SUCCESS;
 }
 
-OAES_RET oaes_key_export_data( OAES_CTX * ctx,
-		uint8_t * data, size_t * data_len )
+OAES_RET oaes_poly1305_update( OAES_CTX * ctx,
+		const uint8_t * m, size_t m_len )
 {
-	size_t _data_len_in;
 	oaes_ctx * _ctx = (oaes_ctx *) ctx;
 	
 	if( NULL == _ctx )
 		return OAES_RET_ARG1;
 	
-	if( NULL == _ctx->key )
-		return OAES_RET_NOKEY;
-	
-	if( NULL == data_len )
-		return OAES_RET_ARG3;
-
-	_data_len_in = *data_len;
-	*data_len = _ctx->key->data_len;
-
-	if( NULL == data )
-		return OAES_RET_SUCCESS;
+	if( NULL == m && m_len )
+		return OAES_RET_ARG2;
 	
-	if( _data_len_in < *data_len )
-		return OAES_RET_BUF;
+	if( 0 == _ctx->poly1305.started )
+		return OAES_RET_ERROR;
 	
-	memcpy( data, _ctx->key->data, *data_len );
+	oaes_poly1305_update_state( &_ctx->poly1305, m, m_len );
 	
 	return OAES_RET_SUCCESS;
 }
 
-OAES_RET oaes_key_import( OAES_CTX * ctx,
-		const uint8_t * data, size_t data_len )
+OAES_RET oaes_poly1305_final( OAES_CTX * ctx, uint8_t tag[OAES_BLOCK_SIZE] )
 {
 	oaes_ctx * _ctx = (oaes_ctx *) ctx;
-	OAES_RET _rc = OAES_RET_SUCCESS;
-	int _key_length;
 	
 	if( NULL == _ctx )
 		return OAES_RET_ARG1;
 	
-	if( NULL == data )
+	if( NULL == tag )
 		return OAES_RET_ARG2;
 	
-	switch( data_len )
-	{
-		case 16 + OAES_BLOCK_SIZE:
-		case 24 + OAES_BLOCK_SIZE:
-		case 32 + OAES_BLOCK_SIZE:
-			break;
-		default:
-			return OAES_RET_ARG3;
-	}
+	if( 0 == _ctx->poly1305.started )
+		return OAES_RET_ERROR;
 	
-	// header
-	if( 0 != memcmp( data, oaes_header, 4 ) )
-		return OAES_RET_HEADER;
-
-	// header version
-	switch( data[4] )
-	{
-		case 0x01:
-			break;
-		default:
-			return OAES_RET_HEADER;
-	}
+	oaes_poly1305_tag( &_ctx->poly1305, tag );
 	
-	// header type
-	switch( data[5] )
-	{
-		case 0x01:
-			break;
-		default:
-			return OAES_RET_HEADER;
-	}
+	return OAES_RET_SUCCESS;
+}
+
+static OAES_RET oaes_poly1305_etm_check( oaes_ctx * ctx,
+		const uint8_t * r, const uint8_t * nonce, const uint8_t * iv,
+		const uint8_t * in, size_t len, const uint8_t * out,
+		const uint8_t * tag )
+{
+	OAES_RET _rc = oaes_poly1305_check( ctx, r, nonce );
 	
-	// options
-	_key_length = data[7];
-	switch( _key_length )
-	{
-		case 16:
-		case 24:
-		case 32:
-			break;
-		default:
-			return OAES_RET_HEADER;
-	}
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
 	
-	if( data_len != _key_length + OAES_BLOCK_SIZE )
-			return OAES_RET_ARG3;
+	if( NULL == iv )
+		return OAES_RET_ARG4;
 	
-	if( _ctx->key )
-		oaes_key_destroy( &(_ctx->key) );
+	if( NULL == in && len )
+		return OAES_RET_ARG5;
 	
-	_ctx->key = (oaes_key *) calloc( sizeof( oaes_key ), 1 );
+	// CBC is not padded here, so that c is as long as m
+	if( ( ctx->options & OAES_OPTION_CBC ) && len % OAES_BLOCK_SIZE )
+		return OAES_RET_ARG6;
 	
-	if( NULL == _ctx->key )
-		return OAES_RET_MEM;
+	if( NULL == out && len )
+		return OAES_RET_ARG7;
 	
-	_ctx->key->data_len = _key_length;
-	_ctx->key->data = (uint8_t *)
-			calloc( _key_length, sizeof( uint8_t ));
+	if( NULL == tag )
+		return OAES_RET_ARG8;
 	
-	if( NULL == _ctx->key->data )
-	{
-		oaes_key_destroy( &(_ctx->key) );
-		return OAES_RET_MEM;
-	}
+	// ECB would show equal blocks, MAC or not
+	if( 0 == ( ctx->options & ( OAES_OPTION_CBC | OAES_OPTION_CTR ) ) )
+		return OAES_RET_ERROR;
+	
+	return OAES_RET_SUCCESS;
+}
 
-	memcpy( _ctx->key->data, data + OAES_BLOCK_SIZE, _key_length );
-	_rc = _rc || oaes_key_expand( ctx );
+OAES_RET oaes_poly1305_encrypt( OAES_CTX * ctx,
+		const uint8_t r[OAES_BLOCK_SIZE], const uint8_t nonce[OAES_BLOCK_SIZE],
+		uint8_t iv[OAES_BLOCK_SIZE], const uint8_t * m, size_t m_len,
+		uint8_t * c, uint8_t tag[OAES_BLOCK_SIZE] )
+{
+	size_t _len, _c_len;
+	uint8_t _pad;
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	oaes_poly1305_state _st;
+	OAES_RET _rc;
 	
-	if( _rc != OAES_RET_SUCCESS )
-	{
-		oaes_key_destroy( &(_ctx->key) );
+	_rc = oaes_poly1305_etm_check( _ctx, r, nonce, iv, m, m_len, c, tag );
+	if( OAES_RET_SUCCESS != _rc )
 		return _rc;
+	
+	// the tag covers the iv, so it cannot be changed to shift the plaintext
+	oaes_poly1305_init( _ctx->key, &_st, r, nonce );
+	oaes_poly1305_update_state( &_st, iv, OAES_BLOCK_SIZE );
+	
+	for( ; m_len; m_len -= _len, m += _len, c += _len )
+	{
+		_len = min( m_len, OAES_POLY1305_CHUNK );
+		_c_len = _len;
+		
+		_rc = oaes_encrypt( ctx, m, _len, c, &_c_len, iv, &_pad );
+		if( OAES_RET_SUCCESS != _rc )
+			return _rc;
+		
+		oaes_poly1305_update_state( &_st, c, _len );
 	}
 	
+	oaes_poly1305_tag( &_st, tag );
+	
 	return OAES_RET_SUCCESS;
 }
 
-OAES_RET oaes_key_import_data( OAES_CTX * ctx,
-		const uint8_t * data, size_t data_len )
+OAES_RET oaes_poly1305_decrypt( OAES_CTX * ctx,
+		const uint8_t r[OAES_BLOCK_SIZE], const uint8_t nonce[OAES_BLOCK_SIZE],
+		uint8_t iv[OAES_BLOCK_SIZE], const uint8_t * c, size_t c_len,
+		uint8_t * m, const uint8_t tag[OAES_BLOCK_SIZE] )
 {
+	size_t _i, _len, _m_len, _left = c_len;
+	uint8_t _tag[OAES_BLOCK_SIZE];
+	uint8_t _diff = 0;
+	uint8_t * _m = m;
 	oaes_ctx * _ctx = (oaes_ctx *) ctx;
-	OAES_RET _rc = OAES_RET_SUCCESS;
+	oaes_poly1305_state _st;
+	OAES_RET _rc;
 	
-	if( NULL == _ctx )
-		return OAES_RET_ARG1;
+	_rc = oaes_poly1305_etm_check( _ctx, r, nonce, iv, c, c_len, m, tag );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
 	
-	if( NULL == data )
-		return OAES_RET_ARG2;
+	oaes_poly1305_init( _ctx->key, &_st, r, nonce );
+	oaes_poly1305_update_state( &_st, iv, OAES_BLOCK_SIZE );
 	
-	switch( data_len )
+	// each chunk is MACed and decrypted while it is in cache, the tag is
+	// only known at the end, so a failed check zeroes all of m
+	for( ; _left; _left -= _len, c += _len, _m += _len )
 	{
-		case 16:
-		case 24:
-		case 32:
-			break;
-		default:
-			return OAES_RET_ARG3;
+		_len = min( _left, OAES_POLY1305_CHUNK );
+		_m_len = _len;
+		
+		oaes_poly1305_update_state( &_st, c, _len );
+		
+		_rc = oaes_decrypt( ctx, c, _len, _m, &_m_len, iv, 0 );
+		if( OAES_RET_SUCCESS != _rc )
+			return _rc;
 	}
 	
-	if( _ctx->key )
-		oaes_key_destroy( &(_ctx->key) );
+	oaes_poly1305_tag( &_st, _tag );
 	
-	_ctx->key = (oaes_key *) calloc( sizeof( oaes_key ), 1 );
+	for( _i = 0; _i < OAES_BLOCK_SIZE; _i++ )
+		_diff |= _tag[_i] ^ tag[_i];
 	
-	if( NULL == _ctx->key )
-		return OAES_RET_MEM;
+	if( _diff )
+	{
+		if( c_len )
+			memset( m, 0, c_len );
+		return OAES_RET_AUTH;
+	}
 	
-	_ctx->key->data_len = data_len;
-	_ctx->key->data = (uint8_t *)
-			calloc( data_len, sizeof( uint8_t ));
+	return OAES_RET_SUCCESS;
+}
+
+// the numerals of half h at a, most significant first, into limbs, least
+// significant first
+static void oaes_ff1_pack( const oaes_ff1_shape * sh, int h,
+		const uint16_t * a, uint32_t * limbs )
+{
+	size_t _i, _j, _end = sh->half[h];
+	uint32_t _l;
 	
-	if( NULL == _ctx->key->data )
+	for( _i = 0; _i < sh->limbs[h]; _i++, _end -= sh->k )
 	{
-		oaes_key_destroy( &(_ctx->key) );
-		return OAES_RET_MEM;
+		_l = 0;
+		for( _j = _end > sh->k ? _end - sh->k : 0; _j < _end; _j++ )
+			_l = _l * sh->radix + a[_j];
+		limbs[_i] = _l;
 	}
+}
 
-	memcpy( _ctx->key->data, data, data_len );
-	_rc = _rc || oaes_key_expand( ctx );
-	
-	if( _rc != OAES_RET_SUCCESS )
+// the count numerals of limb l ending at a
+static void oaes_ff1_digits( uint32_t l, uint16_t * a, size_t count,
+		uint32_t radix )
+{
+	for( ; count; count-- )
 	{
-		oaes_key_destroy( &(_ctx->key) );
-		return _rc;
+		*--a = (uint16_t) ( l % radix );
+		l /= radix;
 	}
-	
-	return OAES_RET_SUCCESS;
 }
 
-OAES_CTX * oaes_alloc()
+// radix 10 and 36, the usual ones, divide by a constant
+static void oaes_ff1_unpack( const oaes_ff1_shape * sh, int h,
+		const uint32_t * limbs, uint16_t * a )
 {
-	oaes_ctx * _ctx = (oaes_ctx *) calloc( sizeof( oaes_ctx ), 1 );
+	size_t _i, _count, _end = sh->half[h];
 	
-	if( NULL == _ctx )
-		return NULL;
-
-#ifdef OAES_HAVE_ISAAC
+	for( _i = 0; _i < sh->limbs[h]; _i++, _end -= _count )
 	{
-		ub4 _i = 0;
-		char _seed[RANDSIZ + 1];
-		
-		_ctx->rctx = (randctx *) calloc( sizeof( randctx ), 1 );
+		_count = min( _end, sh->k );
+		if( 10 == sh->radix )
+			oaes_ff1_digits( limbs[_i], a + _end, _count, 10 );
+		else if( 36 == sh->radix )
+			oaes_ff1_digits( limbs[_i], a + _end, _count, 36 );
+		else
+			oaes_ff1_digits( limbs[_i], a + _end, _count, sh->radix );
+	}
+}
 
-		if( NULL == _ctx->rctx )
+// the value of half h in binary, as bin_len 32 bit words, least
+// significant first
+static void oaes_ff1_binary( const oaes_ff1_shape * sh, int h,
+		const uint32_t * limbs, uint32_t * bin, size_t bin_len )
+{
+	size_t _i, _j;
+	uint64_t _t;
+	
+	memset( bin, 0, bin_len * sizeof( uint32_t ) );
+	bin[0] = limbs[sh->limbs[h] - 1];
+	
+	for( _i = sh->limbs[h] - 1; _i--; )
+	{
+		_t = limbs[_i];
+		for( _j = 0; _j < bin_len; _j++ )
 		{
-			free( _ctx );
-			return NULL;
+			_t += bin[_j] * sh->w;
+			bin[_j] = (uint32_t) _t;
+			_t >>= 32;
 		}
-
-		oaes_get_seed( _seed );
-		memset( _ctx->rctx->randrsl, 0, RANDSIZ );
-		memcpy( _ctx->rctx->randrsl, _seed, RANDSIZ );
-		randinit( _ctx->rctx, TRUE);
 	}
-#else
-		srand( oaes_get_seed() );
-#endif // OAES_HAVE_ISAAC
-
-	_ctx->key = NULL;
-	oaes_set_option( _ctx, OAES_OPTION_CBC, NULL );
-
-#ifdef OAES_DEBUG
-	_ctx->step_cb = NULL;
-	oaes_set_option( _ctx, OAES_OPTION_STEP_OFF, NULL );
-#endif // OAES_DEBUG
-
-	return (OAES_CTX *) _ctx;
 }
 
-OAES_RET oaes_free( OAES_CTX ** ctx )
+// the b bytes of NUM( B ), big endian
+static void oaes_ff1_num_bytes( const oaes_ff1_shape * sh, int h,
+		const uint32_t * limbs, uint8_t * out )
 {
-	oaes_ctx ** _ctx = (oaes_ctx **) ctx;
-
-	if( NULL == _ctx )
-		return OAES_RET_ARG1;
-	
-	if( NULL == *_ctx )
-		return OAES_RET_SUCCESS;
+	size_t _i;
+	uint32_t _bin[OAES_FF1_MAX_B / 4 + 1];
 	
-	if( (*_ctx)->key )
-		oaes_key_destroy( &((*_ctx)->key) );
+	oaes_ff1_binary( sh, h, limbs, _bin, ( sh->b + 3 ) / 4 );
+	for( _i = 0; _i < sh->b; _i++ )
+		out[sh->b - 1 - _i] = (uint8_t) ( _bin[_i / 4] >> ( 8 * ( _i % 4 ) ) );
+}
 
-#ifdef OAES_HAVE_ISAAC
-	if( (*_ctx)->rctx )
+/*
+ * y = NUM( S ) mod radix^m for half h of m numerals, in its limbs, S is
+ * taken 32 bits at a time after the first 64, a limb times 2^32 plus the carry still fits 64
+ * bits as limbs are below 2^32, and the reduction is only the dropping of
+ * what carries out of the top limb
+ */
+static void oaes_ff1_y( const oaes_ff1_shape * sh, int h,
+		const uint8_t * s, uint32_t * y )
+{
+	size_t _i, _j, _top = sh->limbs[h] - 1;
+	uint64_t _t;
+	
+	// S is at least 8 bytes, they go in at once while y is still zero
+	_t = oaes_get_be64( s );
+	for( _j = 0; _j < _top; _j++ )
 	{
-		free( (*_ctx)->rctx );
-		(*_ctx)->rctx = NULL;
+		y[_j] = (uint32_t) ( _t % sh->w );
+		_t /= sh->w;
 	}
-#endif // OAES_HAVE_ISAAC
+	y[_top] = (uint32_t) ( _t % sh->top[h] );
 	
-	free( *_ctx );
-	*_ctx = NULL;
-
-	return OAES_RET_SUCCESS;
+	for( _i = 8; _i < sh->d; _i += 4 )
+	{
+		_t = oaes_get_be32( s + _i );
+		for( _j = 0; _j < _top; _j++ )
+		{
+			_t += (uint64_t) y[_j] << 32;
+			y[_j] = (uint32_t) ( _t % sh->w );
+			_t /= sh->w;
+		}
+		y[_top] = (uint32_t) ( ( _t + ( (uint64_t) y[_top] << 32 ) ) % sh->top[h] );
+	}
 }
 
-OAES_RET oaes_set_option( OAES_CTX * ctx,
-		OAES_OPTION option, const void * value )
+// a = a + y, or a - y, mod radix^m for half h
+static void oaes_ff1_add( const oaes_ff1_shape * sh, int h,
+		uint32_t * a, const uint32_t * y, int subtract )
 {
-	size_t _i;
-	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	size_t _i, _top = sh->limbs[h] - 1;
+	uint64_t _c = 0, _base;
 	
-	if( NULL == _ctx )
-		return OAES_RET_ARG1;
-
-	switch( option )
+	for( _i = 0; _i <= _top; _i++ )
 	{
-		case OAES_OPTION_ECB:
-			_ctx->options &= ~OAES_OPTION_CBC;
-			memset( _ctx->iv, 0, OAES_BLOCK_SIZE );
-			break;
-
-		case OAES_OPTION_CBC:
-			_ctx->options &= ~OAES_OPTION_ECB;
-			if( value )
-				memcpy( _ctx->iv, value, OAES_BLOCK_SIZE );
-			else
-			{
-				for( _i = 0; _i < OAES_BLOCK_SIZE; _i++ )
-					_ctx->iv[_i] = (uint8_t) OAES_RAND(_ctx->rctx);
-			}
-			break;
-
-#ifdef OAES_DEBUG
-
-		case OAES_OPTION_STEP_ON:
-			if( value )
-			{
-				_ctx->options &= ~OAES_OPTION_STEP_OFF;
-				_ctx->step_cb = value;
-			}
-			else
-			{
-				_ctx->options &= ~OAES_OPTION_STEP_ON;
-				_ctx->options |= OAES_OPTION_STEP_OFF;
-				_ctx->step_cb = NULL;
-				return OAES_RET_ARG3;
-			}
-			break;
-
-		case OAES_OPTION_STEP_OFF:
-			_ctx->options &= ~OAES_OPTION_STEP_ON;
-			_ctx->step_cb = NULL;
-			break;
-
-#endif // OAES_DEBUG
-
-		default:
-			return OAES_RET_ARG2;
+		_base = _i == _top ? sh->top[h] : sh->w;
+		if( subtract )
+		{
+			_c = (uint64_t) a[_i] + _base - y[_i] - _c;
+			a[_i] = (uint32_t) ( _c < _base ? _c : _c - _base );
+			_c = _c < _base;
+		}
+		else
+		{
+			_c += (uint64_t) a[_i] + y[_i];
+			a[_i] = (uint32_t) ( _c < _base ? _c : _c - _base );
+			_c = _c >= _base;
+		}
 	}
-
-	_ctx->options |= option;
-
-	return OAES_RET_SUCCESS;
 }
 
-static OAES_RET oaes_encrypt_block(
-		OAES_CTX * ctx, uint8_t * c, size_t c_len )
+// sets up what a batch of values of n numerals in radix, under tweak, share
+static void oaes_ff1_shape_init( const oaes_key * key, oaes_ff1_shape * sh,
+		uint32_t radix, size_t n, const uint8_t * tweak, size_t t )
 {
-	size_t _i, _j;
-	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	size_t _i, _bits, _pad, _pre;
+	uint32_t _max[OAES_FF1_LIMBS];
+	uint32_t _bin[OAES_FF1_MAX_B / 4 + 1];
+	uint8_t _p[OAES_BLOCK_SIZE];
 	
-	if( NULL == _ctx )
-		return OAES_RET_ARG1;
+	memset( sh, 0, sizeof( *sh ) );
+	sh->radix = radix;
+	sh->n = n;
+	sh->half[0] = n / 2;
+	sh->half[1] = n - n / 2;
 	
-	if( NULL == c )
-		return OAES_RET_ARG2;
+	// the most numerals that fit a 32 bit limb
+	for( sh->k = 1, sh->w = radix; sh->w * radix <= 0xffffffffUL; sh->k++ )
+		sh->w *= radix;
 	
-	if( c_len != OAES_BLOCK_SIZE )
-		return OAES_RET_ARG3;
+	for( _i = 0; _i < 2; _i++ )
+	{
+		size_t _j, _top_len;
+		
+		sh->limbs[_i] = ( sh->half[_i] + sh->k - 1 ) / sh->k;
+		_top_len = sh->half[_i] - sh->k * ( sh->limbs[_i] - 1 );
+		for( _j = 0, sh->top[_i] = 1; _j < _top_len; _j++ )
+			sh->top[_i] *= radix;
+	}
 	
-	if( NULL == _ctx->key )
-		return OAES_RET_NOKEY;
+	// b is the byte length of radix^v - 1, the largest v numerals
+	for( _i = 0; _i < sh->limbs[1]; _i++ )
+		_max[_i] = (uint32_t) ( ( _i + 1 < sh->limbs[1] ? sh->w : sh->top[1] ) - 1 );
+	oaes_ff1_binary( sh, 1, _max, _bin, OAES_FF1_MAX_B / 4 + 1 );
+	for( _bits = 32 * ( OAES_FF1_MAX_B / 4 + 1 ); _bits &&
+			0 == ( _bin[( _bits - 1 ) / 32] >> ( ( _bits - 1 ) % 32 ) & 1 ); _bits-- )
+		;
+	sh->b = ( _bits + 7 ) / 8;
+	sh->d = 4 * ( ( sh->b + 3 ) / 4 ) + 4;
 	
-#ifdef OAES_DEBUG
-	if( _ctx->step_cb )
-		_ctx->step_cb( c, "input", 1, NULL );
-#endif // OAES_DEBUG
-
-	// AddRoundKey(State, K0)
-	for( _i = 0; _i < c_len; _i++ )
-		c[_i] = c[_i] ^ _ctx->key->exp_data[_i];
+	// P
+	_p[0] = 1;
+	_p[1] = 2;
+	_p[2] = 1;
+	_p[3] = (uint8_t) ( radix >> 16 );
+	_p[4] = (uint8_t) ( radix >> 8 );
+	_p[5] = (uint8_t) radix;
+	_p[6] = 10;
+	_p[7] = (uint8_t) sh->half[0];
+	oaes_put_be64( _p + 8, ( (uint64_t) n << 32 ) | (uint64_t) t );
+	memcpy( sh->x0, _p, OAES_BLOCK_SIZE );
+	oaes_key_encrypt_blocks( key, sh->x0, 1 );
 	
-#ifdef OAES_DEBUG
-	if( _ctx->step_cb )
+	// Q is T, zeros, the round number and NUM( B ), the blocks of T and
+	// zeros alone are the same every round
+	_pad = ( OAES_BLOCK_SIZE - ( t + sh->b + 1 ) % OAES_BLOCK_SIZE ) %
+			OAES_BLOCK_SIZE;
+	_pre = ( t + _pad ) / OAES_BLOCK_SIZE;
+	for( _i = 0; _i < _pre * OAES_BLOCK_SIZE; _i++ )
 	{
-		_ctx->step_cb( _ctx->key->exp_data, "k_sch", 1, NULL );
-		_ctx->step_cb( c, "k_add", 1, NULL );
+		sh->x0[_i % OAES_BLOCK_SIZE] ^= _i < t ? tweak[_i] : 0;
+		if( OAES_BLOCK_SIZE - 1 == _i % OAES_BLOCK_SIZE )
+			oaes_key_encrypt_blocks( key, sh->x0, 1 );
 	}
-#endif // OAES_DEBUG
+	
+	sh->tail_len = t + _pad + 1 + sh->b - _pre * OAES_BLOCK_SIZE;
+	if( t > _pre * OAES_BLOCK_SIZE )
+		memcpy( sh->tail, tweak + _pre * OAES_BLOCK_SIZE,
+				t - _pre * OAES_BLOCK_SIZE );
+}
 
-	// for round = 1 step 1 to Nr–1
-	for( _i = 1; _i < _ctx->key->num_keys - 1; _i++ )
+/*
+ * FF1 over count values of sh->n numerals at in, OAES_FF1_CHUNK at a time,
+ * every value of a chunk takes the same step of the CBC-MAC in one call to
+ * the block kernel, the halves stay in limbs for all ten rounds, a half
+ * keeps its length, so its role alternates, prf is the one put into Q
+ */
+static void oaes_ff1_run( const oaes_key * key, const oaes_ff1_shape * sh,
+		const uint16_t * in, size_t count, uint16_t * out, int decrypt )
+{
+	size_t _i, _j, _r, _len, _round;
+	size_t _extra = ( sh->d - 1 ) / OAES_BLOCK_SIZE;
+	int _prf;
+	uint32_t _h[OAES_FF1_CHUNK][2][OAES_FF1_LIMBS];
+	uint32_t _y[OAES_FF1_LIMBS];
+	uint8_t _q[OAES_FF1_CHUNK][OAES_FF1_TAIL];
+	uint8_t _x[OAES_FF1_CHUNK * OAES_BLOCK_SIZE];
+	uint8_t _ext[OAES_FF1_CHUNK * ( OAES_FF1_S_BLOCKS - 1 ) * OAES_BLOCK_SIZE];
+	uint8_t _s[OAES_FF1_S_BLOCKS * OAES_BLOCK_SIZE];
+	
+	for( ; count; count -= _len, in += _len * sh->n, out += _len * sh->n )
 	{
-		// SubBytes(state)
-		for( _j = 0; _j < c_len; _j++ )
-			oaes_sub_byte( c + _j );
-
-#ifdef OAES_DEBUG
-		if( _ctx->step_cb )
-			_ctx->step_cb( c, "s_box", _i, NULL );
-#endif // OAES_DEBUG
-
-		// ShiftRows(state)
-		oaes_shift_rows( c );
+		_len = min( count, OAES_FF1_CHUNK );
 		
-#ifdef OAES_DEBUG
-		if( _ctx->step_cb )
-			_ctx->step_cb( c, "s_row", _i, NULL );
-#endif // OAES_DEBUG
-
-		// MixColumns(state)
-		oaes_mix_cols( c );
-		oaes_mix_cols( c + 4 );
-		oaes_mix_cols( c + 8 );
-		oaes_mix_cols( c + 12 );
+		for( _i = 0; _i < _len; _i++ )
+		{
+			oaes_ff1_pack( sh, 0, in + _i * sh->n, _h[_i][0] );
+			oaes_ff1_pack( sh, 1, in + _i * sh->n + sh->half[0], _h[_i][1] );
+			memcpy( _q[_i], sh->tail, sh->tail_len );
+		}
 		
-#ifdef OAES_DEBUG
-		if( _ctx->step_cb )
-			_ctx->step_cb( c, "m_col", _i, NULL );
-#endif // OAES_DEBUG
-
-		// AddRoundKey(state, w[round*Nb, (round+1)*Nb-1])
-		for( _j = 0; _j < c_len; _j++ )
-			c[_j] = c[_j] ^
-					_ctx->key->exp_data[_i * OAES_RKEY_LEN * OAES_COL_LEN + _j];
-
-#ifdef OAES_DEBUG
-	if( _ctx->step_cb )
-	{
-		_ctx->step_cb( _ctx->key->exp_data + _i * OAES_RKEY_LEN * OAES_COL_LEN,
-				"k_sch", _i, NULL );
-		_ctx->step_cb( c, "k_add", _i, NULL );
-	}
-#endif // OAES_DEBUG
-
-	}
-	
-	// SubBytes(state)
-	for( _i = 0; _i < c_len; _i++ )
-		oaes_sub_byte( c + _i );
-	
-#ifdef OAES_DEBUG
-	if( _ctx->step_cb )
-		_ctx->step_cb( c, "s_box", _ctx->key->num_keys - 1, NULL );
-#endif // OAES_DEBUG
-
-	// ShiftRows(state)
-	oaes_shift_rows( c );
-
-#ifdef OAES_DEBUG
-	if( _ctx->step_cb )
-		_ctx->step_cb( c, "s_row", _ctx->key->num_keys - 1, NULL );
-#endif // OAES_DEBUG
-
-	// AddRoundKey(state, w[Nr*Nb, (Nr+1)*Nb-1])
-	for( _i = 0; _i < c_len; _i++ )
-		c[_i] = c[_i] ^ _ctx->key->exp_data[
-				( _ctx->key->num_keys - 1 ) * OAES_RKEY_LEN * OAES_COL_LEN + _i ];
-
-#ifdef OAES_DEBUG
-	if( _ctx->step_cb )
-	{
-		_ctx->step_cb( _ctx->key->exp_data +
-				( _ctx->key->num_keys - 1 ) * OAES_RKEY_LEN * OAES_COL_LEN,
-				"k_sch", _ctx->key->num_keys - 1, NULL );
-		_ctx->step_cb( c, "output", _ctx->key->num_keys - 1, NULL );
+		// encryption puts B into Q and adds to A, decryption puts A in and
+		// subtracts from B
+		_prf = decrypt ? 0 : 1;
+		
+		for( _r = 0; _r < OAES_FF1_ROUNDS; _r++, _prf ^= 1 )
+		{
+			_round = decrypt ? OAES_FF1_ROUNDS - 1 - _r : _r;
+			
+			for( _i = 0; _i < _len; _i++ )
+			{
+				_q[_i][sh->tail_len - sh->b - 1] = (uint8_t) _round;
+				oaes_ff1_num_bytes( sh, _prf, _h[_i][_prf],
+						_q[_i] + sh->tail_len - sh->b );
+				memcpy( _x + _i * OAES_BLOCK_SIZE, sh->x0, OAES_BLOCK_SIZE );
+			}
+			
+			// R, the last block of the CBC-MAC over the rest of Q
+			for( _j = 0; _j < sh->tail_len; _j += OAES_BLOCK_SIZE )
+			{
+				for( _i = 0; _i < _len; _i++ )
+					oaes_xor_bytes( _x + _i * OAES_BLOCK_SIZE,
+							_x + _i * OAES_BLOCK_SIZE, _q[_i] + _j, OAES_BLOCK_SIZE );
+				oaes_key_encrypt_blocks( key, _x, _len );
+			}
+			
+			// S runs on past R with R xor [j]^16 enciphered, j from 1
+			for( _i = 0; _i < _len * _extra; _i++ )
+			{
+				memcpy( _ext + _i * OAES_BLOCK_SIZE,
+						_x + _i / _extra * OAES_BLOCK_SIZE, OAES_BLOCK_SIZE );
+				_ext[_i * OAES_BLOCK_SIZE + OAES_BLOCK_SIZE - 1] ^=
+						(uint8_t) ( _i % _extra + 1 );
+			}
+			if( _extra )
+				oaes_key_encrypt_blocks( key, _ext, _len * _extra );
+			
+			for( _i = 0; _i < _len; _i++ )
+			{
+				memcpy( _s, _x + _i * OAES_BLOCK_SIZE, OAES_BLOCK_SIZE );
+				memcpy( _s + OAES_BLOCK_SIZE, _ext + _i * _extra * OAES_BLOCK_SIZE,
+						_extra * OAES_BLOCK_SIZE );
+				oaes_ff1_y( sh, _prf ^ 1, _s, _y );
+				oaes_ff1_add( sh, _prf ^ 1, _h[_i][_prf ^ 1], _y, decrypt );
+			}
+		}
+		
+		for( _i = 0; _i < _len; _i++ )
+		{
+			oaes_ff1_unpack( sh, 0, _h[_i][0], out + _i * sh->n );
+			oaes_ff1_unpack( sh, 1, _h[_i][1], out + _i * sh->n + sh->half[0] );
+		}
 	}
-#endif // OAES_DEBUG
-
-	return OAES_RET_SUCCESS;
 }
 
-static OAES_RET oaes_decrypt_block(
-		OAES_CTX * ctx, uint8_t * c, size_t c_len )
+static OAES_RET oaes_ff1_crypt( OAES_CTX * ctx, uint32_t radix,
+		const uint8_t * tweak, size_t tweak_len, const uint16_t * in,
+		size_t len, size_t count, uint16_t * out, int decrypt )
 {
-	size_t _i, _j;
+	size_t _i;
+	uint64_t _domain = 1;
+	oaes_ff1_shape _sh;
 	oaes_ctx * _ctx = (oaes_ctx *) ctx;
 	
 	if( NULL == _ctx )
 		return OAES_RET_ARG1;
 	
-	if( NULL == c )
+	if( radix < 2 || radix > 65536 )
 		return OAES_RET_ARG2;
 	
-	if( c_len != OAES_BLOCK_SIZE )
+	if( NULL == tweak && tweak_len )
 		return OAES_RET_ARG3;
 	
+	if( (uint64_t) tweak_len > 0xffffffffUL )
+		return OAES_RET_ARG4;
+	
+	if( NULL == in && count )
+		return OAES_RET_ARG5;
+	
+	// SP 800-38G asks for a domain of at least a million values
+	for( _i = 0; _i < len && _domain < 1000000; _i++ )
+		_domain *= radix;
+	if( len < 2 || len > OAES_FF1_MAX_LEN || _domain < 1000000 )
+		return OAES_RET_ARG6;
+	
+	if( NULL == out && count )
+		return OAES_RET_ARG7;
+	
+	for( _i = 0; _i < count * len; _i++ )
+		if( in[_i] >= radix )
+			return OAES_RET_ARG5;
+	
 	if( NULL == _ctx->key )
 		return OAES_RET_NOKEY;
 	
-#ifdef OAES_DEBUG
-	if( _ctx->step_cb )
-		_ctx->step_cb( c, "iinput", _ctx->key->num_keys - 1, NULL );
-#endif // OAES_DEBUG
+	oaes_ff1_shape_init( _ctx->key, &_sh, radix, len, tweak, tweak_len );
+	oaes_ff1_run( _ctx->key, &_sh, in, count, out, decrypt );
+	
+	return OAES_RET_SUCCESS;
+}
 
-	// AddRoundKey(state, w[Nr*Nb, (Nr+1)*Nb-1])
-	for( _i = 0; _i < c_len; _i++ )
-		c[_i] = c[_i] ^ _ctx->key->exp_data[
-				( _ctx->key->num_keys - 1 ) * OAES_RKEY_LEN * OAES_COL_LEN + _i ];
+OAES_RET oaes_ff1_encrypt( OAES_CTX * ctx, uint32_t radix,
+		const uint8_t * tweak, size_t tweak_len,
+		const uint16_t * x, size_t len, uint16_t * y )
+{
+	return oaes_ff1_crypt( ctx, radix, tweak, tweak_len, x, len, 1, y, 0 );
+}
 
-#ifdef OAES_DEBUG
-	if( _ctx->step_cb )
-	{
-		_ctx->step_cb( _ctx->key->exp_data +
-				( _ctx->key->num_keys - 1 ) * OAES_RKEY_LEN * OAES_COL_LEN,
-				"ik_sch", _ctx->key->num_keys - 1, NULL );
-		_ctx->step_cb( c, "ik_add", _ctx->key->num_keys - 1, NULL );
-	}
-#endif // OAES_DEBUG
+OAES_RET oaes_ff1_decrypt( OAES_CTX * ctx, uint32_t radix,
+		const uint8_t * tweak, size_t tweak_len,
+		const uint16_t * y, size_t len, uint16_t * x )
+{
+	return oaes_ff1_crypt( ctx, radix, tweak, tweak_len, y, len, 1, x, 1 );
+}
 
-	for( _i = _ctx->key->num_keys - 2; _i > 0; _i-- )
-	{
-		// InvShiftRows(state)
-		oaes_inv_shift_rows( c );
+OAES_RET oaes_ff1_encrypt_batch( OAES_CTX * ctx, uint32_t radix,
+		const uint8_t * tweak, size_t tweak_len,
+		const uint16_t * x, size_t len, size_t count, uint16_t * y )
+{
+	return oaes_ff1_crypt( ctx, radix, tweak, tweak_len, x, len, count, y, 0 );
+}
 
-#ifdef OAES_DEBUG
-	if( _ctx->step_cb )
-		_ctx->step_cb( c, "is_row", _i, NULL );
-#endif // OAES_DEBUG
+OAES_RET oaes_ff1_decrypt_batch( OAES_CTX * ctx, uint32_t radix,
+		const uint8_t * tweak, size_t tweak_len,
+		const uint16_t * y, size_t len, size_t count, uint16_t * x )
+{
+	return oaes_ff1_crypt( ctx, radix, tweak, tweak_len, y, len, count, x, 1 );
+}
 
-		// InvSubBytes(state)
-		for( _j = 0; _j < c_len; _j++ )
-			oaes_inv_sub_byte( c + _j );
+// enciphers "oaes round hash" followed by the block index into the key
+// blocks the first time the key is used for the round hash
+static OAES_RET oaes_round_hash_key_setup( oaes_key * key )
+{
+	static const char _label[] = "oaes round hash";
+	uint8_t * _h;
+	size_t _i;
 	
-#ifdef OAES_DEBUG
-	if( _ctx->step_cb )
-		_ctx->step_cb( c, "is_box", _i, NULL );
-#endif // OAES_DEBUG
-
-		// AddRoundKey(state, w[round*Nb, (round+1)*Nb-1])
-		for( _j = 0; _j < c_len; _j++ )
-			c[_j] = c[_j] ^
-					_ctx->key->exp_data[_i * OAES_RKEY_LEN * OAES_COL_LEN + _j];
-		
-#ifdef OAES_DEBUG
-	if( _ctx->step_cb )
+	if( key->hash_data )
+		return OAES_RET_SUCCESS;
+	
+	_h = oaes_calloc_aligned( OAES_ROUND_HASH_KEYS * OAES_BLOCK_SIZE );
+	if( NULL == _h )
+		return OAES_RET_MEM;
+	
+	for( _i = 0; _i < OAES_ROUND_HASH_KEYS; _i++ )
 	{
-		_ctx->step_cb( _ctx->key->exp_data + _i * OAES_RKEY_LEN * OAES_COL_LEN,
-				"ik_sch", _i, NULL );
-		_ctx->step_cb( c, "ik_add", _i, NULL );
+		memcpy( _h + _i * OAES_BLOCK_SIZE, _label, OAES_BLOCK_SIZE - 1 );
+		_h[_i * OAES_BLOCK_SIZE + OAES_BLOCK_SIZE - 1] = (uint8_t) _i;
 	}
-#endif // OAES_DEBUG
+	oaes_key_encrypt_blocks( key, _h, OAES_ROUND_HASH_KEYS );
+	key->hash_data = _h;
+	
+	return OAES_RET_SUCCESS;
+}
 
-		// InvMixColums(state)
-		oaes_inv_mix_cols( c );
-		oaes_inv_mix_cols( c + 4 );
-		oaes_inv_mix_cols( c + 8 );
-		oaes_inv_mix_cols( c + 12 );
+// count rounds of s, each SubBytes, ShiftRows, MixColumns and AddRoundKey
+// with the next block at keys, as AESENC does, for the engines other than
+// aesni, whatever they do for whole blocks
+static void oaes_round_hash_rounds( uint8_t s[OAES_BLOCK_SIZE],
+		const uint8_t * keys, size_t count )
+{
+	uint32_t _s0, _s1, _s2, _s3, _t0, _t1, _t2, _t3;
+	
+	_s0 = oaes_get_word( s );
+	_s1 = oaes_get_word( s + 4 );
+	_s2 = oaes_get_word( s + 8 );
+	_s3 = oaes_get_word( s + 12 );
+	for( ; count; count--, keys += OAES_BLOCK_SIZE )
+	{
+		OAES_TE_ROUND( _s0, _s1, _s2, _s3, _t0, _t1, _t2, _t3,
+				oaes_get_word( keys ), oaes_get_word( keys + 4 ),
+				oaes_get_word( keys + 8 ), oaes_get_word( keys + 12 ) );
+		_s0 = _t0; _s1 = _t1; _s2 = _t2; _s3 = _t3;
+	}
+	oaes_put_word( s, _s0 );
+	oaes_put_word( s + 4, _s1 );
+	oaes_put_word( s + 8, _s2 );
+	oaes_put_word( s + 12, _s3 );
+}
 
-#ifdef OAES_DEBUG
-	if( _ctx->step_cb )
-		_ctx->step_cb( c, "im_col", _i, NULL );
-#endif // OAES_DEBUG
+// adds block b to the sum of the lanes, in two 64 bit halves
+static void oaes_round_hash_sum( uint8_t sum[OAES_BLOCK_SIZE],
+		const uint8_t b[OAES_BLOCK_SIZE] )
+{
+	oaes_put_le64( sum, oaes_get_le64( sum ) + oaes_get_le64( b ) );
+	oaes_put_le64( sum + 8, oaes_get_le64( sum + 8 ) + oaes_get_le64( b + 8 ) );
+}
 
+// takes count stripes at m into lanes, the sum follows the lanes
+static void oaes_round_hash_stripes( const oaes_key * key,
+		uint8_t * lanes, const uint8_t * m, size_t count )
+{
+	uint8_t * _sum = lanes + OAES_ROUND_HASH_STRIPE;
+	size_t _j;
+	
+#if OAES_HAVE_AESNI
+	if( &oaes_engine_aesni == key->engine )
+	{
+		oaes_aesni_hash_stripes( lanes, m, count );
+		return;
 	}
+#endif // OAES_HAVE_AESNI
+	
+	for( ; count; count--, m += OAES_ROUND_HASH_STRIPE )
+		for( _j = 0; _j < OAES_ROUND_HASH_LANES; _j++ )
+		{
+			oaes_round_hash_rounds( lanes + _j * OAES_BLOCK_SIZE,
+					m + _j * OAES_BLOCK_SIZE, 1 );
+			oaes_round_hash_sum( _sum, m + _j * OAES_BLOCK_SIZE );
+		}
+}
 
-	// InvShiftRows(state)
-	oaes_inv_shift_rows( c );
+// the last 3 rounds take the key blocks after the lane seeds, the first of
+// them with len added in, the others as they are
+static void oaes_round_hash_last_keys( const oaes_key * key, uint64_t len,
+		uint8_t * keys )
+{
+	memcpy( keys, key->hash_data + OAES_ROUND_HASH_STRIPE,
+			3 * OAES_BLOCK_SIZE );
+	oaes_put_le64( keys, oaes_get_le64( keys ) ^ len );
+}
 
-#ifdef OAES_DEBUG
-	if( _ctx->step_cb )
-		_ctx->step_cb( c, "is_row", 1, NULL );
-#endif // OAES_DEBUG
+// up to a block: seed 0 xor m, zero padded, then a round with seed 1 and
+// the last 3 rounds
+static void oaes_round_hash_short( const oaes_key * key,
+		const uint8_t * m, size_t m_len, uint8_t * hash, size_t hash_len )
+{
+	uint8_t _s[OAES_BLOCK_SIZE], _keys[4 * OAES_BLOCK_SIZE];
+	
+	memset( _s, 0, OAES_BLOCK_SIZE );
+	memcpy( _s, m, m_len );
+	
+#if OAES_HAVE_AESNI
+	if( &oaes_engine_aesni == key->engine )
+	{
+		oaes_aesni_hash_short( _s, key->hash_data, m_len );
+		memcpy( hash, _s, hash_len );
+		return;
+	}
+#endif // OAES_HAVE_AESNI
+	
+	oaes_xor_bytes( _s, _s, key->hash_data, OAES_BLOCK_SIZE );
+	memcpy( _keys, key->hash_data + OAES_BLOCK_SIZE, OAES_BLOCK_SIZE );
+	oaes_round_hash_last_keys( key, m_len, _keys + OAES_BLOCK_SIZE );
+	
+	oaes_round_hash_rounds( _s, _keys, 4 );
+	memcpy( hash, _s, hash_len );
+}
 
-	// InvSubBytes(state)
-	for( _i = 0; _i < c_len; _i++ )
-		oaes_inv_sub_byte( c + _i );
+static void oaes_round_hash_init( const oaes_key * key,
+		oaes_round_hash_state * st )
+{
+	memset( st, 0, sizeof( *st ) );
+	memcpy( st->lanes, key->hash_data, OAES_ROUND_HASH_STRIPE );
+	st->started = 1;
+}
 
-#ifdef OAES_DEBUG
-	if( _ctx->step_cb )
-		_ctx->step_cb( c, "is_box", 1, NULL );
-#endif // OAES_DEBUG
+static void oaes_round_hash_update_state( const oaes_key * key,
+		oaes_round_hash_state * st, const uint8_t * m, size_t m_len )
+{
+	size_t _len;
+	
+	st->len += m_len;
+	
+	if( st->buf_len )
+	{
+		_len = min( m_len, OAES_ROUND_HASH_STRIPE - st->buf_len );
+		memcpy( st->buf + st->buf_len, m, _len );
+		st->buf_len += _len;
+		m += _len;
+		m_len -= _len;
+		
+		if( st->buf_len < OAES_ROUND_HASH_STRIPE )
+			return;
+		
+		oaes_round_hash_stripes( key, st->lanes, st->buf, 1 );
+		st->buf_len = 0;
+	}
+	
+	oaes_round_hash_stripes( key, st->lanes, m,
+			m_len / OAES_ROUND_HASH_STRIPE );
+	
+	_len = m_len % OAES_ROUND_HASH_STRIPE;
+	memcpy( st->buf, m + m_len - _len, _len );
+	st->buf_len = _len;
+}
 
-	// AddRoundKey(state, w[0, Nb-1])
-	for( _i = 0; _i < c_len; _i++ )
-		c[_i] = c[_i] ^ _ctx->key->exp_data[_i];
+// takes blocks blocks of tail into the lanes from lane 0 on, then chains
+// lane 0 through rounds keyed with lanes 1 to 3 and the sum, and the last
+// 3 rounds, lanes and sum are left as they are
+static void oaes_round_hash_finish( const oaes_key * key,
+		const uint8_t * lanes, const uint8_t * sum, const uint8_t * tail,
+		size_t blocks, uint64_t len, uint8_t * hash, size_t hash_len )
+{
+	uint8_t _s[( OAES_ROUND_HASH_LANES + 4 ) * OAES_BLOCK_SIZE];
+	uint8_t * _sum = _s + OAES_ROUND_HASH_STRIPE;
+	size_t _i;
 	
-#ifdef OAES_DEBUG
-	if( _ctx->step_cb )
+#if OAES_HAVE_AESNI
+	if( &oaes_engine_aesni == key->engine )
 	{
-		_ctx->step_cb( _ctx->key->exp_data, "ik_sch", 1, NULL );
-		_ctx->step_cb( c, "ioutput", 1, NULL );
+		oaes_aesni_hash_close( lanes, sum, tail, blocks, key->hash_data, len,
+				_s );
+		memcpy( hash, _s, hash_len );
+		return;
 	}
-#endif // OAES_DEBUG
+#endif // OAES_HAVE_AESNI
+	
+	// lane 0 becomes the state, what follows it the round keys
+	memcpy( _s, lanes, OAES_ROUND_HASH_STRIPE );
+	memcpy( _sum, sum, OAES_BLOCK_SIZE );
+	for( _i = 0; _i < blocks; _i++ )
+	{
+		oaes_round_hash_rounds( _s + _i * OAES_BLOCK_SIZE,
+				tail + _i * OAES_BLOCK_SIZE, 1 );
+		oaes_round_hash_sum( _sum, tail + _i * OAES_BLOCK_SIZE );
+	}
+	oaes_round_hash_last_keys( key, len, _sum + OAES_BLOCK_SIZE );
+	
+	oaes_round_hash_rounds( _s, _s + OAES_BLOCK_SIZE,
+			OAES_ROUND_HASH_LANES + 3 );
+	memcpy( hash, _s, hash_len );
+}
 
-	return OAES_RET_SUCCESS;
+// the blocks left go in zero padded, messages of up to a block take the
+// short way
+static void oaes_round_hash_close( const oaes_key * key,
+		oaes_round_hash_state * st, uint8_t * hash, size_t hash_len )
+{
+	if( st->len <= OAES_BLOCK_SIZE )
+		oaes_round_hash_short( key, st->buf, st->buf_len, hash, hash_len );
+	else
+	{
+		memset( st->buf + st->buf_len, 0,
+				OAES_ROUND_HASH_STRIPE - st->buf_len );
+		oaes_round_hash_finish( key, st->lanes,
+				st->lanes + OAES_ROUND_HASH_STRIPE, st->buf,
+				( st->buf_len + OAES_BLOCK_SIZE - 1 ) / OAES_BLOCK_SIZE,
+				st->len, hash, hash_len );
+	}
+	
+	memset( st, 0, sizeof( *st ) );
 }
 
-OAES_RET oaes_encrypt( OAES_CTX * ctx,
-		const uint8_t * m, size_t m_len, uint8_t * c, size_t * c_len,
-		uint8_t iv[OAES_BLOCK_SIZE], uint8_t * pad )
+OAES_RET oaes_round_hash( OAES_CTX * ctx,
+		const uint8_t * m, size_t m_len, uint8_t * hash, size_t hash_len )
 {
-	size_t _i, _j, _c_len_in;
-	size_t _pad_len = m_len % OAES_BLOCK_SIZE == 0 ?
-			0 : OAES_BLOCK_SIZE - m_len % OAES_BLOCK_SIZE;
 	oaes_ctx * _ctx = (oaes_ctx *) ctx;
-	OAES_RET _rc = OAES_RET_SUCCESS;
+	uint8_t _lanes[( OAES_ROUND_HASH_LANES + 1 ) * OAES_BLOCK_SIZE];
+	uint8_t _tail[OAES_ROUND_HASH_STRIPE];
+	size_t _len;
+	OAES_RET _rc;
 	
 	if( NULL == _ctx )
 		return OAES_RET_ARG1;
 	
-	if( NULL == m )
+	if( NULL == m && m_len )
 		return OAES_RET_ARG2;
 	
-	if( NULL == c_len )
+	if( NULL == hash )
+		return OAES_RET_ARG4;
+	
+	if( 8 != hash_len && OAES_BLOCK_SIZE != hash_len )
 		return OAES_RET_ARG5;
 	
-	_c_len_in = *c_len;
-	// data + pad
-	*c_len = m_len + _pad_len;
-
-	if( NULL == c )
+	if( NULL == _ctx->key )
+		return OAES_RET_NOKEY;
+	
+	_rc = oaes_round_hash_key_setup( _ctx->key );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
+	
+	// no lanes to set up for the keys of most hash tables
+	if( m_len <= OAES_BLOCK_SIZE )
+	{
+		oaes_round_hash_short( _ctx->key, m, m_len, hash, hash_len );
 		return OAES_RET_SUCCESS;
+	}
 	
-	if( _c_len_in < *c_len )
-		return OAES_RET_BUF;
+	// one call keeps its lanes here, and needs no state
+	memcpy( _lanes, _ctx->key->hash_data, OAES_ROUND_HASH_STRIPE );
+	memset( _lanes + OAES_ROUND_HASH_STRIPE, 0, OAES_BLOCK_SIZE );
+	oaes_round_hash_stripes( _ctx->key, _lanes, m,
+			m_len / OAES_ROUND_HASH_STRIPE );
 	
-	if( NULL == iv )
-		return OAES_RET_ARG6;
-
-	if( NULL == pad )
-		return OAES_RET_ARG7;
+	_len = m_len % OAES_ROUND_HASH_STRIPE;
+	memset( _tail, 0, OAES_ROUND_HASH_STRIPE );
+	memcpy( _tail, m + m_len - _len, _len );
+	oaes_round_hash_finish( _ctx->key, _lanes,
+			_lanes + OAES_ROUND_HASH_STRIPE, _tail,
+			( _len + OAES_BLOCK_SIZE - 1 ) / OAES_BLOCK_SIZE, m_len,
+			hash, hash_len );
+	
+	return OAES_RET_SUCCESS;
+}
 
-	if (NULL == _ctx->key)
-		return OAES_RET_NOKEY;
+OAES_RET oaes_round_hash_start( OAES_CTX * ctx )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
+	OAES_RET _rc;
 	
-	*pad = _pad_len ? 1 : 0;
-	memcpy(c, m, m_len );
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
 	
-	for( _i = 0; _i < *c_len; _i += OAES_BLOCK_SIZE )
-	{
-		uint8_t _block[OAES_BLOCK_SIZE];
-		size_t _block_size = min( m_len - _i, OAES_BLOCK_SIZE );
-
-		memcpy( _block, c + _i, _block_size );
-		
-		// insert pad
-		for( _j = 0; _j < OAES_BLOCK_SIZE - _block_size; _j++ )
-			_block[ _block_size + _j ] = _j + 1;
+	if( NULL == _ctx->key )
+		return OAES_RET_NOKEY;
 	
-		// CBC
-		if( _ctx->options & OAES_OPTION_CBC )
-		{
-			for( _j = 0; _j < OAES_BLOCK_SIZE; _j++ )
-				_block[_j] = _block[_j] ^ iv[_j];
-		}
-
-		_rc = _rc ||
-				oaes_encrypt_block( ctx, _block, OAES_BLOCK_SIZE );
-		memcpy( c + _i, _block, OAES_BLOCK_SIZE );
-		
-		if( _ctx->options & OAES_OPTION_CBC )
-			memcpy( iv, _block, OAES_BLOCK_SIZE );
-	}
+	_rc = oaes_round_hash_key_setup( _ctx->key );
+	if( OAES_RET_SUCCESS != _rc )
+		return _rc;
 	
-	return _rc;
+	oaes_round_hash_init( _ctx->key, &_ctx->round_hash );
+	
+	return OAES_RET_SUCCESS;
 }
 
-OAES_RET oaes_decrypt( OAES_CTX * ctx,
-		const uint8_t * c, size_t c_len, uint8_t * m, size_t * m_len,
-		uint8_t iv[OAES_BLOCK_SIZE], uint8_t pad)
+OAES_RET oaes_round_hash_update( OAES_CTX * ctx,
+		const uint8_t * m, size_t m_len )
 {
-	size_t _i, _j, _m_len_in;
 	oaes_ctx * _ctx = (oaes_ctx *) ctx;
-	OAES_RET _rc = OAES_RET_SUCCESS;
-	uint8_t _flags;
-	OAES_OPTION _options;
 	
-	if( NULL == ctx )
+	if( NULL == _ctx )
 		return OAES_RET_ARG1;
 	
-	if( NULL == c )
+	if( NULL == m && m_len )
 		return OAES_RET_ARG2;
 	
-	if( c_len % OAES_BLOCK_SIZE )
-		return OAES_RET_ARG3;
+	// the key blocks are read until the end, the key has to stay
+	if( 0 == _ctx->round_hash.started || NULL == _ctx->key ||
+			NULL == _ctx->key->hash_data )
+		return OAES_RET_ERROR;
 	
-	if( NULL == m_len )
-		return OAES_RET_ARG5;
+	oaes_round_hash_update_state( _ctx->key, &_ctx->round_hash, m, m_len );
 	
-	_m_len_in = *m_len;
-	*m_len = c_len;
+	return OAES_RET_SUCCESS;
+}
+
+OAES_RET oaes_round_hash_final( OAES_CTX * ctx,
+		uint8_t * hash, size_t hash_len )
+{
+	oaes_ctx * _ctx = (oaes_ctx *) ctx;
 	
-	if( NULL == m )
-		return OAES_RET_SUCCESS;
+	if( NULL == _ctx )
+		return OAES_RET_ARG1;
 	
-	if( _m_len_in < *m_len )
-		return OAES_RET_BUF;
-
-	if (NULL == iv)
-		return OAES_RET_ARG6;
-
-	if (NULL == _ctx->key)
-		return OAES_RET_NOKEY;
+	if( NULL == hash )
+		return OAES_RET_ARG2;
 	
-	// options
-	_options = _ctx->options;
-	// validate that all options are valid
-	if( _options & ~(
-				OAES_OPTION_ECB
-			| OAES_OPTION_CBC
-#ifdef OAES_DEBUG
-			| OAES_OPTION_STEP_ON
-			| OAES_OPTION_STEP_OFF
-#endif // OAES_DEBUG
-			) )
-		return OAES_RET_HEADER;
-	if( ( _options & OAES_OPTION_ECB ) &&
-			( _options & OAES_OPTION_CBC ) )
-		return OAES_RET_HEADER;
-	if( _options == OAES_OPTION_NONE )
-		return OAES_RET_HEADER;
+	if( 8 != hash_len && OAES_BLOCK_SIZE != hash_len )
+		return OAES_RET_ARG3;
 	
-	// data + pad
-	memcpy(m, c, *m_len);
+	if( 0 == _ctx->round_hash.started || NULL == _ctx->key ||
+			NULL == _ctx->key->hash_data )
+		return OAES_RET_ERROR;
 	
-	for( _i = 0; _i < *m_len; _i += OAES_BLOCK_SIZE )
-	{
-		if( ( _options & OAES_OPTION_CBC ) && _i > 0 )
-			memcpy(iv, c - OAES_BLOCK_SIZE + _i, OAES_BLOCK_SIZE);
-		
-		_rc = _rc ||
-				oaes_decrypt_block( ctx, m + _i, min( *m_len - _i, OAES_BLOCK_SIZE ) );
-		
-		// CBC
-		if( _options & OAES_OPTION_CBC )
-		{
-			for( _j = 0; _j < OAES_BLOCK_SIZE; _j++ )
-				m[ _i + _j ] = m[ _i + _j ] ^ iv[_j];
-		}
-	}
-	if( (_options & OAES_OPTION_CBC) && _i > 0 )
-		memcpy(iv, c - OAES_BLOCK_SIZE + _i, OAES_BLOCK_SIZE);
-
-	// remove pad
-	if( pad )
-	{
-		int _is_pad = 1;
-		size_t _temp = (size_t) m[*m_len - 1];
-
-		if( _temp	<= 0x00 || _temp > 0x0f )
-			return OAES_RET_HEADER;
-		for( _i = 0; _i < _temp; _i++ )
-			if( m[*m_len - 1 - _i] != _temp - _i )
-				_is_pad = 0;
-		if( _is_pad )
-		{
-			memset( m + *m_len - _temp, 0, _temp );
-			*m_len -= _temp;
-		}
-		else
-			return OAES_RET_HEADER;
-	}
+	oaes_round_hash_close( _ctx->key, &_ctx->round_hash, hash, hash_len );
 	
 	return OAES_RET_SUCCESS;
 }
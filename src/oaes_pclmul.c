@@ -0,0 +1,368 @@
+/* 
+ * ---------------------------------------------------------------------------
+ * OpenAES License
+ * ---------------------------------------------------------------------------
+ * Copyright (c) 2013, Nabil S. Al Ramli, www.nalramli.com
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ *   - Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   - Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * ---------------------------------------------------------------------------
+ */
+static const char _NR[] = {
+	0x4e,0x61,0x62,0x69,0x6c,0x20,0x53,0x2e,0x20,
+	0x41,0x6c,0x20,0x52,0x61,0x6d,0x6c,0x69,0x00 };
+
+#include "oaes_config.h"
+#include "oaes_engine.h"
+
+#if OAES_HAVE_PCLMUL
+
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+
+// as in oaes_aesni.c, oaes_lib.c only calls in when oaes_cpu_features() has
+// the bits these need
+#if defined(__GNUC__) && !( defined(__PCLMUL__) && defined(__SSSE3__) )
+#define OAES_TARGET_PCLMUL __attribute__((target("pclmul,ssse3,sse2")))
+#else
+#define OAES_TARGET_PCLMUL
+#endif
+
+#if defined(__GNUC__) && \
+		!( defined(__AES__) && defined(__PCLMUL__) && defined(__SSSE3__) )
+#define OAES_TARGET_PCLMUL_AESNI __attribute__((target("aes,pclmul,ssse3,sse2")))
+#else
+#define OAES_TARGET_PCLMUL_AESNI
+#endif
+
+/*
+ * GHASH works on bit reflected polynomials, with the bytes of a block
+ * reversed they multiply with PCLMULQDQ into a product that is one bit
+ * short, oaes_pclmul_reduce() shifts it back and reduces it
+ * 
+ * the key table holds H^1 to H^8 byte reversed, followed by the xor of the
+ * two halves of each for the Karatsuba middle product
+ */
+
+OAES_TARGET_PCLMUL
+static __m128i oaes_pclmul_bswap( void )
+{
+	return _mm_set_epi8( 0, 1, 2, 3, 4, 5, 6, 7,
+			8, 9, 10, 11, 12, 13, 14, 15 );
+}
+
+// adds x * H^( i + 1 ), unreduced, into lo, mid and hi
+OAES_TARGET_PCLMUL
+static void oaes_pclmul_mul_add( __m128i x, const __m128i * h, size_t i,
+		__m128i * lo, __m128i * mid, __m128i * hi )
+{
+	__m128i _h = _mm_load_si128( h + i );
+
+	*lo = _mm_xor_si128( *lo, _mm_clmulepi64_si128( x, _h, 0x00 ) );
+	*hi = _mm_xor_si128( *hi, _mm_clmulepi64_si128( x, _h, 0x11 ) );
+	*mid = _mm_xor_si128( *mid, _mm_clmulepi64_si128(
+			_mm_xor_si128( x, _mm_shuffle_epi32( x, 0x4e ) ),
+			_mm_load_si128( h + 8 + i ), 0x00 ) );
+}
+
+// the sum of the products added up by oaes_pclmul_mul_add(), one reduction
+// serves any number of them
+OAES_TARGET_PCLMUL
+static __m128i oaes_pclmul_reduce( __m128i lo, __m128i mid, __m128i hi )
+{
+	__m128i _t0, _t1, _t2;
+
+	mid = _mm_xor_si128( mid, _mm_xor_si128( lo, hi ) );
+	lo = _mm_xor_si128( lo, _mm_slli_si128( mid, 8 ) );
+	hi = _mm_xor_si128( hi, _mm_srli_si128( mid, 8 ) );
+
+	// shift the 256 bit product hi:lo left by one
+	_t0 = _mm_srli_epi32( lo, 31 );
+	_t1 = _mm_srli_epi32( hi, 31 );
+	lo = _mm_slli_epi32( lo, 1 );
+	hi = _mm_slli_epi32( hi, 1 );
+	_t2 = _mm_srli_si128( _t0, 12 );
+	_t1 = _mm_slli_si128( _t1, 4 );
+	_t0 = _mm_slli_si128( _t0, 4 );
+	lo = _mm_or_si128( lo, _t0 );
+	hi = _mm_or_si128( hi, _t1 );
+	hi = _mm_or_si128( hi, _t2 );
+
+	// reduce modulo x^128 + x^7 + x^2 + x + 1
+	_t0 = _mm_xor_si128( _mm_slli_epi32( lo, 31 ),
+			_mm_xor_si128( _mm_slli_epi32( lo, 30 ), _mm_slli_epi32( lo, 25 ) ) );
+	_t1 = _mm_srli_si128( _t0, 4 );
+	lo = _mm_xor_si128( lo, _mm_slli_si128( _t0, 12 ) );
+	_t2 = _mm_xor_si128( _mm_srli_epi32( lo, 1 ),
+			_mm_xor_si128( _mm_srli_epi32( lo, 2 ), _mm_srli_epi32( lo, 7 ) ) );
+	lo = _mm_xor_si128( lo, _mm_xor_si128( _t2, _t1 ) );
+
+	return _mm_xor_si128( hi, lo );
+}
+
+// x = ( x ^ c[0] ) * H^8 ^ c[1] * H^7 ^ ... ^ c[7] * H, with one reduction
+OAES_TARGET_PCLMUL
+static __m128i oaes_pclmul_hash8( const __m128i * h, __m128i x,
+		const uint8_t * c, __m128i bswap )
+{
+	size_t _i;
+	__m128i _lo = _mm_setzero_si128(), _mid = _lo, _hi = _lo;
+
+	x = _mm_xor_si128( x,
+			_mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *) c ), bswap ) );
+	oaes_pclmul_mul_add( x, h, 7, &_lo, &_mid, &_hi );
+	for( _i = 1; _i < 8; _i++ )
+		oaes_pclmul_mul_add( _mm_shuffle_epi8(
+				_mm_loadu_si128( (const __m128i *) c + _i ), bswap ),
+				h, 7 - _i, &_lo, &_mid, &_hi );
+
+	return oaes_pclmul_reduce( _lo, _mid, _hi );
+}
+
+OAES_TARGET_PCLMUL
+void oaes_pclmul_ghash_init( const uint8_t h[OAES_BLOCK_SIZE], uint8_t * table,
+		size_t powers )
+{
+	size_t _i;
+	__m128i * _t = (__m128i *) table;
+	__m128i _p = _mm_shuffle_epi8(
+			_mm_loadu_si128( (const __m128i *) h ), oaes_pclmul_bswap() );
+	__m128i _lo, _mid, _hi;
+
+	for( _i = 0; _i < powers; _i++ )
+	{
+		_mm_store_si128( _t + _i, _p );
+		_mm_store_si128( _t + 8 + _i,
+				_mm_xor_si128( _p, _mm_shuffle_epi32( _p, 0x4e ) ) );
+
+		// H^( _i + 2 ) = H^( _i + 1 ) * H
+		_lo = _mid = _hi = _mm_setzero_si128();
+		oaes_pclmul_mul_add( _p, _t, 0, &_lo, &_mid, &_hi );
+		_p = oaes_pclmul_reduce( _lo, _mid, _hi );
+	}
+}
+
+// xi = ( xi ^ c ) * H for each of count blocks, the blocks and xi are
+// shuffled with order to and from the byte reversed GHASH layout
+OAES_TARGET_PCLMUL
+static void oaes_pclmul_hash( const uint8_t * table, uint8_t xi[OAES_BLOCK_SIZE],
+		const uint8_t * c, size_t count, __m128i order )
+{
+	const __m128i * _h = (const __m128i *) table;
+	__m128i _x = _mm_shuffle_epi8(
+			_mm_loadu_si128( (const __m128i *) xi ), order );
+	__m128i _lo, _mid, _hi;
+
+	for( ; count >= 8; count -= 8, c += 8 * OAES_BLOCK_SIZE )
+		_x = oaes_pclmul_hash8( _h, _x, c, order );
+
+	for( ; count; count--, c += OAES_BLOCK_SIZE )
+	{
+		_lo = _mid = _hi = _mm_setzero_si128();
+		oaes_pclmul_mul_add( _mm_xor_si128( _x, _mm_shuffle_epi8(
+				_mm_loadu_si128( (const __m128i *) c ), order ) ),
+				_h, 0, &_lo, &_mid, &_hi );
+		_x = oaes_pclmul_reduce( _lo, _mid, _hi );
+	}
+
+	_mm_storeu_si128( (__m128i *) xi, _mm_shuffle_epi8( _x, order ) );
+}
+
+OAES_TARGET_PCLMUL
+void oaes_pclmul_ghash( const uint8_t * table, uint8_t xi[OAES_BLOCK_SIZE],
+		const uint8_t * c, size_t count )
+{
+	oaes_pclmul_hash( table, xi, c, count, oaes_pclmul_bswap() );
+}
+
+// POLYVAL blocks are GHASH blocks with their bytes reversed, so they are
+// taken as they are
+OAES_TARGET_PCLMUL
+void oaes_pclmul_polyval( const uint8_t * table, uint8_t xi[OAES_BLOCK_SIZE],
+		const uint8_t * c, size_t count )
+{
+	oaes_pclmul_hash( table, xi, c, count, _mm_set_epi8( 15, 14, 13, 12,
+			11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 ) );
+}
+
+#if OAES_HAVE_AESNI
+
+// the next 8 counter blocks, whitened with k, the counter is kept byte
+// reversed in _c so that its low 32 bits are a plain dword
+#define OAES_PCLMUL_CTR8( k ) \
+	do { \
+		_s0 = _mm_xor_si128( _mm_shuffle_epi8( _c, _bswap ), k ); \
+		_c = _mm_add_epi32( _c, _one ); \
+		_s1 = _mm_xor_si128( _mm_shuffle_epi8( _c, _bswap ), k ); \
+		_c = _mm_add_epi32( _c, _one ); \
+		_s2 = _mm_xor_si128( _mm_shuffle_epi8( _c, _bswap ), k ); \
+		_c = _mm_add_epi32( _c, _one ); \
+		_s3 = _mm_xor_si128( _mm_shuffle_epi8( _c, _bswap ), k ); \
+		_c = _mm_add_epi32( _c, _one ); \
+		_s4 = _mm_xor_si128( _mm_shuffle_epi8( _c, _bswap ), k ); \
+		_c = _mm_add_epi32( _c, _one ); \
+		_s5 = _mm_xor_si128( _mm_shuffle_epi8( _c, _bswap ), k ); \
+		_c = _mm_add_epi32( _c, _one ); \
+		_s6 = _mm_xor_si128( _mm_shuffle_epi8( _c, _bswap ), k ); \
+		_c = _mm_add_epi32( _c, _one ); \
+		_s7 = _mm_xor_si128( _mm_shuffle_epi8( _c, _bswap ), k ); \
+		_c = _mm_add_epi32( _c, _one ); \
+	} while( 0 )
+
+#define OAES_PCLMUL_ROUND8( op, k ) \
+	do { \
+		_s0 = op( _s0, k ); \
+		_s1 = op( _s1, k ); \
+		_s2 = op( _s2, k ); \
+		_s3 = op( _s3, k ); \
+		_s4 = op( _s4, k ); \
+		_s5 = op( _s5, k ); \
+		_s6 = op( _s6, k ); \
+		_s7 = op( _s7, k ); \
+	} while( 0 )
+
+#define OAES_PCLMUL_XOR8( in, out ) \
+	do { \
+		_mm_storeu_si128( (__m128i *) (out), _mm_xor_si128( _s0, \
+				_mm_loadu_si128( (const __m128i *) (in) ) ) ); \
+		_mm_storeu_si128( (__m128i *) (out) + 1, _mm_xor_si128( _s1, \
+				_mm_loadu_si128( (const __m128i *) (in) + 1 ) ) ); \
+		_mm_storeu_si128( (__m128i *) (out) + 2, _mm_xor_si128( _s2, \
+				_mm_loadu_si128( (const __m128i *) (in) + 2 ) ) ); \
+		_mm_storeu_si128( (__m128i *) (out) + 3, _mm_xor_si128( _s3, \
+				_mm_loadu_si128( (const __m128i *) (in) + 3 ) ) ); \
+		_mm_storeu_si128( (__m128i *) (out) + 4, _mm_xor_si128( _s4, \
+				_mm_loadu_si128( (const __m128i *) (in) + 4 ) ) ); \
+		_mm_storeu_si128( (__m128i *) (out) + 5, _mm_xor_si128( _s5, \
+				_mm_loadu_si128( (const __m128i *) (in) + 5 ) ) ); \
+		_mm_storeu_si128( (__m128i *) (out) + 6, _mm_xor_si128( _s6, \
+				_mm_loadu_si128( (const __m128i *) (in) + 6 ) ) ); \
+		_mm_storeu_si128( (__m128i *) (out) + 7, _mm_xor_si128( _s7, \
+				_mm_loadu_si128( (const __m128i *) (in) + 7 ) ) ); \
+	} while( 0 )
+
+// the 8 ciphertext blocks at c go into the GHASH product sums during the
+// first 8 AES rounds, where the multiplies hide in the AESENC latency
+#define OAES_PCLMUL_HASH_ROUND( c ) \
+	do { \
+		_d = _mm_shuffle_epi8( \
+				_mm_loadu_si128( (const __m128i *) (c) + _i - 1 ), _bswap ); \
+		if( 1 == _i ) \
+			_d = _mm_xor_si128( _d, _x ); \
+		oaes_pclmul_mul_add( _d, _h, 8 - _i, &_lo, &_mid, &_hi ); \
+	} while( 0 )
+
+OAES_TARGET_PCLMUL_AESNI
+void oaes_pclmul_gcm_encrypt( const uint8_t * exp_data, size_t num_keys,
+		const uint8_t * table, uint8_t ctr[OAES_BLOCK_SIZE],
+		uint8_t xi[OAES_BLOCK_SIZE], const uint8_t * in, uint8_t * out,
+		size_t count )
+{
+	size_t _i;
+	const __m128i * _rk = (const __m128i *) exp_data;
+	const __m128i * _h = (const __m128i *) table;
+	__m128i _bswap = oaes_pclmul_bswap();
+	__m128i _one = _mm_set_epi32( 0, 0, 0, 1 );
+	__m128i _c = _mm_shuffle_epi8(
+			_mm_loadu_si128( (const __m128i *) ctr ), _bswap );
+	__m128i _x = _mm_shuffle_epi8(
+			_mm_loadu_si128( (const __m128i *) xi ), _bswap );
+	__m128i _s0, _s1, _s2, _s3, _s4, _s5, _s6, _s7, _k, _d;
+	__m128i _lo, _mid, _hi;
+	// the ciphertext of the previous 8 blocks, hashed while these are
+	// encrypted
+	const uint8_t * _prev = NULL;
+
+	for( ; count >= 8; count -= 8,
+			in += 8 * OAES_BLOCK_SIZE, out += 8 * OAES_BLOCK_SIZE )
+	{
+		_k = _mm_load_si128( _rk );
+		OAES_PCLMUL_CTR8( _k );
+		_lo = _mid = _hi = _mm_setzero_si128();
+		for( _i = 1; _i < num_keys - 1; _i++ )
+		{
+			_k = _mm_load_si128( _rk + _i );
+			OAES_PCLMUL_ROUND8( _mm_aesenc_si128, _k );
+			if( _prev && _i <= 8 )
+				OAES_PCLMUL_HASH_ROUND( _prev );
+		}
+		_k = _mm_load_si128( _rk + _i );
+		OAES_PCLMUL_ROUND8( _mm_aesenclast_si128, _k );
+		if( _prev )
+			_x = oaes_pclmul_reduce( _lo, _mid, _hi );
+		OAES_PCLMUL_XOR8( in, out );
+		_prev = out;
+	}
+
+	if( _prev )
+		_x = oaes_pclmul_hash8( _h, _x, _prev, _bswap );
+
+	_mm_storeu_si128( (__m128i *) ctr, _mm_shuffle_epi8( _c, _bswap ) );
+	_mm_storeu_si128( (__m128i *) xi, _mm_shuffle_epi8( _x, _bswap ) );
+}
+
+OAES_TARGET_PCLMUL_AESNI
+void oaes_pclmul_gcm_decrypt( const uint8_t * exp_data, size_t num_keys,
+		const uint8_t * table, uint8_t ctr[OAES_BLOCK_SIZE],
+		uint8_t xi[OAES_BLOCK_SIZE], const uint8_t * in, uint8_t * out,
+		size_t count )
+{
+	size_t _i;
+	const __m128i * _rk = (const __m128i *) exp_data;
+	const __m128i * _h = (const __m128i *) table;
+	__m128i _bswap = oaes_pclmul_bswap();
+	__m128i _one = _mm_set_epi32( 0, 0, 0, 1 );
+	__m128i _c = _mm_shuffle_epi8(
+			_mm_loadu_si128( (const __m128i *) ctr ), _bswap );
+	__m128i _x = _mm_shuffle_epi8(
+			_mm_loadu_si128( (const __m128i *) xi ), _bswap );
+	__m128i _s0, _s1, _s2, _s3, _s4, _s5, _s6, _s7, _k, _d;
+	__m128i _lo, _mid, _hi;
+
+	// the ciphertext is at hand, it is hashed while its keystream is made
+	for( ; count >= 8; count -= 8,
+			in += 8 * OAES_BLOCK_SIZE, out += 8 * OAES_BLOCK_SIZE )
+	{
+		_k = _mm_load_si128( _rk );
+		OAES_PCLMUL_CTR8( _k );
+		_lo = _mid = _hi = _mm_setzero_si128();
+		for( _i = 1; _i < num_keys - 1; _i++ )
+		{
+			_k = _mm_load_si128( _rk + _i );
+			OAES_PCLMUL_ROUND8( _mm_aesenc_si128, _k );
+			if( _i <= 8 )
+				OAES_PCLMUL_HASH_ROUND( in );
+		}
+		_k = _mm_load_si128( _rk + _i );
+		OAES_PCLMUL_ROUND8( _mm_aesenclast_si128, _k );
+		_x = oaes_pclmul_reduce( _lo, _mid, _hi );
+		OAES_PCLMUL_XOR8( in, out );
+	}
+
+	_mm_storeu_si128( (__m128i *) ctr, _mm_shuffle_epi8( _c, _bswap ) );
+	_mm_storeu_si128( (__m128i *) xi, _mm_shuffle_epi8( _x, _bswap ) );
+}
+
+#endif // OAES_HAVE_AESNI
+
+#endif // OAES_HAVE_PCLMUL
@@ -51,7 +51,7 @@ PyObject* python_oaes_encrypt(PyObject* self, PyObject* args)
     if (!PyArg_ParseTuple(args, "s#s#:encrypt", &key, &len_k, &content, &len_c))
         return NULL;
 
-#ifdef OAES_DEBUG
+#if OAES_DEBUG
     printf("content len:%d\n", len_c);
     printf("key len:%d\n", len_k);
 #endif //end of OAES_DEBUG
@@ -84,7 +84,7 @@ PyObject* python_oaes_encrypt(PyObject* self, PyObject* args)
 
     // encrypt get length
     ret = oaes_encrypt( ctx, content, len_c, NULL, &len_o, NULL, NULL );
-#ifdef OAES_DEBUG
+#if OAES_DEBUG
     printf("out len:%ld\n", len_o);
 #endif //end of OAES_DEBUG
 
@@ -126,7 +126,7 @@ PyObject* python_oaes_decrypt(PyObject* self, PyObject* args)
     if (!PyArg_ParseTuple(args, "s#s#:decrypt", &key, &len_k, &content, &len_c))
         return NULL;
 		
-#ifdef OAES_DEBUG
+#if OAES_DEBUG
     printf("content len:%d\n", len_c);
     printf("key len:%d\n", len_k);
 #endif //end of OAES_DEBUG
@@ -160,7 +160,7 @@ PyObject* python_oaes_decrypt(PyObject* self, PyObject* args)
 
     // decrypt get length
     ret = oaes_decrypt( ctx, content, len_c, NULL, &len_o, NULL, NULL );
-#ifdef OAES_DEBUG
+#if OAES_DEBUG
     printf("out len:%ld\n", len_o);
 #endif //end of OAES_DEBUG
 
@@ -0,0 +1,235 @@
+/* 
+ * ---------------------------------------------------------------------------
+ * OpenAES License
+ * ---------------------------------------------------------------------------
+ * Copyright (c) 2013, Nabil S. Al Ramli, www.nalramli.com
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ *   - Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   - Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * ---------------------------------------------------------------------------
+ */
+static const char _NR[] = {
+	0x4e,0x61,0x62,0x69,0x6c,0x20,0x53,0x2e,0x20,
+	0x41,0x6c,0x20,0x52,0x61,0x6d,0x6c,0x69,0x00 };
+
+#include <string.h>
+
+#include "oaes_config.h"
+#include "oaes_engine.h"
+
+#if OAES_HAVE_VPERM
+
+#include <emmintrin.h>
+#include <tmmintrin.h>
+
+// let gcc and clang emit SSSE3 here without building the rest with -mssse3,
+// oaes_lib.c only calls in when oaes_cpu_features() has OAES_CPU_SSSE3
+#if defined(__GNUC__) && !defined(__SSSE3__)
+#define OAES_TARGET_SSSE3 __attribute__((target("ssse3")))
+#else
+#define OAES_TARGET_SSSE3
+#endif
+
+/*
+ * SubBytes with PSHUFB doing 16 parallel lookups into 16 byte tables that
+ * sit in registers, so no lookup address depends on the data
+ * 
+ * GF(2^8) is viewed as GF(2^4)[t] / ( t^2 + t + z ), a byte being
+ * i * t + j * ( t + 1 ) with i and j in GF(2^4). the nibbles i and
+ * k = i ^ j come out of a change of basis, and the inverse is
+ * 
+ *   io = 1 / ( 1 / i + 1 / ( z * k ) ) + j
+ *   jo = 1 / ( 1 / j + 1 / ( z * k ) ) + i
+ *   1 / x = f( io ) + g( jo )
+ * 
+ * 1 / 0 is 0x80, which PSHUFB turns into 0 on the next lookup, and that
+ * takes care of the zero cases. f and g fold in the inverse of io and jo,
+ * the way back to the AES basis and for SubBytes the affine transform
+ * 
+ * the tables are generated with t = 0x12, z = 0x0d and the GF(2^4) basis
+ * { 0x01, 0x0c, 0x50, 0xb0 }
+ */
+
+// change of basis, low and high nibble of the input
+static const uint8_t oaes_vp_in_lo[16] = {
+	0x00, 0x10, 0x56, 0x46, 0xbc, 0xac, 0xea, 0xfa,
+	0x9c, 0x8c, 0xca, 0xda, 0x20, 0x30, 0x76, 0x66 };
+static const uint8_t oaes_vp_in_hi[16] = {
+	0x00, 0x47, 0x39, 0x7e, 0x07, 0x40, 0x3e, 0x79,
+	0xfe, 0xb9, 0xc7, 0x80, 0xf9, 0xbe, 0xc0, 0x87 };
+
+// same for InvSubBytes, with the inverse affine transform folded in
+static const uint8_t oaes_vp_din_lo[16] = {
+	0xac, 0x61, 0xa9, 0x64, 0x19, 0xd4, 0x1c, 0xd1,
+	0xba, 0x77, 0xbf, 0x72, 0x0f, 0xc2, 0x0a, 0xc7 };
+static const uint8_t oaes_vp_din_hi[16] = {
+	0x00, 0x7b, 0x8b, 0xf0, 0xef, 0x94, 0x64, 0x1f,
+	0x95, 0xee, 0x1e, 0x65, 0x7a, 0x01, 0xf1, 0x8a };
+
+// 1 / x and 1 / ( z * x ) in GF(2^4)
+static const uint8_t oaes_vp_inv[16] = {
+	0x80, 0x01, 0x08, 0x0d, 0x0f, 0x06, 0x05, 0x0e,
+	0x02, 0x0c, 0x0b, 0x0a, 0x09, 0x03, 0x07, 0x04 };
+static const uint8_t oaes_vp_inva[16] = {
+	0x80, 0x0d, 0x05, 0x06, 0x0a, 0x02, 0x03, 0x07,
+	0x0c, 0x0b, 0x04, 0x09, 0x08, 0x01, 0x0f, 0x0e };
+
+// f and g for SubBytes, without the 0x63 constant
+static const uint8_t oaes_vp_sb_io[16] = {
+	0x00, 0x4b, 0x2a, 0xb5, 0xc2, 0xa3, 0x9f, 0x89,
+	0x77, 0xfe, 0x16, 0x5d, 0x61, 0x3c, 0xe8, 0xd4 };
+static const uint8_t oaes_vp_sb_jo[16] = {
+	0x00, 0x54, 0xb7, 0x01, 0xf2, 0x11, 0xb6, 0xa6,
+	0xf3, 0x55, 0x10, 0x44, 0xe3, 0xa7, 0x45, 0xe2 };
+
+// f and g for InvSubBytes
+static const uint8_t oaes_vp_dsb_io[16] = {
+	0x00, 0x1e, 0x8f, 0xab, 0x23, 0xb2, 0x24, 0x3d,
+	0x88, 0xb5, 0x19, 0x07, 0x91, 0x96, 0xac, 0x3a };
+static const uint8_t oaes_vp_dsb_jo[16] = {
+	0x00, 0x1f, 0x3f, 0x4a, 0xce, 0xee, 0x75, 0xd1,
+	0x84, 0x55, 0xa4, 0xbb, 0x20, 0x9b, 0xf1, 0x6a };
+
+#define OAES_VP_TABLE( t ) _mm_loadu_si128( (const __m128i *) (t) )
+
+// byte 4 * c + r is taken from byte 4 * ( c + r ) + r, and back
+#define OAES_VP_SHIFT_ROWS _mm_setr_epi8( \
+		0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, 1, 6, 11 )
+#define OAES_VP_INV_SHIFT_ROWS _mm_setr_epi8( \
+		0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3 )
+
+// rotate each column up by one and by two rows
+#define OAES_VP_ROT1 _mm_setr_epi8( \
+		1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12 )
+#define OAES_VP_ROT2 _mm_setr_epi8( \
+		2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13 )
+
+OAES_TARGET_SSSE3
+static __m128i oaes_vp_sub_bytes( __m128i s,
+		const uint8_t in_lo[16], const uint8_t in_hi[16],
+		const uint8_t out_io[16], const uint8_t out_jo[16] )
+{
+	const __m128i _m = _mm_set1_epi8( 0x0f );
+	const __m128i _inv = OAES_VP_TABLE( oaes_vp_inv );
+	__m128i _i, _j, _k, _ak, _iak, _jak, _io, _jo;
+
+	s = _mm_xor_si128(
+			_mm_shuffle_epi8( OAES_VP_TABLE( in_lo ), _mm_and_si128( s, _m ) ),
+			_mm_shuffle_epi8( OAES_VP_TABLE( in_hi ),
+				_mm_and_si128( _mm_srli_epi16( s, 4 ), _m ) ) );
+
+	_k = _mm_and_si128( s, _m );
+	_i = _mm_and_si128( _mm_srli_epi16( s, 4 ), _m );
+	_j = _mm_xor_si128( _i, _k );
+
+	_ak = _mm_shuffle_epi8( OAES_VP_TABLE( oaes_vp_inva ), _k );
+	_iak = _mm_xor_si128( _mm_shuffle_epi8( _inv, _i ), _ak );
+	_jak = _mm_xor_si128( _mm_shuffle_epi8( _inv, _j ), _ak );
+	_io = _mm_xor_si128( _mm_shuffle_epi8( _inv, _iak ), _j );
+	_jo = _mm_xor_si128( _mm_shuffle_epi8( _inv, _jak ), _i );
+
+	return _mm_xor_si128(
+			_mm_shuffle_epi8( OAES_VP_TABLE( out_io ), _io ),
+			_mm_shuffle_epi8( OAES_VP_TABLE( out_jo ), _jo ) );
+}
+
+OAES_TARGET_SSSE3
+static __m128i oaes_vp_xtime( __m128i x )
+{
+	return _mm_xor_si128( _mm_add_epi8( x, x ),
+			_mm_and_si128( _mm_cmplt_epi8( x, _mm_setzero_si128() ),
+				_mm_set1_epi8( 0x1b ) ) );
+}
+
+// 2 * ( a ^ a1 ) ^ a1 ^ a2 ^ a3, with an the column rotated by n rows
+OAES_TARGET_SSSE3
+static __m128i oaes_vp_mix_cols( __m128i s )
+{
+	__m128i _r1 = _mm_shuffle_epi8( s, OAES_VP_ROT1 );
+	__m128i _u = _mm_xor_si128( s, _r1 );
+
+	return _mm_xor_si128( _mm_xor_si128( oaes_vp_xtime( _u ), _r1 ),
+			_mm_shuffle_epi8( _u, OAES_VP_ROT2 ) );
+}
+
+// InvMixColumns is MixColumns applied to a ^ 4 * ( a ^ a2 )
+OAES_TARGET_SSSE3
+static __m128i oaes_vp_inv_mix_cols( __m128i s )
+{
+	__m128i _u = _mm_xor_si128( s, _mm_shuffle_epi8( s, OAES_VP_ROT2 ) );
+
+	return oaes_vp_mix_cols(
+			_mm_xor_si128( s, oaes_vp_xtime( oaes_vp_xtime( _u ) ) ) );
+}
+
+OAES_TARGET_SSSE3
+void oaes_vperm_encrypt( const uint8_t * exp_data, size_t num_keys,
+		uint8_t c[OAES_BLOCK_SIZE] )
+{
+	size_t _i;
+	const __m128i _sb_const = _mm_set1_epi8( 0x63 );
+	const __m128i * _rk = (const __m128i *) exp_data;
+	__m128i _s = _mm_loadu_si128( (const __m128i *) c );
+
+	_s = _mm_xor_si128( _s, _mm_load_si128( _rk ) );
+	for( _i = 1; _i < num_keys - 1; _i++ )
+	{
+		_s = oaes_vp_sub_bytes( _s, oaes_vp_in_lo, oaes_vp_in_hi,
+				oaes_vp_sb_io, oaes_vp_sb_jo );
+		_s = _mm_shuffle_epi8( _mm_xor_si128( _s, _sb_const ), OAES_VP_SHIFT_ROWS );
+		_s = oaes_vp_mix_cols( _s );
+		_s = _mm_xor_si128( _s, _mm_load_si128( _rk + _i ) );
+	}
+	_s = oaes_vp_sub_bytes( _s, oaes_vp_in_lo, oaes_vp_in_hi,
+			oaes_vp_sb_io, oaes_vp_sb_jo );
+	_s = _mm_shuffle_epi8( _mm_xor_si128( _s, _sb_const ), OAES_VP_SHIFT_ROWS );
+	_s = _mm_xor_si128( _s, _mm_load_si128( _rk + _i ) );
+
+	_mm_storeu_si128( (__m128i *) c, _s );
+}
+
+OAES_TARGET_SSSE3
+void oaes_vperm_decrypt( const uint8_t * exp_data, size_t num_keys,
+		uint8_t c[OAES_BLOCK_SIZE] )
+{
+	size_t _i;
+	const __m128i * _rk = (const __m128i *) exp_data;
+	__m128i _s = _mm_loadu_si128( (const __m128i *) c );
+
+	_s = _mm_xor_si128( _s, _mm_load_si128( _rk + num_keys - 1 ) );
+	for( _i = num_keys - 2; _i > 0; _i-- )
+	{
+		_s = _mm_shuffle_epi8( _s, OAES_VP_INV_SHIFT_ROWS );
+		_s = oaes_vp_sub_bytes( _s, oaes_vp_din_lo, oaes_vp_din_hi,
+				oaes_vp_dsb_io, oaes_vp_dsb_jo );
+		_s = _mm_xor_si128( _s, _mm_load_si128( _rk + _i ) );
+		_s = oaes_vp_inv_mix_cols( _s );
+	}
+	_s = _mm_shuffle_epi8( _s, OAES_VP_INV_SHIFT_ROWS );
+	_s = oaes_vp_sub_bytes( _s, oaes_vp_din_lo, oaes_vp_din_hi,
+			oaes_vp_dsb_io, oaes_vp_dsb_jo );
+	_s = _mm_xor_si128( _s, _mm_load_si128( _rk ) );
+
+	_mm_storeu_si128( (__m128i *) c, _s );
+}
+
+#endif // OAES_HAVE_VPERM
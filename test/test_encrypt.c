@@ -41,7 +41,7 @@ void usage(const char * exe_name)
 	
 	printf(
 			"Usage:\n"
-			"\t%s [-ecb] [-key < 128 | 192 | 256 >] <text>\n",
+			"\t%s [-ecb | -ctr] [-key < 128 | 192 | 256 >] <text>\n",
 			exe_name
 	);
 }
@@ -53,7 +53,7 @@ int main(int argc, char** argv)
 	uint8_t *_encbuf, *_decbuf;
 	size_t _encbuf_len, _decbuf_len, _buf_len;
 	char *_buf;
-	short _is_ecb = 0;
+	short _is_ecb = 0, _is_ctr = 0;
 	char * _text = NULL;
 	int _key_len = 128;
 	uint8_t _iv[OAES_BLOCK_SIZE] = "";
@@ -75,6 +75,12 @@ int main(int argc, char** argv)
 			_is_ecb = 1;
 		}
 		
+		if( 0 == strcmp( argv[_i], "-ctr" ) )
+		{
+			_found = 1;
+			_is_ctr = 1;
+		}
+		
 		if( 0 == strcmp( argv[_i], "-key" ) )
 		{
 			_found = 1;
@@ -151,6 +157,9 @@ int main(int argc, char** argv)
 	if( _is_ecb )
 		if( OAES_RET_SUCCESS != oaes_set_option( ctx, OAES_OPTION_ECB, NULL ) )
 			printf("Error: Failed to set OAES options.\n");
+	if( _is_ctr )
+		if( OAES_RET_SUCCESS != oaes_set_option( ctx, OAES_OPTION_CTR, NULL ) )
+			printf("Error: Failed to set OAES options.\n");
 	switch( _key_len )
 	{
 		case 128:
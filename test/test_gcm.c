@@ -0,0 +1,489 @@
+/* 
+ * ---------------------------------------------------------------------------
+ * OpenAES License
+ * ---------------------------------------------------------------------------
+ * Copyright (c) 2012, Nabil S. Al Ramli, www.nalramli.com
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ *   - Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   - Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * ---------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "oaes_lib.h"
+
+/*
+ * the AES-GCM test cases of the GCM specification, as submitted to NIST
+ * key, iv, aad, plaintext, ciphertext and tag, in hex
+ */
+typedef struct _gcm_vector
+{
+	const char * key;
+	const char * iv;
+	const char * aad;
+	const char * p;
+	const char * c;
+	const char * tag;
+} gcm_vector;
+
+static const gcm_vector gcm_vectors[] = {
+	// test case 1
+	{
+		"00000000000000000000000000000000",
+		"000000000000000000000000",
+		"",
+		"",
+		"",
+		"58e2fccefa7e3061367f1d57a4e7455a"
+	},
+	// test case 2
+	{
+		"00000000000000000000000000000000",
+		"000000000000000000000000",
+		"",
+		"00000000000000000000000000000000",
+		"0388dace60b6a392f328c2b971b2fe78",
+		"ab6e47d42cec13bdf53a67b21257bddf"
+	},
+	// test case 3
+	{
+		"feffe9928665731c6d6a8f9467308308",
+		"cafebabefacedbaddecaf888",
+		"",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255",
+		"42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+		"21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091473f5985",
+		"4d5c2af327cd64a62cf35abd2ba6fab4"
+	},
+	// test case 4
+	{
+		"feffe9928665731c6d6a8f9467308308",
+		"cafebabefacedbaddecaf888",
+		"feedfacedeadbeeffeedfacedeadbeefabaddad2",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+		"42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+		"21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+		"5bc94fbc3221a5db94fae95ae7121a47"
+	},
+	// test case 5
+	{
+		"feffe9928665731c6d6a8f9467308308",
+		"cafebabefacedbad",
+		"feedfacedeadbeeffeedfacedeadbeefabaddad2",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+		"61353b4c2806934a777ff51fa22a4755699b2a714fcdc6f83766e5f97b6c7423"
+		"73806900e49f24b22b097544d4896b424989b5e1ebac0f07c23f4598",
+		"3612d2e79e3b0785561be14aaca2fccb"
+	},
+	// test case 6
+	{
+		"feffe9928665731c6d6a8f9467308308",
+		"9313225df88406e555909c5aff5269aa6a7a9538534f7da1e4c303d2a318a728"
+		"c3c0c95156809539fcf0e2429a6b525416aedbf5a0de6a57a637b39b",
+		"feedfacedeadbeeffeedfacedeadbeefabaddad2",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+		"8ce24998625615b603a033aca13fb894be9112a5c3a211a8ba262a3cca7e2ca7"
+		"01e4a9a4fba43c90ccdcb281d48c7c6fd62875d2aca417034c34aee5",
+		"619cc5aefffe0bfa462af43c1699d050"
+	},
+	// test case 7
+	{
+		"000000000000000000000000000000000000000000000000",
+		"000000000000000000000000",
+		"",
+		"",
+		"",
+		"cd33b28ac773f74ba00ed1f312572435"
+	},
+	// test case 8
+	{
+		"000000000000000000000000000000000000000000000000",
+		"000000000000000000000000",
+		"",
+		"00000000000000000000000000000000",
+		"98e7247c07f0fe411c267e4384b0f600",
+		"2ff58d80033927ab8ef4d4587514f0fb"
+	},
+	// test case 9
+	{
+		"feffe9928665731c6d6a8f9467308308feffe9928665731c",
+		"cafebabefacedbaddecaf888",
+		"",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255",
+		"3980ca0b3c00e841eb06fac4872a2757859e1ceaa6efd984628593b40ca1e19c"
+		"7d773d00c144c525ac619d18c84a3f4718e2448b2fe324d9ccda2710acade256",
+		"9924a7c8587336bfb118024db8674a14"
+	},
+	// test case 10
+	{
+		"feffe9928665731c6d6a8f9467308308feffe9928665731c",
+		"cafebabefacedbaddecaf888",
+		"feedfacedeadbeeffeedfacedeadbeefabaddad2",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+		"3980ca0b3c00e841eb06fac4872a2757859e1ceaa6efd984628593b40ca1e19c"
+		"7d773d00c144c525ac619d18c84a3f4718e2448b2fe324d9ccda2710",
+		"2519498e80f1478f37ba55bd6d27618c"
+	},
+	// test case 11
+	{
+		"feffe9928665731c6d6a8f9467308308feffe9928665731c",
+		"cafebabefacedbad",
+		"feedfacedeadbeeffeedfacedeadbeefabaddad2",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+		"0f10f599ae14a154ed24b36e25324db8c566632ef2bbb34f8347280fc4507057"
+		"fddc29df9a471f75c66541d4d4dad1c9e93a19a58e8b473fa0f062f7",
+		"65dcc57fcf623a24094fcca40d3533f8"
+	},
+	// test case 12
+	{
+		"feffe9928665731c6d6a8f9467308308feffe9928665731c",
+		"9313225df88406e555909c5aff5269aa6a7a9538534f7da1e4c303d2a318a728"
+		"c3c0c95156809539fcf0e2429a6b525416aedbf5a0de6a57a637b39b",
+		"feedfacedeadbeeffeedfacedeadbeefabaddad2",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+		"d27e88681ce3243c4830165a8fdcf9ff1de9a1d8e6b447ef6ef7b79828666e45"
+		"81e79012af34ddd9e2f037589b292db3e67c036745fa22e7e9b7373b",
+		"dcf566ff291c25bbb8568fc3d376a6d9"
+	},
+	// test case 13
+	{
+		"0000000000000000000000000000000000000000000000000000000000000000",
+		"000000000000000000000000",
+		"",
+		"",
+		"",
+		"530f8afbc74536b9a963b4f1c4cb738b"
+	},
+	// test case 14
+	{
+		"0000000000000000000000000000000000000000000000000000000000000000",
+		"000000000000000000000000",
+		"",
+		"00000000000000000000000000000000",
+		"cea7403d4d606b6e074ec5d3baf39d18",
+		"d0d1c8a799996bf0265b98b5d48ab919"
+	},
+	// test case 15
+	{
+		"feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308",
+		"cafebabefacedbaddecaf888",
+		"",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255",
+		"522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa"
+		"8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662898015ad",
+		"b094dac5d93471bdec1a502270e3cc6c"
+	},
+	// test case 16
+	{
+		"feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308",
+		"cafebabefacedbaddecaf888",
+		"feedfacedeadbeeffeedfacedeadbeefabaddad2",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+		"522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa"
+		"8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662",
+		"76fc6ece0f4e1768cddf8853bb2d551b"
+	},
+	// test case 17
+	{
+		"feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308",
+		"cafebabefacedbad",
+		"feedfacedeadbeeffeedfacedeadbeefabaddad2",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+		"c3762df1ca787d32ae47c13bf19844cbaf1ae14d0b976afac52ff7d79bba9de0"
+		"feb582d33934a4f0954cc2363bc73f7862ac430e64abe499f47c9b1f",
+		"3a337dbf46a792c45e454913fe2ea8f2"
+	},
+	// test case 18
+	{
+		"feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308",
+		"9313225df88406e555909c5aff5269aa6a7a9538534f7da1e4c303d2a318a728"
+		"c3c0c95156809539fcf0e2429a6b525416aedbf5a0de6a57a637b39b",
+		"feedfacedeadbeeffeedfacedeadbeefabaddad2",
+		"d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+		"5a8def2f0c9e53f1f75d7853659e2a20eeb2b22aafde6419a058ab4f6f746bf4"
+		"0fc0c3b780f244452da3ebf1c5d82cdea2418997200ef82e44ae7e3f",
+		"a44a8266ee1c8eb0c8b5d4cf5ae9f19a"
+	},
+};
+
+#define GCM_VECTOR_COUNT ( sizeof( gcm_vectors ) / sizeof( gcm_vectors[0] ) )
+
+// AES-GCM-SIV test vectors of RFC 8452, laid out the same way
+static const gcm_vector gcm_siv_vectors[] = {
+	{
+		"01000000000000000000000000000000",
+		"030000000000000000000000",
+		"",
+		"",
+		"",
+		"dc20e2d83f25705bb49e439eca56de25"
+	},
+	{
+		"01000000000000000000000000000000",
+		"030000000000000000000000",
+		"",
+		"0100000000000000",
+		"b5d839330ac7b786",
+		"578782fff6013b815b287c22493a364c"
+	},
+	{
+		"01000000000000000000000000000000"
+		"00000000000000000000000000000000",
+		"030000000000000000000000",
+		"",
+		"",
+		"",
+		"07f5f4169bbf55a8400cd47ea6fd400f"
+	},
+	{
+		"01000000000000000000000000000000"
+		"00000000000000000000000000000000",
+		"030000000000000000000000",
+		"",
+		"0100000000000000",
+		"c2ef328e5c71c83b",
+		"843122130f7364b761e0b97427e3df28"
+	},
+};
+
+#define GCM_SIV_VECTOR_COUNT \
+	( sizeof( gcm_siv_vectors ) / sizeof( gcm_siv_vectors[0] ) )
+
+static size_t from_hex( const char * hex, uint8_t * buf )
+{
+	size_t _i, _len = strlen( hex ) / 2;
+	unsigned int _b;
+
+	for( _i = 0; _i < _len; _i++ )
+	{
+		sscanf( hex + 2 * _i, "%2x", &_b );
+		buf[_i] = (uint8_t) _b;
+	}
+
+	return _len;
+}
+
+// 0 when vector v encrypts, decrypts and rejects a bad tag as it should
+static int test_vector( OAES_CTX * ctx, const gcm_vector * v )
+{
+	uint8_t _key[32], _iv[64], _aad[32], _p[64], _c[64], _tag[16];
+	uint8_t _out[64], _out_tag[16];
+	size_t _key_len = from_hex( v->key, _key );
+	size_t _iv_len = from_hex( v->iv, _iv );
+	size_t _aad_len = from_hex( v->aad, _aad );
+	size_t _len = from_hex( v->p, _p );
+	OAES_RET _rc;
+
+	from_hex( v->c, _c );
+	from_hex( v->tag, _tag );
+
+	if( OAES_RET_SUCCESS != ( _rc = oaes_key_import_data( ctx, _key, _key_len ) ) )
+	{
+		printf( "Error: Failed to import key [%d].\n", _rc );
+		return 1;
+	}
+
+	if( OAES_RET_SUCCESS != ( _rc = oaes_gcm_encrypt( ctx, _iv, _iv_len,
+			_aad, _aad_len, _p, _len, _out, _out_tag, sizeof( _out_tag ) ) ) )
+	{
+		printf( "Error: Failed to encrypt [%d].\n", _rc );
+		return 1;
+	}
+
+	if( memcmp( _out, _c, _len ) || memcmp( _out_tag, _tag, sizeof( _tag ) ) )
+	{
+		printf( "Error: Ciphertext or tag mismatch.\n" );
+		return 1;
+	}
+
+	// a truncated tag is checked over its length only
+	if( OAES_RET_SUCCESS != ( _rc = oaes_gcm_decrypt( ctx, _iv, _iv_len,
+			_aad, _aad_len, _c, _len, _out, _tag, 12 ) ) )
+	{
+		printf( "Error: Failed to decrypt [%d].\n", _rc );
+		return 1;
+	}
+
+	if( memcmp( _out, _p, _len ) )
+	{
+		printf( "Error: Plaintext mismatch.\n" );
+		return 1;
+	}
+
+	_tag[15] ^= 0x01;
+	if( OAES_RET_AUTH != oaes_gcm_decrypt( ctx, _iv, _iv_len,
+			_aad, _aad_len, _c, _len, _out, _tag, sizeof( _tag ) ) )
+	{
+		printf( "Error: Bad tag accepted.\n" );
+		return 1;
+	}
+
+	return 0;
+}
+
+// 0 when GCM-SIV vector v encrypts, decrypts and rejects a bad tag as it
+// should, and a longer message under its key goes through in place
+static int test_siv_vector( OAES_CTX * ctx, const gcm_vector * v )
+{
+	size_t _i;
+	uint8_t _key[32], _nonce[12], _aad[32], _p[64], _c[64], _tag[16];
+	uint8_t _out[64], _out_tag[16], _long[1000];
+	size_t _key_len = from_hex( v->key, _key );
+	size_t _aad_len = from_hex( v->aad, _aad );
+	size_t _len = from_hex( v->p, _p );
+	OAES_RET _rc;
+
+	from_hex( v->iv, _nonce );
+	from_hex( v->c, _c );
+	from_hex( v->tag, _tag );
+
+	if( OAES_RET_SUCCESS != ( _rc = oaes_key_import_data( ctx, _key, _key_len ) ) )
+	{
+		printf( "Error: Failed to import key [%d].\n", _rc );
+		return 1;
+	}
+
+	if( OAES_RET_SUCCESS != ( _rc = oaes_gcm_siv_encrypt( ctx, _nonce,
+			_aad, _aad_len, _p, _len, _out, _out_tag ) ) )
+	{
+		printf( "Error: Failed to encrypt [%d].\n", _rc );
+		return 1;
+	}
+
+	if( memcmp( _out, _c, _len ) || memcmp( _out_tag, _tag, sizeof( _tag ) ) )
+	{
+		printf( "Error: Ciphertext or tag mismatch.\n" );
+		return 1;
+	}
+
+	if( OAES_RET_SUCCESS != ( _rc = oaes_gcm_siv_decrypt( ctx, _nonce,
+			_aad, _aad_len, _c, _len, _out, _tag ) ) ||
+			memcmp( _out, _p, _len ) )
+	{
+		printf( "Error: Failed to decrypt [%d].\n", _rc );
+		return 1;
+	}
+
+	_tag[0] ^= 0x01;
+	if( OAES_RET_AUTH != oaes_gcm_siv_decrypt( ctx, _nonce,
+			_aad, _aad_len, _c, _len, _out, _tag ) )
+	{
+		printf( "Error: Bad tag accepted.\n" );
+		return 1;
+	}
+
+	// long enough for the POLYVAL runs of 8 blocks
+	for( _i = 0; _i < sizeof( _long ); _i++ )
+		_long[_i] = (uint8_t) _i;
+
+	if( oaes_gcm_siv_encrypt( ctx, _nonce, _aad, _aad_len,
+			_long, sizeof( _long ), _long, _out_tag ) ||
+			oaes_gcm_siv_decrypt( ctx, _nonce, _aad, _aad_len,
+			_long, sizeof( _long ), _long, _out_tag ) )
+	{
+		printf( "Error: Long message round trip failed.\n" );
+		return 1;
+	}
+
+	for( _i = 0; _i < sizeof( _long ); _i++ )
+		if( _long[_i] != (uint8_t) _i )
+		{
+			printf( "Error: Long message mismatch.\n" );
+			return 1;
+		}
+
+	return 0;
+}
+
+/*
+ * 
+ */
+int main(int argc, char** argv) {
+
+	size_t _i, _j;
+	const char * _name;
+	int _available, _failed = 0, _engine_failed;
+	OAES_CTX * ctx = NULL;
+
+	if( NULL == ( ctx = oaes_alloc() ) )
+	{
+		printf( "Error: Initialization failed.\n" );
+		return 1;
+	}
+
+	// every vector on every engine this cpu can run
+	for( _i = 0; OAES_RET_SUCCESS ==
+			oaes_get_engine_info( _i, &_name, NULL, &_available ); _i++ )
+	{
+		if( 0 == _available )
+			continue;
+
+		if( OAES_RET_SUCCESS != oaes_set_option( ctx, OAES_OPTION_ENGINE, _name ) )
+		{
+			printf( "Error: Failed to select engine %s.\n", _name );
+			oaes_free( &ctx );
+			return 1;
+		}
+
+		_engine_failed = 0;
+		for( _j = 0; _j < GCM_VECTOR_COUNT; _j++ )
+		{
+			if( test_vector( ctx, gcm_vectors + _j ) )
+			{
+				printf( "engine %s, test case %d: FAILED\n", _name, (int) _j + 1 );
+				_engine_failed = 1;
+			}
+		}
+
+		for( _j = 0; _j < GCM_SIV_VECTOR_COUNT; _j++ )
+		{
+			if( test_siv_vector( ctx, gcm_siv_vectors + _j ) )
+			{
+				printf( "engine %s, GCM-SIV test case %d: FAILED\n",
+						_name, (int) _j + 1 );
+				_engine_failed = 1;
+			}
+		}
+
+		printf( "engine %s: %s\n", _name, _engine_failed ? "FAILED" : "passed" );
+		_failed |= _engine_failed;
+	}
+
+	oaes_free( &ctx );
+
+	return _failed;
+}
@@ -0,0 +1,2308 @@
+/* 
+ * ---------------------------------------------------------------------------
+ * OpenAES License
+ * ---------------------------------------------------------------------------
+ * Copyright (c) 2012, Nabil S. Al Ramli, www.nalramli.com
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ *   - Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   - Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * ---------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "oaes_lib.h"
+/*
+ * XTS-AES test vectors of IEEE 1619, data key then tweak key, the sector
+ * number, plaintext and ciphertext, in hex
+ */
+typedef struct _xts_vector
+{
+	const char * key;
+	uint64_t sector;
+	const char * p;
+	const char * c;
+} xts_vector;
+
+static const xts_vector xts_vectors[] = {
+	// vector 1
+	{
+		"00000000000000000000000000000000"
+		"00000000000000000000000000000000",
+		0,
+		"00000000000000000000000000000000"
+		"00000000000000000000000000000000",
+		"917cf69ebd68b2ec9b9fe9a3eadda692"
+		"cd43d2f59598ed858c02c2652fbf922e"
+	},
+	// vector 2
+	{
+		"11111111111111111111111111111111"
+		"22222222222222222222222222222222",
+		0x3333333333ULL,
+		"44444444444444444444444444444444"
+		"44444444444444444444444444444444",
+		"c454185e6a16936e39334038acef838b"
+		"fb186fff7480adc4289382ecd6d394f0"
+	},
+	// vector 3
+	{
+		"fffefdfcfbfaf9f8f7f6f5f4f3f2f1f0"
+		"22222222222222222222222222222222",
+		0x3333333333ULL,
+		"44444444444444444444444444444444"
+		"44444444444444444444444444444444",
+		"af85336b597afc1a900b2eb21ec949d2"
+		"92df4c047e0b21532186a5971a227a89"
+	},
+	// vector 10, first two blocks of the sector
+	{
+		"27182818284590452353602874713526"
+		"62497757247093699959574966967627"
+		"31415926535897932384626433832795"
+		"02884197169399375105820974944592",
+		0xff,
+		"000102030405060708090a0b0c0d0e0f"
+		"101112131415161718191a1b1c1d1e1f",
+		"1c3b3a102f770386e4836c99e370cf9b"
+		"ea00803f5e482357a4ae12d414a3e63b"
+	},
+	// vectors 15 to 18, ciphertext stealing
+	{
+		"fffefdfcfbfaf9f8f7f6f5f4f3f2f1f0"
+		"bfbebdbcbbbab9b8b7b6b5b4b3b2b1b0",
+		0x123456789aULL,
+		"000102030405060708090a0b0c0d0e0f10",
+		"6c1625db4671522d3d7599601de7ca09ed"
+	},
+	{
+		"fffefdfcfbfaf9f8f7f6f5f4f3f2f1f0"
+		"bfbebdbcbbbab9b8b7b6b5b4b3b2b1b0",
+		0x123456789aULL,
+		"000102030405060708090a0b0c0d0e0f1011",
+		"d069444b7a7e0cab09e24447d24deb1fedbf"
+	},
+	{
+		"fffefdfcfbfaf9f8f7f6f5f4f3f2f1f0"
+		"bfbebdbcbbbab9b8b7b6b5b4b3b2b1b0",
+		0x123456789aULL,
+		"000102030405060708090a0b0c0d0e0f101112",
+		"e5df1351c0544ba1350b3363cd8ef4beedbf9d"
+	},
+	{
+		"fffefdfcfbfaf9f8f7f6f5f4f3f2f1f0"
+		"bfbebdbcbbbab9b8b7b6b5b4b3b2b1b0",
+		0x123456789aULL,
+		"000102030405060708090a0b0c0d0e0f10111213",
+		"9d84c813f719aa2c7be3f66171c7c5c2edbf9dac"
+	},
+};
+
+#define XTS_VECTOR_COUNT ( sizeof( xts_vectors ) / sizeof( xts_vectors[0] ) )
+
+/*
+ * AEAD test vectors, key, nonce, aad, plaintext, ciphertext and tag, in
+ * hex, the tag length is that of the tag
+ */
+typedef struct _aead_vector
+{
+	const char * key;
+	const char * nonce;
+	const char * aad;
+	const char * p;
+	const char * c;
+	const char * tag;
+} aead_vector;
+
+// OCB3 sample results of RFC 7253
+static const aead_vector ocb_vectors[] = {
+	{
+		"000102030405060708090a0b0c0d0e0f",
+		"bbaa99887766554433221100",
+		"",
+		"",
+		"",
+		"785407bfffc8ad9edcc5520ac9111ee6"
+	},
+	{
+		"000102030405060708090a0b0c0d0e0f",
+		"bbaa99887766554433221101",
+		"0001020304050607",
+		"0001020304050607",
+		"6820b3657b6f615a",
+		"5725bda0d3b4eb3a257c9af1f8f03009"
+	},
+	{
+		"000102030405060708090a0b0c0d0e0f",
+		"bbaa99887766554433221102",
+		"0001020304050607",
+		"",
+		"",
+		"81017f8203f081277152fade694a0a00"
+	},
+	{
+		"000102030405060708090a0b0c0d0e0f",
+		"bbaa99887766554433221103",
+		"",
+		"0001020304050607",
+		"45dd69f8f5aae724",
+		"14054cd1f35d82760b2cd00d2f99bfa9"
+	},
+	{
+		"000102030405060708090a0b0c0d0e0f",
+		"bbaa99887766554433221104",
+		"000102030405060708090a0b0c0d0e0f",
+		"000102030405060708090a0b0c0d0e0f",
+		"571d535b60b277188be5147170a9a22c",
+		"3ad7a4ff3835b8c5701c1ccec8fc3358"
+	},
+	{
+		"000102030405060708090a0b0c0d0e0f",
+		"bbaa9988776655443322110d",
+		"000102030405060708090a0b0c0d0e0f"
+		"1011121314151617"
+		"18191a1b1c1d1e1f2021222324252627",
+		"000102030405060708090a0b0c0d0e0f"
+		"1011121314151617"
+		"18191a1b1c1d1e1f2021222324252627",
+		"d5ca91748410c1751ff8a2f618255b68"
+		"a0a12e093ff454606e59f9c1d0ddc54b"
+		"65e8628e568bad7a",
+		"ed07ba06a4a69483a7035490c5769e60"
+	},
+	{
+		"0f0e0d0c0b0a09080706050403020100",
+		"bbaa9988776655443322110d",
+		"000102030405060708090a0b0c0d0e0f"
+		"1011121314151617"
+		"18191a1b1c1d1e1f2021222324252627",
+		"000102030405060708090a0b0c0d0e0f"
+		"1011121314151617"
+		"18191a1b1c1d1e1f2021222324252627",
+		"1792a4e31e0755fb03e31b22116e6c2d"
+		"df9efd6e33d536f1a0124b0a55bae884"
+		"ed93481529c76b6a",
+		"d0c515f4d1cdd4fdac4f02aa"
+	},
+};
+
+#define OCB_VECTOR_COUNT ( sizeof( ocb_vectors ) / sizeof( ocb_vectors[0] ) )
+
+// AES-CCM examples 1 to 3 of NIST SP 800-38C
+static const aead_vector ccm_vectors[] = {
+	{
+		"404142434445464748494a4b4c4d4e4f",
+		"10111213141516",
+		"0001020304050607",
+		"20212223",
+		"7162015b",
+		"4dac255d"
+	},
+	{
+		"404142434445464748494a4b4c4d4e4f",
+		"1011121314151617",
+		"000102030405060708090a0b0c0d0e0f",
+		"202122232425262728292a2b2c2d2e2f",
+		"d2a1f0e051ea5f62081a7792073d593d",
+		"1fc64fbfaccd"
+	},
+	{
+		"404142434445464748494a4b4c4d4e4f",
+		"101112131415161718191a1b",
+		"000102030405060708090a0b0c0d0e0f10111213",
+		"202122232425262728292a2b2c2d2e2f3031323334353637",
+		"e3b201a9f5b71a7a9b1ceaeccd97e70b6176aad9a4428aa5",
+		"484392fbc1b09951"
+	},
+	// example 4, with the 65536 bytes of aad 00 01 .. ff 00 01 .. written
+	// out by test_ccm_vector()
+	{
+		"404142434445464748494a4b4c4d4e4f",
+		"101112131415161718191a1b1c",
+		"",
+		"202122232425262728292a2b2c2d2e2f"
+		"303132333435363738393a3b3c3d3e3f",
+		"69915dad1e84c6376a68c2967e4dab61"
+		"5ae0fd1faec44cc484828529463ccf72",
+		"b4ac6bec93e8598e7f0dadbcea5b"
+	},
+};
+
+#define CCM_VECTOR_COUNT ( sizeof( ccm_vectors ) / sizeof( ccm_vectors[0] ) )
+
+#define CCM_LONG_AAD_LEN 65536
+
+/*
+ * the AES-128 key, four plaintext blocks and iv that most of the SP 800-38A
+ * examples share
+ */
+#define STREAM_KEY "2b7e151628aed2a6abf7158809cf4f3c"
+#define STREAM_IV "000102030405060708090a0b0c0d0e0f"
+#define STREAM_P \
+	"6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51" \
+	"30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710"
+
+/*
+ * ECB test vectors of FIPS-197 appendix C and of SP 800-38A F.1, key,
+ * plaintext and ciphertext in hex
+ */
+typedef struct _ecb_vector
+{
+	const char * key;
+	const char * p;
+	const char * c;
+} ecb_vector;
+
+static const ecb_vector ecb_vectors[] = {
+	// C.1
+	{
+		"000102030405060708090a0b0c0d0e0f",
+		"00112233445566778899aabbccddeeff",
+		"69c4e0d86a7b0430d8cdb78070b4c55a"
+	},
+	// C.2
+	{
+		"000102030405060708090a0b0c0d0e0f1011121314151617",
+		"00112233445566778899aabbccddeeff",
+		"dda97ca4864cdfe06eaf70a0ec0d7191"
+	},
+	// C.3
+	{
+		"000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f",
+		"00112233445566778899aabbccddeeff",
+		"8ea2b7ca516745bfeafc49904b496089"
+	},
+	// F.1.1
+	{
+		STREAM_KEY,
+		STREAM_P,
+		"3ad77bb40d7a3660a89ecaf32466ef97f5d3d58503b9699de785895a96fdbaaf"
+		"43b1cd7f598ece23881b00e3ed0306887b0c785e27e8ad3f8223207104725dd4"
+	},
+	// F.1.3
+	{
+		"8e73b0f7da0e6452c810f32b809079e562f8ead2522c6b7b",
+		STREAM_P,
+		"bd334f1d6e45f25ff712a214571fa5cc974104846d0ad3ad7734ecb3ecee4eef"
+		"ef7afd2270e2e60adce0ba2face6444e9a4b41ba738d6c72fb16691603c18e0e"
+	},
+	// F.1.5
+	{
+		"603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",
+		STREAM_P,
+		"f3eed1bdb5d2a03c064b5a7e3db181f8591ccb10d410ed26dc5ba74a31362870"
+		"b6ed21b99ca6f4f9f153e7b1beafed1d23304b7a39f9f3ff067d8d8f9e24ecc7"
+	},
+};
+
+#define ECB_VECTOR_COUNT ( sizeof( ecb_vectors ) / sizeof( ecb_vectors[0] ) )
+
+/*
+ * CBC test vectors of SP 800-38A F.2, with the shared plaintext and iv
+ */
+typedef struct _cbc_vector
+{
+	const char * key;
+	const char * c;
+} cbc_vector;
+
+static const cbc_vector cbc_vectors[] = {
+	// F.2.1
+	{
+		STREAM_KEY,
+		"7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b2"
+		"73bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a7"
+	},
+	// F.2.3
+	{
+		"8e73b0f7da0e6452c810f32b809079e562f8ead2522c6b7b",
+		"4f021db243bc633d7178183a9fa071e8b4d9ada9ad7dedf4e5e738763f69145a"
+		"571b242012fb7ae07fa9baac3df102e008b0e27988598881d920a9e64f5615cd"
+	},
+	// F.2.5
+	{
+		"603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",
+		"f58c4c04d6e5f1ba779eabfb5f7bfbd69cfc4e967edb808d679f777bc6702c7d"
+		"39f23369a9d9bacfa530e26304231461b2eb05e2c39be9fcda6c19078c6a9d1b"
+	},
+};
+
+#define CBC_VECTOR_COUNT ( sizeof( cbc_vectors ) / sizeof( cbc_vectors[0] ) )
+
+/*
+ * CFB and OFB test vectors of SP 800-38A, F.3 and F.4, with the shared key,
+ * plaintext and iv
+ */
+
+typedef struct _stream_vector
+{
+	const char * name;
+	// 128 or 8 for cfb, 0 for ofb
+	size_t segment_bits;
+	const char * c;
+} stream_vector;
+
+static const stream_vector stream_vectors[] = {
+	// F.3.13
+	{
+		"CFB128", 128,
+		"3b3fd92eb72dad20333449f8e83cfb4ac8a64537a0b3a93fcde3cdad9f1ce58b"
+		"26751f67a3cbb140b1808cf187a4f4dfc04b05357c5d1c0eeac4c66f9ff7f2e6"
+	},
+	// F.3.7, extended past its 18 bytes
+	{
+		"CFB8", 8,
+		"3b79424c9c0dd436bace9e0ed4586a4f32b9ded50ae3ba69d472e88267fb5052"
+		"70cbad1e257691f7c47c5038297edda32ff26d0ed19174096161ecc14086dd62"
+	},
+	// F.4.1
+	{
+		"OFB", 0,
+		"3b3fd92eb72dad20333449f8e83cfb4a7789508d16918f03f53c52dac54ed825"
+		"9740051e9c5fecf64344f7a82260edcc304c6528f659c77866a510d9c1d6ae5e"
+	},
+};
+
+#define STREAM_VECTOR_COUNT \
+	( sizeof( stream_vectors ) / sizeof( stream_vectors[0] ) )
+
+/*
+ * CTR-AES128 of SP 800-38A, F.5.1 encrypts and F.5.2 decrypts, with the
+ * shared key and plaintext
+ */
+#define CTR_IV "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff"
+#define CTR_IV_NEXT "f0f1f2f3f4f5f6f7f8f9fafbfcfdff03"
+#define CTR_C \
+	"874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff" \
+	"5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009cee"
+
+/*
+ * CBC-CS3 test vectors of RFC 3962, appendix B, which uses the CS3 order,
+ * all with the same key, a zero iv and a prefix of the same plaintext
+ */
+#define CTS_KEY "chicken teriyaki"
+#define CTS_P "I would like the General Gau's Chicken, please, and wonton soup."
+
+typedef struct _cts_vector
+{
+	size_t len;
+	const char * c;
+} cts_vector;
+
+static const cts_vector cts_vectors[] = {
+	{ 17, "c6353568f2bf8cb4d8a580362da7ff7f97" },
+	{
+		31,
+		"fc00783e0efdb2c1d445d4c8eff7ed22"
+		"97687268d6ecccc0c07b25e25ecfe5"
+	},
+	{
+		32,
+		"39312523a78662d5be7fcbcc98ebf5a8"
+		"97687268d6ecccc0c07b25e25ecfe584"
+	},
+	{
+		47,
+		"97687268d6ecccc0c07b25e25ecfe584"
+		"b3fffd940c16a18c1b5549d2f838029e"
+		"39312523a78662d5be7fcbcc98ebf5"
+	},
+	{
+		48,
+		"97687268d6ecccc0c07b25e25ecfe584"
+		"9dad8bbb96c4cdc03bc103e1a194bbd8"
+		"39312523a78662d5be7fcbcc98ebf5a8"
+	},
+	{
+		64,
+		"97687268d6ecccc0c07b25e25ecfe584"
+		"39312523a78662d5be7fcbcc98ebf5a8"
+		"4807efe836ee89a526730dbc2f7bc840"
+		"9dad8bbb96c4cdc03bc103e1a194bbd8"
+	},
+};
+
+#define CTS_VECTOR_COUNT ( sizeof( cts_vectors ) / sizeof( cts_vectors[0] ) )
+
+/*
+ * AES-128 CMAC test vectors of SP 800-38B, D.1, over prefixes of the
+ * SP 800-38A plaintext with the same key
+ */
+typedef struct _cmac_vector
+{
+	size_t len;
+	const char * tag;
+} cmac_vector;
+
+static const cmac_vector cmac_vectors[] = {
+	{ 0, "bb1d6929e95937287fa37d129b756746" },
+	{ 16, "070a16b46b4d4144f79bdd9dd04a287c" },
+	{ 40, "dfa66747de9ae63030ca32611497c827" },
+	{ 64, "51f0bebf7e3b9d92fc49741779363cfe" },
+};
+
+#define CMAC_VECTOR_COUNT ( sizeof( cmac_vectors ) / sizeof( cmac_vectors[0] ) )
+
+/*
+ * key wrap test vectors of RFC 3394, 4.1 and 4.6, and of RFC 5649, 6,
+ * the key encryption key, the key and the wrapped key, in hex
+ */
+typedef struct _kw_vector
+{
+	int padded;
+	const char * kek;
+	const char * key;
+	const char * c;
+} kw_vector;
+
+static const kw_vector kw_vectors[] = {
+	{
+		0,
+		"000102030405060708090a0b0c0d0e0f",
+		"00112233445566778899aabbccddeeff",
+		"1fa68b0a8112b447aef34bd8fb5a7b829d3e862371d2cfe5"
+	},
+	{
+		0,
+		"000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f",
+		"00112233445566778899aabbccddeeff000102030405060708090a0b0c0d0e0f",
+		"28c9f404c4b810f4cbccb35cfb87f8263f5786e2d80ed326"
+		"cbc7f0e71a99f43bfb988b9b7a02dd21"
+	},
+	{
+		1,
+		"5840df6e29b02af1ab493b705bf16ea1ae8338f4dcc176a8",
+		"c37b7e6492584340bed12207808941155068f738",
+		"138bdeaa9b8fa7fc61f97742e72248ee5ae6ae5360d1ae6a5f54f373fa543b6a"
+	},
+	{
+		1,
+		"5840df6e29b02af1ab493b705bf16ea1ae8338f4dcc176a8",
+		"466f7250617369",
+		"afbeb0f07dfbf5419200f2ccb50bb24f"
+	},
+};
+
+#define KW_VECTOR_COUNT ( sizeof( kw_vectors ) / sizeof( kw_vectors[0] ) )
+
+/*
+ * Poly1305-AES test vectors of the Poly1305-AES paper, appendix B, the AES
+ * key, r, the nonce, the message and the tag, in hex
+ */
+typedef struct _poly1305_vector
+{
+	const char * k;
+	const char * r;
+	const char * nonce;
+	const char * m;
+	const char * tag;
+} poly1305_vector;
+
+static const poly1305_vector poly1305_vectors[] = {
+	{
+		"75deaa25c09f208e1dc4ce6b5cad3fbf",
+		"a0f3080000f46400d0c7e9076c834403",
+		"61ee09218d29b0aaed7e154a2c5509cc",
+		"",
+		"dd3fab2251f11ac759f0887129cc2ee7"
+	},
+	{
+		"ec074c835580741701425b623235add6",
+		"851fc40c3467ac0be05cc20404f3f700",
+		"fb447350c4e868c52ac3275cf9d4327e",
+		"f3f6",
+		"f4c633c3044fc145f84f335cb81953de"
+	},
+	{
+		"6acb5f61a7176dd320c5c1eb2edcdc74",
+		"48443d0bb0d21109c89a100b5ce2c208",
+		"ae212a55399729595dea458bc621ff0e",
+		"663cea190ffb83d89593f3f476b6bc24d7e679107ea26adb8caf6652d0656136",
+		"0ee1c16bb73f0f4fd19881753c01cdbe"
+	},
+};
+
+#define POLY1305_VECTOR_COUNT \
+	( sizeof( poly1305_vectors ) / sizeof( poly1305_vectors[0] ) )
+
+/*
+ * FF1 samples of NIST SP 800-38G, the key, the tweak in hex, the radix, and
+ * the plaintext and ciphertext numerals written as base 36 digits
+ */
+typedef struct _ff1_vector
+{
+	const char * k;
+	const char * tweak;
+	uint32_t radix;
+	const char * x;
+	const char * y;
+} ff1_vector;
+
+static const ff1_vector ff1_vectors[] = {
+	{
+		"2b7e151628aed2a6abf7158809cf4f3c", "", 10,
+		"0123456789", "2433477484"
+	},
+	{
+		"2b7e151628aed2a6abf7158809cf4f3c", "39383736353433323130", 10,
+		"0123456789", "6124200773"
+	},
+	{
+		"2b7e151628aed2a6abf7158809cf4f3c", "3737373770717273373737", 36,
+		"0123456789abcdefghi", "a9tv40mll9kdu509eum"
+	},
+	{
+		"2b7e151628aed2a6abf7158809cf4f3cef4359d8d580aa4f", "", 10,
+		"0123456789", "2830668132"
+	},
+	{
+		"2b7e151628aed2a6abf7158809cf4f3cef4359d8d580aa4f",
+		"39383736353433323130", 10,
+		"0123456789", "2496655549"
+	},
+	{
+		"2b7e151628aed2a6abf7158809cf4f3cef4359d8d580aa4f",
+		"3737373770717273373737", 36,
+		"0123456789abcdefghi", "xbj3kv35jrawxv32ysr"
+	},
+	{
+		"2b7e151628aed2a6abf7158809cf4f3cef4359d8d580aa4f7f036d6f04fc6a94",
+		"", 10,
+		"0123456789", "6657667009"
+	},
+	{
+		"2b7e151628aed2a6abf7158809cf4f3cef4359d8d580aa4f7f036d6f04fc6a94",
+		"39383736353433323130", 10,
+		"0123456789", "1001623463"
+	},
+	{
+		"2b7e151628aed2a6abf7158809cf4f3cef4359d8d580aa4f7f036d6f04fc6a94",
+		"3737373770717273373737", 36,
+		"0123456789abcdefghi", "xs8a0azh2avyalyzuwd"
+	},
+};
+
+#define FF1_VECTOR_COUNT ( sizeof( ff1_vectors ) / sizeof( ff1_vectors[0] ) )
+
+/*
+ * round hashes under the key 000102...0f of the first len bytes of the
+ * message 00 01 02 ..., worked out apart from the library, with the AES of
+ * OpenSSL and the round of FIPS-197
+ */
+typedef struct _round_hash_vector
+{
+	size_t len;
+	const char * hash;
+} round_hash_vector;
+
+static const round_hash_vector round_hash_vectors[] = {
+	{ 0, "c11770fabb8abf7142f855630012ad2c" },
+	{ 3, "ad3af132a6c879ad4e255eb5ce2ac987" },
+	{ 16, "e8a30631e4efc9a66b77922fc3f31449" },
+	{ 17, "0374294f1ffc75455585c19d02a94b0c" },
+	{ 64, "01da1ba4a44792258d3942a7f0a4c932" },
+	{ 100, "b90e42c2e74b54dced554cc5afeedb76" },
+	{ 300, "2988f30991af87dd624ef0ba541d03fa" },
+};
+
+#define ROUND_HASH_VECTOR_COUNT \
+	( sizeof( round_hash_vectors ) / sizeof( round_hash_vectors[0] ) )
+
+static size_t from_hex( const char * hex, uint8_t * buf )
+{
+	size_t _i, _len = strlen( hex ) / 2;
+	unsigned int _b;
+
+	for( _i = 0; _i < _len; _i++ )
+	{
+		sscanf( hex + 2 * _i, "%2x", &_b );
+		buf[_i] = (uint8_t) _b;
+	}
+
+	return _len;
+}
+
+// the numerals of a string of base 36 digits
+static size_t from_digits( const char * digits, uint16_t * buf )
+{
+	size_t _i, _len = strlen( digits );
+
+	for( _i = 0; _i < _len; _i++ )
+		buf[_i] = (uint16_t) ( digits[_i] <= '9' ?
+				digits[_i] - '0' : digits[_i] - 'a' + 10 );
+
+	return _len;
+}
+
+// sets the OAES_ENGINE environment variable to name, or clears it
+static void set_engine_env( const char * name )
+{
+#ifdef _WIN32
+	_putenv_s( "OAES_ENGINE", name ? name : "" );
+#else
+	if( name )
+		setenv( "OAES_ENGINE", name, 1 );
+	else
+		unsetenv( "OAES_ENGINE" );
+#endif
+}
+
+// 0 when OAES_OPTION_ENGINE binds the key to the engine it names, refuses a
+// name that is not compiled in or that the cpu cannot run, and without a
+// name takes the one in OAES_ENGINE, or else the fastest, and when
+// oaes_get_engine() reports the engine the key is bound to
+static int test_engine_select( OAES_CTX * ctx )
+{
+	uint8_t _key[16];
+	size_t _i;
+	const char * _name, * _first = NULL, * _last = NULL;
+	int _available;
+	OAES_CTX * _bare = NULL;
+
+	from_hex( STREAM_KEY, _key );
+	if( oaes_key_import_data( ctx, _key, sizeof( _key ) ) )
+		return 1;
+
+	for( _i = 0; OAES_RET_SUCCESS ==
+			oaes_get_engine_info( _i, &_name, NULL, &_available ); _i++ )
+	{
+		if( 0 == _available )
+		{
+			if( OAES_RET_ARG3 != oaes_set_option( ctx, OAES_OPTION_ENGINE, _name ) )
+			{
+				printf( "Error: Engine %s selected without cpu support.\n", _name );
+				return 1;
+			}
+			continue;
+		}
+
+		if( NULL == _first )
+			_first = _name;
+		_last = _name;
+		if( oaes_set_option( ctx, OAES_OPTION_ENGINE, _name ) ||
+				strcmp( oaes_get_engine( ctx ), _name ) )
+		{
+			printf( "Error: Key not bound to engine %s.\n", _name );
+			return 1;
+		}
+	}
+
+	// a name that is not there leaves the key where it is
+	if( OAES_RET_ARG3 != oaes_set_option( ctx, OAES_OPTION_ENGINE, "none" ) ||
+			strcmp( oaes_get_engine( ctx ), _last ) )
+	{
+		printf( "Error: Unknown engine not refused.\n" );
+		return 1;
+	}
+
+	// the environment is read each time the key is bound, not in between
+	set_engine_env( _last );
+	if( oaes_set_option( ctx, OAES_OPTION_ENGINE, NULL ) ||
+			strcmp( oaes_get_engine( ctx ), _last ) )
+	{
+		printf( "Error: OAES_ENGINE=%s not used.\n", _last );
+		return 1;
+	}
+	set_engine_env( _first );
+	if( strcmp( oaes_get_engine( ctx ), _last ) ||
+			oaes_set_option( ctx, OAES_OPTION_ENGINE, NULL ) ||
+			strcmp( oaes_get_engine( ctx ), _first ) )
+	{
+		printf( "Error: OAES_ENGINE=%s not used on rebinding.\n", _first );
+		return 1;
+	}
+
+	// a ctx without a key reports the engine a key would get
+	set_engine_env( _last );
+	if( NULL == ( _bare = oaes_alloc() ) )
+		return 1;
+	_name = oaes_get_engine( _bare );
+	oaes_free( &_bare );
+	if( strcmp( _name, _last ) )
+	{
+		printf( "Error: Engine without a key is %s, not %s.\n", _name, _last );
+		return 1;
+	}
+
+	// a name on the ctx wins over the environment, an unknown name in the
+	// environment falls back to the fastest engine
+	if( oaes_set_option( ctx, OAES_OPTION_ENGINE, _first ) ||
+			strcmp( oaes_get_engine( ctx ), _first ) )
+	{
+		printf( "Error: OAES_ENGINE=%s used over the option.\n", _last );
+		return 1;
+	}
+	set_engine_env( "none" );
+	if( oaes_set_option( ctx, OAES_OPTION_ENGINE, NULL ) ||
+			strcmp( oaes_get_engine( ctx ), _first ) )
+	{
+		printf( "Error: Unknown OAES_ENGINE not ignored.\n" );
+		return 1;
+	}
+
+	set_engine_env( NULL );
+
+	return 0;
+}
+
+// the numbers of blocks the multi-block kernels are run on, below, at and
+// past their 8 way interleave
+static const size_t block_counts[] = { 1, 7, 8, 9, 17 };
+
+// fills len bytes of buf with as many copies of the src_len bytes of src as
+// fit
+static void repeat( const uint8_t * src, size_t src_len,
+		uint8_t * buf, size_t len )
+{
+	size_t _i;
+
+	for( _i = 0; _i < len; _i++ )
+		buf[_i] = src[_i % src_len];
+}
+
+// 0 when ECB vector v, its blocks repeated to each of block_counts,
+// encrypts and decrypts as it should through oaes_encrypt_blocks() and
+// oaes_decrypt_blocks(), and as it is through oaes_encrypt() and
+// oaes_decrypt()
+static int test_ecb_vector( OAES_CTX * ctx, const ecb_vector * v )
+{
+	uint8_t _key[32], _p[64], _c[64], _iv[16];
+	uint8_t _buf[17 * 16], _exp[17 * 16];
+	size_t _i, _key_len, _p_len, _len;
+	uint8_t _pad;
+	OAES_RET _rc;
+
+	_key_len = from_hex( v->key, _key );
+	_p_len = from_hex( v->p, _p );
+	from_hex( v->c, _c );
+
+	if( oaes_key_import_data( ctx, _key, _key_len ) )
+	{
+		printf( "Error: Failed to import the key.\n" );
+		return 1;
+	}
+
+	for( _i = 0; _i < sizeof( block_counts ) / sizeof( block_counts[0] ); _i++ )
+	{
+		_len = 16 * block_counts[_i];
+		repeat( _p, _p_len, _buf, _len );
+		repeat( _c, _p_len, _exp, _len );
+		_rc = oaes_encrypt_blocks( ctx, _buf, _len );
+		if( OAES_RET_SUCCESS != _rc || memcmp( _buf, _exp, _len ) )
+		{
+			printf( "Error: %d blocks encrypt mismatch [%d].\n",
+					(int) block_counts[_i], _rc );
+			return 1;
+		}
+
+		repeat( _p, _p_len, _exp, _len );
+		_rc = oaes_decrypt_blocks( ctx, _buf, _len );
+		if( OAES_RET_SUCCESS != _rc || memcmp( _buf, _exp, _len ) )
+		{
+			printf( "Error: %d blocks decrypt mismatch [%d].\n",
+					(int) block_counts[_i], _rc );
+			return 1;
+		}
+	}
+
+	// a whole number of blocks is not padded
+	memset( _iv, 0, sizeof( _iv ) );
+	_len = sizeof( _buf );
+	if( oaes_set_option( ctx, OAES_OPTION_ECB, NULL ) ||
+			oaes_encrypt( ctx, _p, _p_len, _buf, &_len, _iv, &_pad ) ||
+			_p_len != _len || _pad || memcmp( _buf, _c, _p_len ) )
+	{
+		printf( "Error: Failed to encrypt in ECB mode.\n" );
+		return 1;
+	}
+
+	_len = sizeof( _exp );
+	if( oaes_decrypt( ctx, _c, _p_len, _exp, &_len, _iv, 0 ) ||
+			_p_len != _len || memcmp( _exp, _p, _p_len ) )
+	{
+		printf( "Error: Failed to decrypt in ECB mode.\n" );
+		return 1;
+	}
+
+	return 0;
+}
+
+// 0 when CBC vector v encrypts and decrypts as it should through
+// oaes_encrypt() and oaes_decrypt(), and leaves the iv on its last block,
+// and a 17 block message that starts with the vector's plaintext starts
+// with its ciphertext and decrypts back
+static int test_cbc_vector( OAES_CTX * ctx, const cbc_vector * v )
+{
+	uint8_t _key[32], _iv[16], _p[64], _c[64];
+	uint8_t _m[17 * 16], _buf[17 * 16], _out[17 * 16];
+	size_t _key_len, _len = sizeof( _buf );
+	uint8_t _pad;
+
+	_key_len = from_hex( v->key, _key );
+	from_hex( STREAM_P, _p );
+	from_hex( v->c, _c );
+
+	from_hex( STREAM_IV, _iv );
+	if( oaes_key_import_data( ctx, _key, _key_len ) ||
+			oaes_set_option( ctx, OAES_OPTION_CBC, _iv ) ||
+			oaes_encrypt( ctx, _p, sizeof( _p ), _buf, &_len, _iv, &_pad ) ||
+			sizeof( _c ) != _len || _pad || memcmp( _buf, _c, sizeof( _c ) ) ||
+			memcmp( _iv, _c + sizeof( _c ) - 16, sizeof( _iv ) ) )
+	{
+		printf( "Error: Failed to encrypt in CBC mode.\n" );
+		return 1;
+	}
+
+	from_hex( STREAM_IV, _iv );
+	_len = sizeof( _out );
+	if( oaes_decrypt( ctx, _c, sizeof( _c ), _out, &_len, _iv, 0 ) ||
+			sizeof( _p ) != _len || memcmp( _out, _p, sizeof( _p ) ) ||
+			memcmp( _iv, _c + sizeof( _c ) - 16, sizeof( _iv ) ) )
+	{
+		printf( "Error: Failed to decrypt in CBC mode.\n" );
+		return 1;
+	}
+
+	// decryption runs the multi-block kernel over the whole message
+	repeat( _p, sizeof( _p ), _m, sizeof( _m ) );
+	from_hex( STREAM_IV, _iv );
+	_len = sizeof( _buf );
+	if( oaes_encrypt( ctx, _m, sizeof( _m ), _buf, &_len, _iv, &_pad ) ||
+			memcmp( _buf, _c, sizeof( _c ) ) )
+	{
+		printf( "Error: Failed to encrypt 17 blocks in CBC mode.\n" );
+		return 1;
+	}
+
+	from_hex( STREAM_IV, _iv );
+	_len = sizeof( _out );
+	if( oaes_decrypt( ctx, _buf, sizeof( _buf ), _out, &_len, _iv, 0 ) ||
+			sizeof( _m ) != _len || memcmp( _out, _m, sizeof( _m ) ) )
+	{
+		printf( "Error: Failed to decrypt 17 blocks in CBC mode.\n" );
+		return 1;
+	}
+
+	return 0;
+}
+
+#if OAES_STEP_TRACE
+// what step_cb() has seen since step_reset()
+static int step_calls;
+static const char * step_last_name;
+static uint8_t step_last[16];
+
+static void step_reset( void )
+{
+	step_calls = 0;
+	step_last_name = "";
+	memset( step_last, 0, sizeof( step_last ) );
+}
+
+static int step_cb(
+		const uint8_t state[OAES_BLOCK_SIZE],
+		const char * step_name,
+		int step_count,
+		void * user_data )
+{
+	step_calls++;
+	step_last_name = step_name;
+	memcpy( step_last, state, sizeof( step_last ) );
+
+	return 0;
+}
+
+// 0 when the FIPS-197 AES-128 and AES-256 vectors, run over 3 blocks with a
+// step callback installed, come out as they should, with 5 * Nr + 2 calls
+// for each block and the last state the result, and when the callback is
+// no longer called once stepping is off
+static int test_step_trace( OAES_CTX * ctx )
+{
+	static const size_t _vectors[] = { 0, 2 };
+	uint8_t _key[32], _p[16], _c[16], _buf[3 * 16], _exp[3 * 16];
+	size_t _i, _key_len, _nr;
+	const ecb_vector * _v;
+
+	for( _i = 0; _i < sizeof( _vectors ) / sizeof( _vectors[0] ); _i++ )
+	{
+		_v = ecb_vectors + _vectors[_i];
+		_key_len = from_hex( _v->key, _key );
+		from_hex( _v->p, _p );
+		from_hex( _v->c, _c );
+		_nr = _key_len / 4 + 6;
+
+		if( oaes_key_import_data( ctx, _key, _key_len ) ||
+				oaes_set_option( ctx, OAES_OPTION_STEP_ON, step_cb ) )
+		{
+			printf( "Error: Failed to turn stepping on.\n" );
+			return 1;
+		}
+
+		step_reset();
+		repeat( _p, sizeof( _p ), _buf, sizeof( _buf ) );
+		repeat( _c, sizeof( _c ), _exp, sizeof( _exp ) );
+		if( oaes_encrypt_blocks( ctx, _buf, sizeof( _buf ) ) ||
+				memcmp( _buf, _exp, sizeof( _exp ) ) ||
+				3 * ( 5 * _nr + 2 ) != (size_t) step_calls ||
+				strcmp( step_last_name, "output" ) ||
+				memcmp( step_last, _c, sizeof( _c ) ) )
+		{
+			printf( "Error: %d bit encryption stepped %d times to %s.\n",
+					(int) _key_len * 8, step_calls, step_last_name );
+			return 1;
+		}
+
+		step_reset();
+		if( oaes_decrypt_blocks( ctx, _buf, sizeof( _buf ) ) ||
+				3 * ( 5 * _nr + 2 ) != (size_t) step_calls ||
+				strcmp( step_last_name, "ioutput" ) ||
+				memcmp( step_last, _p, sizeof( _p ) ) )
+		{
+			printf( "Error: %d bit decryption stepped %d times to %s.\n",
+					(int) _key_len * 8, step_calls, step_last_name );
+			return 1;
+		}
+
+		step_reset();
+		if( oaes_set_option( ctx, OAES_OPTION_STEP_OFF, NULL ) ||
+				oaes_encrypt_blocks( ctx, _buf, sizeof( _buf ) ) ||
+				memcmp( _buf, _exp, sizeof( _exp ) ) || step_calls )
+		{
+			printf( "Error: Stepped %d times with stepping off.\n",
+					step_calls );
+			return 1;
+		}
+	}
+
+	return 0;
+}
+#endif // OAES_STEP_TRACE
+
+// 0 when XTS vector v encrypts and decrypts as it should
+static int test_xts_vector( OAES_CTX * ctx, const xts_vector * v )
+{
+	uint8_t _key[64], _p[32], _c[32], _out[32];
+	size_t _key_len = from_hex( v->key, _key );
+	size_t _len = from_hex( v->p, _p );
+	OAES_RET _rc;
+
+	from_hex( v->c, _c );
+
+	if( OAES_RET_SUCCESS !=
+			( _rc = oaes_xts_key_import_data( ctx, _key, _key_len ) ) )
+	{
+		printf( "Error: Failed to import key [%d].\n", _rc );
+		return 1;
+	}
+
+	if( OAES_RET_SUCCESS != ( _rc = oaes_xts_encrypt( ctx, v->sector, _len,
+			_p, _len, _out ) ) || memcmp( _out, _c, _len ) )
+	{
+		printf( "Error: Failed to encrypt [%d].\n", _rc );
+		return 1;
+	}
+
+	if( OAES_RET_SUCCESS != ( _rc = oaes_xts_decrypt( ctx, v->sector, _len,
+			_c, _len, _out ) ) || memcmp( _out, _p, _len ) )
+	{
+		printf( "Error: Failed to decrypt [%d].\n", _rc );
+		return 1;
+	}
+
+	return 0;
+}
+
+// 0 when a run of sectors in one call matches the sectors one at a time,
+// with a sector length that takes ciphertext stealing
+static int test_xts_run( OAES_CTX * ctx )
+{
+	size_t _i;
+	uint8_t _key[32], _run[40 * 520], _one[40 * 520];
+
+	for( _i = 0; _i < sizeof( _key ); _i++ )
+		_key[_i] = (uint8_t) ( 3 * _i );
+	for( _i = 0; _i < sizeof( _run ); _i++ )
+		_run[_i] = _one[_i] = (uint8_t) _i;
+
+	if( oaes_xts_key_import_data( ctx, _key, sizeof( _key ) ) ||
+			oaes_xts_encrypt( ctx, 1000, 520, _run, sizeof( _run ), _run ) )
+	{
+		printf( "Error: Failed to encrypt the run.\n" );
+		return 1;
+	}
+
+	for( _i = 0; _i < 40; _i++ )
+		if( oaes_xts_encrypt( ctx, 1000 + _i, 520,
+				_one + _i * 520, 520, _one + _i * 520 ) )
+		{
+			printf( "Error: Failed to encrypt sector %d.\n", (int) _i );
+			return 1;
+		}
+
+	if( memcmp( _run, _one, sizeof( _run ) ) )
+	{
+		printf( "Error: Run and single sectors differ.\n" );
+		return 1;
+	}
+
+	if( oaes_xts_decrypt( ctx, 1000, 520, _run, sizeof( _run ), _run ) )
+	{
+		printf( "Error: Failed to decrypt the run.\n" );
+		return 1;
+	}
+
+	for( _i = 0; _i < sizeof( _run ); _i++ )
+		if( _run[_i] != (uint8_t) _i )
+		{
+			printf( "Error: Run round trip mismatch.\n" );
+			return 1;
+		}
+
+	return 0;
+}
+
+// 0 when OCB vector v encrypts, decrypts and rejects a bad tag as it
+// should, and a message long enough for the runs of 8 blocks goes through
+// in place
+static int test_ocb_vector( OAES_CTX * ctx, const aead_vector * v )
+{
+	size_t _i;
+	uint8_t _key[32], _nonce[15], _aad[64], _p[64], _c[64], _tag[16];
+	uint8_t _out[64], _out_tag[16], _long[1000];
+	size_t _key_len = from_hex( v->key, _key );
+	size_t _nonce_len = from_hex( v->nonce, _nonce );
+	size_t _aad_len = from_hex( v->aad, _aad );
+	size_t _len = from_hex( v->p, _p );
+	size_t _tag_len = from_hex( v->tag, _tag );
+	OAES_RET _rc;
+
+	from_hex( v->c, _c );
+
+	if( OAES_RET_SUCCESS != ( _rc = oaes_key_import_data( ctx, _key, _key_len ) ) )
+	{
+		printf( "Error: Failed to import key [%d].\n", _rc );
+		return 1;
+	}
+
+	if( OAES_RET_SUCCESS != ( _rc = oaes_ocb_encrypt( ctx, _nonce, _nonce_len,
+			_aad, _aad_len, _p, _len, _out, _out_tag, _tag_len ) ) )
+	{
+		printf( "Error: Failed to encrypt [%d].\n", _rc );
+		return 1;
+	}
+
+	if( memcmp( _out, _c, _len ) || memcmp( _out_tag, _tag, _tag_len ) )
+	{
+		printf( "Error: Ciphertext or tag mismatch.\n" );
+		return 1;
+	}
+
+	if( OAES_RET_SUCCESS != ( _rc = oaes_ocb_decrypt( ctx, _nonce, _nonce_len,
+			_aad, _aad_len, _c, _len, _out, _tag, _tag_len ) ) ||
+			memcmp( _out, _p, _len ) )
+	{
+		printf( "Error: Failed to decrypt [%d].\n", _rc );
+		return 1;
+	}
+
+	_tag[0] ^= 0x01;
+	if( OAES_RET_AUTH != oaes_ocb_decrypt( ctx, _nonce, _nonce_len,
+			_aad, _aad_len, _c, _len, _out, _tag, _tag_len ) )
+	{
+		printf( "Error: Bad tag accepted.\n" );
+		return 1;
+	}
+
+	for( _i = 0; _i < sizeof( _long ); _i++ )
+		_long[_i] = (uint8_t) _i;
+
+	if( oaes_ocb_encrypt( ctx, _nonce, _nonce_len, _aad, _aad_len,
+			_long, sizeof( _long ), _long, _out_tag, _tag_len ) ||
+			oaes_ocb_decrypt( ctx, _nonce, _nonce_len, _aad, _aad_len,
+			_long, sizeof( _long ), _long, _out_tag, _tag_len ) )
+	{
+		printf( "Error: Long message round trip failed.\n" );
+		return 1;
+	}
+
+	for( _i = 0; _i < sizeof( _long ); _i++ )
+		if( _long[_i] != (uint8_t) _i )
+		{
+			printf( "Error: Long message mismatch.\n" );
+			return 1;
+		}
+
+	return 0;
+}
+
+// 0 when CCM vector v encrypts and decrypts as it should, both in one go
+// and a byte at a time, and a bad tag is rejected
+static int test_ccm_vector( OAES_CTX * ctx, const aead_vector * v, int long_aad )
+{
+	size_t _i;
+	static uint8_t _aad[CCM_LONG_AAD_LEN];
+	uint8_t _key[32], _nonce[13], _p[64], _c[64], _tag[16];
+	uint8_t _out[64], _out_tag[16];
+	size_t _key_len = from_hex( v->key, _key );
+	size_t _nonce_len = from_hex( v->nonce, _nonce );
+	size_t _aad_len = from_hex( v->aad, _aad );
+	size_t _len = from_hex( v->p, _p );
+	size_t _tag_len = from_hex( v->tag, _tag );
+	OAES_RET _rc;
+
+	from_hex( v->c, _c );
+
+	if( long_aad )
+	{
+		for( _i = 0; _i < CCM_LONG_AAD_LEN; _i++ )
+			_aad[_i] = (uint8_t) _i;
+		_aad_len = CCM_LONG_AAD_LEN;
+	}
+
+	if( OAES_RET_SUCCESS != ( _rc = oaes_key_import_data( ctx, _key, _key_len ) ) )
+	{
+		printf( "Error: Failed to import key [%d].\n", _rc );
+		return 1;
+	}
+
+	if( OAES_RET_SUCCESS != ( _rc = oaes_ccm_encrypt( ctx, _nonce, _nonce_len,
+			_aad, _aad_len, _p, _len, _out, _out_tag, _tag_len ) ) )
+	{
+		printf( "Error: Failed to encrypt [%d].\n", _rc );
+		return 1;
+	}
+
+	if( memcmp( _out, _c, _len ) || memcmp( _out_tag, _tag, _tag_len ) )
+	{
+		printf( "Error: Ciphertext or tag mismatch.\n" );
+		return 1;
+	}
+
+	if( OAES_RET_SUCCESS != ( _rc = oaes_ccm_decrypt( ctx, _nonce, _nonce_len,
+			_aad, _aad_len, _c, _len, _out, _tag, _tag_len ) ) ||
+			memcmp( _out, _p, _len ) )
+	{
+		printf( "Error: Failed to decrypt [%d].\n", _rc );
+		return 1;
+	}
+
+	// a byte at a time, the keystream and the CBC-MAC carry over
+	memset( _out_tag, 0, sizeof( _out_tag ) );
+	_rc = oaes_ccm_start( ctx, _nonce, _nonce_len, _aad, _aad_len,
+			_len, _tag_len );
+	for( _i = 0; _i < _len && OAES_RET_SUCCESS == _rc; _i++ )
+		_rc = oaes_ccm_encrypt_update( ctx, _p + _i, 1, _out + _i );
+	if( OAES_RET_SUCCESS == _rc )
+		_rc = oaes_ccm_encrypt_final( ctx, _out_tag );
+
+	if( OAES_RET_SUCCESS != _rc || memcmp( _out, _c, _len ) ||
+			memcmp( _out_tag, _tag, _tag_len ) )
+	{
+		printf( "Error: Failed to encrypt in pieces [%d].\n", _rc );
+		return 1;
+	}
+
+	_rc = oaes_ccm_start( ctx, _nonce, _nonce_len, _aad, _aad_len,
+			_len, _tag_len );
+	for( _i = 0; _i < _len && OAES_RET_SUCCESS == _rc; _i++ )
+		_rc = oaes_ccm_decrypt_update( ctx, _c + _i, 1, _out + _i );
+	if( OAES_RET_SUCCESS == _rc )
+		_rc = oaes_ccm_decrypt_final( ctx, _tag );
+
+	if( OAES_RET_SUCCESS != _rc || memcmp( _out, _p, _len ) )
+	{
+		printf( "Error: Failed to decrypt in pieces [%d].\n", _rc );
+		return 1;
+	}
+
+	_tag[0] ^= 0x01;
+	if( OAES_RET_AUTH != oaes_ccm_decrypt( ctx, _nonce, _nonce_len,
+			_aad, _aad_len, _c, _len, _out, _tag, _tag_len ) )
+	{
+		printf( "Error: Bad tag accepted.\n" );
+		return 1;
+	}
+
+	return 0;
+}
+
+static OAES_RET stream_start( OAES_CTX * ctx, const stream_vector * v,
+		const uint8_t * iv )
+{
+	if( v->segment_bits )
+		return oaes_cfb_start( ctx, iv, v->segment_bits );
+	return oaes_ofb_start( ctx, iv );
+}
+
+static OAES_RET stream_crypt( OAES_CTX * ctx, const stream_vector * v,
+		int encrypt, const uint8_t * in, size_t len, uint8_t * out )
+{
+	if( 0 == v->segment_bits )
+		return oaes_ofb_crypt( ctx, in, len, out );
+	if( encrypt )
+		return oaes_cfb_encrypt( ctx, in, len, out );
+	return oaes_cfb_decrypt( ctx, in, len, out );
+}
+
+// 0 when stream vector v encrypts and decrypts as it should, in one call
+// and in pieces that start and end mid-block
+static int test_stream_vector( OAES_CTX * ctx, const stream_vector * v )
+{
+	static const size_t _pieces[] = { 1, 5, 16, 3, 33, 6 };
+	uint8_t _key[16], _iv[16], _p[64], _c[64], _out[64];
+	size_t _i, _j, _off, _len;
+	int _encrypt;
+
+	from_hex( STREAM_KEY, _key );
+	from_hex( STREAM_IV, _iv );
+	from_hex( STREAM_P, _p );
+	from_hex( v->c, _c );
+
+	if( OAES_RET_SUCCESS != oaes_key_import_data( ctx, _key, sizeof( _key ) ) )
+	{
+		printf( "Error: Failed to import key.\n" );
+		return 1;
+	}
+
+	for( _encrypt = 1; _encrypt >= 0; _encrypt-- )
+	{
+		const uint8_t * _in = _encrypt ? _p : _c;
+		const uint8_t * _expect = _encrypt ? _c : _p;
+
+		if( stream_start( ctx, v, _iv ) ||
+				stream_crypt( ctx, v, _encrypt, _in, sizeof( _p ), _out ) ||
+				memcmp( _out, _expect, sizeof( _out ) ) )
+		{
+			printf( "Error: Failed to %s in one call.\n",
+					_encrypt ? "encrypt" : "decrypt" );
+			return 1;
+		}
+
+		memset( _out, 0, sizeof( _out ) );
+		if( stream_start( ctx, v, _iv ) )
+			return 1;
+		for( _i = 0, _off = 0; _off < sizeof( _p ); _i++, _off += _len )
+		{
+			_j = _i % ( sizeof( _pieces ) / sizeof( _pieces[0] ) );
+			_len = _pieces[_j] < sizeof( _p ) - _off ?
+					_pieces[_j] : sizeof( _p ) - _off;
+			if( stream_crypt( ctx, v, _encrypt, _in + _off, _len, _out + _off ) )
+				return 1;
+		}
+		if( memcmp( _out, _expect, sizeof( _out ) ) )
+		{
+			printf( "Error: Failed to %s in pieces.\n",
+					_encrypt ? "encrypt" : "decrypt" );
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+// 0 when the CTR vectors encrypt and decrypt as they should, and leave the
+// counter block on the one after the last
+static int test_ctr_vector( OAES_CTX * ctx )
+{
+	static const size_t _width = 128;
+	uint8_t _key[16], _iv[16], _next[16], _p[64], _c[64], _out[64];
+	size_t _len = sizeof( _out );
+	uint8_t _pad;
+
+	from_hex( STREAM_KEY, _key );
+	from_hex( CTR_IV_NEXT, _next );
+	from_hex( STREAM_P, _p );
+	from_hex( CTR_C, _c );
+
+	if( oaes_key_import_data( ctx, _key, sizeof( _key ) ) ||
+			oaes_set_option( ctx, OAES_OPTION_CTR, NULL ) ||
+			oaes_set_option( ctx, OAES_OPTION_CTR_WIDTH, &_width ) )
+	{
+		printf( "Error: Failed to set up CTR.\n" );
+		return 1;
+	}
+
+	from_hex( CTR_IV, _iv );
+	if( oaes_encrypt( ctx, _p, sizeof( _p ), _out, &_len, _iv, &_pad ) ||
+			sizeof( _c ) != _len || memcmp( _out, _c, sizeof( _c ) ) ||
+			memcmp( _iv, _next, sizeof( _iv ) ) )
+	{
+		printf( "Error: Failed to encrypt F.5.1.\n" );
+		return 1;
+	}
+
+	from_hex( CTR_IV, _iv );
+	_len = sizeof( _out );
+	if( oaes_decrypt( ctx, _c, sizeof( _c ), _out, &_len, _iv, 0 ) ||
+			sizeof( _p ) != _len || memcmp( _out, _p, sizeof( _p ) ) ||
+			memcmp( _iv, _next, sizeof( _iv ) ) )
+	{
+		printf( "Error: Failed to decrypt F.5.2.\n" );
+		return 1;
+	}
+
+	return 0;
+}
+
+// 0 when an 8 bit counter wraps around without touching the nonce above
+// it, and one call that needs more blocks than it has values is refused
+static int test_ctr_width( OAES_CTX * ctx )
+{
+	static const size_t _width = 8, _full = 128;
+	uint8_t _key[16], _iv[16], _ks[3 * 16], _out[257 * 16];
+	size_t _i, _len;
+	uint8_t _pad;
+	OAES_RET _rc;
+
+	from_hex( STREAM_KEY, _key );
+	if( oaes_key_import_data( ctx, _key, sizeof( _key ) ) ||
+			oaes_set_option( ctx, OAES_OPTION_CTR, NULL ) ||
+			oaes_set_option( ctx, OAES_OPTION_CTR_WIDTH, &_width ) )
+	{
+		printf( "Error: Failed to set up CTR.\n" );
+		return 1;
+	}
+
+	// the counter blocks ..abfe, ..abff and ..ab00, enciphered on their own
+	for( _i = 0; _i < 3; _i++ )
+	{
+		memset( _ks + 16 * _i, 0x5a, 14 );
+		_ks[16 * _i + 14] = 0xab;
+		_ks[16 * _i + 15] = (uint8_t) ( 0xfe + _i );
+	}
+	if( oaes_encrypt_blocks( ctx, _ks, sizeof( _ks ) ) )
+		return 1;
+
+	memset( _iv, 0x5a, 14 );
+	_iv[14] = 0xab;
+	_iv[15] = 0xfe;
+	memset( _out, 0, sizeof( _ks ) );
+	_len = sizeof( _ks );
+	if( oaes_encrypt( ctx, _out, sizeof( _ks ), _out, &_len, _iv, &_pad ) ||
+			memcmp( _out, _ks, sizeof( _ks ) ) ||
+			0x5a != _iv[13] || 0xab != _iv[14] || 0x01 != _iv[15] )
+	{
+		printf( "Error: Failed to wrap the counter.\n" );
+		return 1;
+	}
+
+	// 256 blocks are all the counter has, 257 would repeat the first
+	memset( _out, 0, sizeof( _out ) );
+	_len = 256 * 16;
+	_rc = oaes_encrypt( ctx, _out, _len, _out, &_len, _iv, &_pad );
+	if( OAES_RET_SUCCESS != _rc )
+	{
+		printf( "Error: Failed to encrypt all counter values [%d].\n", _rc );
+		return 1;
+	}
+	_len = sizeof( _out );
+	_rc = oaes_encrypt( ctx, _out, sizeof( _out ), _out, &_len, _iv, &_pad );
+	if( OAES_RET_ARG3 != _rc )
+	{
+		printf( "Error: Counter reuse not refused [%d].\n", _rc );
+		return 1;
+	}
+
+	return oaes_set_option( ctx, OAES_OPTION_CTR_WIDTH, &_full ) ? 1 : 0;
+}
+
+// 0 when ranges that start and end mid-block, or are empty, come out as
+// the same bytes of one CTR pass from the start, and a range past the end
+// of an 8 bit counter is refused
+static int test_ctr_crypt_at( OAES_CTX * ctx )
+{
+	static const size_t _ranges[][2] = {
+		{ 0, 200 }, { 7, 30 }, { 5, 1 }, { 16, 16 }, { 31, 50 },
+		{ 17, 183 }, { 199, 1 }, { 3, 0 },
+	};
+	static const size_t _width = 8, _full = 128;
+	uint8_t _key[16], _nonce[16], _iv[16], _m[200], _c[200], _out[200];
+	size_t _i, _off, _len;
+	uint8_t _pad;
+	OAES_RET _rc;
+
+	from_hex( STREAM_KEY, _key );
+	from_hex( CTR_IV, _nonce );
+	for( _i = 0; _i < sizeof( _m ); _i++ )
+		_m[_i] = (uint8_t) ( 3 * _i + 1 );
+
+	memcpy( _iv, _nonce, sizeof( _iv ) );
+	_len = sizeof( _c );
+	if( oaes_key_import_data( ctx, _key, sizeof( _key ) ) ||
+			oaes_set_option( ctx, OAES_OPTION_CTR, NULL ) ||
+			oaes_encrypt( ctx, _m, sizeof( _m ), _c, &_len, _iv, &_pad ) )
+	{
+		printf( "Error: Failed to encrypt in one pass.\n" );
+		return 1;
+	}
+
+	for( _i = 0; _i < sizeof( _ranges ) / sizeof( _ranges[0] ); _i++ )
+	{
+		_off = _ranges[_i][0];
+		_len = _ranges[_i][1];
+		memset( _out, 0xee, sizeof( _out ) );
+		_rc = oaes_ctr_crypt_at( ctx, _nonce, _off, _m + _off, _len, _out );
+		if( OAES_RET_SUCCESS != _rc || memcmp( _out, _c + _off, _len ) ||
+				( _len < sizeof( _out ) && 0xee != _out[_len] ) )
+		{
+			printf( "Error: Range %d at %d mismatch [%d].\n", (int) _len,
+					(int) _off, _rc );
+			return 1;
+		}
+
+		// in place, and back
+		memcpy( _out, _c + _off, _len );
+		if( oaes_ctr_crypt_at( ctx, _nonce, _off, _out, _len, _out ) ||
+				memcmp( _out, _m + _off, _len ) )
+		{
+			printf( "Error: Range %d at %d not decrypted in place.\n",
+					(int) _len, (int) _off );
+			return 1;
+		}
+	}
+
+	// 256 blocks of 8 bit counter end at byte 4096
+	if( oaes_set_option( ctx, OAES_OPTION_CTR_WIDTH, &_width ) )
+		return 1;
+	_rc = oaes_ctr_crypt_at( ctx, _nonce, 4090, _m, 6, _out );
+	if( OAES_RET_SUCCESS != _rc )
+	{
+		printf( "Error: Failed to reach the end of the counter [%d].\n", _rc );
+		return 1;
+	}
+	if( OAES_RET_ARG3 != oaes_ctr_crypt_at( ctx, _nonce, 4090, _m, 7, _out ) ||
+			OAES_RET_ARG3 != oaes_ctr_crypt_at( ctx, _nonce, 4000, _m, 200,
+					_out ) )
+	{
+		printf( "Error: Range past the counter not refused.\n" );
+		return 1;
+	}
+
+	return oaes_set_option( ctx, OAES_OPTION_CTR_WIDTH, &_full ) ? 1 : 0;
+}
+
+// CTR encrypts blocks blocks of m from counter block iv, and checks them
+// against c and the hits and misses that the prefetch buffer counts
+static int ctr_prefetch_crypt( OAES_CTX * ctx, const uint8_t * m,
+		const uint8_t * c, size_t blocks, uint8_t iv[16],
+		uint64_t hits, uint64_t misses )
+{
+	uint8_t _out[16 * 16];
+	uint64_t _hits0, _misses0, _hits, _misses;
+	size_t _len = sizeof( _out );
+	uint8_t _pad;
+
+	if( oaes_ctr_prefetch_stats( ctx, &_hits0, &_misses0 ) ||
+			oaes_encrypt( ctx, m, 16 * blocks, _out, &_len, iv, &_pad ) ||
+			oaes_ctr_prefetch_stats( ctx, &_hits, &_misses ) )
+		return 1;
+
+	if( memcmp( _out, c, 16 * blocks ) )
+	{
+		printf( "Error: Prefetched keystream mismatch.\n" );
+		return 1;
+	}
+
+	if( _hits - _hits0 != hits || _misses - _misses0 != misses )
+	{
+		printf( "Error: %d hits and %d misses, %d and %d expected.\n",
+				(int) ( _hits - _hits0 ), (int) ( _misses - _misses0 ),
+				(int) hits, (int) misses );
+		return 1;
+	}
+
+	return 0;
+}
+
+// 0 when prefetched keystream is used for a message inside the buffer and
+// one past it, what is left is used by the next call, and a change of
+// counter, key or counter width drops it
+static int test_ctr_prefetch( OAES_CTX * ctx )
+{
+	static const size_t _depth = 8, _none = 0, _width = 128;
+	uint8_t _key[16], _nonce[16], _iv[16], _other[16];
+	uint8_t _m[16 * 16], _c[16 * 16];
+	size_t _i, _len = sizeof( _c );
+	uint8_t _pad;
+
+	from_hex( STREAM_KEY, _key );
+	from_hex( CTR_IV, _nonce );
+	for( _i = 0; _i < sizeof( _m ); _i++ )
+		_m[_i] = (uint8_t) ( 7 * _i );
+	memset( _other, 0x33, sizeof( _other ) );
+
+	memcpy( _iv, _nonce, sizeof( _iv ) );
+	if( oaes_key_import_data( ctx, _key, sizeof( _key ) ) ||
+			oaes_set_option( ctx, OAES_OPTION_CTR, NULL ) ||
+			oaes_set_option( ctx, OAES_OPTION_CTR_PREFETCH, &_none ) ||
+			oaes_encrypt( ctx, _m, sizeof( _m ), _c, &_len, _iv, &_pad ) )
+	{
+		printf( "Error: Failed to encrypt without a buffer.\n" );
+		return 1;
+	}
+
+	// no buffer, nothing is counted
+	memcpy( _iv, _nonce, sizeof( _iv ) );
+	if( ctr_prefetch_crypt( ctx, _m, _c, 16, _iv, 0, 0 ) )
+		return 1;
+
+	if( oaes_set_option( ctx, OAES_OPTION_CTR_PREFETCH, &_depth ) )
+		return 1;
+
+	// 5 of the 8 blocks, the next call takes 2 of the 3 left, the one
+	// after that the last and 3 more
+	memcpy( _iv, _nonce, sizeof( _iv ) );
+	if( oaes_ctr_prefetch( ctx, _iv ) ||
+			ctr_prefetch_crypt( ctx, _m, _c, 5, _iv, 5, 0 ) ||
+			ctr_prefetch_crypt( ctx, _m + 16 * 5, _c + 16 * 5, 2, _iv, 2, 0 ) ||
+			ctr_prefetch_crypt( ctx, _m + 16 * 7, _c + 16 * 7, 4, _iv, 1, 3 ) )
+	{
+		printf( "Error: Failed to use the buffer.\n" );
+		return 1;
+	}
+
+	// a whole message past the buffer
+	memcpy( _iv, _nonce, sizeof( _iv ) );
+	if( oaes_ctr_prefetch( ctx, _iv ) ||
+			ctr_prefetch_crypt( ctx, _m, _c, 12, _iv, 8, 4 ) )
+	{
+		printf( "Error: Failed to run past the buffer.\n" );
+		return 1;
+	}
+
+	// leftovers topped up by the next prefetch
+	memcpy( _iv, _nonce, sizeof( _iv ) );
+	if( oaes_ctr_prefetch( ctx, _iv ) ||
+			ctr_prefetch_crypt( ctx, _m, _c, 3, _iv, 3, 0 ) ||
+			oaes_ctr_prefetch( ctx, _iv ) ||
+			ctr_prefetch_crypt( ctx, _m + 16 * 3, _c + 16 * 3, 9, _iv, 8, 1 ) )
+	{
+		printf( "Error: Failed to top up the buffer.\n" );
+		return 1;
+	}
+
+	// another counter, in the call or in the next prefetch
+	memcpy( _iv, _nonce, sizeof( _iv ) );
+	if( oaes_ctr_prefetch( ctx, _other ) ||
+			ctr_prefetch_crypt( ctx, _m, _c, 2, _iv, 0, 2 ) ||
+			oaes_ctr_prefetch( ctx, _nonce ) ||
+			oaes_ctr_prefetch( ctx, _other ) )
+		return 1;
+	memcpy( _iv, _nonce, sizeof( _iv ) );
+	if( ctr_prefetch_crypt( ctx, _m, _c, 2, _iv, 0, 2 ) )
+	{
+		printf( "Error: Keystream of another counter used.\n" );
+		return 1;
+	}
+
+	// the key, even the same one again, and the counter width
+	memcpy( _iv, _nonce, sizeof( _iv ) );
+	if( oaes_ctr_prefetch( ctx, _nonce ) ||
+			oaes_key_import_data( ctx, _key, sizeof( _key ) ) ||
+			ctr_prefetch_crypt( ctx, _m, _c, 2, _iv, 0, 2 ) )
+	{
+		printf( "Error: Keystream kept across a key change.\n" );
+		return 1;
+	}
+	memcpy( _iv, _nonce, sizeof( _iv ) );
+	if( oaes_ctr_prefetch( ctx, _nonce ) ||
+			oaes_set_option( ctx, OAES_OPTION_CTR_WIDTH, &_width ) ||
+			ctr_prefetch_crypt( ctx, _m, _c, 2, _iv, 0, 2 ) )
+	{
+		printf( "Error: Keystream kept across a counter width change.\n" );
+		return 1;
+	}
+
+	return oaes_set_option( ctx, OAES_OPTION_CTR_PREFETCH, &_none ) ? 1 : 0;
+}
+
+// 0 when CBC-CS3 vector v encrypts and decrypts as it should, the
+// decryption in place
+static int test_cts_vector( OAES_CTX * ctx, const cts_vector * v )
+{
+	uint8_t _iv[OAES_BLOCK_SIZE] = { 0 };
+	uint8_t _c[64], _out[64];
+
+	from_hex( v->c, _c );
+
+	if( OAES_RET_SUCCESS != oaes_key_import_data( ctx,
+			(const uint8_t *) CTS_KEY, strlen( CTS_KEY ) ) )
+	{
+		printf( "Error: Failed to import key.\n" );
+		return 1;
+	}
+
+	if( oaes_cbc_cs3_encrypt( ctx, _iv, (const uint8_t *) CTS_P, v->len, _out ) ||
+			memcmp( _out, _c, v->len ) )
+	{
+		printf( "Error: Failed to encrypt.\n" );
+		return 1;
+	}
+
+	if( oaes_cbc_cs3_decrypt( ctx, _iv, _out, v->len, _out ) ||
+			memcmp( _out, CTS_P, v->len ) )
+	{
+		printf( "Error: Failed to decrypt.\n" );
+		return 1;
+	}
+
+	return 0;
+}
+
+// 0 when CMAC vector v gives its tag
+static int test_cmac_vector( OAES_CTX * ctx, const cmac_vector * v )
+{
+	uint8_t _key[16], _p[64], _tag[OAES_BLOCK_SIZE], _out[OAES_BLOCK_SIZE];
+
+	from_hex( STREAM_KEY, _key );
+	from_hex( STREAM_P, _p );
+	from_hex( v->tag, _tag );
+
+	if( OAES_RET_SUCCESS != oaes_key_import_data( ctx, _key, sizeof( _key ) ) )
+	{
+		printf( "Error: Failed to import key.\n" );
+		return 1;
+	}
+
+	if( oaes_cmac( ctx, _p, v->len, _out ) ||
+			memcmp( _out, _tag, OAES_BLOCK_SIZE ) )
+	{
+		printf( "Error: Tag mismatch.\n" );
+		return 1;
+	}
+
+	return 0;
+}
+
+// 0 when a batch of messages of mixed lengths, more than there are lanes,
+// gives the same tags as one message at a time
+static int test_cmac_batch( OAES_CTX * ctx )
+{
+	size_t _i, _len[21];
+	const uint8_t * _m[21];
+	uint8_t _key[16], _buf[512];
+	uint8_t _tags[21 * OAES_BLOCK_SIZE], _tag[OAES_BLOCK_SIZE];
+
+	for( _i = 0; _i < sizeof( _key ); _i++ )
+		_key[_i] = (uint8_t) ( 5 * _i );
+	for( _i = 0; _i < sizeof( _buf ); _i++ )
+		_buf[_i] = (uint8_t) _i;
+	for( _i = 0; _i < 21; _i++ )
+	{
+		_m[_i] = _buf + _i;
+		_len[_i] = ( _i * 37 ) % 200;
+	}
+
+	if( oaes_key_import_data( ctx, _key, sizeof( _key ) ) ||
+			oaes_cmac_batch( ctx, _m, _len, 21, _tags ) )
+	{
+		printf( "Error: Failed to run the batch.\n" );
+		return 1;
+	}
+
+	for( _i = 0; _i < 21; _i++ )
+		if( oaes_cmac( ctx, _m[_i], _len[_i], _tag ) ||
+				memcmp( _tag, _tags + _i * OAES_BLOCK_SIZE, OAES_BLOCK_SIZE ) )
+		{
+			printf( "Error: Batch tag %d mismatch.\n", (int) _i );
+			return 1;
+		}
+
+	return 0;
+}
+
+// 0 when key wrap vector v wraps, unwraps, and fails to unwrap once
+// tampered with, as it should
+static int test_kw_vector( OAES_CTX * ctx, const kw_vector * v )
+{
+	uint8_t _kek[32], _key[32], _c[40], _out[40];
+	size_t _kek_len = from_hex( v->kek, _kek );
+	size_t _key_len = from_hex( v->key, _key );
+	size_t _c_len = from_hex( v->c, _c );
+	size_t _out_len = sizeof( _out );
+	OAES_RET _rc;
+
+	if( OAES_RET_SUCCESS != oaes_key_import_data( ctx, _kek, _kek_len ) )
+	{
+		printf( "Error: Failed to import key.\n" );
+		return 1;
+	}
+
+	_rc = v->padded ?
+			oaes_kwp_wrap_key( ctx, _key, _key_len, _out, &_out_len ) :
+			oaes_kw_wrap_key( ctx, _key, _key_len, _out, &_out_len );
+	if( OAES_RET_SUCCESS != _rc || _out_len != _c_len ||
+			memcmp( _out, _c, _c_len ) )
+	{
+		printf( "Error: Failed to wrap [%d].\n", _rc );
+		return 1;
+	}
+
+	_out_len = sizeof( _out );
+	_rc = v->padded ?
+			oaes_kwp_unwrap_key( ctx, _c, _c_len, _out, &_out_len ) :
+			oaes_kw_unwrap_key( ctx, _c, _c_len, _out, &_out_len );
+	if( OAES_RET_SUCCESS != _rc || _out_len != _key_len ||
+			memcmp( _out, _key, _key_len ) )
+	{
+		printf( "Error: Failed to unwrap [%d].\n", _rc );
+		return 1;
+	}
+
+	_c[_c_len - 1] ^= 1;
+	_out_len = sizeof( _out );
+	_rc = v->padded ?
+			oaes_kwp_unwrap_key( ctx, _c, _c_len, _out, &_out_len ) :
+			oaes_kw_unwrap_key( ctx, _c, _c_len, _out, &_out_len );
+	if( OAES_RET_AUTH != _rc )
+	{
+		printf( "Error: Tampered key unwrapped [%d].\n", _rc );
+		return 1;
+	}
+
+	return 0;
+}
+
+// 0 when a batch of keys of mixed lengths, more than there are lanes,
+// wraps as one key at a time does and unwraps back
+static int test_kw_batch( OAES_CTX * ctx, int padded )
+{
+	size_t _i, _len[21], _c_len[21], _m_len[21], _one_len;
+	const uint8_t * _m[21];
+	uint8_t * _c[21];
+	uint8_t * _u[21];
+	uint8_t _kek[24], _buf[256], _wrapped[21][72], _unwrapped[21][64];
+	uint8_t _one[72];
+	OAES_RET _rc[21];
+
+	for( _i = 0; _i < sizeof( _kek ); _i++ )
+		_kek[_i] = (uint8_t) ( 7 * _i );
+	for( _i = 0; _i < sizeof( _buf ); _i++ )
+		_buf[_i] = (uint8_t) ( _i * _i );
+	for( _i = 0; _i < 21; _i++ )
+	{
+		_m[_i] = _buf + 3 * _i;
+		_len[_i] = padded ? 1 + ( _i * 13 ) % 64 : 16 + 8 * ( _i % 7 );
+		_c[_i] = _wrapped[_i];
+		_u[_i] = _unwrapped[_i];
+	}
+
+	if( oaes_key_import_data( ctx, _kek, sizeof( _kek ) ) ||
+			oaes_kw_wrap_batch( ctx, padded, _m, _len, 21, _c ) )
+	{
+		printf( "Error: Failed to wrap the batch.\n" );
+		return 1;
+	}
+
+	for( _i = 0; _i < 21; _i++ )
+	{
+		_one_len = sizeof( _one );
+		if( ( padded ?
+				oaes_kwp_wrap_key( ctx, _m[_i], _len[_i], _one, &_one_len ) :
+				oaes_kw_wrap_key( ctx, _m[_i], _len[_i], _one, &_one_len ) ) ||
+				memcmp( _one, _c[_i], _one_len ) )
+		{
+			printf( "Error: Batch key %d mismatch.\n", (int) _i );
+			return 1;
+		}
+		_c_len[_i] = _one_len;
+	}
+
+	if( oaes_kw_unwrap_batch( ctx, padded, (const uint8_t * const *) _c,
+			_c_len, 21, _u, _m_len, _rc ) )
+	{
+		printf( "Error: Failed to unwrap the batch.\n" );
+		return 1;
+	}
+
+	for( _i = 0; _i < 21; _i++ )
+		if( _m_len[_i] != _len[_i] || memcmp( _u[_i], _m[_i], _len[_i] ) )
+		{
+			printf( "Error: Batch round trip %d mismatch.\n", (int) _i );
+			return 1;
+		}
+
+	return 0;
+}
+
+// 0 when Poly1305-AES vector v gives its tag in one call and in pieces
+static int test_poly1305_vector( OAES_CTX * ctx, const poly1305_vector * v )
+{
+	uint8_t _k[16], _r[16], _nonce[16], _m[32];
+	uint8_t _tag[OAES_BLOCK_SIZE], _out[OAES_BLOCK_SIZE];
+	size_t _i, _m_len;
+
+	from_hex( v->k, _k );
+	from_hex( v->r, _r );
+	from_hex( v->nonce, _nonce );
+	_m_len = from_hex( v->m, _m );
+	from_hex( v->tag, _tag );
+
+	if( OAES_RET_SUCCESS != oaes_key_import_data( ctx, _k, sizeof( _k ) ) )
+	{
+		printf( "Error: Failed to import key.\n" );
+		return 1;
+	}
+
+	if( oaes_poly1305_aes( ctx, _r, _nonce, _m, _m_len, _out ) ||
+			memcmp( _out, _tag, OAES_BLOCK_SIZE ) )
+	{
+		printf( "Error: Tag mismatch.\n" );
+		return 1;
+	}
+
+	if( oaes_poly1305_start( ctx, _r, _nonce ) )
+		return 1;
+	for( _i = 0; _i < _m_len; _i += 3 )
+		if( oaes_poly1305_update( ctx, _m + _i,
+				_m_len - _i < 3 ? _m_len - _i : 3 ) )
+			return 1;
+	if( oaes_poly1305_final( ctx, _out ) ||
+			memcmp( _out, _tag, OAES_BLOCK_SIZE ) )
+	{
+		printf( "Error: Tag mismatch in pieces.\n" );
+		return 1;
+	}
+
+	return 0;
+}
+
+// 0 when encrypt then MAC round trips over a few chunks, in CTR and CBC,
+// and a changed ciphertext is turned down
+static int test_poly1305_etm( OAES_CTX * ctx )
+{
+	size_t _i, _mode;
+	uint8_t _k[16], _r[16], _nonce[16], _iv[16], _iv_dec[16];
+	uint8_t _m[9 * 1024], _c[9 * 1024], _out[9 * 1024];
+	uint8_t _tag[OAES_BLOCK_SIZE];
+	static const OAES_OPTION _modes[] = { OAES_OPTION_CTR, OAES_OPTION_CBC };
+
+	for( _i = 0; _i < 16; _i++ )
+	{
+		_k[_i] = (uint8_t) _i;
+		_r[_i] = (uint8_t) ( 0x40 + _i );
+		_nonce[_i] = (uint8_t) ( 0x80 + _i );
+	}
+	for( _i = 0; _i < sizeof( _m ); _i++ )
+		_m[_i] = (uint8_t) ( _i % 251 );
+
+	if( oaes_key_import_data( ctx, _k, sizeof( _k ) ) )
+		return 1;
+
+	for( _mode = 0; _mode < 2; _mode++ )
+	{
+		if( oaes_set_option( ctx, _modes[_mode], NULL ) )
+			return 1;
+
+		memset( _iv, 0x5a, sizeof( _iv ) );
+		memset( _iv_dec, 0x5a, sizeof( _iv_dec ) );
+		if( oaes_poly1305_encrypt( ctx, _r, _nonce, _iv, _m, sizeof( _m ),
+				_c, _tag ) ||
+				oaes_poly1305_decrypt( ctx, _r, _nonce, _iv_dec, _c, sizeof( _c ),
+				_out, _tag ) || memcmp( _out, _m, sizeof( _m ) ) )
+		{
+			printf( "Error: Encrypt then MAC round trip failed.\n" );
+			oaes_set_option( ctx, OAES_OPTION_CBC, NULL );
+			return 1;
+		}
+
+		_c[5000] ^= 1;
+		memset( _iv_dec, 0x5a, sizeof( _iv_dec ) );
+		if( OAES_RET_AUTH != oaes_poly1305_decrypt( ctx, _r, _nonce, _iv_dec,
+				_c, sizeof( _c ), _out, _tag ) )
+		{
+			printf( "Error: Changed ciphertext passed.\n" );
+			oaes_set_option( ctx, OAES_OPTION_CBC, NULL );
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * 
+ */
+// 0 when FF1 vector v encrypts and decrypts as it should
+static int test_ff1_vector( OAES_CTX * ctx, const ff1_vector * v )
+{
+	uint8_t _k[32], _tweak[16];
+	uint16_t _x[32], _y[32], _out[32];
+	size_t _k_len = from_hex( v->k, _k );
+	size_t _tweak_len = from_hex( v->tweak, _tweak );
+	size_t _len = from_digits( v->x, _x );
+	OAES_RET _rc;
+
+	from_digits( v->y, _y );
+	if( OAES_RET_SUCCESS != oaes_key_import_data( ctx, _k, _k_len ) )
+	{
+		printf( "Error: Failed to import key.\n" );
+		return 1;
+	}
+
+	_rc = oaes_ff1_encrypt( ctx, v->radix, _tweak, _tweak_len, _x, _len, _out );
+	if( OAES_RET_SUCCESS != _rc ||
+			memcmp( _out, _y, _len * sizeof( uint16_t ) ) )
+	{
+		printf( "Error: Failed to encrypt [%d].\n", _rc );
+		return 1;
+	}
+
+	_rc = oaes_ff1_decrypt( ctx, v->radix, _tweak, _tweak_len, _y, _len, _out );
+	if( OAES_RET_SUCCESS != _rc ||
+			memcmp( _out, _x, _len * sizeof( uint16_t ) ) )
+	{
+		printf( "Error: Failed to decrypt [%d].\n", _rc );
+		return 1;
+	}
+
+	return 0;
+}
+
+// 0 when a batch of values, more than the rounds take side by side,
+// encrypts as one value at a time does and decrypts back in place
+static int test_ff1_batch( OAES_CTX * ctx )
+{
+	static const uint8_t _tweak[] = "batch";
+	size_t _i, _len;
+	uint8_t _k[16];
+	uint16_t _x[37 * 40], _y[37 * 40], _one[40];
+	uint32_t _radix;
+
+	for( _i = 0; _i < sizeof( _k ); _i++ )
+		_k[_i] = (uint8_t) ( 5 * _i + 1 );
+	if( oaes_key_import_data( ctx, _k, sizeof( _k ) ) )
+	{
+		printf( "Error: Failed to import key.\n" );
+		return 1;
+	}
+
+	// radix 10 in one limb, then radix 264, over a byte, in several
+	for( _radix = 10, _len = 16; _radix < 1000;
+			_radix = _radix * 26 + 4, _len = _len * 5 / 2 )
+	{
+		for( _i = 0; _i < 37 * _len; _i++ )
+			_x[_i] = (uint16_t) ( ( _i * _i + 3 * _i ) % _radix );
+
+		if( oaes_ff1_encrypt_batch( ctx, _radix, _tweak, sizeof( _tweak ),
+				_x, _len, 37, _y ) )
+		{
+			printf( "Error: Failed to encrypt the batch.\n" );
+			return 1;
+		}
+
+		for( _i = 0; _i < 37; _i++ )
+			if( oaes_ff1_encrypt( ctx, _radix, _tweak, sizeof( _tweak ),
+					_x + _i * _len, _len, _one ) ||
+					memcmp( _one, _y + _i * _len, _len * sizeof( uint16_t ) ) )
+			{
+				printf( "Error: Batch value %d mismatch.\n", (int) _i );
+				return 1;
+			}
+
+		if( oaes_ff1_decrypt_batch( ctx, _radix, _tweak, sizeof( _tweak ),
+				_y, _len, 37, _y ) ||
+				memcmp( _y, _x, 37 * _len * sizeof( uint16_t ) ) )
+		{
+			printf( "Error: Batch round trip mismatch.\n" );
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+// 0 when round hash vector v comes out in one call, 16 and 8 bytes long,
+// and in pieces
+static int test_round_hash_vector( OAES_CTX * ctx, const round_hash_vector * v )
+{
+	uint8_t _k[16], _m[300], _hash[16], _out[16];
+	size_t _i;
+	OAES_RET _rc;
+
+	for( _i = 0; _i < sizeof( _k ); _i++ )
+		_k[_i] = (uint8_t) _i;
+	for( _i = 0; _i < sizeof( _m ); _i++ )
+		_m[_i] = (uint8_t) _i;
+	from_hex( v->hash, _hash );
+
+	if( OAES_RET_SUCCESS != oaes_key_import_data( ctx, _k, sizeof( _k ) ) )
+	{
+		printf( "Error: Failed to import key.\n" );
+		return 1;
+	}
+
+	_rc = oaes_round_hash( ctx, _m, v->len, _out, 16 );
+	if( OAES_RET_SUCCESS != _rc || memcmp( _out, _hash, 16 ) )
+	{
+		printf( "Error: Failed to hash [%d].\n", _rc );
+		return 1;
+	}
+
+	memset( _out, 0, sizeof( _out ) );
+	if( oaes_round_hash( ctx, _m, v->len, _out, 8 ) ||
+			memcmp( _out, _hash, 8 ) || _out[8] )
+	{
+		printf( "Error: Failed to hash to 8 bytes.\n" );
+		return 1;
+	}
+
+	// pieces of 7 bytes straddle both blocks and stripes
+	if( oaes_round_hash_start( ctx ) )
+		return 1;
+	for( _i = 0; _i < v->len; _i += 7 )
+		if( oaes_round_hash_update( ctx, _m + _i,
+				v->len - _i < 7 ? v->len - _i : 7 ) )
+			return 1;
+	if( oaes_round_hash_final( ctx, _out, 16 ) || memcmp( _out, _hash, 16 ) )
+	{
+		printf( "Error: Failed to hash in pieces.\n" );
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char** argv) {
+
+	size_t _i, _j;
+	const char * _name;
+	int _available, _failed = 0, _engine_failed;
+	OAES_CTX * ctx = NULL;
+
+	if( NULL == ( ctx = oaes_alloc() ) )
+	{
+		printf( "Error: Initialization failed.\n" );
+		return 1;
+	}
+
+	if( test_engine_select( ctx ) )
+	{
+		printf( "engine selection: FAILED\n" );
+		_failed = 1;
+	}
+
+	// every vector on every engine this cpu can run
+	for( _i = 0; OAES_RET_SUCCESS ==
+			oaes_get_engine_info( _i, &_name, NULL, &_available ); _i++ )
+	{
+		if( 0 == _available )
+			continue;
+
+		if( OAES_RET_SUCCESS != oaes_set_option( ctx, OAES_OPTION_ENGINE, _name ) )
+		{
+			printf( "Error: Failed to select engine %s.\n", _name );
+			oaes_free( &ctx );
+			return 1;
+		}
+
+		_engine_failed = 0;
+		for( _j = 0; _j < ECB_VECTOR_COUNT; _j++ )
+		{
+			if( test_ecb_vector( ctx, ecb_vectors + _j ) )
+			{
+				printf( "engine %s, ECB vector %d: FAILED\n", _name, (int) _j + 1 );
+				_engine_failed = 1;
+			}
+		}
+
+		for( _j = 0; _j < CBC_VECTOR_COUNT; _j++ )
+		{
+			if( test_cbc_vector( ctx, cbc_vectors + _j ) )
+			{
+				printf( "engine %s, CBC vector %d: FAILED\n", _name, (int) _j + 1 );
+				_engine_failed = 1;
+			}
+		}
+
+#if OAES_STEP_TRACE
+		if( test_step_trace( ctx ) )
+		{
+			printf( "engine %s, step trace: FAILED\n", _name );
+			_engine_failed = 1;
+		}
+#endif // OAES_STEP_TRACE
+
+		for( _j = 0; _j < XTS_VECTOR_COUNT; _j++ )
+		{
+			if( test_xts_vector( ctx, xts_vectors + _j ) )
+			{
+				printf( "engine %s, XTS vector %d: FAILED\n", _name, (int) _j + 1 );
+				_engine_failed = 1;
+			}
+		}
+
+		if( test_xts_run( ctx ) )
+		{
+			printf( "engine %s, XTS sector run: FAILED\n", _name );
+			_engine_failed = 1;
+		}
+
+		for( _j = 0; _j < OCB_VECTOR_COUNT; _j++ )
+		{
+			if( test_ocb_vector( ctx, ocb_vectors + _j ) )
+			{
+				printf( "engine %s, OCB test case %d: FAILED\n",
+						_name, (int) _j + 1 );
+				_engine_failed = 1;
+			}
+		}
+
+		for( _j = 0; _j < CCM_VECTOR_COUNT; _j++ )
+		{
+			if( test_ccm_vector( ctx, ccm_vectors + _j,
+					CCM_VECTOR_COUNT - 1 == _j ) )
+			{
+				printf( "engine %s, CCM example %d: FAILED\n",
+						_name, (int) _j + 1 );
+				_engine_failed = 1;
+			}
+		}
+
+		for( _j = 0; _j < CTS_VECTOR_COUNT; _j++ )
+		{
+			if( test_cts_vector( ctx, cts_vectors + _j ) )
+			{
+				printf( "engine %s, CBC-CS3 vector %d: FAILED\n", _name,
+						(int) _j + 1 );
+				_engine_failed = 1;
+			}
+		}
+
+		for( _j = 0; _j < STREAM_VECTOR_COUNT; _j++ )
+		{
+			if( test_stream_vector( ctx, stream_vectors + _j ) )
+			{
+				printf( "engine %s, %s vector: FAILED\n", _name,
+						stream_vectors[_j].name );
+				_engine_failed = 1;
+			}
+		}
+
+		if( test_ctr_vector( ctx ) )
+		{
+			printf( "engine %s, CTR vector: FAILED\n", _name );
+			_engine_failed = 1;
+		}
+
+		if( test_ctr_width( ctx ) )
+		{
+			printf( "engine %s, CTR counter width: FAILED\n", _name );
+			_engine_failed = 1;
+		}
+
+		if( test_ctr_crypt_at( ctx ) )
+		{
+			printf( "engine %s, CTR ranges: FAILED\n", _name );
+			_engine_failed = 1;
+		}
+
+		if( test_ctr_prefetch( ctx ) )
+		{
+			printf( "engine %s, CTR prefetch: FAILED\n", _name );
+			_engine_failed = 1;
+		}
+
+		for( _j = 0; _j < CMAC_VECTOR_COUNT; _j++ )
+		{
+			if( test_cmac_vector( ctx, cmac_vectors + _j ) )
+			{
+				printf( "engine %s, CMAC vector %d: FAILED\n", _name,
+						(int) _j + 1 );
+				_engine_failed = 1;
+			}
+		}
+
+		if( test_cmac_batch( ctx ) )
+		{
+			printf( "engine %s, CMAC batch: FAILED\n", _name );
+			_engine_failed = 1;
+		}
+
+		for( _j = 0; _j < KW_VECTOR_COUNT; _j++ )
+		{
+			if( test_kw_vector( ctx, kw_vectors + _j ) )
+			{
+				printf( "engine %s, key wrap vector %d: FAILED\n", _name,
+						(int) _j + 1 );
+				_engine_failed = 1;
+			}
+		}
+
+		if( test_kw_batch( ctx, 0 ) || test_kw_batch( ctx, 1 ) )
+		{
+			printf( "engine %s, key wrap batch: FAILED\n", _name );
+			_engine_failed = 1;
+		}
+
+		for( _j = 0; _j < POLY1305_VECTOR_COUNT; _j++ )
+		{
+			if( test_poly1305_vector( ctx, poly1305_vectors + _j ) )
+			{
+				printf( "engine %s, Poly1305-AES vector %d: FAILED\n", _name,
+						(int) _j + 1 );
+				_engine_failed = 1;
+			}
+		}
+
+		if( test_poly1305_etm( ctx ) )
+		{
+			printf( "engine %s, Poly1305-AES encrypt then MAC: FAILED\n", _name );
+			_engine_failed = 1;
+		}
+
+		for( _j = 0; _j < FF1_VECTOR_COUNT; _j++ )
+		{
+			if( test_ff1_vector( ctx, ff1_vectors + _j ) )
+			{
+				printf( "engine %s, FF1 vector %d: FAILED\n", _name,
+						(int) _j + 1 );
+				_engine_failed = 1;
+			}
+		}
+
+		if( test_ff1_batch( ctx ) )
+		{
+			printf( "engine %s, FF1 batch: FAILED\n", _name );
+			_engine_failed = 1;
+		}
+
+		for( _j = 0; _j < ROUND_HASH_VECTOR_COUNT; _j++ )
+		{
+			if( test_round_hash_vector( ctx, round_hash_vectors + _j ) )
+			{
+				printf( "engine %s, round hash vector %d: FAILED\n", _name,
+						(int) _j + 1 );
+				_engine_failed = 1;
+			}
+		}
+
+		printf( "engine %s: %s\n", _name, _engine_failed ? "FAILED" : "passed" );
+		_failed |= _engine_failed;
+	}
+
+	oaes_free( &ctx );
+
+	return _failed;
+}
@@ -37,14 +37,23 @@
 
 void usage(const char * exe_name)
 {
+	size_t _i;
+	const char * _name;
+	int _available;
+	
 	if( NULL == exe_name )
 		return;
 	
 	printf(
 			"Usage:\n"
-			"\t%s [-ecb] [-key < 128 | 192 | 256 >] [-data <data_len>]\n",
+			"\t%s [-ecb] [-key < 128 | 192 | 256 >] [-data <data_len>]"
+			" [-engine <name>]\n",
 			exe_name
 	);
+	printf( "Engines:\n" );
+	for( _i = 0; OAES_RET_SUCCESS ==
+			oaes_get_engine_info( _i, &_name, NULL, &_available ); _i++ )
+		printf( "\t%s%s\n", _name, _available ? "" : " (not supported)" );
 }
 
 /*
@@ -61,6 +70,7 @@ int main(int argc, char** argv) {
 	short _is_ecb = 0;
 	int _key_len = 128;
 	size_t _data_len = 64;
+	const char * _engine = NULL;
 	uint8_t _iv[OAES_BLOCK_SIZE] = "";
 	uint8_t _pad = 0;
 	
@@ -114,6 +124,20 @@ int main(int argc, char** argv) {
 			_data_len = atoi( argv[_i] );
 		}
 		
+		if( 0 == strcmp( argv[_i], "-engine" ) )
+		{
+			_found = 1;
+			_i++; // engine
+			if( _i >= argc )
+			{
+				printf("Error: No value specified for '-%s'.\n",
+						"engine");
+				usage( argv[0] );
+				return 1;
+			}
+			_engine = argv[_i];
+		}
+		
 		if( 0 == _found )
 		{
 			printf("Error: Invalid option '%s'.\n", argv[_i]);
@@ -137,6 +161,14 @@ int main(int argc, char** argv) {
 	if( _is_ecb )
 		if( OAES_RET_SUCCESS != oaes_set_option( ctx, OAES_OPTION_ECB, NULL ) )
 			printf("Error: Failed to set OAES options.\n");
+	if( _engine )
+		if( OAES_RET_SUCCESS != oaes_set_option( ctx, OAES_OPTION_ENGINE, _engine ) )
+		{
+			printf("Error: Engine '%s' is not available.\n", _engine);
+			usage( argv[0] );
+			oaes_free( &ctx );
+			return 1;
+		}
 	switch( _key_len )
 	{
 		case 128:
@@ -193,9 +225,9 @@ int main(int argc, char** argv) {
 	
 	time( &_time_end );
 	printf( "Test encrypt and decrypt:\n\ttime: %lld seconds\n\tdata: %ld MB"
-			"\n\tkey: %d bits\n\tmode: %s\n",
+			"\n\tkey: %d bits\n\tmode: %s\n\tengine: %s\n",
 			_time_end - _time_start, _data_len,
-			_key_len, _is_ecb? "EBC" : "CBC" );
+			_key_len, _is_ecb? "EBC" : "CBC", oaes_get_engine( ctx ) );
 	free( _encbuf );
 	free( _decbuf );
 	if( OAES_RET_SUCCESS !=  oaes_free( &ctx ) )